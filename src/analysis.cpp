@@ -16,39 +16,33 @@
  * ============================================================ */
 
 #include "analysis.h"
+#include "thread_pool.h"
+#include "boundary_trace.h"
 
-#include <unordered_set>
+#include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cmath>
+#include <cstdio>
+#include <memory>
+#include <queue>
 #include <thread>
-#include <atomic>
 
 namespace dynsys::analysis {
 
 namespace {
 
-/* Run body(i) for i in [0,count) across hardware threads. Falls back to a plain
- * serial loop when only one core is available or count is tiny, so behaviour is
+/* Run body(i) for i in [0,count) on the shared worker pool (thread_pool.h).
+ * Falls back to a plain serial loop when count is tiny, so behaviour is
  * identical (just faster) on multi-core machines. body must be thread-safe with
  * respect to disjoint i (each call should touch only its own slice of output).*/
 template <typename F>
 void parallel_for(int count, F &&body) {
   if (count <= 0) return;
-  unsigned hw = std::thread::hardware_concurrency();
-  if (hw < 2 || count < 64) { for (int i = 0; i < count; ++i) body(i); return; }
-  unsigned nthreads = std::min<unsigned>(hw, (unsigned)count);
-  std::atomic<int> next{0};
-  auto worker = [&]() {
-    for (;;) {
-      int i = next.fetch_add(1, std::memory_order_relaxed);
-      if (i >= count) break;
-      body(i);
-    }
-  };
-  std::vector<std::thread> pool;
-  pool.reserve(nthreads);
-  for (unsigned t = 0; t < nthreads; ++t) pool.emplace_back(worker);
-  for (auto &th : pool) th.join();
+  if (count < 64) { for (int i = 0; i < count; ++i) body(i); return; }
+  pool::parallel_for((std::size_t)count, [&](std::size_t i, unsigned) { body((int)i); });
 }
 
 constexpr double kRadix = 2.0; /* floating-point base for balancing */
@@ -420,6 +414,145 @@ bool finite_diff_jacobian(const Model &m, const double *x, double p,
 
 namespace {
 
+/* Dense LU with partial pivoting (row interchanges applied to whole rows, as
+ * in LAPACK getrf). Kept, unlike solve_linear, so one factorization serves
+ * several right-hand sides, the transposed system and the determinant. Real
+ * or complex (the bordered eigenvalue tracking of continue_equilibrium). */
+template <class T>
+struct DenseLUT {
+  std::size_t n = 0;
+  std::vector<T> a;
+  std::vector<std::size_t> piv;
+  bool factor(std::vector<T> A, std::size_t n_) {
+    n = n_; a.swap(A); piv.assign(n, 0);
+    if (a.size() != n * n || n == 0) return false;
+    for (std::size_t c = 0; c < n; ++c) {
+      std::size_t p = c;
+      for (std::size_t r = c + 1; r < n; ++r)
+        if (std::abs(a[r * n + c]) > std::abs(a[p * n + c])) p = r;
+      if (!(std::abs(a[p * n + c]) > 1e-300)) return false;
+      piv[c] = p;
+      if (p != c)
+        for (std::size_t j = 0; j < n; ++j) std::swap(a[p * n + j], a[c * n + j]);
+      const T inv = T(1) / a[c * n + c];
+      for (std::size_t r = c + 1; r < n; ++r) {
+        const T l = a[r * n + c] *= inv;
+        if (l != T(0))
+          for (std::size_t j = c + 1; j < n; ++j) a[r * n + j] -= l * a[c * n + j];
+      }
+    }
+    return true;
+  }
+  /* x <- A^{-1} x */
+  void solve(std::vector<T> *x) const {
+    std::vector<T> &y = *x;
+    for (std::size_t c = 0; c < n; ++c) std::swap(y[c], y[piv[c]]);
+    for (std::size_t c = 0; c < n; ++c)
+      for (std::size_t r = c + 1; r < n; ++r) y[r] -= a[r * n + c] * y[c];
+    for (std::size_t c = n; c-- > 0;) {
+      for (std::size_t j = c + 1; j < n; ++j) y[c] -= a[c * n + j] * y[j];
+      y[c] /= a[c * n + c];
+    }
+  }
+  /* x <- A^{-T} x (plain transpose, also for complex A) */
+  void solve_t(std::vector<T> *x) const {
+    std::vector<T> &y = *x;
+    for (std::size_t c = 0; c < n; ++c) {
+      for (std::size_t j = 0; j < c; ++j) y[c] -= a[j * n + c] * y[j];
+      y[c] /= a[c * n + c];
+    }
+    for (std::size_t c = n; c-- > 0;)
+      for (std::size_t r = c + 1; r < n; ++r) y[c] -= a[r * n + c] * y[r];
+    for (std::size_t c = n; c-- > 0;) std::swap(y[c], y[piv[c]]);
+  }
+  T det() const {
+    T d = T(1);
+    for (std::size_t c = 0; c < n; ++c) d *= piv[c] != c ? -a[c * n + c] : a[c * n + c];
+    return d;
+  }
+};
+using DenseLU = DenseLUT<double>;
+
+/* The corrector loop behind continue_equilibrium, the minimally augmented
+ * curves and the cycle solvers, for a CorrectorKind. `residual` fills G(z),
+ * `refresh` evaluates and factors the Jacobian at the z of the last
+ * residual, and `solve` applies the held factorization (x <- A^{-1} x).
+ * `held` says whether the caller already holds one to start from; Newton
+ * ignores it. Broyden keeps its rank-one updates of the inverse as a list on
+ * top of the LU, H_{k+1} v = H_k v + d_k (s_k . H_k v) with
+ * d_k = (s_k - H_k y_k) / (s_k . H_k y_k), so a step stays O(LU solve).
+ * Within a factor 100 of tol the residual is mostly evaluation noise: there
+ * neither a slow contraction triggers a refactor nor is Broyden updated.
+ * Steps longer than max_step are scaled back. Returns false when an
+ * evaluation or factorization fails; *converged is |G| < tol. */
+struct QNCorrector {
+  CorrectorKind kind = CorrectorKind::Newton;
+  double contraction = 0.5;
+  int iters = 12;
+  double tol = 1e-9;
+  double max_step = 1e300;
+  CorrectorCounts *counts = nullptr;
+};
+
+bool qn_correct(const QNCorrector &o, std::vector<double> *z, bool held,
+                const std::function<bool(const std::vector<double> &, std::vector<double> *)> &residual,
+                const std::function<bool(const std::vector<double> &)> &refresh,
+                const std::function<void(std::vector<double> *)> &solve, bool *converged) {
+  const std::size_t nz = z->size();
+  std::vector<double> G, G_prev, step, y;
+  std::vector<std::vector<double>> ss, ds;
+  auto apply = [&](std::vector<double> *v) {
+    solve(v);
+    for (std::size_t k = 0; k < ss.size(); ++k) {
+      double a = 0.0;
+      for (std::size_t i = 0; i < nz; ++i) a += ss[k][i] * (*v)[i];
+      for (std::size_t i = 0; i < nz; ++i) (*v)[i] += a * ds[k][i];
+    }
+  };
+  *converged = false;
+  double prev_res = 1e300;
+  for (int it = 0; it < o.iters; ++it) {
+    if (!residual(*z, &G)) return false;
+    double res = 0.0;
+    for (double v : G) res += v * v;
+    res = std::sqrt(res);
+    if (res < o.tol) { *converged = true; return true; }
+    const bool noise = res < 1e2 * o.tol;
+    if (o.kind == CorrectorKind::Newton || !held || (res > o.contraction * prev_res && !noise)) {
+      if (!refresh(*z)) return false;
+      if (o.counts) { ++o.counts->jacobians; ++o.counts->factorizations; }
+      held = true;
+      ss.clear(); ds.clear();
+    } else if (o.kind == CorrectorKind::Broyden && !step.empty() && !noise) {
+      y.resize(nz);
+      for (std::size_t i = 0; i < nz; ++i) y[i] = G[i] - G_prev[i];
+      apply(&y);
+      double sy = 0.0, s2 = 0.0, y2 = 0.0;
+      for (std::size_t i = 0; i < nz; ++i) { sy += step[i] * y[i]; s2 += step[i] * step[i]; y2 += y[i] * y[i]; }
+      if (std::fabs(sy) > 1e-12 * std::sqrt(s2 * y2)) {
+        std::vector<double> d(nz);
+        for (std::size_t i = 0; i < nz; ++i) d[i] = (step[i] - y[i]) / sy;
+        ss.push_back(step);
+        ds.push_back(std::move(d));
+      }
+    }
+    if (o.counts) ++o.counts->iterations;
+    step.resize(nz);
+    for (std::size_t i = 0; i < nz; ++i) step[i] = -G[i];
+    apply(&step);
+    double nrm = 0.0;
+    for (double v : step) nrm += v * v;
+    nrm = std::sqrt(nrm);
+    if (!std::isfinite(nrm)) return false;
+    if (nrm > o.max_step)
+      for (double &v : step) v *= o.max_step / nrm;
+    for (std::size_t i = 0; i < nz; ++i) (*z)[i] += step[i];
+    G_prev = G;
+    prev_res = res;
+  }
+  return true;
+}
+
 bool jacobian_x(const Model &m, const double *x, double p,
                 std::vector<double> *jac, std::string *err) {
   if (m.jacobian_x) {
@@ -474,66 +607,642 @@ bool correct_equilibrium(const Model &m, std::vector<double> *x, double p,
   return std::sqrt(res) < tol * 1e3;
 }
 
-/* Fold test function: det(f_x). Sign change => a real eigenvalue
- * crossed zero. */
-double fold_test(const Model &m, const double *x, double p) {
-  std::vector<double> J;
+/* Fold and branch-point test functions, both read off one LU of the bordered
+ * matrix A = [ f_x f_p ; t^T ] at an accepted point (t = the current curve
+ * tangent, or e_last before there is one):
+ *   branch point   det A            singular where two branches cross
+ *   fold           det f_x = det A * (A^{-1} e_last)_n     (Cramer)
+ * and A^{-1} e_last, normalized, is the next tangent. At a fold det A stays
+ * nonzero (a turning point, not a crossing), so a sign change of det f_x
+ * without one of det A is a fold, and a sign change of det A is a branch
+ * point. f_x is kept for the Hopf tracking below. */
+struct BorderedTests {
+  double fold = std::nan(""), bp = std::nan("");
+  std::vector<double> tan;  /* A^{-1} e_last, unnormalized */
+  std::vector<double> J;    /* f_x at the point */
+  std::vector<double> fp;   /* f_p at the point */
+};
+
+bool bordered_tests(const Model &m, const double *x, double p, const std::vector<double> &t,
+                    BorderedTests *out) {
+  const std::size_t n = m.n, N = n + 1;
+  std::vector<double> &fp = out->fp;
   std::string err;
-  if (!jacobian_x(m, x, p, &J, &err)) return std::nan("");
-  return determinant(J, m.n);
+  if (!jacobian_x(m, x, p, &out->J, &err)) return false;
+  if (!dfdp(m, x, p, &fp, &err)) return false;
+  std::vector<double> A(N * N, 0.0);
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t c = 0; c < n; ++c) A[r * N + c] = out->J[r * n + c];
+    A[r * N + n] = fp[r];
+  }
+  if (t.size() == N)
+    for (std::size_t c = 0; c < N; ++c) A[n * N + c] = t[c];
+  else
+    A[n * N + n] = 1.0;
+  DenseLU lu;
+  if (!lu.factor(std::move(A), N)) { out->fold = out->bp = 0.0; return false; }
+  out->tan.assign(N, 0.0);
+  out->tan[n] = 1.0;
+  lu.solve(&out->tan);
+  out->bp = lu.det();
+  out->fold = out->bp * out->tan[n];
+  return is_finite_vec(out->tan) && std::isfinite(out->fold);
 }
 
-/* Hopf test function: product over complex-conjugate pairs of the
- * sum of their real parts. We use a robust proxy: the minimum
- * |Re(lambda)| among complex (nonzero-imag) eigenvalues, signed by
- * the sign of that Re. A sign change with imag != 0 brackets a Hopf.
- * Returns NaN when there is no complex pair. */
-double hopf_test(const Model &m, const double *x, double p, double tol) {
-  std::vector<double> J;
-  std::string err;
-  if (!jacobian_x(m, x, p, &J, &err)) return std::nan("");
-  std::vector<Complex> ev;
-  if (!eigenvalues(J, m.n, &ev)) return std::nan("");
-  bool found = false;
-  double best_abs = 0.0, signed_val = 0.0;
-  for (const Complex &z : ev) {
-    if (std::fabs(z.imag()) > tol) {
-      const double a = std::fabs(z.real());
-      if (!found || a < best_abs) {
-        best_abs = a;
-        signed_val = z.real();
-        found = true;
+/* Hopf test function without a bialternate product: one complex pair is
+ * followed along the branch by Newton on the bordered system
+ *
+ *     [ f_x - lam I   b ] [ v ]   [ 0 ]
+ *     [ c^H           0 ] [ g ] = [ 1 ]
+ *
+ * g(lam) vanishes exactly at an eigenvalue and dg/dlam = y^T [v; 0] with
+ * y = M^{-T} e_last, so a Newton step is one complex LU; the borders are then
+ * reset to the new (left) eigenvectors. The test value is Re lam. The full
+ * spectrum is only computed to seed the pair (see continue_equilibrium). */
+struct PairTrack {
+  bool on = false;
+  Complex lam;
+  std::vector<Complex> b, c;
+};
+
+bool track_pair(const std::vector<double> &J, std::size_t n, double tol, PairTrack *t) {
+  if (!t->on) return false;
+  const std::size_t N = n + 1;
+  std::vector<Complex> M(N * N), v(N), y(N);
+  DenseLUT<Complex> lu;
+  for (int it = 0; it < 12; ++it) {
+    std::fill(M.begin(), M.end(), Complex(0.0));
+    for (std::size_t r = 0; r < n; ++r) {
+      for (std::size_t c = 0; c < n; ++c) M[r * N + c] = J[r * n + c];
+      M[r * N + r] -= t->lam;
+      M[r * N + n] = t->b[r];
+      M[n * N + r] = std::conj(t->c[r]);
+    }
+    if (!lu.factor(M, N)) return false;
+    std::fill(v.begin(), v.end(), Complex(0.0)); v[n] = 1.0;
+    std::fill(y.begin(), y.end(), Complex(0.0)); y[n] = 1.0;
+    lu.solve(&v);
+    lu.solve_t(&y);
+    Complex dg(0.0);
+    double vn = 0.0, yn = 0.0;
+    for (std::size_t i = 0; i < n; ++i) { dg += y[i] * v[i]; vn += std::norm(v[i]); yn += std::norm(y[i]); }
+    vn = std::sqrt(vn); yn = std::sqrt(yn);
+    if (!(std::abs(dg) > 0.0) || !(vn > 0.0) || !(yn > 0.0)) return false;
+    const Complex dl = v[n] / dg;
+    t->lam -= dl;
+    for (std::size_t i = 0; i < n; ++i) { t->c[i] = v[i] / vn; t->b[i] = std::conj(y[i]) / yn; }
+    if (!std::isfinite(t->lam.real()) || !std::isfinite(t->lam.imag())) return false;
+    if (std::abs(dl) <= 1e-12 * (1.0 + std::abs(t->lam))) return t->lam.imag() > tol;
+  }
+  return false;
+}
+
+/* seed the tracking at the complex pair of ev (Im > tol) nearest the
+ * imaginary axis; off when there is none */
+bool seed_pair(const std::vector<double> &J, std::size_t n, const std::vector<Complex> &ev, double tol,
+               PairTrack *t) {
+  t->on = false;
+  double best = 1e300;
+  for (const Complex &z : ev)
+    if (z.imag() > tol && std::fabs(z.real()) < best) { best = std::fabs(z.real()); t->lam = z; }
+  if (best == 1e300) return false;
+  t->b.assign(n, 0.0);
+  for (std::size_t i = 0; i < n; ++i) t->b[i] = Complex(std::sin(1.0 + 2.0 * i), std::cos(0.5 + 3.0 * i)) / std::sqrt((double)n);
+  t->c = t->b;
+  t->on = true;
+  if (!track_pair(J, n, tol, t)) { t->on = false; return false; }
+  return true;
+}
+
+/* ---- matrix-free continuation (Newton-Krylov) ---------------------------- */
+
+double vdot(const std::vector<double> &a, const std::vector<double> &b) {
+  double s = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i) s += a[i] * b[i];
+  return s;
+}
+double vnorm(const std::vector<double> &a) { return std::sqrt(vdot(a, a)); }
+
+using KrylovOp = std::function<bool(const std::vector<double> &, std::vector<double> *)>;
+
+/* Restarted GMRES with right preconditioning: x <- A^{-1} b, from the x
+ * passed in, until |b - A x| <= tol |b| or max_iters iterations. P applies
+ * the preconditioner. Returns false only when A or P fails; *relres is the
+ * final relative residual and *iters is incremented by the iterations. */
+bool gmres(const KrylovOp &A, const KrylovOp &P, const std::vector<double> &b, std::vector<double> *x,
+           int restart, int max_iters, double tol, double *relres, long *iters) {
+  const std::size_t nb = b.size();
+  const double bn = vnorm(b);
+  x->resize(nb, 0.0);
+  *relres = 0.0;
+  if (bn == 0.0) { x->assign(nb, 0.0); return true; }
+  const int m = std::max(1, restart);
+  std::vector<double> r(nb), w, z, H((m + 1) * m), cs(m), sn(m), g(m + 1), y(m);
+  std::vector<std::vector<double>> V, Z;
+  int total = 0;
+  for (;;) {
+    if (!A(*x, &w)) return false;
+    for (std::size_t i = 0; i < nb; ++i) r[i] = b[i] - w[i];
+    const double beta = vnorm(r);
+    *relres = beta / bn;
+    if (*relres <= tol || total >= max_iters) return true;
+    V.assign(1, r);
+    for (double &v : V[0]) v /= beta;
+    Z.clear();
+    std::fill(g.begin(), g.end(), 0.0);
+    g[0] = beta;
+    int k = 0;
+    while (k < m && total < max_iters) {
+      if (!P(V[k], &z) || !A(z, &w)) return false;
+      Z.push_back(z);
+      for (int j = 0; j <= k; ++j) {
+        const double h = vdot(w, V[j]);
+        H[j * m + k] = h;
+        for (std::size_t i = 0; i < nb; ++i) w[i] -= h * V[j][i];
+      }
+      const double hk = vnorm(w);
+      for (int j = 0; j < k; ++j) {
+        const double t = cs[j] * H[j * m + k] + sn[j] * H[(j + 1) * m + k];
+        H[(j + 1) * m + k] = -sn[j] * H[j * m + k] + cs[j] * H[(j + 1) * m + k];
+        H[j * m + k] = t;
+      }
+      const double d = std::hypot(H[k * m + k], hk);
+      cs[k] = d > 0.0 ? H[k * m + k] / d : 1.0;
+      sn[k] = d > 0.0 ? hk / d : 0.0;
+      H[k * m + k] = d;
+      g[k + 1] = -sn[k] * g[k];
+      g[k] *= cs[k];
+      ++k;
+      ++total;
+      if (std::fabs(g[k]) <= tol * bn || !(hk > 1e-14 * d)) break;
+      V.push_back(w);
+      for (double &v : V.back()) v /= hk;
+    }
+    if (iters) *iters += k;
+    for (int i = k; i-- > 0;) {
+      double s = g[i];
+      for (int j = i + 1; j < k; ++j) s -= H[i * m + j] * y[j];
+      y[i] = H[i * m + i] != 0.0 ? s / H[i * m + i] : 0.0;
+    }
+    for (int j = 0; j < k; ++j)
+      for (std::size_t i = 0; i < nb; ++i) (*x)[i] += y[j] * Z[j][i];
+  }
+}
+
+/* Block-Jacobi preconditioner from the diagonal blocks of f_x, probed with
+ * 3 * b products: column j of every third block goes into one probe, which
+ * leaves each diagonal block exact as long as no row couples to unknowns
+ * two or more blocks away. The blocks are kept and factored per shift,
+ * (block - shift I); a block that will not factor is passed through. */
+struct BlockJacobi {
+  std::size_t n = 0, b = 0;
+  std::vector<std::vector<double>> blocks;
+  std::vector<DenseLU> lu;
+  std::vector<char> usable;
+  double shift = std::nan("");
+  std::size_t size(std::size_t k) const { return std::min(b, n - k * b); }
+  bool build(std::size_t n_, std::size_t b_, const KrylovOp &jv) {
+    n = n_;
+    b = std::max<std::size_t>(1, std::min(b_, n_));
+    shift = std::nan("");
+    const std::size_t nb = (n + b - 1) / b;
+    blocks.assign(nb, {});
+    for (std::size_t k = 0; k < nb; ++k) blocks[k].assign(size(k) * size(k), 0.0);
+    std::vector<double> v(n), out;
+    for (std::size_t c = 0; c < 3; ++c)
+      for (std::size_t j = 0; j < b; ++j) {
+        std::fill(v.begin(), v.end(), 0.0);
+        bool any = false;
+        for (std::size_t k = c; k < nb; k += 3)
+          if (j < size(k)) { v[k * b + j] = 1.0; any = true; }
+        if (!any) continue;
+        if (!jv(v, &out)) return false;
+        for (std::size_t k = c; k < nb; k += 3) {
+          const std::size_t sk = size(k);
+          if (j >= sk) continue;
+          for (std::size_t r = 0; r < sk; ++r) blocks[k][r * sk + j] = out[k * b + r];
+        }
+      }
+    return true;
+  }
+  void apply(double s, const double *r, double *out, CorrectorCounts *counts) {
+    if (s != shift) {
+      lu.assign(blocks.size(), DenseLU());
+      usable.assign(blocks.size(), 0);
+      for (std::size_t k = 0; k < blocks.size(); ++k) {
+        const std::size_t sk = size(k);
+        std::vector<double> A = blocks[k];
+        for (std::size_t i = 0; i < sk; ++i) A[i * sk + i] -= s;
+        usable[k] = lu[k].factor(std::move(A), sk);
+      }
+      shift = s;
+      ++counts->factorizations;
+    }
+    std::vector<double> y;
+    for (std::size_t k = 0; k < blocks.size(); ++k) {
+      const std::size_t sk = size(k), o = k * b;
+      y.assign(r + o, r + o + sk);
+      if (usable[k]) lu[k].solve(&y);
+      std::copy(y.begin(), y.end(), out + o);
+    }
+  }
+};
+
+/* Ritz values of a shift-invert Arnoldi factorization, (f_x - shift I)^{-1}
+ * V_k = V_{k+1} H: the eigenvalues mu of the k x k part whose Ritz residual
+ * beta |y_k| is below tol |mu|, mapped back to lambda = shift + 1 / mu and
+ * ordered nearest the shift first. */
+bool shift_invert_ritz(const std::vector<double> &H, std::size_t ld, std::size_t k, double beta, double shift,
+                       double tol, std::vector<Complex> *out) {
+  std::vector<double> Hk(k * k);
+  for (std::size_t i = 0; i < k; ++i)
+    for (std::size_t j = 0; j < k; ++j) Hk[i * k + j] = H[i * ld + j];
+  std::vector<Complex> mu;
+  if (!eigenvalues(Hk, k, &mu)) return false;
+  std::sort(mu.begin(), mu.end(), [](const Complex &a, const Complex &b) { return std::abs(a) > std::abs(b); });
+  out->clear();
+  for (const Complex &u : mu) {
+    if (!(std::abs(u) > 1e-300)) continue;
+    /* Ritz vector by two inverse iterations on H_k - mu */
+    std::vector<Complex> A(k * k);
+    for (std::size_t i = 0; i < k * k; ++i) A[i] = Hk[i];
+    for (std::size_t i = 0; i < k; ++i) A[i * k + i] -= u * (1.0 + 1e-10);
+    DenseLUT<Complex> lu;
+    double res = 0.0;
+    if (lu.factor(std::move(A), k)) {
+      std::vector<Complex> y(k, Complex(1.0, 0.0));
+      for (int it = 0; it < 2; ++it) {
+        lu.solve(&y);
+        double nrm = 0.0;
+        for (const Complex &c : y) nrm += std::norm(c);
+        nrm = std::sqrt(nrm);
+        if (!(nrm > 0.0) || !std::isfinite(nrm)) break;
+        for (Complex &c : y) c /= nrm;
       }
+      res = beta * std::abs(y[k - 1]);
     }
+    if (res <= tol * std::abs(u)) out->push_back(shift + 1.0 / u);
   }
-  return found ? signed_val : std::nan("");
+  return !out->empty();
 }
 
-/* Branch-point test function. A branch point (where two equilibrium branches
- * cross) is a point on the curve where the bordered (n+1)x(n+1) matrix
- * [ f_x  f_p ; v^T ] (v = curve tangent) becomes singular, WHILE the
- * equilibrium itself persists. At a regular point this determinant is nonzero;
- * at a fold it stays nonzero (a fold is a turning point, not a crossing). So a
- * sign change of this determinant that is NOT accompanied by a fold-test sign
- * change brackets a branch point. Returns NaN on evaluation failure. */
-double branch_point_test(const Model &m, const double *x, double p,
-                         const std::vector<double> &tangent, std::size_t n) {
-  std::vector<double> J, fp;
+/* continue_equilibrium with settings.matrix_free: see analysis.h. The
+ * bordered system A = [f_x f_p; t^T] is only ever applied, and preconditioned
+ * through its Schur complement with M ~ f_x:
+ *   y = M^{-1} r_1,  w = M^{-1} f_p,  s = (r_2 - t_1.y) / (t_n - t_1.w),
+ *   z = [y - s w; s]. */
+Branch continue_equilibrium_krylov(const Model &m, const std::vector<double> &x0, double p0,
+                                   const ContinuationSettings &settings) {
+  Branch branch;
+  const std::size_t n = m.n, N = n + 1;
+  const KrylovSettings &ks = settings.krylov;
+  CorrectorCounts &cnt = branch.counts;
   std::string err;
-  if (!jacobian_x(m, x, p, &J, &err)) return std::nan("");
-  if (!dfdp(m, x, p, &fp, &err)) return std::nan("");
-  const std::size_t N = n + 1;
-  std::vector<double> A(N * N, 0.0);
-  for (std::size_t r = 0; r < n; ++r) {
-    for (std::size_t c = 0; c < n; ++c) A[r * N + c] = J[r * n + c];
-    A[r * N + n] = fp[r];
+  const double ctol = settings.event_tol * 1e2;
+  /* tangent and eigenvalue solves: about as far as forward-difference
+   * products are accurate, below which GMRES only stagnates */
+  const double inner_tol = std::min(ks.tol, 1e-7);
+
+  /* the linearization point and f, f_p there */
+  std::vector<double> lx(n), f0(n), fp(n), xe(n), fe(n);
+  double lp = 0.0, lxn = 0.0;
+  auto linearize = [&](const std::vector<double> &zz) {
+    lx.assign(zz.begin(), zz.begin() + n);
+    lp = zz[n];
+    lxn = vnorm(lx);
+    return m.vector_field(lx.data(), lp, f0.data(), &err) && dfdp(m, lx.data(), lp, &fp, &err);
+  };
+  /* f_x v from the first n entries of v */
+  KrylovOp jv = [&](const std::vector<double> &v, std::vector<double> *out) {
+    out->resize(n);
+    ++cnt.products;
+    if (m.jacobian_vec) return m.jacobian_vec(lx.data(), lp, v.data(), out->data(), &err);
+    double vn = 0.0;
+    for (std::size_t i = 0; i < n; ++i) vn += v[i] * v[i];
+    vn = std::sqrt(vn);
+    if (vn == 0.0) { std::fill(out->begin(), out->end(), 0.0); return true; }
+    const double eps = 1.4901161193847656e-8 * (1.0 + lxn) / vn;
+    for (std::size_t i = 0; i < n; ++i) xe[i] = lx[i] + eps * v[i];
+    if (!m.vector_field(xe.data(), lp, fe.data(), &err)) return false;
+    for (std::size_t i = 0; i < n; ++i) (*out)[i] = (fe[i] - f0[i]) / eps;
+    return true;
+  };
+
+  /* M^{-1} ~ (f_x - shift I)^{-1}: the model's, else block-Jacobi (taken
+   * once per accepted point), else none */
+  BlockJacobi bj;
+  bool have_bj = false;
+  auto precond = [&](double shift, const double *r, double *out) {
+    if (m.precondition) return m.precondition(lx.data(), lp, shift, r, out, &err);
+    if (have_bj) bj.apply(shift, r, out, &cnt);
+    else std::copy(r, r + n, out);
+    return true;
+  };
+  auto refresh_precond = [&]() {
+    if (m.precondition || ks.block <= 0) return;
+    have_bj = bj.build(n, (std::size_t)ks.block, jv);
+  };
+
+  std::vector<double> border(N), w_fp(n);
+  double schur = 0.0;
+  auto prepare = [&]() {
+    if (!precond(0.0, fp.data(), w_fp.data())) return false;
+    schur = border[n];
+    for (std::size_t i = 0; i < n; ++i) schur -= border[i] * w_fp[i];
+    return true;
+  };
+  KrylovOp bordered = [&](const std::vector<double> &v, std::vector<double> *out) {
+    std::vector<double> t;
+    if (!jv(v, &t)) return false;
+    out->resize(N);
+    for (std::size_t i = 0; i < n; ++i) (*out)[i] = t[i] + fp[i] * v[n];
+    (*out)[n] = vdot(border, v);
+    return true;
+  };
+  KrylovOp bordered_prec = [&](const std::vector<double> &r, std::vector<double> *out) {
+    out->resize(N);
+    if (!precond(0.0, r.data(), out->data())) return false;
+    double s = r[n];
+    for (std::size_t i = 0; i < n; ++i) s -= border[i] * (*out)[i];
+    if (std::fabs(schur) > 1e-12 * (std::fabs(border[n]) + std::fabs(border[n] - schur))) {
+      s /= schur;
+      for (std::size_t i = 0; i < n; ++i) (*out)[i] -= s * w_fp[i];
+    } else {
+      s = r[n];
+    }
+    (*out)[n] = s;
+    return true;
+  };
+  auto bsolve = [&](const std::vector<double> &rhs, std::vector<double> *sol, double tol, double *rr) {
+    sol->assign(N, 0.0);
+    return gmres(bordered, bordered_prec, rhs, sol, ks.restart, ks.max_iters, tol, rr, &cnt.krylov_iterations);
+  };
+
+  /* Newton on G(z) = [f(x,p); tan.(z - z_pred)] with inexact GMRES steps;
+   * leaves the linearization at the returned point */
+  auto corrector = [&](std::vector<double> *zc, const std::vector<double> &z_pred,
+                       const std::vector<double> &tan) -> bool {
+    border = tan;
+    std::vector<double> G(N), dz;
+    for (int it = 0;; ++it) {
+      if (!linearize(*zc)) return false;
+      double arc = 0.0;
+      for (std::size_t i = 0; i < N; ++i) arc += tan[i] * ((*zc)[i] - z_pred[i]);
+      for (std::size_t i = 0; i < n; ++i) G[i] = -f0[i];
+      G[n] = -arc;
+      if (vnorm(G) < settings.corrector_tol) return true;
+      if (it == settings.max_corrector_iters || !prepare()) return false;
+      ++cnt.iterations;
+      double rr = 0.0;
+      if (!bsolve(G, &dz, ks.tol, &rr) || !(rr < 0.5)) return false;
+      for (std::size_t i = 0; i < N; ++i) (*zc)[i] += dz[i];
+      if (!is_finite_vec(*zc)) return false;
+    }
+  };
+
+  /* A^{-1} e_last at the linearization point, bordered with prev: the next
+   * tangent before normalization, and its p-component the fold test */
+  auto raw_tangent = [&](const std::vector<double> &prev, std::vector<double> *t) {
+    border = prev;
+    if (!prepare()) return false;
+    std::vector<double> e(N, 0.0);
+    e[n] = 1.0;
+    double rr = 0.0;
+    return bsolve(e, t, inner_tol, &rr) && rr < 1e2 * inner_tol && is_finite_vec(*t);
+  };
+
+  /* the ks.n_eigs eigenvalues of f_x nearest ks.shift at the linearization
+   * point, by shift-invert Arnoldi with GMRES inner solves */
+  struct KSpec {
+    bool ok = false;
+    std::vector<Complex> eigenvalues;
+    int n_unstable = 0, n_center = 0;
+  };
+  auto spectrum = [&](KSpec *s) {
+    s->ok = false;
+    s->eigenvalues.clear();
+    const double sigma = ks.shift;
+    const std::size_t kmax = std::min<std::size_t>((std::size_t)std::max(ks.arnoldi_dim, 2), n);
+    KrylovOp op = [&](const std::vector<double> &v, std::vector<double> *out) {
+      if (!jv(v, out)) return false;
+      for (std::size_t i = 0; i < n; ++i) (*out)[i] -= sigma * v[i];
+      return true;
+    };
+    KrylovOp pc = [&](const std::vector<double> &r, std::vector<double> *out) {
+      out->resize(n);
+      return precond(sigma, r.data(), out->data());
+    };
+    std::vector<std::vector<double>> V(1, std::vector<double>(n));
+    for (std::size_t i = 0; i < n; ++i) V[0][i] = std::sin(1.0 + 2.0 * i);
+    const double v0 = vnorm(V[0]);
+    for (double &v : V[0]) v /= v0;
+    std::vector<double> H((kmax + 1) * kmax, 0.0), w;
+    std::size_t k = 0;
+    double beta = 0.0;
+    while (k < kmax) {
+      double rr = 0.0;
+      w.assign(n, 0.0);
+      if (!gmres(op, pc, V[k], &w, ks.restart, ks.max_iters, inner_tol, &rr, &cnt.krylov_iterations) ||
+          !(rr < 1e2 * inner_tol))
+        return false;
+      for (int pass = 0; pass < 2; ++pass)
+        for (std::size_t j = 0; j <= k; ++j) {
+          const double h = vdot(w, V[j]);
+          H[j * kmax + k] += h;
+          for (std::size_t i = 0; i < n; ++i) w[i] -= h * V[j][i];
+        }
+      beta = vnorm(w);
+      H[(k + 1) * kmax + k] = beta;
+      ++k;
+      if (!(beta > 1e-12 * std::fabs(H[(k - 1) * kmax + k - 1]) + 1e-300)) { beta = 0.0; break; }
+      for (double &v : w) v /= beta;
+      V.push_back(w);
+    }
+    std::vector<Complex> ev;
+    if (!shift_invert_ritz(H, kmax, k, beta, sigma, std::max(1e-6, 1e2 * inner_tol), &ev)) return false;
+    std::size_t keep = std::min<std::size_t>(ev.size(), (std::size_t)std::max(ks.n_eigs, 1));
+    /* do not split a conjugate pair at the cut */
+    if (keep < ev.size() && std::fabs(ev[keep - 1].imag()) > ctol &&
+        std::abs(ev[keep] - std::conj(ev[keep - 1])) < 1e-6 * (1.0 + std::abs(ev[keep])))
+      ++keep;
+    ev.resize(keep);
+    for (const Complex &lam : ev) {
+      if (lam.real() > ctol) ++s->n_unstable;
+      else if (lam.real() >= -ctol) ++s->n_center;
+    }
+    s->eigenvalues = std::move(ev);
+    s->ok = true;
+    return true;
+  };
+  /* the eigenvalue of s with Im > 0 nearest ref; none when s has no pair */
+  auto nearest_pair = [&](const KSpec &s, Complex ref, Complex *out) {
+    double best = 1e300;
+    for (const Complex &lam : s.eigenvalues)
+      if (lam.imag() > ctol && std::abs(lam - ref) < best) { best = std::abs(lam - ref); *out = lam; }
+    return best < 1e300;
+  };
+
+  auto record_point = [&](const std::vector<double> &zz, SpecialPointKind kind, const KSpec &s) {
+    BranchPoint bp;
+    bp.p = zz[n];
+    bp.x.assign(zz.begin(), zz.begin() + n);
+    bp.eigenvalues = s.eigenvalues;
+    bp.n_unstable = s.n_unstable;
+    bp.stable = s.n_unstable == 0 && s.n_center == 0;
+    bp.special = kind;
+    if (kind != SpecialPointKind::None) branch.special_indices.push_back(branch.points.size());
+    branch.points.push_back(std::move(bp));
+  };
+  /* the spectrum at a special point; stability carried from `carry` if the
+   * eigen-solve fails */
+  auto spectrum_at = [&](const std::vector<double> &zz, const KSpec &carry) {
+    KSpec s;
+    if (!linearize(zz) || !spectrum(&s)) { s = carry; s.eigenvalues.clear(); }
+    return s;
+  };
+
+  /* Locate an event between the accepted points za and zb from test values
+   * ga, gb of opposite sign: Illinois (modified regula falsi) on the chord,
+   * each iterate re-corrected onto the branch. */
+  auto refine_event = [&](const std::vector<double> &za, const std::vector<double> &zb, double ga, double gb,
+                          const std::function<bool(const std::vector<double> &, double *)> &g,
+                          const std::vector<double> &tan, std::vector<double> *z_out) {
+    std::vector<double> a = za, b = zb, c, prev = zb;
+    int side = 0;
+    *z_out = zb;
+    for (int it = 0; it < 40; ++it) {
+      const double w = ga / (ga - gb);
+      c.resize(N);
+      for (std::size_t i = 0; i < N; ++i) c[i] = a[i] + w * (b[i] - a[i]);
+      const std::vector<double> c_pred = c;
+      double gc = 0.0;
+      if (!corrector(&c, c_pred, tan) || !g(c, &gc) || !std::isfinite(gc)) return;
+      *z_out = c;
+      double step = 0.0;
+      for (std::size_t i = 0; i < N; ++i) step = std::max(step, std::fabs(c[i] - prev[i]));
+      if (gc == 0.0 || step <= 1e2 * settings.event_tol) return;
+      prev = c;
+      if (gc * gb > 0.0) {
+        b = c; gb = gc;
+        if (side == 1) ga *= 0.5;
+        side = 1;
+      } else {
+        a = c; ga = gc;
+        if (side == -1) gb *= 0.5;
+        side = -1;
+      }
+    }
+  };
+
+  /* Correct the start at fixed p (border e_last) and take its tangent. */
+  std::vector<double> z(N), e_last(N, 0.0);
+  std::copy(x0.begin(), x0.end(), z.begin());
+  z[n] = p0;
+  e_last[n] = 1.0;
+  if (linearize(z)) refresh_precond();
+  const std::vector<double> z_start = z;
+  if (!corrector(&z, z_start, e_last)) {
+    branch.message = "no equilibrium found from this start — Newton-Krylov did not converge (" +
+                     (err.empty() ? std::string("residual too large") : err) + ")";
+    return branch;
   }
-  /* last row: the curve tangent (length N). If unavailable, fall back to e_last. */
-  if (tangent.size() == N)
-    for (std::size_t c = 0; c < N; ++c) A[n * N + c] = tangent[c];
-  else
-    A[n * N + n] = 1.0;
-  return determinant(A, N);
+  refresh_precond();
+  std::vector<double> tangent, raw;
+  if (!raw_tangent(e_last, &raw)) {
+    branch.message = "could not compute initial tangent (singular system)";
+    return branch;
+  }
+  tangent = raw;
+  {
+    const double nrm = vnorm(tangent);
+    const double sgn = (tangent[n] < 0.0) == (settings.direction < 0) ? 1.0 : -1.0;
+    for (double &v : tangent) v *= sgn / nrm;
+  }
+  KSpec spec;
+  spectrum(&spec);
+  record_point(z, SpecialPointKind::None, spec);
+
+  double h = settings.h0;
+  int produced = 1;
+  while (produced < settings.max_points) {
+    std::vector<double> z_pred(N);
+    for (std::size_t i = 0; i < N; ++i) z_pred[i] = z[i] + h * tangent[i];
+    std::vector<double> z_new = z_pred;
+    if (!corrector(&z_new, z_pred, tangent)) {
+      h *= 0.5;
+      if (h < settings.h_min) {
+        branch.message = "corrector failed; step underflow";
+        break;
+      }
+      continue;
+    }
+    if (z_new[n] < settings.p_min || z_new[n] > settings.p_max) {
+      branch.message = "reached parameter bound";
+      record_point(z_new, SpecialPointKind::EndOfBranch, spectrum_at(z_new, spec));
+      break;
+    }
+
+    /* tangent (fold test) and spectrum at the new point, from the
+     * linearization the corrector left there */
+    refresh_precond();
+    if (!raw_tangent(tangent, &raw)) {
+      branch.message = "tangent went singular (possible bifurcation); stopping";
+      break;
+    }
+    KSpec spec_new;
+    if (!spectrum(&spec_new)) { spec_new = spec; spec_new.ok = false; spec_new.eigenvalues.clear(); }
+
+    const std::vector<double> tan_ev = tangent;
+    if (settings.detect_fold && tangent[n] * raw[n] < 0.0) {
+      auto g = [&](const std::vector<double> &, double *out) {
+        std::vector<double> t;
+        if (!raw_tangent(tan_ev, &t)) return false;
+        *out = t[n];
+        return true;
+      };
+      double ga = 0.0, gb = 0.0;
+      std::vector<double> z_ev = z_new;
+      if (linearize(z) && g(z, &ga) && linearize(z_new) && g(z_new, &gb) && ga * gb < 0.0)
+        refine_event(z, z_new, ga, gb, g, tan_ev, &z_ev);
+      record_point(z_ev, SpecialPointKind::Fold, spectrum_at(z_ev, spec_new));
+    }
+    /* a pair crosses when the Ritz value nearest the axis at the new point
+     * and its counterpart at the old one differ in the sign of Re */
+    Complex lam_new(0.0, 0.0), lam_old;
+    for (const Complex &lam : spec_new.eigenvalues)
+      if (lam.imag() > ctol && (lam_new.imag() == 0.0 || std::fabs(lam.real()) < std::fabs(lam_new.real())))
+        lam_new = lam;
+    if (settings.detect_hopf && spec.ok && spec_new.ok && lam_new.imag() != 0.0) {
+      if (nearest_pair(spec, lam_new, &lam_old) && lam_old.real() * lam_new.real() < 0.0) {
+        Complex ref = lam_new;
+        auto g = [&](const std::vector<double> &, double *out) {
+          KSpec s;
+          Complex lam;
+          if (!spectrum(&s) || !nearest_pair(s, ref, &lam)) return false;
+          ref = lam;
+          *out = lam.real();
+          return true;
+        };
+        std::vector<double> z_ev = z_new;
+        refine_event(z, z_new, lam_old.real(), lam_new.real(), g, tan_ev, &z_ev);
+        record_point(z_ev, SpecialPointKind::Hopf, spectrum_at(z_ev, spec_new));
+      }
+    }
+
+    record_point(z_new, SpecialPointKind::None, spec_new);
+    ++produced;
+    /* raw.tangent = 1, so it already points along the branch */
+    const double nrm = vnorm(raw);
+    for (std::size_t i = 0; i < N; ++i) tangent[i] = raw[i] / nrm;
+    z = z_new;
+    spec = spec_new;
+    h = std::min(settings.h_max, h * 1.2);
+  }
+
+  if (branch.message.empty())
+    branch.message = "completed (" + std::to_string(produced) + " points)";
+  branch.ok = branch.points.size() > 1;
+  return branch;
 }
 
 }  // namespace
@@ -548,6 +1257,7 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
     branch.message = "starting point dimension mismatch";
     return branch;
   }
+  if (settings.matrix_free) return continue_equilibrium_krylov(m, x0, p0, settings);
 
   std::string err;
 
@@ -568,6 +1278,28 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
   std::vector<double> z(N);
   for (std::size_t i = 0; i < n; ++i) z[i] = x[i];
   z[n] = p0;
+  const double ctol = settings.event_tol * 1e2;
+
+  /* Stability of regular points. The spectrum is computed on demand: at the
+   * start, at special points, after every event and every kSpectrumEvery
+   * points. In between the unstable count cannot change without a fold or
+   * Hopf event, so it is carried forward (eigenvalues left empty). */
+  struct Spectrum {
+    bool fresh = false;
+    std::vector<Complex> eigenvalues;
+    int n_unstable = 0;
+    int n_right = 0;  /* Re > 0 exactly: changes only at a crossing */
+    bool stable = false;
+  } spec;
+  auto classify_at = [&](const std::vector<double> &J) {
+    Classification cl = classify_equilibrium(J, n, ctol);
+    spec.fresh = true;
+    spec.eigenvalues = cl.eigenvalues;
+    spec.n_unstable = cl.n_unstable;
+    spec.n_right = 0;
+    for (const Complex &lam : cl.eigenvalues) spec.n_right += lam.real() > 0.0;
+    spec.stable = cl.n_unstable == 0 && cl.n_center == 0;
+  };
 
   auto record_point = [&](const std::vector<double> &zz,
                           SpecialPointKind kind) {
@@ -575,8 +1307,12 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
     bp.p = zz[n];
     bp.x.assign(zz.begin(), zz.begin() + n);
     std::vector<double> J;
-    if (jacobian_x(m, bp.x.data(), bp.p, &J, &err)) {
-      Classification cl = classify_equilibrium(J, n, settings.event_tol * 1e2);
+    if (kind == SpecialPointKind::None) {
+      if (spec.fresh) bp.eigenvalues = spec.eigenvalues;
+      bp.n_unstable = spec.n_unstable;
+      bp.stable = spec.stable;
+    } else if (jacobian_x(m, bp.x.data(), bp.p, &J, &err)) {
+      Classification cl = classify_equilibrium(J, n, ctol);
       bp.eigenvalues = cl.eigenvalues;
       bp.n_unstable = cl.n_unstable;
       bp.stable = cl.n_unstable == 0 && cl.n_center == 0;
@@ -609,38 +1345,18 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
     branch.points.push_back(std::move(bp));
   };
 
-  /* Initial tangent: solve the bordered system for the null vector of
-   * [ f_x | f_p ]. We build [f_x f_p; e_last^T] tangent = e_last and
-   * normalize. The last component sign sets the initial direction. */
-  auto compute_tangent = [&](const std::vector<double> &zz,
-                             const std::vector<double> &prev_tan,
-                             std::vector<double> *tan) -> bool {
-    std::vector<double> J, fp;
-    std::vector<double> xx(zz.begin(), zz.begin() + n);
-    if (!jacobian_x(m, xx.data(), zz[n], &J, &err)) return false;
-    if (!dfdp(m, xx.data(), zz[n], &fp, &err)) return false;
-    /* Augmented (n+1)x(n+1): rows 0..n-1 are [J | fp];
-     * last row is the previous tangent (or e_last on the first call)
-     * to fix the scale and pick a consistent direction. */
-    std::vector<double> A(N * N, 0.0), b(N, 0.0);
-    for (std::size_t r = 0; r < n; ++r) {
-      for (std::size_t c = 0; c < n; ++c) A[r * N + c] = J[r * n + c];
-      A[r * N + n] = fp[r];
-    }
-    if (prev_tan.empty()) {
-      A[n * N + n] = 1.0;  /* e_last */
-      b[n] = 1.0;
-    } else {
-      for (std::size_t c = 0; c < N; ++c) A[n * N + c] = prev_tan[c];
-      b[n] = 1.0;
-    }
-    if (!solve_linear(A, b, tan)) return false;
+  /* the next tangent from the bordered tests at a point: normalized, and
+   * oriented along the previous tangent (or by settings.direction at the
+   * start) */
+  auto orient_tangent = [&](const std::vector<double> &raw,
+                            const std::vector<double> &prev_tan,
+                            std::vector<double> *tan) -> bool {
+    *tan = raw;
     double norm = 0.0;
     for (double v : *tan) norm += v * v;
     norm = std::sqrt(norm);
     if (norm < 1e-300) return false;
     for (double &v : *tan) v /= norm;
-    /* Keep direction consistent with the previous tangent. */
     if (!prev_tan.empty()) {
       double dot = 0.0;
       for (std::size_t i = 0; i < N; ++i) dot += (*tan)[i] * prev_tan[i];
@@ -654,51 +1370,78 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
     return true;
   };
 
+  /* Initial tangent: the null vector of [f_x | f_p], from the bordered
+   * system with e_last as its last row. */
   std::vector<double> tangent;
-  std::vector<double> empty_prev;
-  if (!compute_tangent(z, empty_prev, &tangent)) {
+  BorderedTests bt;
+  if (!bordered_tests(m, x.data(), p0, {}, &bt) || !orient_tangent(bt.tan, {}, &tangent)) {
     branch.message = "could not compute initial tangent (singular system)";
     return branch;
   }
+  /* the start's tests, bordered with the tangent as every later point is */
+  bordered_tests(m, x.data(), p0, tangent, &bt);
+  classify_at(bt.J);
+  PairTrack pair;
+  if (settings.detect_hopf) seed_pair(bt.J, n, spec.eigenvalues, ctol, &pair);
 
   record_point(z, SpecialPointKind::None);
-  double prev_fold = fold_test(m, x.data(), p0);
-  double prev_hopf = hopf_test(m, x.data(), p0, settings.event_tol * 1e2);
-  double prev_bp = branch_point_test(m, x.data(), p0, tangent, n);
+  double prev_fold = bt.fold;
+  double prev_hopf = pair.on ? pair.lam.real() : std::nan("");
+  double prev_bp = bt.bp;
+  std::vector<double> J_prev = bt.J;
 
   double h = settings.h0;
 
-  /* Corrector: Newton on G(z) = [f(x,p); tangent.(z - z_pred) - 0]
-   * where the predicted point is z_pred = z + h*tangent and the
-   * pseudo-arclength condition pins the step. */
+  /* Corrector on G(z) = [f(x,p); tangent.(z - z_pred) - 0] where the
+   * predicted point is z_pred = z + h*tangent and the pseudo-arclength
+   * condition pins the step. The factorization of [f_x f_p; tangent^T] is
+   * held between calls: chord and Broyden start each step from f_x, f_p of
+   * the last point they were evaluated at (the accepted point's, from its
+   * bordered tests), refactored with the new tangent row. */
+  std::vector<double> J_held = bt.J, fp_held = bt.fp, tan_held;
+  DenseLU lu_held;
+  bool held = false;
+  auto factor_held = [&](const std::vector<double> &tan) {
+    std::vector<double> A(N * N, 0.0);
+    for (std::size_t r = 0; r < n; ++r) {
+      for (std::size_t c = 0; c < n; ++c) A[r * N + c] = J_held[r * n + c];
+      A[r * N + n] = fp_held[r];
+    }
+    for (std::size_t c = 0; c < N; ++c) A[n * N + c] = tan[c];
+    tan_held = tan;
+    held = lu_held.factor(std::move(A), N);
+    return held;
+  };
+  QNCorrector qn;
+  qn.kind = settings.corrector;
+  qn.contraction = settings.contraction;
+  qn.iters = settings.max_corrector_iters;
+  qn.tol = settings.corrector_tol;
+  qn.counts = &branch.counts;
   auto corrector = [&](std::vector<double> *zc,
                        const std::vector<double> &z_pred,
                        const std::vector<double> &tan) -> bool {
-    std::vector<double> J, fp, f(n);
-    for (int it = 0; it < settings.max_corrector_iters; ++it) {
-      std::vector<double> xx(zc->begin(), zc->begin() + n);
-      const double pp = (*zc)[n];
-      if (!m.vector_field(xx.data(), pp, f.data(), &err)) return false;
-      double arc = 0.0;
-      for (std::size_t i = 0; i < N; ++i) arc += tan[i] * ((*zc)[i] - z_pred[i]);
-      double res = arc * arc;
-      for (double v : f) res += v * v;
-      if (std::sqrt(res) < settings.corrector_tol) return true;
-      if (!jacobian_x(m, xx.data(), pp, &J, &err)) return false;
-      if (!dfdp(m, xx.data(), pp, &fp, &err)) return false;
-      std::vector<double> A(N * N, 0.0), b(N, 0.0);
-      for (std::size_t r = 0; r < n; ++r) {
-        for (std::size_t c = 0; c < n; ++c) A[r * N + c] = J[r * n + c];
-        A[r * N + n] = fp[r];
-        b[r] = -f[r];
-      }
-      for (std::size_t c = 0; c < N; ++c) A[n * N + c] = tan[c];
-      b[n] = -arc;
-      std::vector<double> delta;
-      if (!solve_linear(A, b, &delta)) return false;
-      for (std::size_t i = 0; i < N; ++i) (*zc)[i] += delta[i];
+    if (settings.corrector != CorrectorKind::Newton && (!held || tan_held != tan)) {
+      factor_held(tan);
+      ++branch.counts.factorizations;
     }
-    return false;
+    std::vector<double> f(n);
+    auto residual = [&](const std::vector<double> &zz, std::vector<double> *G) {
+      if (!m.vector_field(zz.data(), zz[n], f.data(), &err)) return false;
+      G->assign(f.begin(), f.end());
+      double arc = 0.0;
+      for (std::size_t i = 0; i < N; ++i) arc += tan[i] * (zz[i] - z_pred[i]);
+      G->push_back(arc);
+      return true;
+    };
+    auto refresh = [&](const std::vector<double> &zz) {
+      return jacobian_x(m, zz.data(), zz[n], &J_held, &err) && dfdp(m, zz.data(), zz[n], &fp_held, &err) &&
+             factor_held(tan);
+    };
+    bool converged = false;
+    return qn_correct(qn, zc, held, residual, refresh, [&](std::vector<double> *v) { lu_held.solve(v); },
+                      &converged) &&
+           converged;
   };
 
   /* Refine an event bracketed between z_lo and z_hi (both corrected
@@ -751,7 +1494,64 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
     return true;
   };
 
-  int produced = 1;
+  /* Re-seed the Hopf pair from the spectrum just computed at the current
+   * point. When that picks a different pair, its value at the previous point
+   * is tracked too, so the sign comparison stays within one pair. Returns
+   * whether the pair changed. */
+  auto reseed_pair = [&](const std::vector<double> &J_new) -> bool {
+    if (!settings.detect_hopf) return false;
+    const PairTrack old = pair;
+    PairTrack fresh;
+    seed_pair(J_new, n, spec.eigenvalues, ctol, &fresh);
+    if (fresh.on && old.on && std::abs(fresh.lam - old.lam) < 1e-6 * (1.0 + std::abs(old.lam))) return false;
+    if (!fresh.on && !old.on) return false;
+    pair = fresh;
+    prev_hopf = std::nan("");
+    if (pair.on) {
+      PairTrack back = pair;
+      if (track_pair(J_prev, n, ctol, &back)) prev_hopf = back.lam.real();
+    }
+    return true;
+  };
+
+  /* A checkpoint at the last point whose spectrum was computed. If a later
+   * spectrum shows a change of the unstable count that no event accounts for
+   * (a pair other than the tracked one crossed the axis), the branch is
+   * rewound to it and replayed with the spectrum at every point. */
+  const int kSpectrumEvery = 8;
+  struct Checkpoint {
+    std::vector<double> z, tangent, J;
+    double h = 0, fold = 0, hopf = 0, bp = 0;
+    PairTrack pair;
+    std::size_t points = 0, specials = 0;
+    int produced = 0, n_unstable = 0, n_right = 0;
+    bool stable = false;
+  } ck;
+  int produced = 1, since_spectrum = 0, replay_until = 0;
+  auto checkpoint = [&]() {
+    ck.z = z; ck.tangent = tangent; ck.J = J_prev; ck.h = h;
+    ck.fold = prev_fold; ck.hopf = prev_hopf; ck.bp = prev_bp; ck.pair = pair;
+    ck.points = branch.points.size(); ck.specials = branch.special_indices.size();
+    ck.produced = produced; ck.n_unstable = spec.n_unstable; ck.n_right = spec.n_right;
+    ck.stable = spec.stable;
+  };
+  checkpoint();
+  /* whether the change of n_right since the checkpoint is explained by the
+   * events recorded since: a fold or branch point moves one eigenvalue, a
+   * Hopf a pair; other codim-2 labels are not checked */
+  auto accounted = [&]() {
+    int budget = 0;
+    for (std::size_t k = ck.specials; k < branch.special_indices.size(); ++k) {
+      switch (branch.points[branch.special_indices[k]].special) {
+      case SpecialPointKind::Fold: case SpecialPointKind::Cusp: case SpecialPointKind::BranchPoint: budget += 1; break;
+      case SpecialPointKind::Hopf: case SpecialPointKind::GeneralizedHopf: budget += 2; break;
+      default: return true;
+      }
+    }
+    const int d = std::abs(spec.n_right - ck.n_right);
+    return d <= budget && (budget - d) % 2 == 0;
+  };
+
   while (produced < settings.max_points) {
     std::vector<double> z_pred(N);
     for (std::size_t i = 0; i < N; ++i) z_pred[i] = z[i] + h * tangent[i];
@@ -773,45 +1573,75 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
       break;
     }
 
+    /* All per-point tests from one bordered LU at the new point. */
+    std::vector<double> x_new(z_new.begin(), z_new.begin() + n);
+    const bool tests_ok = bordered_tests(m, x_new.data(), p_new, tangent, &bt);
+    const double f_new = tests_ok ? bt.fold : std::nan("");
+    const double bp_new = tests_ok ? bt.bp : std::nan("");
+
+    /* The Hopf test follows the tracked pair; when a re-seed switches pairs,
+     * the one given up is checked for a crossing in this step as well. */
+    spec.fresh = false;
+    double hp_new = std::nan("");
+    PairTrack dropped;
+    double dropped_prev = std::nan(""), dropped_new = std::nan("");
+    bool need_spectrum = ++since_spectrum >= kSpectrumEvery || produced < replay_until;
+    if (tests_ok && pair.on) {
+      PairTrack t = pair;
+      if (track_pair(bt.J, n, ctol, &t)) { pair = t; hp_new = pair.lam.real(); }
+      else need_spectrum = true;
+    }
+    if (tests_ok && need_spectrum) {
+      classify_at(bt.J);
+      const PairTrack before = pair;
+      const double before_prev = prev_hopf, before_new = hp_new;
+      if (reseed_pair(bt.J)) { dropped = before; dropped_prev = before_prev; dropped_new = before_new; }
+      if (pair.on) hp_new = pair.lam.real();
+      since_spectrum = 0;
+    }
+
     /* Event detection between z (old) and z_new. When a test
      * function changes sign we bisect to locate the event precisely
      * and record it as its own tagged point, then record the regular
-     * continuation point. */
-    std::vector<double> x_new(z_new.begin(), z_new.begin() + n);
-
-    /* Compute the branch-point test up front so the fold block can tell a real
-     * fold from a branch point (at a pitchfork the fold test also vanishes, but
-     * the point is a BP, not a fold/cusp). */
-    const double bp_new_pre = branch_point_test(m, x_new.data(), p_new, tangent, n);
-    const bool bp_coincides = std::isfinite(prev_bp) && std::isfinite(bp_new_pre) &&
-                              prev_bp * bp_new_pre < 0.0;
+     * continuation point. A fold sign change that coincides with a
+     * branch-point sign change is the branch point (at a pitchfork
+     * det f_x also vanishes), not a fold/cusp. */
+    const bool bp_coincides = std::isfinite(prev_bp) && std::isfinite(bp_new) &&
+                              prev_bp * bp_new < 0.0;
+    const std::size_t specials_before = branch.special_indices.size();
+    const std::vector<double> tan_ev = tangent;
+    BorderedTests scratch;
+    auto fold_g = [&](const double *xx, double pp) {
+      return bordered_tests(m, xx, pp, tan_ev, &scratch) ? scratch.fold : std::nan("");
+    };
+    auto bp_g = [&](const double *xx, double pp) {
+      return bordered_tests(m, xx, pp, tan_ev, &scratch) ? scratch.bp : std::nan("");
+    };
 
     if (settings.detect_fold) {
-      const double f_new = fold_test(m, x_new.data(), p_new);
       if (std::isfinite(prev_fold) && std::isfinite(f_new) &&
           prev_fold * f_new < 0.0 && !bp_coincides) {
         std::vector<double> z_ev = z_new;
-        auto g = [&](const double *xx, double pp) {
-          return fold_test(m, xx, pp);
-        };
-        refine_event(z, z_new, g, tangent, &z_ev);
+        refine_event(z, z_new, fold_g, tangent, &z_ev);
         record_point(z_ev, SpecialPointKind::Fold);
       }
       prev_fold = f_new;
     }
     if (settings.detect_hopf) {
-      const double hp_new = hopf_test(m, x_new.data(), p_new,
-                                      settings.event_tol * 1e2);
-      if (std::isfinite(prev_hopf) && std::isfinite(hp_new) &&
-          prev_hopf * hp_new < 0.0) {
+      auto hopf_event = [&](double before, double after, const PairTrack &pair_ev) {
+        if (!std::isfinite(before) || !std::isfinite(after) || before * after >= 0.0) return;
         std::vector<double> z_ev = z_new;
-        const double htol = settings.event_tol * 1e2;
-        auto g = [&, htol](const double *xx, double pp) {
-          return hopf_test(m, xx, pp, htol);
+        auto g = [&](const double *xx, double pp) {
+          PairTrack t = pair_ev;
+          std::vector<double> J;
+          if (!jacobian_x(m, xx, pp, &J, &err) || !track_pair(J, n, ctol, &t)) return std::nan("");
+          return t.lam.real();
         };
         refine_event(z, z_new, g, tangent, &z_ev);
         record_point(z_ev, SpecialPointKind::Hopf);
-      }
+      };
+      hopf_event(dropped_prev, dropped_new, dropped);
+      hopf_event(prev_hopf, hp_new, pair);
       prev_hopf = hp_new;
     }
 
@@ -820,13 +1650,9 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
      * locate it, compute the SECOND tangent (the other branch's direction) for
      * branch switching, and tag the point. */
     {
-      const double bp_new = bp_new_pre;
       if (std::isfinite(prev_bp) && std::isfinite(bp_new) && prev_bp * bp_new < 0.0) {
         std::vector<double> z_ev = z_new;
-        auto g = [&](const double *xx, double pp) {
-          return branch_point_test(m, xx, pp, tangent, n);
-        };
-        refine_event(z, z_new, g, tangent, &z_ev);
+        refine_event(z, z_new, bp_g, tangent, &z_ev);
         /* second tangent: a direction in the null space of [f_x f_p] that is
          * independent of the current curve tangent. Solve the bordered system
          * with the RHS picking out a complementary direction, then orthogonal-
@@ -892,6 +1718,28 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
       prev_bp = bp_new;
     }
 
+    /* after an event the carried stability is stale: take the spectrum here */
+    const bool had_event = branch.special_indices.size() != specials_before;
+    if (tests_ok && had_event && !spec.fresh) {
+      classify_at(bt.J);
+      reseed_pair(bt.J);
+      prev_hopf = pair.on ? pair.lam.real() : std::nan("");
+      since_spectrum = 0;
+    }
+
+    if (spec.fresh && produced >= replay_until && !accounted()) {
+      /* rewind and replay with the spectrum at every point */
+      replay_until = produced + 1;
+      branch.points.resize(ck.points);
+      branch.special_indices.resize(ck.specials);
+      z = ck.z; tangent = ck.tangent; J_prev = ck.J; h = ck.h;
+      prev_fold = ck.fold; prev_hopf = ck.hopf; prev_bp = ck.bp; pair = ck.pair;
+      produced = ck.produced; spec.n_unstable = ck.n_unstable; spec.n_right = ck.n_right;
+      spec.stable = ck.stable;
+      since_spectrum = 0;
+      continue;
+    }
+
     record_point(z_new, SpecialPointKind::None);
     ++produced;
 
@@ -900,13 +1748,18 @@ Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
      * keep it. (We approximate "easily" by always nudging up; the
      * retry path above handles hard cases by shrinking.) */
     std::vector<double> new_tan;
-    if (!compute_tangent(z_new, tangent, &new_tan)) {
+    if (!tests_ok || !orient_tangent(bt.tan, tangent, &new_tan)) {
       branch.message = "tangent went singular (possible bifurcation); stopping";
       break;
     }
     z = z_new;
     tangent = new_tan;
+    J_prev = bt.J;
+    J_held = bt.J;
+    fp_held = bt.fp;
+    held = false;
     h = std::min(settings.h_max, h * 1.2);
+    if (spec.fresh) checkpoint();
   }
 
   if (branch.message.empty())
@@ -970,176 +1823,679 @@ Branch switch_branch(const Model &m, const BranchPoint &bp,
 /* ---- two-parameter continuation of fold/Hopf curves --------------------- */
 namespace {
 
-/* the codim-1 defining function g(x,p,q): det(f_x) for a fold; for Hopf, the
- * minimum |Re| over complex pairs signed by Re (zero when a pair is on the
- * imaginary axis). Built on finite-difference Jacobians of the 2-param field. */
-double g_fold2(const Model2 &m, const std::vector<double> &x, double p, double q) {
-  const std::size_t n = m.n;
-  std::vector<double> J(n * n);
-  std::vector<double> f0(n), fp(n);
-  std::string err;
-  if (!m.vector_field(x.data(), p, q, f0.data(), &err)) return std::nan("");
-  const double h = 1e-7;
-  std::vector<double> xt = x;
-  for (std::size_t j = 0; j < n; ++j) {
-    const double save = xt[j]; const double dh = h * (std::fabs(save) + 1.0);
-    xt[j] = save + dh;
-    if (!m.vector_field(xt.data(), p, q, fp.data(), &err)) return std::nan("");
-    for (std::size_t i = 0; i < n; ++i) J[i * n + j] = (fp[i] - f0[i]) / dh;
-    xt[j] = save;
+/* Fold and Hopf curves, and the codim-2 curves further down, are continued on
+ * minimally augmented systems (Govaerts): f = 0 closed by test functions read
+ * off bordered matrices. A block borders an n x n matrix A(x, parameters),
+ *
+ *     [ A    B ] [ V ]   [ 0 ]
+ *     [ C^T  0 ] [ G ] = [ I ]        B, C: n x k borders
+ *
+ * and the k x k G vanishes exactly where A has a k-dimensional kernel:
+ *   Fold    A = f_x                 k = 1   a zero eigenvalue
+ *   Square  A = f_x^2               k = 2   a double zero (Bogdanov-Takens)
+ *   Hopf    A = f_x^2 + kappa I     k = 2   eigenvalues +-i sqrt(kappa), with
+ *                                           kappa an extra unknown
+ * For k = 2 only two entries of G are independent conditions; the two whose
+ * gradients are most independent of the other rows are kept. Gradients come
+ * from the adjoint solution W: G_z = -W^T A_z V, and by the symmetry of second
+ * derivatives w^T (d f_x / d x_l) u is the l-th entry of (D_u f_x)^T w, with
+ * D_u f_x the derivative of the Jacobian along u. A Newton step thus costs f_x
+ * at x, two more per direction u and two per parameter (exact when the model
+ * has jacobian_x, as the app's AD does) and one LU per block: no determinants,
+ * no eigenvalues and no differences of whole defining systems.
+ * The unknowns are U = [x, parameters, kappa of each Hopf block]. */
+enum class BorderKind { Fold, Square, Hopf };
+
+struct BorderBlock {
+  BorderKind kind = BorderKind::Fold;
+  std::size_t kappa = 0;        /* Hopf: index of kappa in U */
+  std::vector<double> B, C;     /* borders, n x k row-major */
+  int e0 = 0, e1 = 1;           /* k = 2: the entries of G kept, as i*2 + j */
+  std::vector<double> V, W, G;  /* last solve: V, W n x k, G k x k */
+  std::size_t k() const { return kind == BorderKind::Fold ? 1 : 2; }
+};
+
+struct MinAugSys {
+  std::size_t n = 0, np = 0;    /* state dimension, parameter count */
+  std::function<bool(const double *x, const double *par, double *f)> field;
+  /* optional: exact f_x and df/dpar[0]; finite differences when null */
+  std::function<bool(const double *x, const double *par, double *J)> jac;
+  std::function<bool(const double *x, const double *par, double *out)> dfdp0;
+  std::vector<BorderBlock> blocks;
+  bool cusp = false;            /* extra row: the fold coefficient of blocks[0] */
+  std::size_t unknowns() const {
+    std::size_t u = n + np;
+    for (const BorderBlock &b : blocks) u += b.kind == BorderKind::Hopf;
+    return u;
   }
-  return determinant(J, n);
+  std::size_t equations() const {
+    std::size_t r = n + (cusp ? 1 : 0);
+    for (const BorderBlock &b : blocks) r += b.k();
+    return r;
+  }
+};
+
+struct MinAugEval {
+  std::vector<double> F, DF, J;         /* DF: equations() x unknowns() */
+  std::vector<std::vector<double>> dG;  /* per block: k*k gradient rows */
+};
+
+MinAugSys minaug_sys(const Model2 &m) {
+  MinAugSys s; s.n = m.n; s.np = 2;
+  s.field = [&m](const double *x, const double *a, double *f) {
+    std::string e; return m.vector_field(x, a[0], a[1], f, &e);
+  };
+  if (m.jacobian_x)
+    s.jac = [&m](const double *x, const double *a, double *J) {
+      std::string e; return m.jacobian_x(x, a[0], a[1], J, &e);
+    };
+  if (m.dfdp)
+    s.dfdp0 = [&m](const double *x, const double *a, double *o) {
+      std::string e; return m.dfdp(x, a[0], a[1], o, &e);
+    };
+  return s;
 }
 
-double g_hopf2(const Model2 &m, const std::vector<double> &x, double p, double q) {
-  const std::size_t n = m.n;
-  std::vector<double> J(n * n), f0(n), fp(n);
-  std::string err;
-  if (!m.vector_field(x.data(), p, q, f0.data(), &err)) return std::nan("");
-  const double h = 1e-7;
-  std::vector<double> xt = x;
-  for (std::size_t j = 0; j < n; ++j) {
-    const double save = xt[j]; const double dh = h * (std::fabs(save) + 1.0);
-    xt[j] = save + dh;
-    if (!m.vector_field(xt.data(), p, q, fp.data(), &err)) return std::nan("");
-    for (std::size_t i = 0; i < n; ++i) J[i * n + j] = (fp[i] - f0[i]) / dh;
-    xt[j] = save;
-  }
-  std::vector<std::complex<double>> ev;
-  if (!eigenvalues(J, n, &ev)) return std::nan("");
-  bool found = false; double best = 0, sgn = 0;
-  for (const auto &z : ev)
-    if (std::fabs(z.imag()) > 1e-7) {
-      const double a = std::fabs(z.real());
-      if (!found || a < best) { best = a; sgn = z.real(); found = true; }
-    }
-  return found ? sgn : std::nan("");
-}
-
-/* the extended residual G(u) where u = [x(0..n-1), p, q], length n+2.
- * G has n+1 components: f (n of them) and the codim-1 condition g. */
-void G_residual(const Model2 &m, TwoParamKind kind, const std::vector<double> &u,
-                std::vector<double> *out) {
-  const std::size_t n = m.n;
-  std::vector<double> x(u.begin(), u.begin() + n);
-  const double p = u[n], q = u[n + 1];
-  out->assign(n + 1, 0.0);
-  std::string err;
-  std::vector<double> f(n);
-  if (m.vector_field(x.data(), p, q, f.data(), &err))
-    for (std::size_t i = 0; i < n; ++i) (*out)[i] = f[i];
-  (*out)[n] = (kind == TwoParamKind::Fold) ? g_fold2(m, x, p, q) : g_hopf2(m, x, p, q);
+MinAugSys minaug_sys(const Model3 &m) {
+  MinAugSys s; s.n = m.n; s.np = 3;
+  s.field = [&m](const double *x, const double *a, double *f) {
+    std::string e; return m.vector_field(x, a[0], a[1], a[2], f, &e);
+  };
+  if (m.jacobian_x)
+    s.jac = [&m](const double *x, const double *a, double *J) {
+      std::string e; return m.jacobian_x(x, a[0], a[1], a[2], J, &e);
+    };
+  return s;
 }
 
-/* finite-difference Jacobian of G wrt u: (n+1) x (n+2). */
-void G_jacobian(const Model2 &m, TwoParamKind kind, const std::vector<double> &u,
-                std::vector<double> *Jout) {
-  const std::size_t n = m.n, R = n + 1, C = n + 2;
-  Jout->assign(R * C, 0.0);
-  std::vector<double> g0, gp;
-  G_residual(m, kind, u, &g0);
-  std::vector<double> ut = u;
-  for (std::size_t j = 0; j < C; ++j) {
-    const double save = ut[j]; const double dh = 1e-6 * (std::fabs(save) + 1.0);
-    ut[j] = save + dh;
-    G_residual(m, kind, ut, &gp);
-    for (std::size_t i = 0; i < R; ++i) (*Jout)[i * C + j] = (gp[i] - g0[i]) / dh;
-    ut[j] = save;
+bool ma_jac(const MinAugSys &s, const double *x, const double *par, std::vector<double> *J) {
+  const std::size_t n = s.n;
+  J->assign(n * n, 0.0);
+  if (s.jac) return s.jac(x, par, J->data());
+  std::vector<double> xt(x, x + n), fp(n), fm(n);
+  for (std::size_t j = 0; j < n; ++j) {
+    const double h = 1e-6 * (std::fabs(x[j]) + 1.0);
+    xt[j] = x[j] + h;
+    if (!s.field(xt.data(), par, fp.data())) return false;
+    xt[j] = x[j] - h;
+    if (!s.field(xt.data(), par, fm.data())) return false;
+    xt[j] = x[j];
+    for (std::size_t i = 0; i < n; ++i) (*J)[i * n + j] = (fp[i] - fm[i]) / (2 * h);
   }
+  return true;
 }
 
-}  // namespace
-
-TwoParamCurve two_param_curve(const Model2 &m, TwoParamKind kind,
-                              const std::vector<double> &x0, double p0, double q0,
-                              const TwoParamSettings &settings) {
-  TwoParamCurve curve;
-  curve.kind = (kind == TwoParamKind::Fold) ? SpecialPointKind::Fold : SpecialPointKind::Hopf;
-  const std::size_t n = m.n;
-  if (x0.size() != n || n == 0) { curve.message = "bad starting point"; return curve; }
-  const std::size_t C = n + 2;        /* unknowns: x, p, q */
-  const std::size_t Rr = n + 1;       /* equations */
-
-  /* Newton corrector onto G=0 with an arclength constraint (project the step
-   * orthogonal to the current tangent). We use a least-squares solve of the
-   * (n+1) x (n+2) system by appending the tangent row to make it square. */
-  auto correct = [&](std::vector<double> *u, const std::vector<double> &tan) -> bool {
-    for (int it = 0; it < settings.max_corrector_iters; ++it) {
-      std::vector<double> G; G_residual(m, kind, *u, &G);
-      double res = 0; for (double v : G) res += v * v; res = std::sqrt(res);
-      if (res < settings.corrector_tol) return true;
-      std::vector<double> J; G_jacobian(m, kind, *u, &J);
-      /* square (n+2)x(n+2): G-rows + tangent row (=0 in residual) */
-      std::vector<double> A(C * C, 0.0), b(C, 0.0);
-      for (std::size_t i = 0; i < Rr; ++i) {
-        for (std::size_t j = 0; j < C; ++j) A[i * C + j] = J[i * C + j];
-        b[i] = -G[i];
+/* bordered solve of one block at U with Jacobian J: fills V, W, G */
+bool ma_block_solve(const MinAugSys &s, BorderBlock &b, const std::vector<double> &J, const double *U) {
+  const std::size_t n = s.n, k = b.k(), nk = n + k;
+  std::vector<double> M(nk * nk, 0.0);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (b.kind == BorderKind::Fold) {
+      for (std::size_t j = 0; j < n; ++j) M[i * nk + j] = J[i * n + j];
+    } else {
+      for (std::size_t l = 0; l < n; ++l) {
+        const double jil = J[i * n + l];
+        if (jil != 0.0)
+          for (std::size_t j = 0; j < n; ++j) M[i * nk + j] += jil * J[l * n + j];
       }
-      for (std::size_t j = 0; j < C; ++j) A[Rr * C + j] = tan[j];
-      b[Rr] = 0.0;
-      std::vector<double> dz;
-      if (!solve_linear(A, b, &dz)) return false;
-      for (std::size_t j = 0; j < C; ++j) (*u)[j] += dz[j];
-    }
-    std::vector<double> G; G_residual(m, kind, *u, &G);
-    double res = 0; for (double v : G) res += v * v;
-    return std::sqrt(res) < 1e-6;
-  };
-
-  /* tangent: null vector of the (n+1)x(n+2) Jacobian (the curve direction). */
-  auto tangent_of = [&](const std::vector<double> &u, const std::vector<double> &prev,
-                        std::vector<double> *t) -> bool {
-    std::vector<double> J; G_jacobian(m, kind, u, &J);
-    std::vector<double> A(C * C, 0.0), b(C, 0.0);
-    for (std::size_t i = 0; i < Rr; ++i)
-      for (std::size_t j = 0; j < C; ++j) A[i * C + j] = J[i * C + j];
-    if (prev.empty()) { A[Rr * C + (n + 1)] = 1.0; b[Rr] = 1.0; }  /* seed: move in q */
-    else { for (std::size_t j = 0; j < C; ++j) A[Rr * C + j] = prev[j]; b[Rr] = 1.0; }
-    if (!solve_linear(A, b, t)) return false;
-    double nrm = 0; for (double v : *t) nrm += v * v; nrm = std::sqrt(nrm);
-    if (nrm < 1e-300) return false;
-    for (double &v : *t) v /= nrm;
-    if (!prev.empty()) { double d = 0; for (std::size_t j = 0; j < C; ++j) d += (*t)[j]*prev[j];
-      if (d < 0) for (double &v : *t) v = -v; }
+      if (b.kind == BorderKind::Hopf) M[i * nk + i] += U[b.kappa];
+    }
+    for (std::size_t j = 0; j < k; ++j) {
+      M[i * nk + n + j] = b.B[i * k + j];
+      M[(n + j) * nk + i] = b.C[i * k + j];
+    }
+  }
+  DenseLU lu;
+  if (!lu.factor(std::move(M), nk)) return false;
+  b.V.assign(n * k, 0.0); b.W.assign(n * k, 0.0); b.G.assign(k * k, 0.0);
+  std::vector<double> r(nk);
+  for (std::size_t j = 0; j < k; ++j) {
+    std::fill(r.begin(), r.end(), 0.0); r[n + j] = 1.0;
+    lu.solve(&r);
+    for (std::size_t i = 0; i < n; ++i) b.V[i * k + j] = r[i];
+    for (std::size_t i = 0; i < k; ++i) b.G[i * k + j] = r[n + i];
+    std::fill(r.begin(), r.end(), 0.0); r[n + j] = 1.0;
+    lu.solve_t(&r);
+    for (std::size_t i = 0; i < n; ++i) b.W[i * k + j] = r[i];
+  }
+  return is_finite_vec(b.G);
+}
+
+/* the fold (saddle-node) coefficient a = <p, B(q,q)> / 2 of a Fold block,
+ * with q = V / |V| and p = W / <W, q>; B(q,q) is a second difference of f */
+bool ma_fold_coeff(const MinAugSys &s, const BorderBlock &b, const double *U, const double *f0, double *a) {
+  const std::size_t n = s.n;
+  double vn = 0.0, xs = 0.0;
+  for (std::size_t i = 0; i < n; ++i) { vn += b.V[i] * b.V[i]; xs = std::max(xs, std::fabs(U[i])); }
+  vn = std::sqrt(vn);
+  if (!(vn > 0.0)) return false;
+  const double h = 1e-4 * (1.0 + xs);
+  std::vector<double> xt(n), fp(n), fm(n);
+  for (std::size_t i = 0; i < n; ++i) xt[i] = U[i] + h * b.V[i] / vn;
+  if (!s.field(xt.data(), U + n, fp.data())) return false;
+  for (std::size_t i = 0; i < n; ++i) xt[i] = U[i] - h * b.V[i] / vn;
+  if (!s.field(xt.data(), U + n, fm.data())) return false;
+  double wq = 0.0, wb = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    wq += b.W[i] * b.V[i] / vn;
+    wb += b.W[i] * (fp[i] - 2 * f0[i] + fm[i]) / (h * h);
+  }
+  if (!(std::fabs(wq) > 0.0)) return false;
+  *a = 0.5 * wb / wq;
+  return std::isfinite(*a);
+}
+
+/* copy the kept entries of G, and with DF their gradients, into the block rows */
+void ma_rows(const MinAugSys &s, MinAugEval *e, bool with_df) {
+  const std::size_t nu = s.unknowns();
+  std::size_t r = s.n;
+  for (std::size_t bi = 0; bi < s.blocks.size(); ++bi) {
+    const BorderBlock &b = s.blocks[bi];
+    const int kept[2] = {b.k() == 1 ? 0 : b.e0, b.e1};
+    for (std::size_t t = 0; t < b.k(); ++t, ++r) {
+      e->F[r] = b.G[kept[t]];
+      if (with_df) std::copy_n(&e->dG[bi][kept[t] * nu], nu, &e->DF[r * nu]);
+    }
+  }
+}
+
+/* residual at U: f, the kept G entries of every block, the cusp row */
+bool ma_eval(MinAugSys &s, const std::vector<double> &U, MinAugEval *e) {
+  const std::size_t n = s.n;
+  e->F.assign(s.equations(), 0.0);
+  if (!s.field(U.data(), U.data() + n, e->F.data())) return false;
+  if (!ma_jac(s, U.data(), U.data() + n, &e->J)) return false;
+  for (BorderBlock &b : s.blocks)
+    if (!ma_block_solve(s, b, e->J, U.data())) return false;
+  ma_rows(s, e, false);
+  if (s.cusp) {
+    std::vector<double> f0(e->F.begin(), e->F.begin() + n);
+    if (!ma_fold_coeff(s, s.blocks[0], U.data(), f0.data(), &e->F.back())) return false;
+  }
+  return is_finite_vec(e->F);
+}
+
+/* Jacobian of the system at the U of the last ma_eval */
+bool ma_grad(MinAugSys &s, const std::vector<double> &U, MinAugEval *e) {
+  const std::size_t n = s.n, np = s.np, nu = s.unknowns(), nr = s.equations();
+  const double *x = U.data(), *par = U.data() + n;
+  const std::vector<double> &J = e->J;
+  double xs = 0.0;
+  for (std::size_t i = 0; i < n; ++i) xs = std::max(xs, std::fabs(x[i]));
+  const double h0 = s.jac ? 1e-5 : 1e-4;
+  std::vector<double> xt(n), pt(par, par + np), Jp, Jm;
+  /* derivatives of f_x along a direction in x, and in one parameter */
+  auto dJ = [&](const std::vector<double> &d, std::vector<double> *out) -> bool {
+    double dn = 0.0;
+    for (double v : d) dn = std::max(dn, std::fabs(v));
+    out->assign(n * n, 0.0);
+    if (dn == 0.0) return true;
+    const double h = h0 * (1.0 + xs) / dn;
+    for (std::size_t i = 0; i < n; ++i) xt[i] = x[i] + h * d[i];
+    if (!ma_jac(s, xt.data(), par, &Jp)) return false;
+    for (std::size_t i = 0; i < n; ++i) xt[i] = x[i] - h * d[i];
+    if (!ma_jac(s, xt.data(), par, &Jm)) return false;
+    for (std::size_t i = 0; i < n * n; ++i) (*out)[i] = (Jp[i] - Jm[i]) / (2 * h);
     return true;
   };
+  std::vector<std::vector<double>> DJpar(np);
+  for (std::size_t a = 0; a < np; ++a) {
+    const double h = h0 * (1.0 + std::fabs(par[a]));
+    pt[a] = par[a] + h;
+    if (!ma_jac(s, x, pt.data(), &Jp)) return false;
+    pt[a] = par[a] - h;
+    if (!ma_jac(s, x, pt.data(), &Jm)) return false;
+    pt[a] = par[a];
+    DJpar[a].assign(n * n, 0.0);
+    for (std::size_t i = 0; i < n * n; ++i) DJpar[a][i] = (Jp[i] - Jm[i]) / (2 * h);
+  }
+  auto col = [&](const std::vector<double> &Mv, std::size_t k, std::size_t j) {
+    std::vector<double> c(n);
+    for (std::size_t i = 0; i < n; ++i) c[i] = Mv[i * k + j];
+    return c;
+  };
+  auto mul = [&](const std::vector<double> &M, const std::vector<double> &v, bool trans) {
+    std::vector<double> r(n, 0.0);
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < n; ++j) r[trans ? j : i] += M[i * n + j] * v[trans ? i : j];
+    return r;
+  };
+  auto dot = [&](const std::vector<double> &a1, const std::vector<double> &b1) {
+    double d = 0.0;
+    for (std::size_t i = 0; i < n; ++i) d += a1[i] * b1[i];
+    return d;
+  };
 
-  std::vector<double> u(C);
-  for (std::size_t i = 0; i < n; ++i) u[i] = x0[i];
-  u[n] = p0; u[n + 1] = q0;
-  std::vector<double> empty_prev;
-  if (!correct(&u, std::vector<double>(C, 0.0))) {
-    /* still record the start even if it wasn't a perfect codim-1 point */
+  e->DF.assign(nr * nu, 0.0);
+  {
+    std::vector<double> fp(n), fm(n);
+    for (std::size_t a = 0; a < np; ++a) {
+      if (a == 0 && s.dfdp0) {
+        if (!s.dfdp0(x, par, fp.data())) return false;
+        for (std::size_t i = 0; i < n; ++i) e->DF[i * nu + n] = fp[i];
+        continue;
+      }
+      const double h = 1e-6 * (std::fabs(par[a]) + 1.0);
+      pt[a] = par[a] + h;
+      if (!s.field(x, pt.data(), fp.data())) return false;
+      pt[a] = par[a] - h;
+      if (!s.field(x, pt.data(), fm.data())) return false;
+      pt[a] = par[a];
+      for (std::size_t i = 0; i < n; ++i) e->DF[i * nu + n + a] = (fp[i] - fm[i]) / (2 * h);
+    }
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < n; ++j) e->DF[i * nu + j] = J[i * n + j];
+  }
+  e->dG.assign(s.blocks.size(), {});
+  for (std::size_t bi = 0; bi < s.blocks.size(); ++bi) {
+    const BorderBlock &b = s.blocks[bi];
+    const std::size_t k = b.k();
+    std::vector<double> &dG = e->dG[bi];
+    dG.assign(k * k * nu, 0.0);
+    for (std::size_t j = 0; j < k; ++j) {
+      const std::vector<double> v = col(b.V, k, j);
+      std::vector<double> Dv, DJv, Jv;
+      if (!dJ(v, &Dv)) return false;
+      if (k == 2) {
+        Jv = mul(J, v, false);
+        if (!dJ(Jv, &DJv)) return false;
+      }
+      for (std::size_t i = 0; i < k; ++i) {
+        const std::vector<double> w = col(b.W, k, i);
+        double *row = &dG[(i * k + j) * nu];
+        if (k == 1) {
+          /* A_z = J_z */
+          const std::vector<double> gx = mul(Dv, w, true);
+          for (std::size_t l = 0; l < n; ++l) row[l] = -gx[l];
+          for (std::size_t a = 0; a < np; ++a) row[n + a] = -dot(w, mul(DJpar[a], v, false));
+          continue;
+        }
+        /* A_z = J_z J + J J_z: w^T A_z v = w^T J_z (J v) + (J^T w)^T J_z v */
+        const std::vector<double> Jtw = mul(J, w, true), g1 = mul(DJv, w, true), g2 = mul(Dv, Jtw, true);
+        for (std::size_t l = 0; l < n; ++l) row[l] = -(g1[l] + g2[l]);
+        for (std::size_t a = 0; a < np; ++a)
+          row[n + a] = -(dot(w, mul(DJpar[a], Jv, false)) + dot(Jtw, mul(DJpar[a], v, false)));
+        if (b.kind == BorderKind::Hopf) row[b.kappa] = -dot(w, v);
+      }
+    }
+  }
+  ma_rows(s, e, true);
+  if (s.cusp) {
+    /* the fold coefficient involves third derivatives: its row is a central
+     * difference over the unknowns, the borders held fixed */
+    BorderBlock b = s.blocks[0];
+    std::vector<double> Ut = U, f0(n), Jt;
+    double gp = 0.0, gm = 0.0;
+    for (std::size_t j = 0; j < nu; ++j) {
+      const double h = 1e-3 * (std::fabs(U[j]) + 1.0);
+      for (int side = 0; side < 2; ++side) {
+        Ut[j] = U[j] + (side ? -h : h);
+        if (!s.field(Ut.data(), Ut.data() + n, f0.data()) || !ma_jac(s, Ut.data(), Ut.data() + n, &Jt) ||
+            !ma_block_solve(s, b, Jt, Ut.data()) || !ma_fold_coeff(s, b, Ut.data(), f0.data(), side ? &gm : &gp))
+          return false;
+      }
+      Ut[j] = U[j];
+      e->DF[(nr - 1) * nu + j] = (gp - gm) / (2 * h);
+    }
+  }
+  return is_finite_vec(e->DF);
+}
+
+/* new borders from the last solves: B spans the adjoint kernel, C the kernel
+ * (orthonormal columns), which keeps each bordered matrix well conditioned */
+void ma_borders(MinAugSys *s) {
+  const std::size_t n = s->n;
+  for (BorderBlock &b : s->blocks) {
+    const std::size_t k = b.k();
+    for (int side = 0; side < 2; ++side) {
+      std::vector<double> &D = side ? b.C : b.B;
+      D = side ? b.V : b.W;
+      for (std::size_t j = 0; j < k; ++j) {
+        for (std::size_t l = 0; l < j; ++l) {
+          double d = 0.0;
+          for (std::size_t i = 0; i < n; ++i) d += D[i * k + j] * D[i * k + l];
+          for (std::size_t i = 0; i < n; ++i) D[i * k + j] -= d * D[i * k + l];
+        }
+        double nr = 0.0;
+        for (std::size_t i = 0; i < n; ++i) nr += D[i * k + j] * D[i * k + j];
+        nr = std::sqrt(nr);
+        if (nr > 0.0)
+          for (std::size_t i = 0; i < n; ++i) D[i * k + j] /= nr;
+      }
+    }
   }
+}
 
-  auto push = [&](const std::vector<double> &uu) {
-    TwoParamPoint pt; pt.p = uu[n]; pt.q = uu[n + 1];
-    pt.x.assign(uu.begin(), uu.begin() + n);
-    curve.points.push_back(std::move(pt));
+/* for each k = 2 block keep the two entries of G whose gradients, projected
+ * off the rows already in the system (f, fold rows, earlier picks), span the
+ * largest area; the other two are then locally dependent on them */
+void ma_pick(MinAugSys *s, MinAugEval *e) {
+  const std::size_t n = s->n, nu = s->unknowns();
+  std::vector<std::vector<double>> basis;
+  auto add = [&](const double *row) {
+    std::vector<double> r(row, row + nu);
+    for (const std::vector<double> &q : basis) {
+      double d = 0.0;
+      for (std::size_t j = 0; j < nu; ++j) d += r[j] * q[j];
+      for (std::size_t j = 0; j < nu; ++j) r[j] -= d * q[j];
+    }
+    double nr = 0.0;
+    for (double v : r) nr += v * v;
+    nr = std::sqrt(nr);
+    if (nr > 1e-12) {
+      for (double &v : r) v /= nr;
+      basis.push_back(std::move(r));
+    }
+  };
+  auto project = [&](const double *row) {
+    std::vector<double> r(row, row + nu);
+    for (const std::vector<double> &q : basis) {
+      double d = 0.0;
+      for (std::size_t j = 0; j < nu; ++j) d += r[j] * q[j];
+      for (std::size_t j = 0; j < nu; ++j) r[j] -= d * q[j];
+    }
+    return r;
+  };
+  for (std::size_t i = 0; i < n; ++i) add(&e->DF[i * nu]);
+  for (std::size_t bi = 0; bi < s->blocks.size(); ++bi)
+    if (s->blocks[bi].k() == 1) add(&e->dG[bi][0]);
+  for (std::size_t bi = 0; bi < s->blocks.size(); ++bi) {
+    BorderBlock &b = s->blocks[bi];
+    if (b.k() != 2) continue;
+    std::vector<double> r[4];
+    for (int t = 0; t < 4; ++t) r[t] = project(&e->dG[bi][t * nu]);
+    double best = -1.0;
+    for (int a = 0; a < 4; ++a)
+      for (int c = a + 1; c < 4; ++c) {
+        double aa = 0.0, cc = 0.0, ac = 0.0;
+        for (std::size_t j = 0; j < nu; ++j) { aa += r[a][j] * r[a][j]; cc += r[c][j] * r[c][j]; ac += r[a][j] * r[c][j]; }
+        if (aa * cc - ac * ac > best) { best = aa * cc - ac * ac; b.e0 = a; b.e1 = c; }
+      }
+    add(&e->dG[bi][b.e0 * nu]);
+    add(&e->dG[bi][b.e1 * nu]);
+  }
+  ma_rows(*s, e, true);
+}
+
+/* kappa = omega^2 for `count` distinct complex pairs nearest the imaginary
+ * axis, least damped first */
+bool ma_kappas(const std::vector<double> &J, std::size_t n, std::size_t count, std::vector<double> *kap) {
+  std::vector<Complex> ev;
+  if (!eigenvalues(J, n, &ev)) return false;
+  std::vector<Complex> pos;
+  for (const Complex &z : ev)
+    if (z.imag() > 1e-7) pos.push_back(z);
+  std::sort(pos.begin(), pos.end(), [](const Complex &a, const Complex &b) { return std::fabs(a.real()) < std::fabs(b.real()); });
+  kap->clear();
+  for (const Complex &z : pos) {
+    bool distinct = true;
+    for (double k : *kap) distinct = distinct && std::fabs(std::sqrt(k) - z.imag()) > 1e-4 * (1.0 + z.imag());
+    if (distinct) kap->push_back(z.imag() * z.imag());
+    if (kap->size() == count) return true;
+  }
+  return false;
+}
+
+/* borders for a fresh system at U: fixed start vectors, then two sweeps of
+ * inverse iteration onto the (adjoint) kernels, then the entry picks */
+bool ma_init(MinAugSys *s, const std::vector<double> &U, MinAugEval *e) {
+  const std::size_t n = s->n;
+  for (std::size_t bi = 0; bi < s->blocks.size(); ++bi) {
+    BorderBlock &b = s->blocks[bi];
+    const std::size_t k = b.k();
+    b.B.assign(n * k, 0.0);
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < k; ++j) b.B[i * k + j] = std::sin(1.0 + (double)((i + 1) * (j + 2) + bi));
+    b.C = b.B;
+  }
+  for (int it = 0; it < 2; ++it) {
+    if (!ma_eval(*s, U, e)) return false;
+    ma_borders(s);
+  }
+  if (!ma_eval(*s, U, e) || !ma_grad(*s, U, e)) return false;
+  ma_pick(s, e);
+  return true;
+}
+
+/* A factored for the square continuation systems. Where DF loses rank
+ * (f_x and f_par share a kernel, e.g. an equilibrium that persists for all
+ * parameters) LU gives a meaningless step; the minimum-norm least-squares
+ * step, via Tikhonov-regularized normal equations, is taken instead. Kept
+ * as an object so a chord corrector can reuse it. */
+struct MaFactor {
+  DenseLU lu;
+  std::vector<double> A;  /* kept only for the normal equations */
+  bool normal = false;
+  bool factor(std::vector<double> A_, std::size_t nu) {
+    normal = false;
+    if (lu.factor(A_, nu)) {
+      double lo = 1e300, hi = 0.0;
+      for (std::size_t c = 0; c < nu; ++c) {
+        lo = std::min(lo, std::fabs(lu.a[c * nu + c]));
+        hi = std::max(hi, std::fabs(lu.a[c * nu + c]));
+      }
+      if (lo > 1e-10 * hi) return true;
+    }
+    std::vector<double> N(nu * nu, 0.0);
+    double tr = 0.0;
+    for (std::size_t i = 0; i < nu; ++i) {
+      for (std::size_t j = 0; j < nu; ++j) {
+        double d = 0.0;
+        for (std::size_t k = 0; k < nu; ++k) d += A_[k * nu + i] * A_[k * nu + j];
+        N[i * nu + j] = d;
+      }
+      tr = std::max(tr, N[i * nu + i]);
+    }
+    for (std::size_t i = 0; i < nu; ++i) N[i * nu + i] += 1e-12 * tr;
+    A = std::move(A_);
+    normal = true;
+    return lu.factor(std::move(N), nu);
+  }
+  /* x <- A^{-1} x (least squares on the normal equations) */
+  void solve(std::vector<double> *x) const {
+    if (normal) {
+      const std::size_t nu = lu.n;
+      std::vector<double> b(nu, 0.0);
+      for (std::size_t i = 0; i < nu; ++i)
+        for (std::size_t k = 0; k < nu; ++k) b[i] += A[k * nu + i] * (*x)[k];
+      *x = std::move(b);
+    }
+    lu.solve(x);
+  }
+};
+
+/* x <- A^{-1} x for the square continuation systems */
+bool ma_solve(std::vector<double> A, std::size_t nu, std::vector<double> *x) {
+  MaFactor f;
+  if (!f.factor(std::move(A), nu)) return false;
+  f.solve(x);
+  return is_finite_vec(*x);
+}
+
+/* Corrector on [F; tan . (U - U_start) = 0], the step kept in the
+ * hyperplane orthogonal to tan through the starting U; steps longer than
+ * max_step are scaled back. Chord / Broyden (qn.kind) start from the DF of
+ * the last ma_grad, which ma_tangent leaves at the accepted point. */
+bool ma_correct(MinAugSys &s, std::vector<double> *U, const std::vector<double> &tan, const QNCorrector &qn,
+                MinAugEval *e) {
+  const std::size_t nu = s.unknowns(), nr = s.equations();
+  const std::vector<double> U0 = *U;
+  MaFactor fac;
+  auto factor = [&]() {
+    std::vector<double> A(nu * nu, 0.0);
+    std::copy(e->DF.begin(), e->DF.end(), A.begin());
+    std::copy(tan.begin(), tan.end(), A.begin() + nr * nu);
+    return fac.factor(std::move(A), nu);
+  };
+  bool held = false;
+  if (qn.kind != CorrectorKind::Newton && e->DF.size() == nr * nu) {
+    held = factor();
+    if (qn.counts) ++qn.counts->factorizations;
+  }
+  auto residual = [&](const std::vector<double> &uu, std::vector<double> *G) {
+    if (!ma_eval(s, uu, e)) return false;
+    *G = e->F;
+    double g = 0.0;
+    for (std::size_t j = 0; j < nu; ++j) g += tan[j] * (uu[j] - U0[j]);
+    G->push_back(g);
+    return true;
   };
+  auto refresh = [&](const std::vector<double> &uu) { return ma_grad(s, uu, e) && factor(); };
+  bool converged = false;
+  if (!qn_correct(qn, U, held, residual, refresh, [&](std::vector<double> *v) { fac.solve(v); }, &converged))
+    return false;
+  if (converged) return true;
+  if (!ma_eval(s, *U, e)) return false;
+  double res = 0; for (double v : e->F) res += v * v;
+  return std::sqrt(res) < 1e-6;
+}
+
+
+/* the curve tangent at an accepted U: borders and entry picks are refreshed
+ * there, then the null vector of DF is taken, oriented along prev (or with a
+ * positive component `seed` at the start) */
+bool ma_tangent(MinAugSys &s, const std::vector<double> &U, const std::vector<double> &prev, std::size_t seed,
+                std::vector<double> *t, MinAugEval *e) {
+  const std::size_t nu = s.unknowns(), nr = s.equations();
+  if (!ma_eval(s, U, e)) return false;
+  ma_borders(&s);
+  if (!ma_eval(s, U, e) || !ma_grad(s, U, e)) return false;
+  ma_pick(&s, e);
+  std::vector<double> A(nu * nu, 0.0);
+  std::copy(e->DF.begin(), e->DF.end(), A.begin());
+  if (prev.empty()) A[nr * nu + seed] = 1.0;
+  else std::copy(prev.begin(), prev.end(), A.begin() + nr * nu);
+  t->assign(nu, 0.0);
+  (*t)[nr] = 1.0;
+  if (!ma_solve(std::move(A), nu, t)) return false;
+  double nrm = 0; for (double v : *t) nrm += v * v; nrm = std::sqrt(nrm);
+  if (!(nrm > 1e-300) || !std::isfinite(nrm)) return false;
+  for (double &v : *t) v /= nrm;
+  if (!prev.empty()) {
+    double d = 0; for (std::size_t j = 0; j < nu; ++j) d += (*t)[j] * prev[j];
+    /* a turn this sharp in one step means U sits on a crossing of solution
+     * branches (DF loses rank there): carry straight on along prev */
+    if (std::fabs(d) < 0.5) *t = prev;
+    else if (d < 0) for (double &v : *t) v = -v;
+  }
+  return true;
+}
+
+/* Shared pseudo-arclength driver. The start is located with the unknown
+ * `seed` held fixed (damped steps), then the curve is followed both ways from
+ * it; a failed corrector halves the step down to h0/16 and a converged one
+ * lets it grow back to h0. `inside` false records the point and stops that
+ * direction, `valid` false stops it without recording. */
+struct MinAugTrace {
+  double h0 = 0.05;
+  int steps = 100;              /* per direction */
+  int max_iters = 20;
+  double tol = 1e-9;
+  CorrectorKind corrector = CorrectorKind::Newton;  /* along the curve */
+  double contraction = 0.5;
+  CorrectorCounts *counts = nullptr;
+  std::size_t seed = 0;
+  bool record_start = false;
+  std::function<bool(const std::vector<double> &)> inside, valid;
+  std::function<void(const std::vector<double> &)> record;
+};
 
-  /* trace both directions */
+bool ma_trace(MinAugSys &s, std::vector<double> U, const MinAugTrace &tr, MinAugEval *e) {
+  const std::size_t nu = s.unknowns();
+  QNCorrector qn;
+  qn.iters = 60;
+  qn.tol = tr.tol;
+  qn.max_step = 0.5;
+  {
+    std::vector<double> Us = U, fix(nu, 0.0);
+    fix[tr.seed] = 1.0;
+    if (ma_correct(s, &Us, fix, qn, e)) U = Us;
+  }
+  qn.kind = tr.corrector;
+  qn.contraction = tr.contraction;
+  qn.iters = tr.max_iters;
+  qn.max_step = 1e300;
+  qn.counts = tr.counts;
+  std::vector<double> t0;
+  if (!ma_tangent(s, U, {}, tr.seed, &t0, e)) return false;
+  const std::vector<BorderBlock> start_blocks = s.blocks;
+  if (tr.record_start) tr.record(U);
   for (int dir = 0; dir < 2; ++dir) {
-    std::vector<double> uu = u, tan;
-    if (!tangent_of(uu, empty_prev, &tan)) continue;
+    s.blocks = start_blocks;
+    std::vector<double> uu = U, tan = t0;
     if (dir == 1) for (double &v : tan) v = -v;
-    int steps = settings.max_points / 2;
-    for (int s = 0; s < steps; ++s) {
+    double h = tr.h0;
+    for (int st = 0; st < tr.steps;) {
       std::vector<double> un = uu;
-      for (std::size_t j = 0; j < C; ++j) un[j] += settings.h0 * tan[j];
-      std::vector<double> ntan;
-      if (!tangent_of(uu, tan, &ntan)) break;  /* tangent at current point */
-      if (!correct(&un, ntan)) break;
-      const double pp = un[n], qq = un[n + 1];
-      if (pp < settings.p_min || pp > settings.p_max ||
-          qq < settings.q_min || qq > settings.q_max) { push(un); break; }
-      push(un);
-      /* advance */
+      for (std::size_t j = 0; j < nu; ++j) un[j] += h * tan[j];
+      if (!ma_correct(s, &un, tan, qn, e)) {
+        if ((h *= 0.5) < tr.h0 / 16) break;
+        continue;
+      }
+      ++st;
+      h = std::min(tr.h0, 2 * h);
+      if (tr.valid && !tr.valid(un)) break;
+      tr.record(un);
+      if (tr.inside && !tr.inside(un)) break;
       std::vector<double> t2;
-      if (!tangent_of(un, ntan, &t2)) break;
+      if (!ma_tangent(s, un, tan, tr.seed, &t2, e)) break;
       uu = un; tan = t2;
     }
   }
+  return true;
+}
+
+}  // namespace
+
+TwoParamCurve two_param_curve(const Model2 &m, TwoParamKind kind,
+                              const std::vector<double> &x0, double p0, double q0,
+                              const TwoParamSettings &settings) {
+  TwoParamCurve curve;
+  curve.kind = (kind == TwoParamKind::Fold) ? SpecialPointKind::Fold : SpecialPointKind::Hopf;
+  const std::size_t n = m.n;
+  if (x0.size() != n || n == 0) { curve.message = "bad starting point"; return curve; }
+  MinAugSys sys = minaug_sys(m);
+  BorderBlock blk;
+  blk.kind = kind == TwoParamKind::Fold ? BorderKind::Fold : BorderKind::Hopf;
+  blk.kappa = n + 2;
+  sys.blocks.push_back(blk);
+
+  std::vector<double> u(sys.unknowns());  /* x, p, q (, kappa) */
+  for (std::size_t i = 0; i < n; ++i) u[i] = x0[i];
+  u[n] = p0; u[n + 1] = q0;
+  MinAugEval ev;
+  {
+    std::vector<double> J;
+    if (!ma_jac(sys, x0.data(), u.data() + n, &J)) { curve.message = "Jacobian failed at the start point"; return curve; }
+    if (blk.kind == BorderKind::Hopf) {
+      std::vector<double> kap;
+      if (!ma_kappas(J, n, 1, &kap)) { curve.message = "no complex eigenvalue pair at the start point"; return curve; }
+      u[n + 2] = kap[0];
+    }
+    if (!ma_init(&sys, u, &ev)) { curve.message = "singular bordered system at the start point"; return curve; }
+  }
+
+  MinAugTrace tr;
+  tr.h0 = settings.h0;
+  tr.steps = settings.max_points / 2;
+  tr.max_iters = settings.max_corrector_iters;
+  tr.tol = settings.corrector_tol;
+  tr.corrector = settings.corrector;
+  tr.contraction = settings.contraction;
+  tr.counts = &curve.counts;
+  tr.seed = n + 1;  /* the start is located at fixed q */
+  tr.inside = [&](const std::vector<double> &uu) {
+    return uu[n] >= settings.p_min && uu[n] <= settings.p_max && uu[n + 1] >= settings.q_min &&
+           uu[n + 1] <= settings.q_max;
+  };
+  /* past a BT the Hopf curve continues as a neutral saddle, not a Hopf */
+  if (blk.kind == BorderKind::Hopf) tr.valid = [&](const std::vector<double> &uu) { return uu[n + 2] > 0.0; };
+  tr.record = [&](const std::vector<double> &uu) {
+    TwoParamPoint pt; pt.p = uu[n]; pt.q = uu[n + 1];
+    pt.x.assign(uu.begin(), uu.begin() + n);
+    curve.points.push_back(std::move(pt));
+  };
+  ma_trace(sys, u, tr, &ev);
 
   /* ---- detect codim-2 points ALONG the curve ----------------------------
    * Two scalar test functions are evaluated at each curve point; a sign change
@@ -1454,277 +2810,18 @@ Codim2Point locate_bogdanov_takens(const Model2 &m, const std::vector<double> &x
   return R;
 }
 
-BTCurve bt_curve(const Model3 &m, const std::vector<double> &x0,
-                 double p0, double q0, double r0, const BTCurveSettings &settings) {
-  BTCurve C;
-  const std::size_t n = m.n;
-  if (n < 2 || x0.size() < n) { C.message = "BT curve needs a 2+ dim system"; return C; }
-  const std::size_t NU = n + 3;        /* unknowns: x[0..n-1], p, q, r */
-  const std::size_t NE = n + 2;        /* equations: f=0 (n), mu_prod=0, mu_sum=0 */
-
-  /* defining-system residual G(U), length NE */
-  auto eval_G = [&](const std::vector<double> &U, std::vector<double> *G) -> bool {
-    std::vector<double> x(U.begin(), U.begin()+n); double p=U[n], q=U[n+1], r=U[n+2];
-    Model mm; mm.n=n;
-    mm.vector_field = [&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    std::vector<double> f(n); std::string e;
-    if (!mm.vector_field(x.data(), p, f.data(), &e)) return false;
-    std::vector<double> A; if (!finite_diff_jacobian(mm, x.data(), p, &A, &e, 1e-7)) return false;
-    std::vector<Complex> ev; if (!eigenvalues(A, n, &ev)) return false;
-    std::sort(ev.begin(), ev.end(), [](const Complex&a,const Complex&b){ return std::abs(a) < std::abs(b); });
-    const Complex l1=ev[0], l2=(ev.size()>1?ev[1]:Complex(0,0));
-    G->assign(NE, 0.0);
-    for (std::size_t i=0;i<n;i++) (*G)[i]=f[i];
-    (*G)[n]   = (l1*l2).real();
-    (*G)[n+1] = l1.real()+l2.real();
-    return true;
-  };
-  /* (NE x NU) finite-difference Jacobian of G */
-  auto eval_Jac = [&](const std::vector<double> &U, std::vector<double> *Jg) -> bool {
-    std::vector<double> G0; if (!eval_G(U, &G0)) return false;
-    Jg->assign(NE*NU, 0.0); std::vector<double> Up=U, Gp;
-    for (std::size_t c=0;c<NU;c++){ const double sv=Up[c]; const double dh=1e-7*(std::fabs(sv)+1e-3);
-      Up[c]=sv+dh; if(!eval_G(Up,&Gp)){Up[c]=sv;return false;} Up[c]=sv;
-      for (std::size_t rr=0;rr<NE;rr++) (*Jg)[rr*NU+c]=(Gp[rr]-G0[rr])/dh; }
-    return true;
-  };
-  /* null vector of the (NE x NU) Jacobian (the curve tangent): NU=NE+1, so the
-   * nullspace is 1-D. Find it by solving the square system formed by appending
-   * a normalization row, taking the direction of largest response. */
-  auto tangent = [&](const std::vector<double> &U, std::vector<double> *t) -> bool {
-    std::vector<double> Jg; if (!eval_Jac(U,&Jg)) return false;
-    /* Build (NU x NU): NE Jacobian rows + 1 row that picks an index; solve for
-     * each candidate index and keep the best-conditioned. Simpler: append a row
-     * e_k and rhs e_k; solve; that yields a vector with t_k=1 in the nullspace
-     * direction if k is not orthogonal to it. Try all k, keep max-norm result. */
-    double best=-1; std::vector<double> bestv(NU,0.0);
-    for (std::size_t k=0;k<NU;k++){
-      std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-      for (std::size_t rr=0;rr<NE;rr++) for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc];
-      M[NE*NU+k]=1.0; rhs[NE]=1.0;
-      std::vector<double> v;
-      if (!solve_linear(M, rhs, &v)) continue;
-      double nrm=0; for(double z:v) nrm+=z*z; nrm=std::sqrt(nrm);
-      if (nrm>best){ best=nrm; bestv=v; }
-    }
-    if (best<=0) return false;
-    for(double&z:bestv) z/=best;
-    *t=bestv; return true;
-  };
-
-  /* refine the start with a Newton on G (no arclength row) to land on the curve */
-  std::vector<double> U(NU,0.0);
-  for (std::size_t i=0;i<n;i++) U[i]=x0[i];
-  U[n]=p0; U[n+1]=q0; U[n+2]=r0;
-  {
-    std::vector<double> G; 
-    for (int it=0; it<60; ++it) {
-      if (!eval_G(U,&G)) { C.message="BT curve: start eval failed"; return C; }
-      double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn); if (rn<1e-10) break;
-      std::vector<double> Jg; if(!eval_Jac(U,&Jg)){ C.message="BT curve: start Jac failed"; return C; }
-      /* least-squares Newton: solve (J^T J) dU = -J^T G with damping */
-      std::vector<double> JtJ(NU*NU,0.0), Jtb(NU,0.0);
-      for(std::size_t a=0;a<NU;a++){ double s=0; for(std::size_t rr=0;rr<NE;rr++) s+=Jg[rr*NU+a]*G[rr]; Jtb[a]=-s;
-        for(std::size_t b2=0;b2<NU;b2++){ double t=0; for(std::size_t rr=0;rr<NE;rr++) t+=Jg[rr*NU+a]*Jg[rr*NU+b2]; JtJ[a*NU+b2]=t; } }
-      for(std::size_t a=0;a<NU;a++) JtJ[a*NU+a]+=1e-10;
-      std::vector<double> dU; if(!solve_linear(JtJ,Jtb,&dU)) break;
-      double dn=0; for(double v:dU) dn+=v*v; dn=std::sqrt(dn);
-      double damp = dn>0.5?0.5/dn:1.0;
-      for(std::size_t a=0;a<NU;a++) U[a]+=damp*dU[a];
-    }
-  }
-
-  auto record = [&](const std::vector<double> &U) {
-    BTCurvePoint P; P.x.assign(U.begin(), U.begin()+n); P.p=U[n]; P.q=U[n+1]; P.r=U[n+2];
-    std::vector<double> G; if (eval_G(U,&G)){ double rn=0; for(double g:G) rn+=g*g; P.residual=std::sqrt(rn); }
-    Model mm; mm.n=n; double q=P.q, r=P.r;
-    mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    double a=0,b=0; std::string e; if (bt_normal_form(mm,P.x,P.p,&a,&b,&e)){ P.a=a; P.b=b; }
-    C.points.push_back(P);
-  };
-
-  /* initial tangent */
-  std::vector<double> t0; if (!tangent(U,&t0)) { C.message="BT curve: could not find a tangent at the start"; return C; }
-
-  for (int dir=0; dir<2; ++dir) {
-    std::vector<double> Uc=U, tc=t0;
-    if (dir==1) for(double&z:tc) z=-z;
-    if (dir==0) record(Uc);
-    std::vector<double> tprev=tc;
-    for (int step=0; step<settings.max_points; ++step) {
-      /* predictor */
-      std::vector<double> Up(NU); for(std::size_t i=0;i<NU;i++) Up[i]=Uc[i]+settings.ds*tprev[i];
-      /* corrector: Newton on [ G(U) ; <U-Up, tprev> = 0 ] (NU x NU square) */
-      bool conv=false;
-      for (int it=0; it<settings.max_corrector_iters; ++it) {
-        std::vector<double> G; if(!eval_G(Up,&G)) break;
-        double arc=0; for(std::size_t i=0;i<NU;i++) arc+=(Up[i]-( Uc[i]+settings.ds*tprev[i]))*tprev[i];
-        double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn+arc*arc);
-        if (rn<settings.corrector_tol) { conv=true; break; }
-        std::vector<double> Jg; if(!eval_Jac(Up,&Jg)) break;
-        std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-        for(std::size_t rr=0;rr<NE;rr++){ for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc]; rhs[rr]=-G[rr]; }
-        for(std::size_t cc=0;cc<NU;cc++) M[NE*NU+cc]=tprev[cc];
-        rhs[NE]=-arc;
-        std::vector<double> dU; if(!solve_linear(M,rhs,&dU)) break;
-        for(std::size_t i=0;i<NU;i++) Up[i]+=dU[i];
-      }
-      if (!conv) break;
-      /* box check */
-      if (Up[n]<settings.p_min||Up[n]>settings.p_max||Up[n+1]<settings.q_min||Up[n+1]>settings.q_max||
-          Up[n+2]<settings.r_min||Up[n+2]>settings.r_max) { record(Up); break; }
-      record(Up);
-      /* new tangent, oriented consistently with the previous step */
-      std::vector<double> tnew; if (!tangent(Up,&tnew)) break;
-      double dotp=0; for(std::size_t i=0;i<NU;i++) dotp+=tnew[i]*tprev[i];
-      if (dotp<0) for(double&z:tnew) z=-z;
-      Uc=Up; tprev=tnew;
-    }
-  }
-  C.ok = C.points.size() >= 2;
-  C.message = C.ok ? ("traced BT curve: "+std::to_string(C.points.size())+" points")
-                   : "could not trace a BT curve from this start";
-  return C;
-}
-
-BTCurve zh_curve(const Model3 &m, const std::vector<double> &x0,
-                 double p0, double q0, double r0, const BTCurveSettings &settings) {
-  BTCurve C;
-  const std::size_t n = m.n;
-  if (n < 3 || x0.size() < n) { C.message = "zero-Hopf curve needs a 3+ dim system"; return C; }
-  const std::size_t NU = n + 3;        /* unknowns: x[0..n-1], p, q, r */
-  const std::size_t NE = n + 2;        /* equations: f=0 (n), Re(real eig)=0, Re(complex pair)=0 */
-
-  /* defining-system residual G(U): n equilibrium eqns plus
-   *   G[n]   = real part of the smallest-|Re| REAL eigenvalue   (-> 0 at fold)
-   *   G[n+1] = real part of the least-damped COMPLEX pair        (-> 0 at Hopf)
-   * Together these pin a fold and a Hopf simultaneously = zero-Hopf. */
-  auto eval_G = [&](const std::vector<double> &U, std::vector<double> *G) -> bool {
-    std::vector<double> x(U.begin(), U.begin()+n); double p=U[n], q=U[n+1], r=U[n+2];
-    Model mm; mm.n=n;
-    mm.vector_field = [&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    std::vector<double> f(n); std::string e;
-    if (!mm.vector_field(x.data(), p, f.data(), &e)) return false;
-    std::vector<double> A; if (!finite_diff_jacobian(mm, x.data(), p, &A, &e, 1e-7)) return false;
-    std::vector<Complex> ev; if (!eigenvalues(A, n, &ev)) return false;
-    /* smallest-|Re| real eigenvalue (imag ~ 0) and least-damped complex pair */
-    bool have_real=false, have_cplx=false; double g_real=0, g_cplx=0; double best_real=1e300, best_cplx=1e300;
-    for (const auto &lam : ev) {
-      if (std::fabs(lam.imag()) < 1e-6) { if (std::fabs(lam.real()) < best_real) { best_real=std::fabs(lam.real()); g_real=lam.real(); have_real=true; } }
-      else if (lam.imag() > 0)         { if (std::fabs(lam.real()) < best_cplx) { best_cplx=std::fabs(lam.real()); g_cplx=lam.real(); have_cplx=true; } }
-    }
-    if (!have_real) g_real = ev[0].real();   /* fallbacks keep G well-defined off-target */
-    if (!have_cplx) { /* no complex pair: use the next-smallest real as a proxy so Newton still moves */
-      double b2=1e300; for (const auto&lam:ev){ double d=std::fabs(lam.real()); if (std::fabs(lam.imag())<1e-6 && d<b2 && lam.real()!=g_real){b2=d; g_cplx=lam.real();} } }
-    G->assign(NE, 0.0);
-    for (std::size_t i=0;i<n;i++) (*G)[i]=f[i];
-    (*G)[n]   = g_real;
-    (*G)[n+1] = g_cplx;
-    return true;
-  };
-  auto eval_Jac = [&](const std::vector<double> &U, std::vector<double> *Jg) -> bool {
-    std::vector<double> G0; if (!eval_G(U, &G0)) return false;
-    Jg->assign(NE*NU, 0.0); std::vector<double> Up=U, Gp;
-    for (std::size_t c=0;c<NU;c++){ const double sv=Up[c]; const double dh=1e-7*(std::fabs(sv)+1e-3);
-      Up[c]=sv+dh; if(!eval_G(Up,&Gp)){Up[c]=sv;return false;} Up[c]=sv;
-      for (std::size_t rr=0;rr<NE;rr++) (*Jg)[rr*NU+c]=(Gp[rr]-G0[rr])/dh; }
-    return true;
-  };
-  auto tangent = [&](const std::vector<double> &U, std::vector<double> *t) -> bool {
-    std::vector<double> Jg; if (!eval_Jac(U,&Jg)) return false;
-    double best=-1; std::vector<double> bestv(NU,0.0);
-    for (std::size_t k=0;k<NU;k++){
-      std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-      for (std::size_t rr=0;rr<NE;rr++) for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc];
-      M[NE*NU+k]=1.0; rhs[NE]=1.0;
-      std::vector<double> v; if (!solve_linear(M, rhs, &v)) continue;
-      double nrm=0; for(double z:v) nrm+=z*z; nrm=std::sqrt(nrm);
-      if (nrm>best){ best=nrm; bestv=v; }
-    }
-    if (best<=0) return false;
-    for(double&z:bestv) z/=best;
-    *t=bestv; return true;
-  };
-
-  std::vector<double> U(NU,0.0);
-  for (std::size_t i=0;i<n;i++) U[i]=x0[i];
-  U[n]=p0; U[n+1]=q0; U[n+2]=r0;
-  { std::vector<double> G;
-    for (int it=0; it<60; ++it) {
-      if (!eval_G(U,&G)) { C.message="zero-Hopf curve: start eval failed"; return C; }
-      double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn); if (rn<1e-10) break;
-      std::vector<double> Jg; if(!eval_Jac(U,&Jg)){ C.message="zero-Hopf curve: start Jac failed"; return C; }
-      std::vector<double> JtJ(NU*NU,0.0), Jtb(NU,0.0);
-      for(std::size_t a=0;a<NU;a++){ double s=0; for(std::size_t rr=0;rr<NE;rr++) s+=Jg[rr*NU+a]*G[rr]; Jtb[a]=-s;
-        for(std::size_t b2=0;b2<NU;b2++){ double t=0; for(std::size_t rr=0;rr<NE;rr++) t+=Jg[rr*NU+a]*Jg[rr*NU+b2]; JtJ[a*NU+b2]=t; } }
-      for(std::size_t a=0;a<NU;a++) JtJ[a*NU+a]+=1e-10;
-      std::vector<double> dU; if(!solve_linear(JtJ,Jtb,&dU)) break;
-      double dn=0; for(double v:dU) dn+=v*v; dn=std::sqrt(dn);
-      double damp = dn>0.5?0.5/dn:1.0;
-      for(std::size_t a=0;a<NU;a++) U[a]+=damp*dU[a];
-    }
-  }
-
-  auto record = [&](const std::vector<double> &Uv){
-    BTCurvePoint P; P.x.assign(Uv.begin(), Uv.begin()+n); P.p=Uv[n]; P.q=Uv[n+1]; P.r=Uv[n+2];
-    std::vector<double> G; if (eval_G(Uv,&G)) { double rn=0; for(double g:G) rn+=g*g; P.residual=std::sqrt(rn); }
-    Model mm; mm.n=n; double q=P.q, r=P.r;
-    mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    double b=0,recc=0,om=0,s=0; std::string e;
-    if (zero_hopf_normal_form(mm,P.x,P.p,&b,&recc,&om,&s,&e)) { P.a=b; P.b=recc; }  /* a<-b, b<-Re(c) */
-    C.points.push_back(P);
-  };
-
-  std::vector<double> t0; if (!tangent(U,&t0)) { C.message="zero-Hopf curve: could not find a tangent at the start"; return C; }
-  for (int dir=0; dir<2; ++dir) {
-    std::vector<double> Uc=U, tc=t0;
-    if (dir==1) for(double&z:tc) z=-z;
-    if (dir==0) record(Uc);
-    std::vector<double> tprev=tc;
-    for (int step=0; step<settings.max_points; ++step) {
-      std::vector<double> Up(NU); for(std::size_t i=0;i<NU;i++) Up[i]=Uc[i]+settings.ds*tprev[i];
-      bool conv=false;
-      for (int it=0; it<settings.max_corrector_iters; ++it) {
-        std::vector<double> G; if(!eval_G(Up,&G)) break;
-        double arc=0; for(std::size_t i=0;i<NU;i++) arc+=(Up[i]-( Uc[i]+settings.ds*tprev[i]))*tprev[i];
-        double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn+arc*arc);
-        if (rn<settings.corrector_tol) { conv=true; break; }
-        std::vector<double> Jg; if(!eval_Jac(Up,&Jg)) break;
-        std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-        for(std::size_t rr=0;rr<NE;rr++){ for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc]; rhs[rr]=-G[rr]; }
-        for(std::size_t cc=0;cc<NU;cc++) M[NE*NU+cc]=tprev[cc];
-        rhs[NE]=-arc;
-        std::vector<double> dU; if(!solve_linear(M,rhs,&dU)) break;
-        for(std::size_t i=0;i<NU;i++) Up[i]+=dU[i];
-      }
-      if (!conv) break;
-      if (Up[n]<settings.p_min||Up[n]>settings.p_max||Up[n+1]<settings.q_min||Up[n+1]>settings.q_max||
-          Up[n+2]<settings.r_min||Up[n+2]>settings.r_max) { record(Up); break; }
-      record(Up);
-      std::vector<double> tnew; if (!tangent(Up,&tnew)) break;
-      double dotp=0; for(std::size_t i=0;i<NU;i++) dotp+=tnew[i]*tprev[i];
-      if (dotp<0) for(double&z:tnew) z=-z;
-      Uc=Up; tprev=tnew;
-    }
-  }
-  C.ok = C.points.size() >= 2;
-  C.message = C.ok ? ("traced zero-Hopf curve: "+std::to_string(C.points.size())+" points")
-                   : "could not trace a zero-Hopf curve from this start";
-  return C;
-}
-
-/* Shared pseudo-arclength codim-2 curve tracer parameterized by the two extra
- * defining conditions g0,g1 (functions of the Jacobian spectrum + model at a
- * point) and a per-point recorder. Mirrors bt_curve/zh_curve exactly so all
- * three codim-2 curve continuations share one validated continuation core. */
+/* The four codim-2 curves share the minimally augmented engine above: each is
+ * a list of bordered blocks on f_x (plus the cusp coefficient row), traced in
+ * (x, p, q, r, frequencies) from a start located at fixed r. */
 namespace {
 struct C2CurveSpec {
   std::size_t nmin;                 /* minimum state dimension required */
-  /* compute the two extra residuals from (model-at-(q,r), x, p); return false on failure */
-  std::function<bool(const Model3&,double,double,const std::vector<double>&,double,double*,double*)> conds;
+  std::vector<BorderKind> blocks;
+  bool cusp = false;
   /* fill point.a, point.b after a converged sample */
   std::function<void(const Model3&,double,double,BTCurvePoint&)> record_nf;
   const char *name;
+  const char *too_small;            /* message when n < nmin */
 };
 
 BTCurve trace_codim2_curve(const Model3 &m, const std::vector<double> &x0,
@@ -1732,123 +2829,92 @@ BTCurve trace_codim2_curve(const Model3 &m, const std::vector<double> &x0,
                            const BTCurveSettings &settings, const C2CurveSpec &spec) {
   BTCurve C;
   const std::size_t n = m.n;
-  if (n < spec.nmin || x0.size() < n) { C.message = std::string(spec.name)+": system dimension too small"; return C; }
-  const std::size_t NU = n + 3, NE = n + 2;
-  auto eval_G = [&](const std::vector<double> &U, std::vector<double> *G) -> bool {
-    std::vector<double> x(U.begin(), U.begin()+n); double p=U[n], q=U[n+1], r=U[n+2];
-    Model mm; mm.n=n;
-    mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    std::vector<double> f(n); std::string e;
-    if (!mm.vector_field(x.data(), p, f.data(), &e)) return false;
-    double g0=0,g1=0; if (!spec.conds(m,q,r,x,p,&g0,&g1)) return false;
-    G->assign(NE,0.0); for (std::size_t i=0;i<n;i++) (*G)[i]=f[i];
-    (*G)[n]=g0; (*G)[n+1]=g1; return true;
-  };
-  auto eval_Jac = [&](const std::vector<double> &U, std::vector<double> *Jg) -> bool {
-    std::vector<double> G0; if (!eval_G(U,&G0)) return false;
-    Jg->assign(NE*NU,0.0); std::vector<double> Up=U, Gp;
-    for (std::size_t c=0;c<NU;c++){ const double sv=Up[c]; const double dh=1e-7*(std::fabs(sv)+1e-3);
-      Up[c]=sv+dh; if(!eval_G(Up,&Gp)){Up[c]=sv;return false;} Up[c]=sv;
-      for (std::size_t rr=0;rr<NE;rr++) (*Jg)[rr*NU+c]=(Gp[rr]-G0[rr])/dh; }
+  if (n < spec.nmin || x0.size() < n) { C.message = spec.too_small; return C; }
+  MinAugSys sys = minaug_sys(m);
+  sys.cusp = spec.cusp;
+  std::size_t nhopf = 0;
+  for (BorderKind k : spec.blocks) {
+    BorderBlock b; b.kind = k;
+    if (k == BorderKind::Hopf) b.kappa = n + 3 + nhopf++;
+    sys.blocks.push_back(b);
+  }
+  std::vector<double> U(sys.unknowns(), 0.0);
+  for (std::size_t i = 0; i < n; ++i) U[i] = x0[i];
+  U[n] = p0; U[n + 1] = q0; U[n + 2] = r0;
+  MinAugEval ev;
+  if (nhopf > 0) {
+    std::vector<double> J, kap;
+    if (!ma_jac(sys, U.data(), U.data() + n, &J) || !ma_kappas(J, n, nhopf, &kap)) {
+      C.message = std::string(spec.name) + ": no complex eigenvalue pair at the start";
+      return C;
+    }
+    for (std::size_t h = 0; h < nhopf; ++h) U[n + 3 + h] = kap[h];
+  }
+  if (!ma_init(&sys, U, &ev)) { C.message = std::string(spec.name) + ": singular bordered system at the start"; return C; }
+
+  MinAugTrace tr;
+  tr.h0 = settings.ds;
+  tr.steps = settings.max_points;
+  tr.max_iters = settings.max_corrector_iters;
+  tr.tol = settings.corrector_tol;
+  tr.seed = n + 2;
+  tr.record_start = true;
+  tr.inside = [&](const std::vector<double> &u) {
+    return u[n] >= settings.p_min && u[n] <= settings.p_max && u[n + 1] >= settings.q_min &&
+           u[n + 1] <= settings.q_max && u[n + 2] >= settings.r_min && u[n + 2] <= settings.r_max;
+  };
+  tr.valid = [&](const std::vector<double> &u) {
+    for (std::size_t h = 0; h < nhopf; ++h)
+      if (!(u[n + 3 + h] > 0.0)) return false;
     return true;
   };
-  auto tangent = [&](const std::vector<double> &U, std::vector<double> *t) -> bool {
-    std::vector<double> Jg; if (!eval_Jac(U,&Jg)) return false;
-    double best=-1; std::vector<double> bestv(NU,0.0);
-    for (std::size_t k=0;k<NU;k++){
-      std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-      for (std::size_t rr=0;rr<NE;rr++) for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc];
-      M[NE*NU+k]=1.0; rhs[NE]=1.0;
-      std::vector<double> v; if (!solve_linear(M, rhs, &v)) continue;
-      double nrm=0; for(double z:v) nrm+=z*z; nrm=std::sqrt(nrm);
-      if (nrm>best){ best=nrm; bestv=v; }
-    }
-    if (best<=0) return false;
-    for(double&z:bestv) z/=best;
-    *t=bestv; return true;
-  };
-  std::vector<double> U(NU,0.0);
-  for (std::size_t i=0;i<n;i++) U[i]=x0[i];
-  U[n]=p0; U[n+1]=q0; U[n+2]=r0;
-  { std::vector<double> G;
-    for (int it=0; it<60; ++it) {
-      if (!eval_G(U,&G)) { C.message=std::string(spec.name)+": start eval failed"; return C; }
-      double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn); if (rn<1e-10) break;
-      std::vector<double> Jg; if(!eval_Jac(U,&Jg)){ C.message=std::string(spec.name)+": start Jac failed"; return C; }
-      std::vector<double> JtJ(NU*NU,0.0), Jtb(NU,0.0);
-      for(std::size_t a=0;a<NU;a++){ double s=0; for(std::size_t rr=0;rr<NE;rr++) s+=Jg[rr*NU+a]*G[rr]; Jtb[a]=-s;
-        for(std::size_t b2=0;b2<NU;b2++){ double t=0; for(std::size_t rr=0;rr<NE;rr++) t+=Jg[rr*NU+a]*Jg[rr*NU+b2]; JtJ[a*NU+b2]=t; } }
-      for(std::size_t a=0;a<NU;a++) JtJ[a*NU+a]+=1e-10;
-      std::vector<double> dU; if(!solve_linear(JtJ,Jtb,&dU)) break;
-      double dn=0; for(double v:dU) dn+=v*v; dn=std::sqrt(dn);
-      double damp = dn>0.5?0.5/dn:1.0;
-      for(std::size_t a=0;a<NU;a++) U[a]+=damp*dU[a];
-    }
-  }
-  auto record = [&](const std::vector<double> &Uv){
-    BTCurvePoint P; P.x.assign(Uv.begin(), Uv.begin()+n); P.p=Uv[n]; P.q=Uv[n+1]; P.r=Uv[n+2];
-    std::vector<double> G; if (eval_G(Uv,&G)) { double rn=0; for(double g:G) rn+=g*g; P.residual=std::sqrt(rn); }
+  tr.record = [&](const std::vector<double> &u) {
+    BTCurvePoint P; P.x.assign(u.begin(), u.begin() + n); P.p = u[n]; P.q = u[n + 1]; P.r = u[n + 2];
+    double rn = 0; for (double g : ev.F) rn += g * g; P.residual = std::sqrt(rn);
     spec.record_nf(m, P.q, P.r, P);
     C.points.push_back(P);
   };
-  std::vector<double> t0; if (!tangent(U,&t0)) { C.message=std::string(spec.name)+": could not find a tangent at the start"; return C; }
-  for (int dir=0; dir<2; ++dir) {
-    std::vector<double> Uc=U, tc=t0;
-    if (dir==1) for(double&z:tc) z=-z;
-    if (dir==0) record(Uc);
-    std::vector<double> tprev=tc;
-    for (int step=0; step<settings.max_points; ++step) {
-      std::vector<double> Up(NU); for(std::size_t i=0;i<NU;i++) Up[i]=Uc[i]+settings.ds*tprev[i];
-      bool conv=false;
-      for (int it=0; it<settings.max_corrector_iters; ++it) {
-        std::vector<double> G; if(!eval_G(Up,&G)) break;
-        double arc=0; for(std::size_t i=0;i<NU;i++) arc+=(Up[i]-( Uc[i]+settings.ds*tprev[i]))*tprev[i];
-        double rn=0; for(double g:G) rn+=g*g; rn=std::sqrt(rn+arc*arc);
-        if (rn<settings.corrector_tol) { conv=true; break; }
-        std::vector<double> Jg; if(!eval_Jac(Up,&Jg)) break;
-        std::vector<double> M(NU*NU,0.0), rhs(NU,0.0);
-        for(std::size_t rr=0;rr<NE;rr++){ for(std::size_t cc=0;cc<NU;cc++) M[rr*NU+cc]=Jg[rr*NU+cc]; rhs[rr]=-G[rr]; }
-        for(std::size_t cc=0;cc<NU;cc++) M[NE*NU+cc]=tprev[cc];
-        rhs[NE]=-arc;
-        std::vector<double> dU; if(!solve_linear(M,rhs,&dU)) break;
-        for(std::size_t i=0;i<NU;i++) Up[i]+=dU[i];
-      }
-      if (!conv) break;
-      if (Up[n]<settings.p_min||Up[n]>settings.p_max||Up[n+1]<settings.q_min||Up[n+1]>settings.q_max||
-          Up[n+2]<settings.r_min||Up[n+2]>settings.r_max) { record(Up); break; }
-      record(Up);
-      std::vector<double> tnew; if (!tangent(Up,&tnew)) break;
-      double dotp=0; for(std::size_t i=0;i<NU;i++) dotp+=tnew[i]*tprev[i];
-      if (dotp<0) for(double&z:tnew) z=-z;
-      Uc=Up; tprev=tnew;
-    }
-  }
+  ma_trace(sys, U, tr, &ev);
   C.ok = C.points.size() >= 2;
   C.message = C.ok ? (std::string("traced ")+spec.name+" curve: "+std::to_string(C.points.size())+" points")
                    : (std::string("could not trace a ")+spec.name+" curve from this start");
   return C;
 }
-} /* anonymous namespace */
+}  // namespace
 
-BTCurve cusp_curve(const Model3 &m, const std::vector<double> &x0,
-                   double p0, double q0, double r0, const BTCurveSettings &settings) {
+BTCurve bt_curve(const Model3 &m, const std::vector<double> &x0,
+                 double p0, double q0, double r0, const BTCurveSettings &settings) {
   C2CurveSpec spec;
-  spec.nmin = 1; spec.name = "cusp";
-  spec.conds = [](const Model3 &m, double q, double r, const std::vector<double> &x, double p,
-                  double *g0, double *g1) -> bool {
+  spec.nmin = 2; spec.name = "BT"; spec.too_small = "BT curve needs a 2+ dim system";
+  spec.blocks = std::vector<BorderKind>{BorderKind::Square};  /* f_x^2 has a 2-D kernel at a double zero */
+  spec.record_nf = [](const Model3 &m, double q, double r, BTCurvePoint &P){
     Model mm; mm.n=m.n;
     mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    std::vector<double> A; std::string e;
-    if (!finite_diff_jacobian(mm, x.data(), p, &A, &e, 1e-7)) return false;
-    std::vector<Complex> ev; if (!eigenvalues(A, m.n, &ev)) return false;
-    /* fold condition: smallest-|.| eigenvalue real part -> 0 */
-    std::sort(ev.begin(), ev.end(), [](const Complex&a,const Complex&b){ return std::abs(a)<std::abs(b); });
-    *g0 = ev[0].real();
-    /* cusp condition: fold normal-form coefficient a -> 0 */
-    double a=0,lam0=0; if (!fold_normal_form(mm, x, p, &a, &lam0, &e)) { *g1 = 0; return true; }
-    *g1 = a;
-    return true;
+    double a=0,b=0; std::string e; if (bt_normal_form(mm,P.x,P.p,&a,&b,&e)){ P.a=a; P.b=b; }
+  };
+  return trace_codim2_curve(m, x0, p0, q0, r0, settings, spec);
+}
+
+BTCurve zh_curve(const Model3 &m, const std::vector<double> &x0,
+                 double p0, double q0, double r0, const BTCurveSettings &settings) {
+  C2CurveSpec spec;
+  spec.nmin = 3; spec.name = "zero-Hopf"; spec.too_small = "zero-Hopf curve needs a 3+ dim system";
+  spec.blocks = std::vector<BorderKind>{BorderKind::Fold, BorderKind::Hopf};
+  spec.record_nf = [](const Model3 &m, double q, double r, BTCurvePoint &P){
+    Model mm; mm.n=m.n;
+    mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
+    double b=0,recc=0,om=0,s=0; std::string e;
+    if (zero_hopf_normal_form(mm,P.x,P.p,&b,&recc,&om,&s,&e)) { P.a=b; P.b=recc; }  /* a<-b, b<-Re(c) */
   };
+  return trace_codim2_curve(m, x0, p0, q0, r0, settings, spec);
+}
+
+BTCurve cusp_curve(const Model3 &m, const std::vector<double> &x0,
+                   double p0, double q0, double r0, const BTCurveSettings &settings) {
+  C2CurveSpec spec;
+  spec.nmin = 1; spec.name = "cusp"; spec.too_small = "cusp: system dimension too small";
+  spec.blocks = std::vector<BorderKind>{BorderKind::Fold};
+  spec.cusp = true;
   spec.record_nf = [](const Model3 &m, double q, double r, BTCurvePoint &P){
     Model mm; mm.n=m.n;
     mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
@@ -1861,32 +2927,8 @@ BTCurve cusp_curve(const Model3 &m, const std::vector<double> &x0,
 BTCurve hh_curve(const Model3 &m, const std::vector<double> &x0,
                  double p0, double q0, double r0, const BTCurveSettings &settings) {
   C2CurveSpec spec;
-  spec.nmin = 4; spec.name = "Hopf-Hopf";
-  spec.conds = [](const Model3 &m, double q, double r, const std::vector<double> &x, double p,
-                  double *g0, double *g1) -> bool {
-    Model mm; mm.n=m.n;
-    mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
-    std::vector<double> A; std::string e;
-    if (!finite_diff_jacobian(mm, x.data(), p, &A, &e, 1e-7)) return false;
-    std::vector<Complex> ev; if (!eigenvalues(A, m.n, &ev)) return false;
-    /* two least-damped DISTINCT complex pairs (positive imaginary reps),
-     * require both real parts -> 0. */
-    std::vector<std::pair<double,double>> pairs; /* (|Re|, Re) by ascending imag-grouped */
-    std::vector<Complex> pos;
-    for (const auto &lam : ev) if (lam.imag() > 1e-6) pos.push_back(lam);
-    std::sort(pos.begin(), pos.end(), [](const Complex&a,const Complex&b){ return a.imag()<b.imag(); });
-    /* dedup by frequency */
-    std::vector<Complex> dist;
-    for (auto &z : pos) { if (dist.empty() || std::fabs(z.imag()-dist.back().imag())>1e-4*(1+z.imag())) dist.push_back(z); }
-    if (dist.size() < 2) { /* not two pairs yet: drive both toward the axis using the two smallest|Re| pairs */
-      if (pos.size()>=2){ *g0=pos[0].real(); *g1=pos[1].real(); return true; }
-      if (pos.size()==1){ *g0=pos[0].real(); *g1=pos[0].real(); return true; }
-      *g0=ev[0].real(); *g1=ev.size()>1?ev[1].real():ev[0].real(); return true;
-    }
-    *g0 = dist[0].real();
-    *g1 = dist[1].real();
-    return true;
-  };
+  spec.nmin = 4; spec.name = "Hopf-Hopf"; spec.too_small = "Hopf-Hopf: system dimension too small";
+  spec.blocks = std::vector<BorderKind>{BorderKind::Hopf, BorderKind::Hopf};  /* the two least-damped distinct pairs */
   spec.record_nf = [](const Model3 &m, double q, double r, BTCurvePoint &P){
     Model mm; mm.n=m.n;
     mm.vector_field=[&m,q,r](const double*xx,double pp,double*fo,std::string*er){ return m.vector_field(xx,pp,q,r,fo,er); };
@@ -1906,7 +2948,13 @@ namespace {
  * which is m*n equations, plus one phase condition fixing the orbit's phase:
  *   <X[0] - Xprev[0], f(Xprev[0])> = 0  (orthogonality to the reference field;
  *   for the first solve we instead pin the first coordinate of X[0] to its
- *   guess, which is robust). */
+ *   guess, which is robust).
+ * With ncol > 0 the same m points are grouped into m/ncol intervals of ncol
+ * points each: interval i carries the polynomial through its points
+ * X[i*ncol .. i*ncol+ncol] (equally spaced in time, the last one shared with
+ * the next interval), and its ncol*n equations are
+ *   u'(zeta_c) - T h_i f(u(zeta_c)) = 0   at the ncol Gauss-Legendre points,
+ * i.e. MATCONT-style orthogonal collocation, still m*n equations. */
 struct CycleCtx {
   const Model *m;
   double p;
@@ -1921,8 +2969,84 @@ struct CycleCtx {
    * more points where the orbit moves fast / curves sharply (stiff relaxation
    * cycles), which a uniform-in-time mesh resolves poorly. */
   std::vector<double> frac;
+  std::size_t ncol = 0;            /* 0: trapezoidal; >= 1: Gauss collocation */
+  std::size_t intervals() const { return ncol ? mesh / ncol : mesh; }
+  /* corrector strategy of cyc_newton (CycleSettings), carried by copies */
+  CorrectorKind corrector = CorrectorKind::Newton;
+  double contraction = 0.5;
+  CorrectorCounts *counts = nullptr;
+};
+
+/* Gauss-Legendre collocation data for ncol points per interval: the nodes
+ * zeta_c on [0,1] and, at each of them, the Lagrange basis l_j and its
+ * derivative for the ncol+1 equally spaced basis points tau_j = j/ncol. */
+struct ColTab {
+  std::vector<double> zeta, l, d;  /* l, d: ncol x (ncol+1), row-major */
 };
 
+void lagrange_basis(std::size_t nc, double t, double *l, double *d) {
+  for (std::size_t j = 0; j <= nc; ++j) {
+    const double tj = (double)j / (double)nc;
+    double v = 1.0, dv = 0.0;
+    for (std::size_t k = 0; k <= nc; ++k) {
+      if (k == j) continue;
+      const double den = tj - (double)k / (double)nc, num = t - (double)k / (double)nc;
+      dv = dv * num / den + v / den;
+      v *= num / den;
+    }
+    l[j] = v;
+    if (d) d[j] = dv;
+  }
+}
+
+const ColTab &colloc_table(std::size_t nc) {
+  static const std::vector<ColTab> tabs = [] {
+    std::vector<ColTab> t(8);
+    for (std::size_t m = 1; m < t.size(); ++m) {
+      ColTab &tb = t[m];
+      tb.l.assign(m * (m + 1), 0.0); tb.d.assign(m * (m + 1), 0.0);
+      for (std::size_t k = 0; k < m; ++k) {
+        /* Newton on the Legendre polynomial P_m from the Chebyshev-like guess */
+        double x = std::cos(M_PI * ((double)k + 0.75) / ((double)m + 0.5));
+        for (int it = 0; it < 100; ++it) {
+          double p0 = 1.0, p1 = x;
+          for (std::size_t j = 2; j <= m; ++j) { const double p2 = ((2.0 * j - 1) * x * p1 - (j - 1.0) * p0) / j; p0 = p1; p1 = p2; }
+          const double dp = m == 1 ? 1.0 : (double)m * (x * p1 - p0) / (x * x - 1.0), dx = p1 / dp;
+          x -= dx;
+          if (std::fabs(dx) < 1e-16) break;
+        }
+        tb.zeta.push_back(0.5 * (1.0 - x));   /* ascending on [0,1] */
+      }
+      for (std::size_t c = 0; c < m; ++c) lagrange_basis(m, tb.zeta[c], &tb.l[c * (m + 1)], &tb.d[c * (m + 1)]);
+    }
+    return t;
+  }();
+  return tabs[nc];
+}
+
+/* the orbit at normalized period-time s in [0,1): linear between the points
+ * for the trapezoidal scheme, the interval's collocation polynomial otherwise */
+void cyc_eval(const CycleCtx &c, const std::vector<double> &U, double s, double *x) {
+  const std::size_t n = c.n, M = c.mesh, NI = c.intervals(), nc = c.ncol ? c.ncol : 1;
+  s -= std::floor(s);
+  std::size_t i = 0;
+  double t0 = 0.0, w = 1.0 / (double)NI;
+  for (; i < NI; ++i) {
+    w = c.frac.size() == NI ? c.frac[i] : 1.0 / (double)NI;
+    if (s < t0 + w || i + 1 == NI) break;
+    t0 += w;
+  }
+  const double t = w > 1e-15 ? std::min(1.0, std::max(0.0, (s - t0) / w)) : 0.0;
+  double l[8];
+  if (c.ncol) lagrange_basis(nc, t, l, nullptr);
+  else { l[0] = 1.0 - t; l[1] = t; }
+  for (std::size_t k = 0; k < n; ++k) x[k] = 0.0;
+  for (std::size_t j = 0; j <= nc; ++j) {
+    const double *P = &U[((i * nc + j) % M) * n];
+    for (std::size_t k = 0; k < n; ++k) x[k] += l[j] * P[k];
+  }
+}
+
 bool cyc_field(const CycleCtx &c, const double *x, std::vector<double> *f) {
   f->assign(c.n, 0.0);
   std::string err;
@@ -1935,8 +3059,25 @@ bool cyc_residual(const CycleCtx &c, const std::vector<double> &U, std::vector<d
   const double T = U[M * n];
   Fout->assign(M * n + 1, 0.0);
   std::vector<double> fi(n), fj(n), xi(n), xj(n);
-  for (std::size_t i = 0; i < M; ++i) {
-    const std::size_t j = (i + 1) % M;
+  if (c.ncol) {
+    const std::size_t nc = c.ncol, NI = c.intervals();
+    const ColTab &tb = colloc_table(nc);
+    for (std::size_t i = 0; i < NI; ++i) {
+      const double hi = T * ((c.frac.size() == NI) ? c.frac[i] : 1.0 / (double)NI);
+      for (std::size_t q = 0; q < nc; ++q) {
+        double *r = &(*Fout)[(i * nc + q) * n];
+        std::fill(xi.begin(), xi.end(), 0.0);
+        for (std::size_t j = 0; j <= nc; ++j) {
+          const double *P = &U[((i * nc + j) % M) * n], l = tb.l[q * (nc + 1) + j], d = tb.d[q * (nc + 1) + j];
+          for (std::size_t k = 0; k < n; ++k) { xi[k] += l * P[k]; r[k] += d * P[k]; }
+        }
+        if (!cyc_field(c, xi.data(), &fi)) return false;
+        for (std::size_t k = 0; k < n; ++k) r[k] -= hi * fi[k];
+      }
+    }
+  }
+  for (std::size_t i = 0; i < M && !c.ncol; ++i) {
+    const std::size_t j = (i + 1) % M;
     for (std::size_t k = 0; k < n; ++k) { xi[k] = U[i*n+k]; xj[k] = U[j*n+k]; }
     if (!cyc_field(c, xi.data(), &fi)) return false;
     if (!cyc_field(c, xj.data(), &fj)) return false;
@@ -1970,6 +3111,70 @@ bool cyc_remesh(CycleCtx &c, const std::vector<double> &U, std::vector<double> *
   if (M < 4) return false;
   const double T = U[M * n];
   if (!(T > 0)) return false;
+  if (c.ncol) {
+    /* de Boor's monitor for degree-ncol collocation (as AUTO / MATCONT): the
+     * error on interval i goes like h_i^(ncol+1) |u^(ncol+1)|, so equidistribute
+     * |u^(ncol+1)|^(1/(ncol+1)), estimating u^(ncol+1) from the jumps of the
+     * piecewise-constant ncol-th derivative between neighbouring intervals.
+     * The new interval's points are the old collocation polynomials evaluated
+     * at their new times. */
+    const std::size_t nc = c.ncol, NI = c.intervals();
+    if (NI < 4) return false;
+    std::vector<double> fr(NI), w(NI, 0.0), dm(NI * n, 0.0), diff(nc + 1);
+    double wsum = 0.0;
+    for (std::size_t i = 0; i < NI; ++i) {
+      fr[i] = (c.frac.size() == NI) ? c.frac[i] : 1.0 / (double)NI;
+      /* ncol-th derivative of the interpolant through equally spaced points:
+       * the ncol-th forward difference over (h/ncol)^ncol */
+      const double scale = std::pow((double)nc / fr[i], (double)nc);
+      for (std::size_t k = 0; k < n; ++k) {
+        for (std::size_t j = 0; j <= nc; ++j) diff[j] = U[((i * nc + j) % M) * n + k];
+        for (std::size_t o = 1; o <= nc; ++o)
+          for (std::size_t j = nc; j >= o; --j) diff[j] -= diff[j - 1];
+        dm[i * n + k] = diff[nc] * scale;
+      }
+    }
+    for (std::size_t i = 0; i < NI; ++i) {
+      const std::size_t a = (i + NI - 1) % NI, b = (i + 1) % NI;
+      double ja = 0.0, jb = 0.0;
+      for (std::size_t k = 0; k < n; ++k) {
+        ja += (dm[i * n + k] - dm[a * n + k]) * (dm[i * n + k] - dm[a * n + k]);
+        jb += (dm[b * n + k] - dm[i * n + k]) * (dm[b * n + k] - dm[i * n + k]);
+      }
+      const double d = 0.5 * (std::sqrt(ja) / (0.5 * (fr[a] + fr[i])) + std::sqrt(jb) / (0.5 * (fr[i] + fr[b])));
+      w[i] = fr[i] * std::pow(d, 1.0 / (double)(nc + 1));
+      wsum += w[i];
+    }
+    if (!(wsum > 0) || !std::isfinite(wsum)) return false;
+    /* floor: keep a share of the points uniform in time so smooth arcs are
+     * never starved */
+    for (std::size_t i = 0; i < NI; ++i) w[i] += 0.1 * wsum * fr[i];
+    wsum *= 1.1;
+    std::vector<double> cum(NI + 1, 0.0), tcum(NI + 1, 0.0), tnew(NI + 1, 0.0);
+    for (std::size_t i = 0; i < NI; ++i) { cum[i + 1] = cum[i] + w[i] / wsum; tcum[i + 1] = tcum[i] + fr[i]; }
+    for (std::size_t k = 0; k <= NI; ++k) {
+      const double target = (double)k / (double)NI;
+      std::size_t s = 0;
+      while (s < NI && cum[s + 1] < target) ++s;
+      if (s >= NI) s = NI - 1;
+      const double seg = cum[s + 1] - cum[s];
+      tnew[k] = tcum[s] + (seg > 1e-15 ? (target - cum[s]) / seg : 0.0) * fr[s];
+    }
+    std::vector<double> newfrac(NI);
+    double fsum = 0.0;
+    for (std::size_t i = 0; i < NI; ++i) { newfrac[i] = std::max(1e-9, tnew[i + 1] - tnew[i]); fsum += newfrac[i]; }
+    Unew->assign(M * n + 1, 0.0);
+    double t = 0.0;
+    for (std::size_t i = 0; i < NI; ++i) {
+      newfrac[i] /= fsum;
+      for (std::size_t j = 0; j < nc; ++j)
+        cyc_eval(c, U, t + newfrac[i] * (double)j / (double)nc, &(*Unew)[(i * nc + j) * n]);
+      t += newfrac[i];
+    }
+    (*Unew)[M * n] = T;
+    c.frac = newfrac;
+    return true;
+  }
 
   /* current interval time fractions (uniform or existing adaptive) */
   std::vector<double> fr(M);
@@ -2041,32 +3246,572 @@ bool cyc_remesh(CycleCtx &c, const std::vector<double> &U, std::vector<double> *
   return true;
 }
 
-/* Newton solve of the collocation system; returns refined U. Uses a finite-
- * difference Jacobian (dense (M*n+1)^2) — fine for the modest mesh sizes here.*/
-bool cyc_newton(const CycleCtx &c, std::vector<double> *U, int iters, double tol) {
-  const std::size_t N = c.mesh * c.n + 1;
-  std::vector<double> F0, Fp;
-  for (int it = 0; it < iters; ++it) {
-    if (!cyc_residual(c, *U, &F0)) return false;
-    double res = 0; for (double v : F0) res += v*v; res = std::sqrt(res);
-    if (res < tol) return true;
-    std::vector<double> J(N * N, 0.0);
-    std::vector<double> Ut = *U;
-    for (std::size_t j = 0; j < N; ++j) {
-      const double save = Ut[j]; const double dh = 1e-7 * (std::fabs(save) + 1.0);
-      Ut[j] = save + dh;
-      if (!cyc_residual(c, Ut, &Fp)) return false;
-      for (std::size_t i = 0; i < N; ++i) J[i*N+j] = (Fp[i] - F0[i]) / dh;
-      Ut[j] = save;
-    }
-    std::vector<double> b(N); for (std::size_t i = 0; i < N; ++i) b[i] = -F0[i];
-    std::vector<double> du;
-    if (!solve_linear(J, b, &du)) return false;
-    /* damped step for robustness */
-    double nrm = 0; for (double v : du) nrm += v*v; nrm = std::sqrt(nrm);
-    double damp = (nrm > 1.0) ? 1.0 / nrm : 1.0;
-    for (std::size_t j = 0; j < N; ++j) (*U)[j] += damp * du[j];
+/* ---- block-structured collocation Jacobian --------------------------------
+ * Interval i's n residual rows touch only its two end points, so the Jacobian
+ * of the periodic BVP is cyclic block-bidiagonal, bordered by nb columns z
+ * (the period, plus the parameter in arclength mode) and nb dense rows (the
+ * phase condition, plus the arclength / tangent row):
+ *
+ *     [ A_0  B_0                  C_0     ]   interval i:
+ *     [      A_1  B_1             C_1     ]     A_i X_i + B_i X_{i+1} + C_i z
+ *     [             ...           ...     ]   with X_M = X_0
+ *     [ B_M-1            A_M-1    C_M-1   ]
+ *     [ D_0  D_1  ...    D_M-1    E       ]   nb border rows
+ *
+ * Only these blocks are stored: O(M n^2) memory instead of O((M n)^2).
+ * A boundary map Q replaces X_M = X_0 by X_M = Q X_0 (anti-periodic for the
+ * period-doubling test, the doubled Neimark-Sacker system); empty means Q = I.
+ * For Gauss collocation (ncol > 0) interval i has ncol*n rows over all of its
+ * ncol+1 points, stored whole in L (C then has ncol*n rows per interval, D
+ * spans every point); cyc_factor condenses the ncol-1 interior points of each
+ * interval away locally, which leaves exactly the A_i / B_i form above. */
+struct CycleJac {
+  std::size_t n = 0, M = 0, nb = 0, ncol = 0;  /* M = intervals */
+  std::vector<double> A, B;  /* M blocks of n x n, row-major */
+  std::vector<double> L;     /* ncol > 0: M blocks of ncol*n x (ncol+1)*n */
+  std::vector<double> C;     /* M blocks of n x nb (ncol*n x nb) */
+  std::vector<double> D;     /* nb rows of length points()*n */
+  std::vector<double> E;     /* nb x nb */
+  std::vector<double> Q;     /* n x n boundary map, empty: periodic */
+  void resize(std::size_t n_, std::size_t M_, std::size_t nb_, std::size_t ncol_ = 0) {
+    n = n_; M = M_; nb = nb_; ncol = ncol_;
+    const std::size_t r = ncol ? ncol * n : n;
+    A.assign(ncol ? 0 : M * n * n, 0.0); B.assign(ncol ? 0 : M * n * n, 0.0);
+    L.assign(ncol ? M * r * (r + n) : 0, 0.0);
+    C.assign(M * r * nb, 0.0); D.assign(nb * points() * n, 0.0); E.assign(nb * nb, 0.0);
+    Q.clear();
+  }
+  std::size_t points() const { return ncol ? M * ncol : M; }
+  std::size_t size() const { return points() * n + nb; }
+};
+
+/* Structured LU of a CycleJac ("condensation"). X_1 .. X_{M-1} are eliminated
+ * in turn: the n rows carried over from the previous step and interval k's own
+ * n rows are stacked and X_k is eliminated with partial pivoting over those 2n
+ * rows, which leaves n new carried rows in (X_0, X_{k+1}, z). The border rows
+ * are reduced alongside. What remains is a dense (n + nb) system in (X_0, z).
+ * O(M n^3) time; the pivots also give det(J) without over/underflow. */
+struct CycleLU {
+  std::size_t n = 0, M = 0, nb = 0, w = 0;  /* w = 3n + nb: stacked row width */
+  std::vector<double> S;           /* per step: 2n x w stack, LU multipliers below */
+  std::vector<std::size_t> piv;    /* per step: n row interchanges */
+  std::vector<double> G;           /* per step: nb x n border-row multipliers */
+  std::vector<double> R;           /* final (n+nb)^2 dense LU */
+  std::vector<std::size_t> rpiv;
+  double sign = 0.0, logdet = 0.0; /* det(J) = sign * exp(logdet) */
+  /* Gauss collocation: per interval the ncol*n x lw local elimination over
+   * [interior points | X_i | X_i+1 | z], its row interchanges and the border
+   * multipliers; the fields above then factor the condensed system */
+  std::size_t ncol = 0, lw = 0;
+  std::vector<double> LS, LG;
+  std::vector<std::size_t> lpiv;
+  /* the interval rows condensed to P0 X_0 + P1 X_M (n x n each, z terms
+   * dropped): the discrete monodromy matrix is -P1^{-1} P0 */
+  std::vector<double> P0, P1;
+  std::vector<double> Q;           /* the CycleJac's boundary map */
+};
+
+bool cyc_factor_blocks(const CycleJac &J, CycleLU *lu) {
+  const std::size_t n = J.n, M = J.M, nb = J.nb, w = 3 * n + nb, nf = n + nb;
+  const std::size_t N = J.size();
+  lu->n = n; lu->M = M; lu->nb = nb; lu->w = w; lu->ncol = 0;
+  lu->sign = 0.0; lu->logdet = 0.0;
+  lu->Q = J.Q;
+  const bool qmap = J.Q.size() == n * n;
+  if (n == 0 || M < 2) return false;
+  lu->S.assign((M - 1) * 2 * n * w, 0.0);
+  lu->piv.assign((M - 1) * n, 0);
+  lu->G.assign((M - 1) * nb * n, 0.0);
+  /* stack segments: [X_k | X_0 | X_{k+1} | z] at offsets 0, n, 2n, 3n */
+  std::vector<double> carry(n * w, 0.0), bd(nb * w, 0.0);
+  std::vector<std::size_t> carry_id(n), ids(2 * n), order;
+  order.reserve(N);
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t c = 0; c < n; ++c) {
+      carry[r * w + c] = J.B[r * n + c];
+      carry[r * w + n + c] = J.A[r * n + c];
+    }
+    for (std::size_t c = 0; c < nb; ++c) carry[r * w + 3 * n + c] = J.C[r * nb + c];
+    carry_id[r] = r;
+  }
+  for (std::size_t b = 0; b < nb; ++b) {
+    const double *d = &J.D[b * M * n];
+    for (std::size_t c = 0; c < n; ++c) {
+      bd[b * w + c] = d[n + c];
+      bd[b * w + n + c] = d[c];
+      if (M > 2) bd[b * w + 2 * n + c] = d[2 * n + c];
+    }
+    for (std::size_t c = 0; c < nb; ++c) bd[b * w + 3 * n + c] = J.E[b * nb + c];
+  }
+  double sign = 1.0, logdet = 0.0;
+  for (std::size_t k = 1; k < M; ++k) {
+    double *S = &lu->S[(k - 1) * 2 * n * w];
+    std::size_t *pv = &lu->piv[(k - 1) * n];
+    double *G = &lu->G[(k - 1) * nb * n];
+    std::copy(carry.begin(), carry.end(), S);
+    for (std::size_t r = 0; r < n; ++r) {
+      double *row = S + (n + r) * w;
+      /* the last interval's B goes to X_M, kept apart from X_0 until the end
+       * so the open chain P0 X_0 + P1 X_M is available to cyc_monodromy */
+      for (std::size_t c = 0; c < n; ++c) {
+        row[c] = J.A[k * n * n + r * n + c];
+        row[2 * n + c] = J.B[k * n * n + r * n + c];
+      }
+      for (std::size_t c = 0; c < nb; ++c) row[3 * n + c] = J.C[k * n * nb + r * nb + c];
+      ids[r] = carry_id[r];
+      ids[n + r] = k * n + r;
+    }
+    for (std::size_t col = 0; col < n; ++col) {
+      std::size_t p = col;
+      for (std::size_t r = col + 1; r < 2 * n; ++r)
+        if (std::fabs(S[r * w + col]) > std::fabs(S[p * w + col])) p = r;
+      const double d = S[p * w + col];
+      if (!(std::fabs(d) > 1e-300)) return false;
+      pv[col] = p;
+      if (p != col) {
+        for (std::size_t c = 0; c < w; ++c) std::swap(S[p * w + c], S[col * w + c]);
+        std::swap(ids[p], ids[col]);
+      }
+      if (d < 0) sign = -sign;
+      logdet += std::log(std::fabs(d));
+      const double inv = 1.0 / d;
+      const double *pr = S + col * w;
+      for (std::size_t r = col + 1; r < 2 * n; ++r) {
+        double *row = S + r * w;
+        const double l = row[col] * inv;
+        row[col] = l;
+        if (l != 0.0) for (std::size_t c = col + 1; c < w; ++c) row[c] -= l * pr[c];
+      }
+    }
+    order.insert(order.end(), ids.begin(), ids.begin() + n);
+    /* border rows: eliminate X_k against the pivot rows */
+    for (std::size_t b = 0; b < nb; ++b) {
+      double *row = &bd[b * w];
+      for (std::size_t col = 0; col < n; ++col) {
+        const double l = row[col] / S[col * w + col];
+        G[b * n + col] = l;
+        row[col] = 0.0;
+        if (l != 0.0) for (std::size_t c = col + 1; c < w; ++c) row[c] -= l * S[col * w + c];
+      }
+    }
+    /* shift: the new carry / border rows are over [X_{k+1} | X_0 | X_{k+2} | z] */
+    std::fill(carry.begin(), carry.end(), 0.0);
+    for (std::size_t r = 0; r < n; ++r) {
+      const double *src = S + (n + r) * w;
+      double *dst = &carry[r * w];
+      for (std::size_t c = 0; c < n; ++c) { dst[c] = src[2 * n + c]; dst[n + c] = src[n + c]; }
+      for (std::size_t c = 0; c < nb; ++c) dst[3 * n + c] = src[3 * n + c];
+      carry_id[r] = ids[n + r];
+    }
+    for (std::size_t b = 0; b < nb; ++b) {
+      double *row = &bd[b * w];
+      for (std::size_t c = 0; c < n; ++c) {
+        row[c] = row[2 * n + c];
+        row[2 * n + c] = (k + 2 < M) ? J.D[b * M * n + (k + 2) * n + c] : 0.0;
+      }
+    }
+  }
+  /* the carried rows now read P0 X_0 + P1 X_M + (z terms) */
+  lu->P0.assign(n * n, 0.0); lu->P1.assign(n * n, 0.0);
+  for (std::size_t r = 0; r < n; ++r)
+    for (std::size_t c = 0; c < n; ++c) {
+      lu->P0[r * n + c] = carry[r * w + n + c];
+      lu->P1[r * n + c] = carry[r * w + c];
+    }
+  /* remaining dense system in (X_0, z), X_M = Q X_0: carried rows, then
+   * border rows */
+  lu->R.assign(nf * nf, 0.0);
+  lu->rpiv.assign(nf, 0);
+  std::vector<std::size_t> rid(nf);
+  for (std::size_t r = 0; r < nf; ++r) {
+    const double *src = r < n ? &carry[r * w] : &bd[(r - n) * w];
+    for (std::size_t c = 0; c < n; ++c) {
+      double v = src[n + c];
+      if (qmap) for (std::size_t j = 0; j < n; ++j) v += src[j] * J.Q[j * n + c];
+      else v += src[c];
+      lu->R[r * nf + c] = v;
+    }
+    for (std::size_t c = 0; c < nb; ++c) lu->R[r * nf + n + c] = src[3 * n + c];
+    rid[r] = r < n ? carry_id[r] : M * n + (r - n);
+  }
+  double *Rm = lu->R.data();
+  for (std::size_t col = 0; col < nf; ++col) {
+    std::size_t p = col;
+    for (std::size_t r = col + 1; r < nf; ++r)
+      if (std::fabs(Rm[r * nf + col]) > std::fabs(Rm[p * nf + col])) p = r;
+    const double d = Rm[p * nf + col];
+    if (!(std::fabs(d) > 1e-300)) return false;
+    lu->rpiv[col] = p;
+    if (p != col) {
+      for (std::size_t c = 0; c < nf; ++c) std::swap(Rm[p * nf + c], Rm[col * nf + c]);
+      std::swap(rid[p], rid[col]);
+    }
+    if (d < 0) sign = -sign;
+    logdet += std::log(std::fabs(d));
+    for (std::size_t r = col + 1; r < nf; ++r) {
+      const double l = Rm[r * nf + col] / d;
+      Rm[r * nf + col] = l;
+      if (l != 0.0) for (std::size_t c = col + 1; c < nf; ++c) Rm[r * nf + c] -= l * Rm[col * nf + c];
+    }
+  }
+  order.insert(order.end(), rid.begin(), rid.end());
+  /* det(J) = sign(row order) * sign(column order) * prod(pivots); the columns
+   * were taken as X_1 .. X_{M-1}, X_0, z, i.e. X_0 moved past (M-1) n columns */
+  std::vector<char> seen(N, 0);
+  for (std::size_t i = 0; i < N; ++i) {
+    if (seen[i]) continue;
+    std::size_t len = 0;
+    for (std::size_t j = i; !seen[j]; j = order[j]) { seen[j] = 1; ++len; }
+    if (len % 2 == 0) sign = -sign;
+  }
+  if ((n * n * (M - 1)) % 2 == 1) sign = -sign;
+  lu->sign = sign;
+  lu->logdet = logdet;
+  return true;
+}
+
+void cyc_solve_blocks(const CycleLU &lu, const std::vector<double> &rhs, std::vector<double> *x) {
+  const std::size_t n = lu.n, M = lu.M, nb = lu.nb, w = lu.w, nf = n + nb;
+  x->assign(M * n + nb, 0.0);
+  std::vector<double> t((M - 1) * n), st(2 * n), br(nb), y(nf);
+  std::vector<double> cr(rhs.begin(), rhs.begin() + n);
+  for (std::size_t b = 0; b < nb; ++b) br[b] = rhs[M * n + b];
+  for (std::size_t k = 1; k < M; ++k) {
+    const double *S = &lu.S[(k - 1) * 2 * n * w];
+    const std::size_t *pv = &lu.piv[(k - 1) * n];
+    const double *G = &lu.G[(k - 1) * nb * n];
+    for (std::size_t r = 0; r < n; ++r) { st[r] = cr[r]; st[n + r] = rhs[k * n + r]; }
+    for (std::size_t col = 0; col < n; ++col) std::swap(st[col], st[pv[col]]);
+    for (std::size_t col = 0; col < n; ++col) {
+      const double v = st[col];
+      if (v != 0.0) for (std::size_t r = col + 1; r < 2 * n; ++r) st[r] -= S[r * w + col] * v;
+    }
+    for (std::size_t r = 0; r < n; ++r) { t[(k - 1) * n + r] = st[r]; cr[r] = st[n + r]; }
+    for (std::size_t b = 0; b < nb; ++b)
+      for (std::size_t col = 0; col < n; ++col) br[b] -= G[b * n + col] * st[col];
+  }
+  for (std::size_t r = 0; r < n; ++r) y[r] = cr[r];
+  for (std::size_t b = 0; b < nb; ++b) y[n + b] = br[b];
+  const double *Rm = lu.R.data();
+  for (std::size_t col = 0; col < nf; ++col) std::swap(y[col], y[lu.rpiv[col]]);
+  for (std::size_t col = 0; col < nf; ++col) {
+    for (std::size_t r = col + 1; r < nf; ++r) y[r] -= Rm[r * nf + col] * y[col];
+  }
+  for (std::size_t r = nf; r-- > 0;) {
+    double s = y[r];
+    for (std::size_t c = r + 1; c < nf; ++c) s -= Rm[r * nf + c] * y[c];
+    y[r] = s / Rm[r * nf + r];
+  }
+  double *X = x->data();
+  for (std::size_t c = 0; c < n; ++c) X[c] = y[c];
+  for (std::size_t b = 0; b < nb; ++b) X[M * n + b] = y[n + b];
+  const double *z = X + M * n;
+  std::vector<double> xm(X, X + n);  /* X_M = Q X_0 */
+  if (lu.Q.size() == n * n)
+    for (std::size_t r = 0; r < n; ++r) {
+      xm[r] = 0.0;
+      for (std::size_t c = 0; c < n; ++c) xm[r] += lu.Q[r * n + c] * X[c];
+    }
+  for (std::size_t k = M - 1; k >= 1; --k) {
+    const double *S = &lu.S[(k - 1) * 2 * n * w];
+    const double *xn = (k + 1 < M) ? X + (k + 1) * n : xm.data();
+    double *xk = X + k * n;
+    for (std::size_t r = n; r-- > 0;) {
+      const double *row = S + r * w;
+      double s = t[(k - 1) * n + r];
+      for (std::size_t c = r + 1; c < n; ++c) s -= row[c] * xk[c];
+      for (std::size_t c = 0; c < n; ++c) s -= row[n + c] * X[c];
+      for (std::size_t c = 0; c < n; ++c) s -= row[2 * n + c] * xn[c];
+      for (std::size_t c = 0; c < nb; ++c) s -= row[3 * n + c] * z[c];
+      xk[r] = s / row[r];
+    }
+  }
+}
+
+/* Structured LU of any CycleJac. With Gauss collocation each interval's
+ * interior points are first eliminated against its own ncol*n rows (partial
+ * pivoting within the interval; the border rows are reduced alongside), which
+ * leaves n rows in (X_i, X_i+1, z) per interval: the trapezoidal block form,
+ * factored by cyc_factor_blocks. Still O(M n^3), and det(J) is the product of
+ * both sets of pivots. */
+bool cyc_factor(const CycleJac &J, CycleLU *lu) {
+  if (!J.ncol) return cyc_factor_blocks(J, lu);
+  const std::size_t n = J.n, NI = J.M, nb = J.nb, nc = J.ncol;
+  const std::size_t ni = (nc - 1) * n, R = nc * n, W = (nc + 1) * n, lw = W + nb, P = NI * R;
+  if (NI < 2) return false;
+  CycleJac Jc;
+  Jc.resize(n, NI, nb);
+  Jc.E = J.E;
+  Jc.Q = J.Q;
+  const bool qmap = J.Q.size() == n * n;
+  for (std::size_t b = 0; b < nb; ++b)
+    for (std::size_t i = 0; i < NI; ++i)
+      for (std::size_t k = 0; k < n; ++k) Jc.D[b * NI * n + i * n + k] = J.D[b * P + i * R + k];
+  std::vector<double> LS(NI * R * lw, 0.0), LG(NI * nb * ni, 0.0), row(lw);
+  std::vector<std::size_t> lpiv(NI * ni);
+  double sign = 1.0, logdet = 0.0;
+  for (std::size_t i = 0; i < NI; ++i) {
+    double *S = &LS[i * R * lw];
+    std::size_t *pv = &lpiv[i * ni];
+    const std::size_t i1 = (i + 1) % NI;
+    for (std::size_t r = 0; r < R; ++r) {
+      const double *src = &J.L[(i * R + r) * W];
+      double *dst = S + r * lw;
+      for (std::size_t c = 0; c < ni; ++c) dst[c] = src[n + c];
+      for (std::size_t c = 0; c < n; ++c) { dst[ni + c] = src[c]; dst[ni + n + c] = src[nc * n + c]; }
+      for (std::size_t c = 0; c < nb; ++c) dst[W + c] = J.C[(i * R + r) * nb + c];
+    }
+    for (std::size_t col = 0; col < ni; ++col) {
+      std::size_t p = col;
+      for (std::size_t r = col + 1; r < R; ++r)
+        if (std::fabs(S[r * lw + col]) > std::fabs(S[p * lw + col])) p = r;
+      const double d = S[p * lw + col];
+      if (!(std::fabs(d) > 1e-300)) return false;
+      pv[col] = p;
+      if (p != col) {
+        for (std::size_t c = 0; c < lw; ++c) std::swap(S[p * lw + c], S[col * lw + c]);
+        sign = -sign;
+      }
+      if (d < 0) sign = -sign;
+      logdet += std::log(std::fabs(d));
+      for (std::size_t r = col + 1; r < R; ++r) {
+        double *rr = S + r * lw;
+        const double l = rr[col] / d;
+        rr[col] = l;
+        if (l != 0.0) for (std::size_t c = col + 1; c < lw; ++c) rr[c] -= l * S[col * lw + c];
+      }
+    }
+    for (std::size_t r = 0; r < n; ++r) {
+      const double *src = S + (ni + r) * lw;
+      for (std::size_t c = 0; c < n; ++c) {
+        Jc.A[i * n * n + r * n + c] = src[ni + c];
+        Jc.B[i * n * n + r * n + c] = src[ni + n + c];
+      }
+      for (std::size_t c = 0; c < nb; ++c) Jc.C[(i * n + r) * nb + c] = src[W + c];
+    }
+    for (std::size_t b = 0; b < nb; ++b) {
+      double *dx = &Jc.D[b * NI * n];
+      /* with a boundary map the last interval's far end is X_M = Q X_0, which
+       * the border rows see only through the elimination */
+      const bool wrap = qmap && i1 == 0;
+      for (std::size_t c = 0; c < ni; ++c) row[c] = J.D[b * P + i * R + n + c];
+      for (std::size_t c = 0; c < n; ++c) {
+        row[ni + c] = dx[i * n + c];
+        row[ni + n + c] = wrap ? 0.0 : dx[i1 * n + c];
+      }
+      for (std::size_t c = 0; c < nb; ++c) row[W + c] = Jc.E[b * nb + c];
+      for (std::size_t col = 0; col < ni; ++col) {
+        const double l = row[col] / S[col * lw + col];
+        LG[(i * nb + b) * ni + col] = l;
+        if (l != 0.0) for (std::size_t c = col + 1; c < lw; ++c) row[c] -= l * S[col * lw + c];
+      }
+      for (std::size_t c = 0; c < n; ++c) dx[i * n + c] = row[ni + c];
+      for (std::size_t c = 0; c < n; ++c) {
+        if (!wrap) { dx[i1 * n + c] = row[ni + n + c]; continue; }
+        for (std::size_t j = 0; j < n; ++j) dx[c] += row[ni + n + j] * J.Q[j * n + c];
+      }
+      for (std::size_t c = 0; c < nb; ++c) Jc.E[b * nb + c] = row[W + c];
+    }
+  }
+  if (!cyc_factor_blocks(Jc, lu)) return false;
+  /* gathering the interior rows and columns ahead of the condensed ones:
+   * n ni M (M-1)/2 and n ni M (M+1)/2 transpositions, n ni M^2 together */
+  if ((n * ni * NI * NI) % 2 == 1) sign = -sign;
+  lu->sign *= sign;
+  lu->logdet += logdet;
+  lu->ncol = nc; lu->lw = lw;
+  lu->LS.swap(LS); lu->LG.swap(LG); lu->lpiv.swap(lpiv);
+  return true;
+}
+
+/* Solve J x = rhs with a factorization from cyc_factor. */
+void cyc_solve(const CycleLU &lu, const std::vector<double> &rhs, std::vector<double> *x) {
+  if (!lu.ncol) { cyc_solve_blocks(lu, rhs, x); return; }
+  const std::size_t n = lu.n, NI = lu.M, nb = lu.nb, nc = lu.ncol, lw = lu.lw;
+  const std::size_t ni = (nc - 1) * n, R = nc * n, W = (nc + 1) * n, P = NI * R;
+  std::vector<double> rc(NI * n + nb), t(NI * ni), st(R), xc;
+  for (std::size_t b = 0; b < nb; ++b) rc[NI * n + b] = rhs[P + b];
+  for (std::size_t i = 0; i < NI; ++i) {
+    const double *S = &lu.LS[i * R * lw];
+    const std::size_t *pv = &lu.lpiv[i * ni];
+    for (std::size_t r = 0; r < R; ++r) st[r] = rhs[i * R + r];
+    for (std::size_t col = 0; col < ni; ++col) std::swap(st[col], st[pv[col]]);
+    for (std::size_t col = 0; col < ni; ++col) {
+      const double v = st[col];
+      if (v != 0.0) for (std::size_t r = col + 1; r < R; ++r) st[r] -= S[r * lw + col] * v;
+    }
+    for (std::size_t r = 0; r < ni; ++r) t[i * ni + r] = st[r];
+    for (std::size_t r = 0; r < n; ++r) rc[i * n + r] = st[ni + r];
+    for (std::size_t b = 0; b < nb; ++b)
+      for (std::size_t col = 0; col < ni; ++col) rc[NI * n + b] -= lu.LG[(i * nb + b) * ni + col] * st[col];
+  }
+  cyc_solve_blocks(lu, rc, &xc);
+  x->assign(P + nb, 0.0);
+  double *X = x->data();
+  for (std::size_t i = 0; i < NI; ++i)
+    for (std::size_t k = 0; k < n; ++k) X[i * R + k] = xc[i * n + k];
+  for (std::size_t b = 0; b < nb; ++b) X[P + b] = xc[NI * n + b];
+  std::vector<double> xm(X, X + n);  /* X_M = Q X_0 */
+  if (lu.Q.size() == n * n)
+    for (std::size_t r = 0; r < n; ++r) {
+      xm[r] = 0.0;
+      for (std::size_t c = 0; c < n; ++c) xm[r] += lu.Q[r * n + c] * X[c];
+    }
+  for (std::size_t i = 0; i < NI; ++i) {
+    const double *S = &lu.LS[i * R * lw], *xa = X + i * R, *xb = i + 1 < NI ? X + (i + 1) * R : xm.data();
+    double *y = X + i * R + n;
+    for (std::size_t r = ni; r-- > 0;) {
+      const double *rr = S + r * lw;
+      double s = t[i * ni + r];
+      for (std::size_t c = r + 1; c < ni; ++c) s -= rr[c] * y[c];
+      for (std::size_t c = 0; c < n; ++c) s -= rr[ni + c] * xa[c] + rr[ni + n + c] * xb[c];
+      for (std::size_t c = 0; c < nb; ++c) s -= rr[W + c] * X[P + c];
+      y[r] = s / rr[r];
+    }
+  }
+}
+
+/* sum of log row 2-norms of J (zero rows count as 1, as the dense tests did),
+ * so logdet minus this is the log-determinant of the row-normalized J */
+double cyc_log_row_norms(const CycleJac &J) {
+  const std::size_t n = J.n, M = J.M, nb = J.nb, P = J.points() * n;
+  double s = 0.0;
+  if (J.ncol) {
+    const std::size_t R = J.ncol * n, W = R + n;
+    for (std::size_t r = 0; r < M * R; ++r) {
+      double q = 0.0;
+      for (std::size_t c = 0; c < W; ++c) q += J.L[r * W + c] * J.L[r * W + c];
+      for (std::size_t c = 0; c < nb; ++c) q += J.C[r * nb + c] * J.C[r * nb + c];
+      if (std::sqrt(q) >= 1e-300) s += 0.5 * std::log(q);
+    }
+  }
+  for (std::size_t i = 0; i < M && !J.ncol; ++i)
+    for (std::size_t r = 0; r < n; ++r) {
+      double q = 0.0;
+      for (std::size_t c = 0; c < n; ++c) {
+        const double a = J.A[i * n * n + r * n + c], b = J.B[i * n * n + r * n + c];
+        q += a * a + b * b;
+      }
+      for (std::size_t c = 0; c < nb; ++c) q += J.C[(i * n + r) * nb + c] * J.C[(i * n + r) * nb + c];
+      if (std::sqrt(q) >= 1e-300) s += 0.5 * std::log(q);
+    }
+  for (std::size_t b = 0; b < nb; ++b) {
+    double q = 0.0;
+    for (std::size_t c = 0; c < P; ++c) q += J.D[b * P + c] * J.D[b * P + c];
+    for (std::size_t c = 0; c < nb; ++c) q += J.E[b * nb + c] * J.E[b * nb + c];
+    if (std::sqrt(q) >= 1e-300) s += 0.5 * std::log(q);
   }
+  return s;
+}
+
+/* Blockwise Jacobian of cyc_residual at U: one field Jacobian per mesh point
+ * (per Gauss point with ncol > 0) instead of one residual evaluation per
+ * unknown. The model's exact
+ * jacobian_x / dfdp (forward AD in the app) are used when present, forward
+ * differences of the field otherwise. With with_p the parameter is a second
+ * border unknown, z = (T, p), and border row 1 is left zero for the caller
+ * (the arclength / tangent row). */
+bool cyc_jacobian(const CycleCtx &c, const std::vector<double> &U, bool with_p, CycleJac *J) {
+  const std::size_t n = c.n, M = c.mesh, nb = with_p ? 2 : 1;
+  const double T = U[M * n];
+  std::vector<double> x(n), f1(n);
+  std::string err;
+  /* field, Jacobian and (with_p) parameter derivative at x */
+  auto point = [&](double *fi, double *Ji, double *fpi) -> bool {
+    if (!c.m->vector_field(x.data(), c.p, fi, &err)) return false;
+    if (!c.m->jacobian_x || !c.m->jacobian_x(x.data(), c.p, Ji, &err))
+      for (std::size_t j = 0; j < n; ++j) {
+        const double save = x[j], dh = 1e-7 * (std::fabs(save) + 1.0);
+        x[j] = save + dh;
+        if (!c.m->vector_field(x.data(), c.p, f1.data(), &err)) return false;
+        for (std::size_t k = 0; k < n; ++k) Ji[k * n + j] = (f1[k] - fi[k]) / dh;
+        x[j] = save;
+      }
+    if (with_p && !(c.m->dfdp && c.m->dfdp(x.data(), c.p, fpi, &err))) {
+      const double dh = 1e-7 * (std::fabs(c.p) + 1.0);
+      if (!c.m->vector_field(x.data(), c.p + dh, f1.data(), &err)) return false;
+      for (std::size_t k = 0; k < n; ++k) fpi[k] = (f1[k] - fi[k]) / dh;
+    }
+    return true;
+  };
+  if (c.ncol) {
+    /* row (c, r) of interval i: sum_j d_j(zeta_c) X_j - T h_i f(u(zeta_c)) */
+    const std::size_t nc = c.ncol, NI = c.intervals(), R = nc * n, W = R + n;
+    const ColTab &tb = colloc_table(nc);
+    J->resize(n, NI, nb, nc);
+    std::vector<double> fc(n), Jc(n * n), fpc(n);
+    for (std::size_t i = 0; i < NI; ++i) {
+      const double wi = (c.frac.size() == NI) ? c.frac[i] : 1.0 / (double)NI, h = T * wi;
+      for (std::size_t q = 0; q < nc; ++q) {
+        const double *l = &tb.l[q * (nc + 1)], *d = &tb.d[q * (nc + 1)];
+        std::fill(x.begin(), x.end(), 0.0);
+        for (std::size_t j = 0; j <= nc; ++j)
+          for (std::size_t k = 0; k < n; ++k) x[k] += l[j] * U[((i * nc + j) % M) * n + k];
+        if (!point(fc.data(), Jc.data(), fpc.data())) return false;
+        for (std::size_t r = 0; r < n; ++r) {
+          double *row = &J->L[(i * R + q * n + r) * W], *C = &J->C[(i * R + q * n + r) * nb];
+          for (std::size_t j = 0; j <= nc; ++j) {
+            for (std::size_t k = 0; k < n; ++k) row[j * n + k] = -h * l[j] * Jc[r * n + k];
+            row[j * n + r] += d[j];
+          }
+          C[0] = -wi * fc[r];
+          if (with_p) C[1] = -h * fpc[r];
+        }
+      }
+    }
+  } else {
+    J->resize(n, M, nb);
+    std::vector<double> f(M * n), Jf(M * n * n), fp(with_p ? M * n : 0);
+    for (std::size_t i = 0; i < M; ++i) {
+      for (std::size_t k = 0; k < n; ++k) x[k] = U[i * n + k];
+      if (!point(&f[i * n], &Jf[i * n * n], with_p ? &fp[i * n] : nullptr)) return false;
+    }
+    for (std::size_t i = 0; i < M; ++i) {
+      const std::size_t j = (i + 1) % M;
+      const double wi = (c.frac.size() == M) ? c.frac[i] : 1.0 / (double)M, h = 0.5 * T * wi;
+      double *A = &J->A[i * n * n], *B = &J->B[i * n * n], *C = &J->C[i * n * nb];
+      for (std::size_t r = 0; r < n; ++r) {
+        for (std::size_t k = 0; k < n; ++k) {
+          A[r * n + k] = -h * Jf[i * n * n + r * n + k];
+          B[r * n + k] = -h * Jf[j * n * n + r * n + k];
+        }
+        A[r * n + r] -= 1.0;
+        B[r * n + r] += 1.0;
+        C[r * nb] = -0.5 * wi * (f[i * n + r] + f[j * n + r]);
+        if (with_p) C[r * nb + 1] = -h * (fp[i * n + r] + fp[j * n + r]);
+      }
+    }
+  }
+  if (c.pin_mode || c.phase_ref.size() < n || c.phase_dir.size() < n) {
+    if (c.pin_mode) J->D[0] = 1.0;
+  } else {
+    for (std::size_t k = 0; k < n; ++k) J->D[k] = c.phase_dir[k];
+  }
+  return true;
+}
+
+/* Newton solve of the collocation system; returns refined U. The Jacobian is
+ * assembled blockwise and solved by the structured elimination above, so a
+ * step costs O(M n^3) rather than a dense (M*n+1)^2 factorization. With
+ * c.corrector Chord / Broyden the factorization is kept across iterates.
+ * Steps are damped to unit length for robustness. */
+bool cyc_newton(const CycleCtx &c, std::vector<double> *U, int iters, double tol) {
+  CycleJac J;
+  CycleLU lu;
+  QNCorrector qn;
+  qn.kind = c.corrector;
+  qn.contraction = c.contraction;
+  qn.iters = iters;
+  qn.tol = tol;
+  qn.max_step = 1.0;
+  qn.counts = c.counts;
+  auto residual = [&](const std::vector<double> &uu, std::vector<double> *F) { return cyc_residual(c, uu, F); };
+  auto refresh = [&](const std::vector<double> &uu) { return cyc_jacobian(c, uu, false, &J) && cyc_factor(J, &lu); };
+  auto solve = [&](std::vector<double> *v) { std::vector<double> x; cyc_solve(lu, *v, &x); v->swap(x); };
+  bool converged = false;
+  if (!qn_correct(qn, U, false, residual, refresh, solve, &converged)) return false;
+  if (converged) return true;
+  std::vector<double> F0;
   if (!cyc_residual(c, *U, &F0)) return false;
   double res = 0; for (double v : F0) res += v*v;
   return std::sqrt(res) < tol * 100;
@@ -2080,31 +3825,43 @@ void cyc_amp(const std::vector<double> &U, std::size_t n, std::size_t M,
   *mn = lo; *mx = hi; *amp = hi - lo;
 }
 
-/* Fold-of-cycles (LPC) test function: the determinant of the collocation
- * Jacobian at a converged cycle U. Away from a cycle fold the periodic BVP is
- * regular and this is bounded away from zero; at an LPC (a nontrivial Floquet
- * multiplier crossing +1, where the cycle branch turns) the system becomes
- * singular and the determinant changes sign. We rescale rows to keep the
- * determinant in a sane numeric range (only its SIGN is used downstream). */
-double cycle_fold_test(const CycleCtx &c, const std::vector<double> &U) {
-  const std::size_t N = c.mesh * c.n + 1;
-  std::vector<double> F0, Fp;
-  if (!cyc_residual(c, U, &F0)) return std::nan("");
-  std::vector<double> J(N * N, 0.0), Ut = U;
-  for (std::size_t j = 0; j < N; ++j) {
-    const double save = Ut[j]; const double dh = 1e-7 * (std::fabs(save) + 1.0);
-    Ut[j] = save + dh;
-    if (!cyc_residual(c, Ut, &Fp)) return std::nan("");
-    for (std::size_t i = 0; i < N; ++i) J[i*N+j] = (Fp[i] - F0[i]) / dh;
-    Ut[j] = save;
-  }
-  /* row-normalize so det doesn't under/overflow for large meshes */
-  for (std::size_t i = 0; i < N; ++i) {
-    double s = 0; for (std::size_t j = 0; j < N; ++j) s += J[i*N+j]*J[i*N+j];
-    s = std::sqrt(s); if (s < 1e-300) s = 1.0;
-    for (std::size_t j = 0; j < N; ++j) J[i*N+j] /= s;
+/* ---- Floquet multipliers from the factored collocation system --------------
+ * cyc_factor condenses the interval rows to P0 X_0 + P1 X_M = 0 (T and p
+ * fixed), so the discrete monodromy matrix is -P1^{-1} P0: the collocation
+ * scheme's own transfer over one period, with no re-integration. The
+ * condensation pivots between the carried and the new rows at every step
+ * instead of multiplying transfer matrices, so the pencil stays well scaled
+ * when the multipliers span many orders of magnitude. Multipliers of modulus
+ * >= 1 come from the eigenvalues of -P1^{-1} P0, the others as reciprocals of
+ * those of -P0^{-1} P1, so strongly expanding and strongly contracting
+ * directions both keep their relative accuracy. */
+void cyc_monodromy(const CycleLU &lu, std::vector<Complex> *mult_out) {
+  const std::size_t n = lu.n;
+  mult_out->clear();
+  if (n == 0 || lu.P0.size() != n * n) return;
+  /* -X^{-1} Y, column by column */
+  auto pencil = [n](const std::vector<double> &X, const std::vector<double> &Y, std::vector<double> *out) {
+    out->assign(n * n, 0.0);
+    std::vector<double> b(n), x;
+    for (std::size_t j = 0; j < n; ++j) {
+      for (std::size_t i = 0; i < n; ++i) b[i] = -Y[i * n + j];
+      if (!solve_linear(X, b, &x)) return false;
+      for (std::size_t i = 0; i < n; ++i) (*out)[i * n + j] = x[i];
+    }
+    return true;
+  };
+  std::vector<double> Mf, Mb;
+  std::vector<Complex> ef, eb;
+  const bool fwd = pencil(lu.P1, lu.P0, &Mf) && eigenvalues(Mf, n, &ef);
+  const bool bwd = pencil(lu.P0, lu.P1, &Mb) && eigenvalues(Mb, n, &eb);
+  if (fwd && bwd) {
+    for (const Complex &z : ef) if (std::abs(z) >= 1.0) mult_out->push_back(z);
+    for (const Complex &z : eb) if (std::abs(z) > 1.0) mult_out->push_back(1.0 / z);
+    if (mult_out->size() == n) return;
   }
-  return determinant(J, N);
+  mult_out->clear();
+  if (fwd) *mult_out = ef;
+  else if (bwd) for (const Complex &z : eb) mult_out->push_back(std::abs(z) > 0 ? 1.0 / z : Complex(1e300, 0.0));
 }
 
 /* ---- Floquet multipliers of a converged cycle -------------------------------
@@ -2112,7 +3869,10 @@ double cycle_fold_test(const CycleCtx &c, const std::vector<double> &U) {
  * over one period (s: 0->1) using the orbit samples in U and the model Jacobian.
  * The monodromy matrix Phi(1) has eigenvalues = the Floquet multipliers. One is
  * always ~1 (along the flow); the others govern stability. RK4 on the matrix
- * ODE between mesh points (interpolating x along the orbit). */
+ * ODE between mesh points (interpolating x along the orbit). Used for the
+ * trapezoidal scheme, whose own one-period transfer (the Cayley map of
+ * T*Df*h) misplaces strongly contracting multipliers by tens of percent;
+ * Gauss collocation reads them off its factorization (cyc_monodromy). */
 void cycle_floquet(const CycleCtx &c, const std::vector<double> &U,
                    std::vector<Complex> *mult_out) {
   const std::size_t n = c.n, M = c.mesh;
@@ -2120,26 +3880,9 @@ void cycle_floquet(const CycleCtx &c, const std::vector<double> &U,
   mult_out->clear();
   if (n == 0 || M < 2 || !(T > 0)) return;
 
-  auto node = [&](std::size_t i, std::vector<double> &x) {
-    i %= M; for (std::size_t k = 0; k < n; ++k) x[k] = U[i*n+k];
-  };
-  /* cumulative node times in [0,1]: uniform (i/M) unless an adaptive mesh frac
-   * is present, in which case node i sits at the cumulative sum of fractions. */
-  std::vector<double> tnode(M + 1, 0.0);
-  for (std::size_t i = 0; i < M; ++i)
-    tnode[i + 1] = tnode[i] + ((c.frac.size() == M) ? c.frac[i] : 1.0 / (double)M);
-  std::vector<double> xa(n), xb(n);
-  /* interpolate the orbit at normalized period-time s in [0,1) using tnode */
-  auto orbit_at_s = [&](double s, std::vector<double> &x) {
-    s -= std::floor(s);
-    std::size_t i = 0;
-    while (i < M && tnode[i + 1] < s) ++i;
-    if (i >= M) i = M - 1;
-    const double seg = tnode[i + 1] - tnode[i];
-    const double t = seg > 1e-15 ? (s - tnode[i]) / seg : 0.0;
-    node(i, xa); node(i + 1, xb);
-    for (std::size_t k = 0; k < n; ++k) x[k] = (1.0 - t) * xa[k] + t * xb[k];
-  };
+  /* the orbit at normalized period-time s (adaptive mesh fractions and the
+   * collocation polynomials included) */
+  auto orbit_at_s = [&](double s, std::vector<double> &x) { cyc_eval(c, U, s, x.data()); };
   std::vector<double> Jf(n * n);
   auto jac_at = [&](const std::vector<double> &x) -> bool {
     std::string err;
@@ -2190,6 +3933,28 @@ void cycle_floquet(const CycleCtx &c, const std::vector<double> &U,
   eigenvalues(Phi, n, mult_out);
 }
 
+/* Fold-of-cycles (LPC) test function: the determinant of the collocation
+ * Jacobian at a converged cycle U. Away from a cycle fold the periodic BVP is
+ * regular and this is bounded away from zero; at an LPC (a nontrivial Floquet
+ * multiplier crossing +1, where the cycle branch turns) the system becomes
+ * singular and the determinant changes sign. It comes from the structured
+ * factorization's pivots, taken relative to the row norms so it stays in a sane
+ * numeric range (only its SIGN is used downstream). With `mult` the Floquet
+ * multipliers are read off the same factorization (cyc_monodromy) under Gauss
+ * collocation, and integrated (cycle_floquet) under the trapezoidal rule. */
+double cycle_fold_test(const CycleCtx &c, const std::vector<double> &U, std::vector<Complex> *mult = nullptr) {
+  CycleJac J;
+  CycleLU lu;
+  if (mult) mult->clear();
+  if (!cyc_jacobian(c, U, false, &J)) return std::nan("");
+  if (!cyc_factor(J, &lu)) return 0.0;
+  if (mult) {
+    if (c.ncol > 0) cyc_monodromy(lu, mult);
+    else cycle_floquet(c, U, mult);
+  }
+  return lu.sign * std::exp(lu.logdet - cyc_log_row_norms(J));
+}
+
 /* Bordered residual for pseudo-arclength: unknowns V = (U, p), p in last slot. */
 bool cyc_residual_p(CycleCtx c, const std::vector<double> &V,
                     std::size_t Ulen, std::vector<double> *Fout) {
@@ -2218,18 +3983,12 @@ double cycle_bp_test(CycleCtx c, const std::vector<double> &V, std::size_t Ulen,
   const std::size_t NF = c.mesh * c.n + 1;   /* residual rows                  */
   const std::size_t NV = Ulen + 1;           /* unknowns incl. p (== NF here)  */
   if (tangent.size() != NV) return std::nan("");
-  std::vector<double> F0, Fp;
-  if (!cyc_residual_p(c, V, Ulen, &F0)) return std::nan("");
-  /* extended Jacobian F_V : NF x NV by forward differences in every unknown */
-  std::vector<double> B((NF + 1) * NV, 0.0);
-  std::vector<double> Vt = V;
-  for (std::size_t j = 0; j < NV; ++j) {
-    const double save = Vt[j]; const double dh = 1e-7 * (std::fabs(save) + 1.0);
-    Vt[j] = save + dh;
-    if (!cyc_residual_p(c, Vt, Ulen, &Fp)) return std::nan("");
-    for (std::size_t i = 0; i < NF; ++i) B[i * NV + j] = (Fp[i] - F0[i]) / dh;
-    Vt[j] = save;
-  }
+  /* extended Jacobian F_V in block form: z = (T, p), border rows = phase and
+   * the tangent */
+  c.p = V[Ulen];
+  std::vector<double> U(V.begin(), V.begin() + Ulen);
+  CycleJac B;
+  if (!cyc_jacobian(c, U, true, &B)) return std::nan("");
   /* last row = branch tangent (the bordering vector). Its overall SIGN is a
    * gauge choice (the two-direction continuation negates it), which would flip
    * the bordered determinant spuriously. Fix the gauge: orient the tangent so
@@ -2240,39 +3999,171 @@ double cycle_bp_test(CycleCtx c, const std::vector<double> &V, std::size_t Ulen,
   double gauge = tg[NV-1];
   if (std::fabs(gauge) < 1e-12) { for (std::size_t j=0;j<NV;++j) if (std::fabs(tg[j])>1e-9) { gauge = tg[j]; break; } }
   if (gauge < 0) for (double &v : tg) v = -v;
-  for (std::size_t j = 0; j < NV; ++j) B[NF * NV + j] = tg[j];
-  /* row-normalize (square (NF+1)x(NV), NV==NF+1) so each row is unit norm; then
-   * return the SIGNED geometric-mean determinant  sign(det)*|det|^(1/Nsq).
-   * The raw determinant of a ~200x200 matrix underflows to ~1e-27 even when
-   * well-conditioned (product of ~200 sub-unity pivots), which destroys the
-   * sign signal; the geometric mean stays O(1) and preserves the sign, so a
-   * genuine sign change at a branch point is detectable above noise. */
+  const std::size_t Mn = NF - 1;
+  for (std::size_t j = 0; j < Mn; ++j) B.D[Mn + j] = tg[j];
+  B.E[2] = tg[Mn]; B.E[3] = tg[Mn + 1];
+  /* return the SIGNED geometric-mean determinant of the row-normalized matrix,
+   * sign(det)*|det|^(1/Nsq). The raw determinant of a ~200x200 matrix
+   * underflows to ~1e-27 even when well-conditioned (product of ~200 sub-unity
+   * pivots), which destroys the sign signal; the geometric mean stays O(1) and
+   * preserves the sign, so a genuine sign change at a branch point is
+   * detectable above noise. */
   const std::size_t Nsq = NF + 1;
-  for (std::size_t i = 0; i < Nsq; ++i) {
-    double s = 0; for (std::size_t j = 0; j < NV; ++j) s += B[i*NV+j]*B[i*NV+j];
-    s = std::sqrt(s); if (s < 1e-300) s = 1.0;
-    for (std::size_t j = 0; j < NV; ++j) B[i*NV+j] /= s;
-  }
-  /* signed geometric-mean determinant via LU with pivot-sign tracking */
-  std::vector<double> mm(B);
-  double sign = 1.0, logabs = 0.0; bool singular = false;
-  for (std::size_t col = 0; col < Nsq && !singular; ++col) {
-    std::size_t piv = col;
-    for (std::size_t r = col+1; r < Nsq; ++r)
-      if (std::fabs(mm[r*NV+col]) > std::fabs(mm[piv*NV+col])) piv = r;
-    if (std::fabs(mm[piv*NV+col]) < 1e-300) { singular = true; break; }
-    if (piv != col) { for (std::size_t c=0;c<NV;++c) std::swap(mm[piv*NV+c], mm[col*NV+c]); sign = -sign; }
-    const double d = mm[col*NV+col];
-    if (d < 0) sign = -sign;
-    logabs += std::log(std::fabs(d));
-    const double inv = 1.0/d;
-    for (std::size_t r = col+1; r < Nsq; ++r) {
-      const double f = mm[r*NV+col]*inv;
-      if (f != 0.0) for (std::size_t c=col;c<NV;++c) mm[r*NV+c] -= f*mm[col*NV+c];
+  CycleLU lu;
+  if (!cyc_factor(B, &lu)) return 0.0;
+  return lu.sign * std::exp((lu.logdet - cyc_log_row_norms(B)) / (double)Nsq);   /* signed geometric mean */
+}
+
+/* J with its first `keep` border slots (columns z and rows) and nb - keep new
+ * zero ones after them. */
+CycleJac cyc_border(const CycleJac &J, std::size_t keep, std::size_t nb) {
+  CycleJac B;
+  B.resize(J.n, J.M, nb, J.ncol);
+  B.A = J.A; B.B = J.B; B.L = J.L; B.Q = J.Q;
+  const std::size_t rows = J.C.size() / std::max<std::size_t>(J.nb, 1), P = J.points() * J.n;
+  for (std::size_t r = 0; r < rows && J.nb; ++r)
+    for (std::size_t c = 0; c < keep; ++c) B.C[r * nb + c] = J.C[r * J.nb + c];
+  for (std::size_t b = 0; b < keep; ++b) {
+    std::copy(J.D.begin() + b * P, J.D.begin() + (b + 1) * P, B.D.begin() + b * P);
+    for (std::size_t c = 0; c < keep; ++c) B.E[b * nb + c] = J.E[b * J.nb + c];
+  }
+  return B;
+}
+
+/* ---- minimally extended systems for cycle bifurcations --------------------
+ * The codim-1 cycle bifurcations are rank drops of the collocation operator
+ * of the variational equation along the cycle U, with a boundary map that
+ * picks the multiplier:
+ *   LPC  [ F_U  F_T ; phase row ], X_M = X_0     (a second multiplier +1)
+ *   PD   F_U,                      X_M = -X_0    (a multiplier -1)
+ *   NS   F_U on pairs (v, w),      v_M = w_0, w_M = 2 kappa w_0 - v_0
+ *                                   (multipliers e^{+-i theta}, kappa = cos theta)
+ * For NS, M^2 - 2 kappa M + I is singular on the real 2-D invariant subspace
+ * of the pair, so the rank drops by two. Bordering A by k = 1 (k = 2 for NS)
+ * vectors B, used for both the columns and the rows,
+ *   [ A  B ] [ V ]   [ 0 ]
+ *   [ B' 0 ] [ G ] = [ I ],
+ * gives a k x k G that is smooth in (U, T, p, q, kappa) and vanishes exactly on
+ * the bifurcation: no determinants, and the same structured factorization as
+ * the cycle itself (MATCONT's minimally extended systems). */
+enum class CycleBifKind { LPC, PD, NS };
+
+/* A of the table above for the cycle U, with k = 1 / 2 zero border slots
+ * (extra = false: none) */
+bool cyc_bif_matrix(const CycleCtx &c, const std::vector<double> &U, CycleBifKind kind, double kappa,
+                    bool extra, CycleJac *A) {
+  CycleJac J;
+  if (!cyc_jacobian(c, U, false, &J)) return false;
+  const std::size_t n = c.n, k = kind == CycleBifKind::NS ? 2 : 1, x = extra ? k : 0;
+  if (kind == CycleBifKind::LPC) { *A = cyc_border(J, 1, 1 + x); return true; }
+  if (kind == CycleBifKind::PD) {
+    *A = cyc_border(J, 0, x);
+    A->Q.assign(n * n, 0.0);
+    for (std::size_t r = 0; r < n; ++r) A->Q[r * n + r] = -1.0;
+    return true;
+  }
+  /* NS: the variational operator acting on v and w alike */
+  const std::size_t n2 = 2 * n, M = J.M;
+  A->resize(n2, M, x, J.ncol);
+  if (J.ncol) {
+    const std::size_t nc = J.ncol, R = nc * n, W = R + n, R2 = nc * n2, W2 = R2 + n2;
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t q = 0; q < nc; ++q)
+        for (std::size_t r = 0; r < n; ++r)
+          for (std::size_t j = 0; j <= nc; ++j)
+            for (std::size_t h = 0; h < n; ++h)
+              for (std::size_t s = 0; s < 2; ++s)
+                A->L[(i * R2 + q * n2 + s * n + r) * W2 + j * n2 + s * n + h] = J.L[(i * R + q * n + r) * W + j * n + h];
+  } else {
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t r = 0; r < n; ++r)
+        for (std::size_t h = 0; h < n; ++h)
+          for (std::size_t s = 0; s < 2; ++s) {
+            A->A[i * n2 * n2 + (s * n + r) * n2 + s * n + h] = J.A[i * n * n + r * n + h];
+            A->B[i * n2 * n2 + (s * n + r) * n2 + s * n + h] = J.B[i * n * n + r * n + h];
+          }
+  }
+  A->Q.assign(n2 * n2, 0.0);
+  for (std::size_t r = 0; r < n; ++r) {
+    A->Q[r * n2 + n + r] = 1.0;
+    A->Q[(n + r) * n2 + r] = -1.0;
+    A->Q[(n + r) * n2 + n + r] = 2.0 * kappa;
+  }
+  return true;
+}
+
+/* order of A (rows = columns) */
+std::size_t cyc_bif_order(const CycleCtx &c, CycleBifKind kind) {
+  const std::size_t P = c.mesh * c.n;
+  return kind == CycleBifKind::LPC ? P + 1 : kind == CycleBifKind::PD ? P : 2 * P;
+}
+
+/* Border vectors for cyc_bif_test: two steps of inverse iteration with A from
+ * fixed start vectors, i.e. approximate null vectors of A near the
+ * bifurcation (orthonormalized for NS). */
+bool cyc_bif_borders(const CycleCtx &c, const std::vector<double> &U, CycleBifKind kind, double kappa,
+                     std::vector<double> *B) {
+  const std::size_t N = cyc_bif_order(c, kind), k = kind == CycleBifKind::NS ? 2 : 1;
+  B->assign(k * N, 0.0);
+  for (std::size_t j = 0; j < k; ++j)
+    for (std::size_t i = 0; i < N; ++i) (*B)[j * N + i] = std::sin(1.0 + 0.7 * (double)i + 2.3 * (double)j);
+  CycleJac A;
+  CycleLU lu;
+  const bool fac = cyc_bif_matrix(c, U, kind, kappa, false, &A) && cyc_factor(A, &lu);
+  std::vector<double> b(N), x;
+  for (int it = 0; it < (fac ? 2 : 1); ++it)
+    for (std::size_t j = 0; j < k; ++j) {
+      double *v = &(*B)[j * N];
+      if (fac) {
+        std::copy(v, v + N, b.begin());
+        cyc_solve(lu, b, &x);
+        std::copy(x.begin(), x.end(), v);
+      }
+      for (std::size_t h = 0; h < j; ++h) {
+        const double *u = &(*B)[h * N];
+        double d = 0.0;
+        for (std::size_t i = 0; i < N; ++i) d += u[i] * v[i];
+        for (std::size_t i = 0; i < N; ++i) v[i] -= d * u[i];
+      }
+      double nrm = 0.0;
+      for (std::size_t i = 0; i < N; ++i) nrm += v[i] * v[i];
+      nrm = std::sqrt(nrm);
+      if (!(nrm > 0) || !std::isfinite(nrm)) return false;
+      for (std::size_t i = 0; i < N; ++i) v[i] /= nrm;
     }
+  return true;
+}
+
+/* G (k x k, row-major) of the bordered system at the cycle U, and with V the
+ * null-vector parts (k x order) */
+bool cyc_bif_test(const CycleCtx &c, const std::vector<double> &U, CycleBifKind kind, double kappa,
+                  const std::vector<double> &B, std::vector<double> *G, std::vector<double> *V = nullptr) {
+  const std::size_t N = cyc_bif_order(c, kind), k = kind == CycleBifKind::NS ? 2 : 1;
+  const std::size_t keep = kind == CycleBifKind::LPC ? 1 : 0, P = N - keep, nb = keep + k;
+  if (B.size() != k * N) return false;
+  CycleJac A;
+  if (!cyc_bif_matrix(c, U, kind, kappa, true, &A)) return false;
+  const std::size_t Pc = A.C.size() / nb;   /* collocation rows */
+  for (std::size_t j = 0; j < k; ++j) {
+    const double *b = &B[j * N];
+    for (std::size_t r = 0; r < Pc; ++r) A.C[r * nb + keep + j] = b[r];
+    for (std::size_t r = 0; r < P; ++r) A.D[(keep + j) * P + r] = b[r];
+    for (std::size_t i = 0; i < keep; ++i) { A.E[i * nb + keep + j] = b[P + i]; A.E[(keep + j) * nb + i] = b[P + i]; }
+  }
+  CycleLU lu;
+  if (!cyc_factor(A, &lu)) return false;
+  G->assign(k * k, 0.0);
+  if (V) V->assign(k * N, 0.0);
+  std::vector<double> rhs(N + k, 0.0), x;
+  for (std::size_t j = 0; j < k; ++j) {
+    std::fill(rhs.begin(), rhs.end(), 0.0);
+    rhs[N + j] = 1.0;
+    cyc_solve(lu, rhs, &x);
+    for (std::size_t i = 0; i < k; ++i) (*G)[i * k + j] = x[N + i];
+    if (V) std::copy(x.begin(), x.begin() + N, V->begin() + j * N);
   }
-  if (singular) return 0.0;
-  return sign * std::exp(logabs / (double)Nsq);   /* signed geometric mean */
+  for (double g : *G) if (!std::isfinite(g)) return false;
+  return true;
 }
 
 }  // namespace
@@ -2387,6 +4278,13 @@ static bool refine_cycle_seed_by_simulation(
   return true;
 }
 
+/* The orbits behind the samples of an arclength branch (V = (U, p), the
+ * branch tangent and the mesh fractions, in sample order), for callers that
+ * restart from one of them: the direct LPC / PD / NS curves. */
+struct CycleTrace {
+  std::vector<std::vector<double>> V, tangent, frac;
+};
+
 /* Pseudo-arclength continuation of a periodic orbit in the extended space
  * V = (U, p). Predictor: step along the branch tangent (null vector of the
  * bordered Jacobian). Corrector: Newton on [ cycle BVP ; arclength constraint ]
@@ -2395,7 +4293,7 @@ static bool refine_cycle_seed_by_simulation(
  * monotone-in-p continuation stalls. */
 static CycleBranch continue_limit_cycle_arclength(
     const Model &m, const std::vector<std::vector<double>> &guess_points,
-    double period_guess, double p0, const CycleSettings &settings) {
+    double period_guess, double p0, const CycleSettings &settings, CycleTrace *trace = nullptr) {
   CycleBranch out;
   const std::size_t n = m.n, M = guess_points.size();
   if (n == 0 || M < 4 || period_guess <= 0) { out.message = "need a periodic-orbit guess (>=4 points) and T>0"; return out; }
@@ -2403,7 +4301,8 @@ static CycleBranch continue_limit_cycle_arclength(
   const std::size_t Ulen = M * n + 1;       /* orbit + period */
   const std::size_t NV = Ulen + 1;          /* + parameter    */
 
-  CycleCtx c; c.m = &m; c.n = n; c.mesh = M; c.p = p0;
+  CycleCtx c; c.m = &m; c.n = n; c.mesh = M; c.p = p0; c.ncol = (std::size_t)settings.ncol;
+  c.corrector = settings.corrector; c.contraction = settings.contraction; c.counts = &out.counts;
   c.pin_mode = false;
 
   /* pack V0 = (U, p) and converge the initial cycle at p0 with a pinned phase */
@@ -2444,39 +4343,36 @@ static CycleBranch continue_limit_cycle_arclength(
     if (cyc_field(c, c.phase_ref.data(), &fr)) c.phase_dir = fr; else c.phase_dir.assign(n, 0.0);
   };
 
-  /* build the (Ulen) x (NV) Jacobian of the cycle residual wrt V by finite diff */
-  auto resid_jac = [&](const std::vector<double> &Vc, std::vector<double> *F, std::vector<double> *J) -> bool {
-    if (!cyc_residual_p(c, Vc, Ulen, F)) return false; /* length Ulen */
-    J->assign(Ulen * NV, 0.0);
-    std::vector<double> Vt = Vc, Fp;
-    for (std::size_t j = 0; j < NV; ++j) {
-      const double save = Vt[j], dh = 1e-7 * (std::fabs(save) + 1.0);
-      Vt[j] = save + dh;
-      if (!cyc_residual_p(c, Vt, Ulen, &Fp)) return false;
-      for (std::size_t i = 0; i < Ulen; ++i) (*J)[i*NV+j] = (Fp[i] - (*F)[i]) / dh;
-      Vt[j] = save;
-    }
+  /* block Jacobian of [ cycle residual ; row . dV ] wrt V = (U, p): the cycle
+   * rows over z = (T, p), border rows = phase condition and `row` */
+  auto bordered_jac = [&](const std::vector<double> &Vc, const std::vector<double> &row, CycleJac *J) -> bool {
+    CycleCtx cj = c; cj.p = Vc[Ulen];
+    std::vector<double> U(Vc.begin(), Vc.begin() + Ulen);
+    if (!cyc_jacobian(cj, U, true, J)) return false;
+    for (std::size_t j = 0; j < M * n; ++j) J->D[M * n + j] = row[j];
+    J->E[2] = row[M * n]; J->E[3] = row[Ulen];
     return true;
   };
 
   /* tangent: null vector of the Ulen x NV Jacobian (one-dim kernel generically).
-   * Solve [J; e_k^T] t = e_last for some pivot, then normalize; pick orientation
+   * Solve [J; t_prev^T] t = e_last, then normalize; pick orientation
    * consistent with prev. */
   std::vector<double> tangent(NV, 0.0); tangent[Ulen] = 1.0; /* initial guess: increase p */
+  CycleJac J_held;  /* the last bordered Jacobian and where, for chord / Broyden */
+  std::vector<double> V_held;
   auto compute_tangent = [&](const std::vector<double> &Vc, std::vector<double> &tan_io) -> bool {
-    std::vector<double> F, J;
     set_phase(Vc);
-    if (!resid_jac(Vc, &F, &J)) return false;
     /* augment with the previous tangent as the last row to fix the kernel scale:
      * [ J ] t = [ 0 ]
      * [ t_prev^T ]   [ 1 ]  */
-    std::vector<double> A(NV * NV, 0.0), b(NV, 0.0);
-    for (std::size_t i = 0; i < Ulen; ++i)
-      for (std::size_t j = 0; j < NV; ++j) A[i*NV+j] = J[i*NV+j];
-    for (std::size_t j = 0; j < NV; ++j) A[Ulen*NV+j] = tan_io[j];
+    CycleJac &J = J_held;
+    CycleLU lu;
+    V_held.clear();
+    if (!bordered_jac(Vc, tan_io, &J) || !cyc_factor(J, &lu)) return false;
+    V_held = Vc;
+    std::vector<double> b(NV, 0.0), t;
     b[Ulen] = 1.0;
-    std::vector<double> t;
-    if (!solve_linear(A, b, &t)) return false;
+    cyc_solve(lu, b, &t);
     double nrm = 0; for (double v : t) nrm += v*v; nrm = std::sqrt(nrm);
     if (!(nrm > 0) || !std::isfinite(nrm)) return false;
     for (double &v : t) v /= nrm;
@@ -2492,16 +4388,16 @@ static CycleBranch continue_limit_cycle_arclength(
     std::vector<double> U(Vc.begin(), Vc.begin() + Ulen);
     cyc_amp(U, n, M, &s.amplitude, &s.min0, &s.max0);
     CycleCtx cf = c; cf.p = Vc[Ulen];
-    s.fold_test = cycle_fold_test(cf, U);
+    std::vector<Complex> mult;
+    s.fold_test = cycle_fold_test(cf, U, settings.compute_floquet ? &mult : nullptr);
     /* branch-point-of-cycles test: bordered determinant using the current
      * branch tangent (skipped on the very first record, before a tangent
      * exists; tangent has length NV = Ulen+1 once computed). */
     if (tangent.size() == Ulen + 1) s.bp_test = cycle_bp_test(cf, Vc, Ulen, tangent);
     else s.bp_test = std::nan("");
-    if (settings.compute_floquet) {
-      std::vector<Complex> mult; cycle_floquet(cf, U, &mult); classify_floquet(mult, &s);
-    }
+    if (settings.compute_floquet) classify_floquet(mult, &s);
     out.samples.push_back(s);
+    if (trace) { trace->V.push_back(Vc); trace->tangent.push_back(tangent); trace->frac.push_back(c.frac); }
   };
 
   set_phase(V);   /* establish the integral phase reference before recording */
@@ -2526,31 +4422,40 @@ static CycleBranch continue_limit_cycle_arclength(
       std::vector<double> Vp = V;
       for (std::size_t j = 0; j < NV; ++j) Vp[j] += ds * tangent[j];
 
-      /* corrector: Newton on [ cycle_resid(V) ; tangent . (V - Vp) ] = 0 */
+      /* corrector on [ cycle_resid(V) ; tangent . (V - Vp) ] = 0; chord and
+       * Broyden start from the bordered Jacobian of the last tangent, with
+       * the new tangent as its border row */
       std::vector<double> Vc = Vp;
-      bool ok = false;
-      for (int it = 0; it < settings.newton_iters; ++it) {
-        std::vector<double> F, J;
-        set_phase(Vc);
-        if (!resid_jac(Vc, &F, &J)) break;
-        double g = -ds;
-        for (std::size_t j = 0; j < NV; ++j) g += tangent[j] * (Vc[j] - V[j]);
-        double res = 0; for (double v : F) res += v*v; res = std::sqrt(res + g*g);
-        if (res < settings.newton_tol) { ok = true; break; }
-        std::vector<double> A(NV * NV, 0.0), rhs(NV, 0.0);
-        for (std::size_t i = 0; i < Ulen; ++i) {
-          for (std::size_t j = 0; j < NV; ++j) A[i*NV+j] = J[i*NV+j];
-          rhs[i] = -F[i];
-        }
-        for (std::size_t j = 0; j < NV; ++j) A[Ulen*NV+j] = tangent[j];
-        rhs[Ulen] = -g;
-        std::vector<double> dV;
-        if (!solve_linear(A, rhs, &dV)) break;
-        double nrm = 0; for (double v : dV) nrm += v*v; nrm = std::sqrt(nrm);
-        double damp = (nrm > 1.0) ? 1.0 / nrm : 1.0;
-        for (std::size_t j = 0; j < NV; ++j) Vc[j] += damp * dV[j];
+      CycleLU lu;
+      bool held = false;
+      if (settings.corrector != CorrectorKind::Newton && V_held == V) {
+        for (std::size_t j = 0; j < M * n; ++j) J_held.D[M * n + j] = tangent[j];
+        J_held.E[2] = tangent[M * n]; J_held.E[3] = tangent[Ulen];
+        held = cyc_factor(J_held, &lu);
+        ++out.counts.factorizations;
       }
-      if (!ok) break;
+      QNCorrector qn;
+      qn.kind = settings.corrector;
+      qn.contraction = settings.contraction;
+      qn.iters = settings.newton_iters;
+      qn.tol = settings.newton_tol;
+      qn.max_step = 1.0;
+      qn.counts = &out.counts;
+      auto residual = [&](const std::vector<double> &Vi, std::vector<double> *F) {
+        set_phase(Vi);
+        if (!cyc_residual_p(c, Vi, Ulen, F)) return false;
+        double g = -ds;
+        for (std::size_t j = 0; j < NV; ++j) g += tangent[j] * (Vi[j] - V[j]);
+        F->resize(NV);
+        (*F)[Ulen] = g;
+        return true;
+      };
+      auto refresh = [&](const std::vector<double> &Vi) {
+        return bordered_jac(Vi, tangent, &J_held) && cyc_factor(J_held, &lu);
+      };
+      auto solve = [&](std::vector<double> *v) { std::vector<double> x; cyc_solve(lu, *v, &x); v->swap(x); };
+      bool ok = false;
+      if (!qn_correct(qn, &Vc, held, residual, refresh, solve, &ok) || !ok) break;
       if (!(Vc[M*n] > 0) || !std::isfinite(Vc[M*n])) break;
       if (Vc[Ulen] < settings.p_min - 1e-9 || Vc[Ulen] > settings.p_max + 1e-9) {
         record(Vc); break;
@@ -2583,8 +4488,22 @@ static CycleBranch continue_limit_cycle_arclength(
   }
 
   out.turned = turned;
-  std::sort(out.samples.begin(), out.samples.end(),
-            [](const CycleSample &a, const CycleSample &b){ return a.p < b.p; });
+  {
+    std::vector<std::size_t> order(out.samples.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](std::size_t a, std::size_t b) { return out.samples[a].p < out.samples[b].p; });
+    std::vector<CycleSample> sorted;
+    for (std::size_t i : order) sorted.push_back(out.samples[i]);
+    out.samples.swap(sorted);
+    if (trace) {
+      CycleTrace st;
+      for (std::size_t i : order) {
+        st.V.push_back(trace->V[i]); st.tangent.push_back(trace->tangent[i]); st.frac.push_back(trace->frac[i]);
+      }
+      *trace = st;
+    }
+  }
   /* also flag LPC by fold-test sign change -- but ONLY when the parameter has a
    * local extremum (a true turning point) at that interval. A branch point of
    * cycles ALSO makes the cycle determinant vanish (a second multiplier hits
@@ -2663,12 +4582,9 @@ static CycleBranch continue_limit_cycle_arclength(
   return out;
 }
 
-CycleBranch continue_limit_cycle(const Model &m,
-                                 const std::vector<std::vector<double>> &guess_points,
-                                 double period_guess, double p0,
-                                 const CycleSettings &settings) {
-  if (settings.arclength)
-    return continue_limit_cycle_arclength(m, guess_points, period_guess, p0, settings);
+static CycleBranch continue_limit_cycle_natural(
+    const Model &m, const std::vector<std::vector<double>> &guess_points,
+    double period_guess, double p0, const CycleSettings &settings) {
   CycleBranch out;
   const std::size_t n = m.n;
   const std::size_t M = guess_points.size();
@@ -2680,7 +4596,8 @@ CycleBranch continue_limit_cycle(const Model &m,
   for (std::size_t i = 0; i < M; ++i) for (std::size_t k = 0; k < n; ++k) U[i*n+k] = guess_points[i][k];
   U[M*n] = period_guess;
 
-  CycleCtx c; c.m = &m; c.n = n; c.mesh = M; c.p = p0;
+  CycleCtx c; c.m = &m; c.n = n; c.mesh = M; c.p = p0; c.ncol = (std::size_t)settings.ncol;
+  c.corrector = settings.corrector; c.contraction = settings.contraction; c.counts = &out.counts;
   c.pin_mode = true; c.pin_val = U[0]; /* pin first coord of X0 for the first solve */
 
   if (!cyc_newton(c, &U, settings.newton_iters, settings.newton_tol)) {
@@ -2774,127 +4691,444 @@ CycleBranch continue_limit_cycle(const Model &m,
   return out;
 }
 
-/* Two-parameter fold-of-cycles (LPC) curve. For each q across [q_min,q_max] we
- * build the single-parameter cycle model at that q, continue the cycle in p,
- * and look for a fold-of-cycles (a sign change of the cycle fold test). The
- * (p,q) where it occurs is one point of the LPC curve. The seed cycle from the
- * previous q is reused as the next guess, so the locus is followed smoothly. */
-LPCCurve lpc_curve(const Model2 &m,
-                   const std::vector<std::vector<double>> &guess_points,
-                   double period_guess, double p0, double q0,
-                   const TwoParamSettings &settings, const CycleSettings &cyc) {
-  LPCCurve out;
-  const std::size_t n = m.n;
-  if (n < 2 || guess_points.size() < 4) { out.message = "need a 2+ D system and a cycle guess"; return out; }
+/* The guess as the solvers store it: Gauss collocation keeps mesh*ncol
+ * points, evenly spaced in time on the initial uniform mesh, so an (evenly
+ * spaced) guess is resampled to that; otherwise it is used as given. */
+static const std::vector<std::vector<double>> &cycle_guess_points(
+    std::size_t n, const std::vector<std::vector<double>> &guess_points, const CycleSettings &settings,
+    std::vector<std::vector<double>> *pts) {
+  bool dims_ok = !guess_points.empty();
+  for (const auto &g : guess_points) dims_ok = dims_ok && g.size() == n;
+  if (settings.ncol <= 0 || !dims_ok) return guess_points;
+  const std::size_t G = guess_points.size();
+  const std::size_t ntst = settings.mesh > 0 ? (std::size_t)settings.mesh : G;
+  pts->assign(ntst * (std::size_t)settings.ncol, std::vector<double>(n, 0.0));
+  for (std::size_t i = 0; i < pts->size(); ++i) {
+    const double f = (double)i * (double)G / (double)pts->size();
+    const std::size_t j = (std::size_t)f % G, j1 = (j + 1) % G;
+    const double a = f - std::floor(f);
+    for (std::size_t k = 0; k < n; ++k) (*pts)[i][k] = (1 - a) * guess_points[j][k] + a * guess_points[j1][k];
+  }
+  return *pts;
+}
 
-  const int nq = std::max(8, std::min(settings.max_points, 80));
-  std::vector<std::vector<double>> guess = guess_points;
-  double per = period_guess;
-  (void)q0; /* the seed cycle was simulated at q0; the scan covers [q_min,q_max] */
+CycleBranch continue_limit_cycle(const Model &m,
+                                 const std::vector<std::vector<double>> &guess_points,
+                                 double period_guess, double p0,
+                                 const CycleSettings &settings) {
+  if (settings.ncol < 0 || settings.ncol > 7) {
+    CycleBranch out;
+    out.message = "ncol must be 0 (trapezoidal) or 1..7 Gauss points per interval";
+    return out;
+  }
+  std::vector<std::vector<double>> pts;
+  const std::vector<std::vector<double>> &guess = cycle_guess_points(m.n, guess_points, settings, &pts);
+  return settings.arclength ? continue_limit_cycle_arclength(m, guess, period_guess, p0, settings)
+                            : continue_limit_cycle_natural(m, guess, period_guess, p0, settings);
+}
 
-  auto model_at_q = [&](double qfix) {
-    Model mm; mm.n = n;
-    mm.vector_field = [&m, qfix](const double *xx, double pp, double *fo, std::string *er) {
-      return m.vector_field(xx, pp, qfix, fo, er);
-    };
-    return mm;
+/* The one-parameter model at fixed q seen by the cycle continuations of the
+ * LPC / PD / NS curves, carrying the exact derivatives when m has them. */
+static Model cycle_model_at_q(const Model2 &m, double q) {
+  Model mm; mm.n = m.n;
+  mm.vector_field = [&m, q](const double *xx, double pp, double *fo, std::string *er) {
+    return m.vector_field(xx, pp, q, fo, er);
   };
-
-  for (int iq = 0; iq <= nq; ++iq) {
-    const double q = settings.q_min + (settings.q_max - settings.q_min) * (double)iq / nq;
-    Model mm = model_at_q(q);
-    CycleSettings cs = cyc;
-    cs.p_min = settings.p_min; cs.p_max = settings.p_max;
-    CycleBranch br = continue_limit_cycle(mm, guess, per, p0, cs);
-    if (!br.ok || br.samples.empty()) continue;
-    /* find the LPC sample on this branch */
-    for (const auto &smp : br.samples)
-      if (smp.is_fold) {
-        LPCPoint pt; pt.p = smp.p; pt.q = q; pt.period = smp.period; pt.amplitude = smp.amplitude;
-        out.points.push_back(pt);
-        break;
-      }
-    /* reseed the next q from the middle sample of this branch (keeps the guess
-     * close as the locus moves) and update period/p0 toward the LPC if found. */
-    const CycleSample &mid = br.samples[br.samples.size()/2];
-    per = mid.period; p0 = mid.p;
-  }
-  out.ok = out.points.size() >= 2;
-  out.message = out.ok ? ("traced " + std::to_string(out.points.size()) + " LPC points")
-                       : "no fold-of-cycles found in this (p,q) window (the cycle may not fold here)";
-  return out;
+  if (m.jacobian_x)
+    mm.jacobian_x = [&m, q](const double *xx, double pp, double *jo, std::string *er) {
+      return m.jacobian_x(xx, pp, q, jo, er);
+    };
+  if (m.dfdp)
+    mm.dfdp = [&m, q](const double *xx, double pp, double *fo, std::string *er) {
+      return m.dfdp(xx, pp, q, fo, er);
+    };
+  return mm;
 }
 
-/* Shared engine for the PD and NS two-parameter curves: scan q, continue the
- * cycle in p at each q with Floquet on, and collect the bracketed PD (want_pd)
- * or NS (want_ns) sample. Mirrors lpc_curve. */
-static CycleBifCurve cycle_bif_curve(const Model2 &m,
-                                     const std::vector<std::vector<double>> &guess_points,
-                                     double period_guess, double p0, double q0,
-                                     const TwoParamSettings &settings,
-                                     const CycleSettings &cyc, bool want_pd) {
+/* ---- direct continuation of LPC / PD / NS curves ---------------------------
+ * The curve is followed in Y = (U, T, p, q), plus kappa for NS, as the zero
+ * set of the cycle BVP F(Y) = 0 (collocation rows and phase condition) and of
+ * the k test functions g(Y) = 0 of the minimally extended system
+ * (cyc_bif_test). It is continued by pseudo-arclength in a norm that weights
+ * the orbit points by 1/(number of points), so the step does not depend on
+ * the mesh.
+ *
+ * A Newton step factors F_Y bordered by an orthonormal basis z1, z2 of the
+ * previous null space of F_Y, which gives dY = Yp + a1 Z1 + a2 Z2 with
+ * F_Y Yp = -F and F_Y Z_i = 0. The test equations and the arclength row then
+ * form a (k+1) x (k+1) system in (a1, a2 [, dkappa]). That system needs g only
+ * along Yp, Z1, Z2 (and kappa): forward differences, one bordered
+ * factorization each, with no second derivatives of the field. A curve point
+ * costs a few factorizations of the collocation matrix, where the former q
+ * scan cost a whole cycle branch per point. The start is located by the same
+ * Newton at fixed q, from the bifurcation that a one-parameter branch
+ * brackets at q0. */
+static CycleBifCurve cycle_bif_direct(const Model2 &m, const std::vector<std::vector<double>> &guess_points,
+                                      double period_guess, double p0, double q0,
+                                      const TwoParamSettings &settings, const CycleSettings &cyc,
+                                      CycleBifKind kind) {
   CycleBifCurve out;
   const std::size_t n = m.n;
+  const char *what = kind == CycleBifKind::LPC ? "fold-of-cycles" : kind == CycleBifKind::PD ? "PD" : "NS";
   if (n < 2 || guess_points.size() < 4) { out.message = "need a 2+ D system and a cycle guess"; return out; }
-  const int nq = std::max(8, std::min(settings.max_points, 80));
-  std::vector<std::vector<double>> guess = guess_points;
-  double per = period_guess;
-  (void)q0;
-  auto model_at_q = [&](double qfix) {
-    Model mm; mm.n = n;
-    mm.vector_field = [&m, qfix](const double *xx, double pp, double *fo, std::string *er) {
-      return m.vector_field(xx, pp, qfix, fo, er);
-    };
-    return mm;
-  };
-  for (int iq = 0; iq <= nq; ++iq) {
-    const double q = settings.q_min + (settings.q_max - settings.q_min) * (double)iq / nq;
-    Model mm = model_at_q(q);
-    CycleSettings cs = cyc;
-    cs.p_min = settings.p_min; cs.p_max = settings.p_max;
-    cs.compute_floquet = true;                 /* required for PD/NS detection */
-    CycleBranch br = continue_limit_cycle(mm, guess, per, p0, cs);
-    if (!br.ok || br.samples.empty()) continue;
-    for (const auto &smp : br.samples) {
-      const bool hit = want_pd ? smp.is_pd : smp.is_ns;
-      if (hit) {
-        CycleBifPoint pt;
-        pt.p = want_pd ? smp.pd_p : smp.ns_p;  /* the refined bifurcation param */
-        pt.q = q; pt.period = smp.period; pt.amplitude = smp.amplitude;
-        /* secondary test functions at the bifurcation sample, for codim-2 */
-        pt.fold_test = smp.fold_test;
-        pt.ns_test   = want_pd ? smp.ns_test : smp.pd_test; /* the OTHER cycle test */
-        pt.max_nontrivial_mult = smp.max_nontrivial_mult;
-        out.points.push_back(pt);
-        break;
+  if (cyc.ncol < 0 || cyc.ncol > 7) { out.message = "ncol must be 0 (trapezoidal) or 1..7 Gauss points per interval"; return out; }
+  if (q0 < settings.q_min || q0 > settings.q_max) { out.message = "the seed cycle's q lies outside [q_min, q_max]"; return out; }
+  std::vector<std::vector<double>> pts;
+  const std::vector<std::vector<double>> &guess = cycle_guess_points(n, guess_points, cyc, &pts);
+  const std::size_t P = guess.size(), Pn = P * n, NY = Pn + 3, k = kind == CycleBifKind::NS ? 2 : 1;
+
+  /* 1. seed: the bifurcation bracketed on a cycle branch in p at q0, or at the
+   * nearest q of a coarse scan of the window when that branch has none */
+  CycleSettings cs = cyc;
+  cs.p_min = settings.p_min; cs.p_max = settings.p_max; cs.arclength = true;
+  cs.compute_floquet = kind != CycleBifKind::LPC;
+  std::vector<double> qs(1, q0);
+  for (int i = 0; i <= 8; ++i) qs.push_back(settings.q_min + (settings.q_max - settings.q_min) * i / 8.0);
+  std::stable_sort(qs.begin() + 1, qs.end(), [q0](double a, double b) { return std::fabs(a - q0) < std::fabs(b - q0); });
+  CycleCtx c; c.n = n; c.mesh = P; c.ncol = (std::size_t)cyc.ncol; c.pin_mode = false;
+  std::vector<double> Y, tb;
+  double kappa = 0.0;
+  bool seeded = false;
+  for (std::size_t iq = 0; iq < qs.size() && !seeded; ++iq) {
+    const Model mq = cycle_model_at_q(m, qs[iq]);
+    CycleTrace tr;
+    const CycleBranch br = continue_limit_cycle_arclength(mq, guess, period_guess, p0, cs, &tr);
+    for (std::size_t i = 0; i < br.samples.size() && !seeded; ++i) {
+      const CycleSample &smp = br.samples[i];
+      const bool hit = kind == CycleBifKind::LPC ? smp.is_fold : kind == CycleBifKind::PD ? smp.is_pd : smp.is_ns;
+      if (!hit || tr.V[i].size() != Pn + 2) continue;
+      Y = tr.V[i]; Y.push_back(qs[iq]);
+      tb = tr.tangent[i]; tb.resize(NY, 0.0);
+      c.frac = tr.frac[i];
+      /* NS: kappa = cos(theta) of the complex pair nearest the unit circle */
+      double best = 1e300;
+      for (std::size_t j = 0; j < smp.floquet_re.size(); ++j) {
+        const double re = smp.floquet_re[j], im = smp.floquet_im[j], mag = std::hypot(re, im);
+        if (std::fabs(im) > 1e-9 && std::fabs(mag - 1.0) < best) { best = std::fabs(mag - 1.0); kappa = re / mag; }
       }
+      seeded = true;
     }
-    const CycleSample &mid = br.samples[br.samples.size()/2];
-    per = mid.period; p0 = mid.p;
   }
-  /* CODIM-2 points on the curve: scan consecutive points (ordered in q) for a
-   * second condition becoming satisfied along the (PD or NS) locus.
-   *  - FoldFlip (LPPD): the cycle FOLD test changes sign along the curve => an
-   *    LPC coincides with the PD/NS at that q (refined by interpolation).
-   *  - PDNS: the OTHER cycle test (NS test on a PD curve, or PD test on an NS
-   *    curve) changes sign => PD and NS loci cross (a strong-resonance / PDNS
-   *    interaction point).
-   *  - DegeneratePD: the cycle amplitude collapses toward 0 => the curve runs
-   *    into a Hopf point (the cycle bifurcation degenerates as the orbit
-   *    shrinks to the equilibrium). */
-  auto interp_q = [](const CycleBifPoint &a, const CycleBifPoint &b, double fa, double fb) {
-    const double t = fa / (fa - fb); return a.q + t * (b.q - a.q);
+  if (!seeded) {
+    out.message = std::string("no ") + what + " bifurcation on the cycle branches in this (p,q) window" +
+                  (kind == CycleBifKind::LPC ? " (the cycle may not fold here)" : "");
+    return out;
+  }
+
+  /* 2. the extended system */
+  Model mq;   /* the one-parameter model at the current q */
+  auto ctx = [&](const std::vector<double> &Yv) {
+    mq = cycle_model_at_q(m, Yv[Pn + 2]);
+    CycleCtx cc = c; cc.m = &mq; cc.p = Yv[Pn + 1];
+    return cc;
   };
-  auto interp_p = [](const CycleBifPoint &a, const CycleBifPoint &b, double fa, double fb) {
-    const double t = fa / (fa - fb); return a.p + t * (b.p - a.p);
+  auto set_phase = [&](const std::vector<double> &Yv) {
+    const CycleCtx cc = ctx(Yv);
+    c.phase_ref.assign(Yv.begin(), Yv.begin() + n);
+    std::vector<double> fr;
+    if (cyc_field(cc, c.phase_ref.data(), &fr)) c.phase_dir = fr; else c.phase_dir.assign(n, 0.0);
   };
-  for (std::size_t i = 1; i < out.points.size(); ++i) {
-    const CycleBifPoint &a = out.points[i-1], &b = out.points[i];
-    const double fa = a.fold_test, fb = b.fold_test;
-    if (std::isfinite(fa) && std::isfinite(fb) && fa * fb < 0.0) {
-      CycleCodim2Point c2; c2.kind = CycleCodim2Kind::FoldFlip;
-      c2.q = interp_q(a,b,fa,fb); c2.p = interp_p(a,b,fa,fb);
-      out.codim2.push_back(c2);
+  auto wdot = [&](const std::vector<double> &a, const std::vector<double> &b) {
+    double s0 = 0.0, s1 = 0.0;
+    for (std::size_t j = 0; j < Pn; ++j) s0 += a[j] * b[j];
+    for (std::size_t j = Pn; j < NY; ++j) s1 += a[j] * b[j];
+    return s0 / (double)P + s1;
+  };
+  std::vector<double> Bv;   /* test-function borders */
+  auto gfun = [&](const std::vector<double> &Yv, double kap, std::vector<double> *G, std::vector<double> *V) {
+    const CycleCtx cc = ctx(Yv);
+    const std::vector<double> U(Yv.begin(), Yv.begin() + Pn + 1);
+    return cyc_bif_test(cc, U, kind, kap, Bv, G, V);
+  };
+  /* new borders from the null vectors at a converged point */
+  auto refresh_borders = [&](const std::vector<double> &Yv, double kap) {
+    std::vector<double> G, V;
+    if (!gfun(Yv, kap, &G, &V)) return;
+    const std::size_t N = V.size() / k;
+    for (std::size_t j = 0; j < k; ++j) {
+      double *v = &V[j * N];
+      for (std::size_t h = 0; h < j; ++h) {
+        double d = 0.0;
+        for (std::size_t i = 0; i < N; ++i) d += V[h * N + i] * v[i];
+        for (std::size_t i = 0; i < N; ++i) v[i] -= d * V[h * N + i];
+      }
+      double nrm = 0.0;
+      for (std::size_t i = 0; i < N; ++i) nrm += v[i] * v[i];
+      nrm = std::sqrt(nrm);
+      if (!(nrm > 0) || !std::isfinite(nrm)) return;
+      for (std::size_t i = 0; i < N; ++i) v[i] /= nrm;
+    }
+    Bv = V;
+  };
+
+  std::vector<double> rows(2 * NY, 0.0);   /* null-space basis of F_Y, as border rows */
+  std::vector<double> Z1, Z2;
+  double Sg[2][3] = {{0, 0, 0}, {0, 0, 0}};  /* g rows of the last Newton system */
+  std::size_t sel[2] = {0, 3};                /* the entries of G used (NS) */
+  bool pick_sel = kind == CycleBifKind::NS;
+  const double tol = cyc.newton_tol > 0 ? cyc.newton_tol : 1e-8;
+  /* Newton onto F = 0, g = 0 and ell . Y + lk kappa = target; Z1, Z2 and Sg are
+   * left describing the null space at the solution */
+  auto correct = [&](std::vector<double> &Yc, double &kap, const std::vector<double> &ell, double lk,
+                     double target) -> bool {
+    for (int it = 0; it < std::max(1, settings.max_corrector_iters); ++it) {
+      CycleCtx cc = ctx(Yc);
+      const std::vector<double> U(Yc.begin(), Yc.begin() + Pn + 1);
+      std::vector<double> F, Fq;
+      CycleJac J;
+      if (!cyc_residual(cc, U, &F) || !cyc_jacobian(cc, U, true, &J)) return false;
+      /* the q column by a forward difference of the residual */
+      std::vector<double> Yq = Yc;
+      const double hq = 1e-7 * (std::fabs(Yc[Pn + 2]) + 1.0);
+      Yq[Pn + 2] += hq;
+      cc = ctx(Yq);
+      if (!cyc_residual(cc, U, &Fq)) return false;
+      CycleJac Jb = cyc_border(J, 2, 3);
+      for (std::size_t r = 0; r < Pn; ++r) Jb.C[r * 3 + 2] = (Fq[r] - F[r]) / hq;
+      for (std::size_t b = 0; b < 2; ++b) {
+        const double *z = &rows[b * NY];
+        std::copy(z, z + Pn, Jb.D.begin() + (1 + b) * Pn);
+        for (std::size_t j = 0; j < 3; ++j) Jb.E[(1 + b) * 3 + j] = z[Pn + j];
+      }
+      CycleLU lu;
+      if (!cyc_factor(Jb, &lu)) return false;
+      std::vector<double> rhs(NY, 0.0), Yp;
+      for (std::size_t i = 0; i <= Pn; ++i) rhs[i] = -F[i];
+      cyc_solve(lu, rhs, &Yp);
+      std::fill(rhs.begin(), rhs.end(), 0.0); rhs[Pn + 1] = 1.0;
+      cyc_solve(lu, rhs, &Z1);
+      std::fill(rhs.begin(), rhs.end(), 0.0); rhs[Pn + 2] = 1.0;
+      cyc_solve(lu, rhs, &Z2);
+      /* g at Yc and its derivatives along Yp, Z1, Z2 and kappa */
+      std::vector<double> G0, Gd;
+      if (!gfun(Yc, kap, &G0, nullptr)) return false;
+      double dg[4][4] = {};
+      const std::vector<double> *dirs[3] = {&Yp, &Z1, &Z2};
+      for (std::size_t d = 0; d < 3; ++d) {
+        const double nv = std::sqrt(wdot(*dirs[d], *dirs[d]));
+        if (!(nv > 0) || !std::isfinite(nv)) continue;
+        const double eps = 1e-7 / nv;
+        std::vector<double> Ye = Yc;
+        for (std::size_t j = 0; j < NY; ++j) Ye[j] += eps * (*dirs[d])[j];
+        if (!gfun(Ye, kap, &Gd, nullptr)) return false;
+        for (std::size_t e = 0; e < k * k; ++e) dg[d][e] = (Gd[e] - G0[e]) / eps;
+      }
+      if (kind == CycleBifKind::NS) {
+        if (!gfun(Yc, kap + 1e-7, &Gd, nullptr)) return false;
+        for (std::size_t e = 0; e < 4; ++e) dg[3][e] = (Gd[e] - G0[e]) / 1e-7;
+      }
+      /* NS: of the four entries of G use the pair whose gradients (within the
+       * null space and in kappa) are the most independent */
+      if (pick_sel) {
+        double best = -1.0;
+        for (std::size_t a = 0; a < 4; ++a)
+          for (std::size_t b = a + 1; b < 4; ++b) {
+            const double x = dg[1][a] * dg[2][b] - dg[2][a] * dg[1][b], y = dg[2][a] * dg[3][b] - dg[3][a] * dg[2][b],
+                         z = dg[3][a] * dg[1][b] - dg[1][a] * dg[3][b], v = x * x + y * y + z * z;
+            if (v > best) { best = v; sel[0] = a; sel[1] = b; }
+          }
+        pick_sel = false;
+      }
+      const std::size_t m1 = k + 1;
+      std::vector<double> S(m1 * m1, 0.0), bb(m1, 0.0), a;
+      double res = 0.0;
+      for (double v : F) res += v * v;
+      for (std::size_t i = 0; i < k; ++i) {
+        const std::size_t e = sel[i];
+        S[i * m1] = Sg[i][0] = dg[1][e];
+        S[i * m1 + 1] = Sg[i][1] = dg[2][e];
+        if (kind == CycleBifKind::NS) S[i * m1 + 2] = Sg[i][2] = dg[3][e];
+        bb[i] = -(G0[e] + dg[0][e]);
+        res += G0[e] * G0[e];
+      }
+      double phi = lk * kap - target, lYp = 0.0, lZ1 = 0.0, lZ2 = 0.0;
+      for (std::size_t j = 0; j < NY; ++j) {
+        phi += ell[j] * Yc[j]; lYp += ell[j] * Yp[j]; lZ1 += ell[j] * Z1[j]; lZ2 += ell[j] * Z2[j];
+      }
+      res = std::sqrt(res + phi * phi);
+      if (!std::isfinite(res)) return false;
+      if (res < tol) return true;
+      S[k * m1] = lZ1; S[k * m1 + 1] = lZ2;
+      if (kind == CycleBifKind::NS) S[k * m1 + 2] = lk;
+      bb[k] = -(phi + lYp);
+      if (!solve_linear(S, bb, &a)) return false;
+      std::vector<double> dY(NY);
+      for (std::size_t j = 0; j < NY; ++j) dY[j] = Yp[j] + a[0] * Z1[j] + a[1] * Z2[j];
+      const double dk = kind == CycleBifKind::NS ? a[2] : 0.0, nrm = std::sqrt(wdot(dY, dY) + dk * dk);
+      if (!std::isfinite(nrm)) return false;
+      const double damp = nrm > 1.0 ? 1.0 / nrm : 1.0;
+      for (std::size_t j = 0; j < NY; ++j) Yc[j] += damp * dY[j];
+      kap += damp * dk;
+    }
+    return false;
+  };
+  /* curve tangent: the null direction of the g rows within span(Z1, Z2[, kappa]) */
+  auto tangent = [&](std::vector<double> *t, double *tk) -> bool {
+    double a[3];
+    if (k == 1) { a[0] = Sg[0][1]; a[1] = -Sg[0][0]; a[2] = 0.0; }
+    else {
+      a[0] = Sg[0][1] * Sg[1][2] - Sg[0][2] * Sg[1][1];
+      a[1] = Sg[0][2] * Sg[1][0] - Sg[0][0] * Sg[1][2];
+      a[2] = Sg[0][0] * Sg[1][1] - Sg[0][1] * Sg[1][0];
+    }
+    t->assign(NY, 0.0);
+    for (std::size_t j = 0; j < NY; ++j) (*t)[j] = a[0] * Z1[j] + a[1] * Z2[j];
+    *tk = a[2];
+    const double nrm = std::sqrt(wdot(*t, *t) + a[2] * a[2]);
+    if (!(nrm > 0) || !std::isfinite(nrm)) return false;
+    for (double &v : *t) v /= nrm;
+    *tk /= nrm;
+    return true;
+  };
+  /* border rows for the next step: Z1, Z2 orthonormalized */
+  auto set_rows = [&](const std::vector<double> &a, const std::vector<double> &b) -> bool {
+    double na = 0.0;
+    for (std::size_t j = 0; j < NY; ++j) na += a[j] * a[j];
+    na = std::sqrt(na);
+    if (!(na > 0)) return false;
+    double d = 0.0;
+    for (std::size_t j = 0; j < NY; ++j) d += a[j] / na * b[j];
+    double nb = 0.0;
+    for (std::size_t j = 0; j < NY; ++j) nb += (b[j] - d * a[j] / na) * (b[j] - d * a[j] / na);
+    nb = std::sqrt(nb);
+    if (!(nb > 1e-12 * na) || !std::isfinite(nb)) return false;
+    for (std::size_t j = 0; j < NY; ++j) { rows[j] = a[j] / na; rows[NY + j] = (b[j] - d * a[j] / na) / nb; }
+    return true;
+  };
+  auto make_point = [&](const std::vector<double> &Yv) {
+    CycleBifPoint pt; pt.p = Yv[Pn + 1]; pt.q = Yv[Pn + 2]; pt.period = Yv[Pn];
+    double mn = 0.0, mx = 0.0;
+    cyc_amp(Yv, n, P, &pt.amplitude, &mn, &mx);
+    if (kind != CycleBifKind::LPC) {
+      /* secondary cycle tests at this point, for the codim-2 scan */
+      const CycleCtx cc = ctx(Yv);
+      const std::vector<double> U(Yv.begin(), Yv.begin() + Pn + 1);
+      std::vector<Complex> mult;
+      CycleSample smp;
+      smp.fold_test = cycle_fold_test(cc, U, &mult);
+      classify_floquet(mult, &smp);
+      pt.fold_test = smp.fold_test;
+      pt.ns_test = kind == CycleBifKind::PD ? smp.ns_test : smp.pd_test;   /* the OTHER cycle test */
+      pt.max_nontrivial_mult = smp.max_nontrivial_mult;
+    }
+    return pt;
+  };
+
+  /* 3. locate the start at fixed q: the branch tangent and q span the null
+   * space there */
+  set_phase(Y);
+  {
+    std::vector<double> eq(NY, 0.0);
+    eq[Pn + 2] = 1.0;
+    if (!set_rows(tb, eq)) { out.message = "could not start the curve from the cycle branch"; return out; }
+    const CycleCtx cc = ctx(Y);
+    const std::vector<double> U(Y.begin(), Y.begin() + Pn + 1);
+    if (!cyc_bif_borders(cc, U, kind, kappa, &Bv) || !correct(Y, kappa, eq, 0.0, Y[Pn + 2])) {
+      out.message = std::string("the ") + what + " point on the cycle branch did not converge";
+      return out;
+    }
+  }
+  std::vector<double> t0;
+  double tk0 = 0.0;
+  if (!tangent(&t0, &tk0) || !set_rows(Z1, Z2)) { out.message = "could not form the curve tangent"; return out; }
+  if (t0[Pn + 2] < 0) { for (double &v : t0) v = -v; tk0 = -tk0; }
+  refresh_borders(Y, kappa);
+  const std::vector<double> Y0 = Y, rows0 = rows, B0 = Bv;
+  const double kappa0 = kappa;
+
+  /* 4. both directions from the start */
+  std::vector<CycleBifPoint> side[2];
+  const double h0 = settings.h0 > 0 ? settings.h0 : 0.05;
+  const int steps_per_dir = std::max(1, settings.max_points / 2);
+  for (int dir = 0; dir < 2; ++dir) {
+    Y = Y0; kappa = kappa0; rows = rows0; Bv = B0;
+    std::vector<double> t = t0;
+    double tk = dir ? -tk0 : tk0, ds = h0;
+    if (dir) for (double &v : t) v = -v;
+    int made = 0;
+    while (made < steps_per_dir) {
+      set_phase(Y);
+      std::vector<double> Yn = Y, ell(NY);
+      for (std::size_t j = 0; j < NY; ++j) { Yn[j] += ds * t[j]; ell[j] = t[j] * (j < Pn ? 1.0 / (double)P : 1.0); }
+      double kn = kappa + ds * tk, target = tk * kappa + ds;
+      for (std::size_t j = 0; j < NY; ++j) target += ell[j] * Y[j];
+      if (!correct(Yn, kn, ell, tk, target)) {
+        ds *= 0.5;
+        if (ds < h0 / 16) break;
+        continue;
+      }
+      if (!(Yn[Pn] > 0) || !std::isfinite(Yn[Pn])) break;
+      const CycleBifPoint pt = make_point(Yn);
+      side[dir].push_back(pt);
+      ++made;
+      if (pt.p < settings.p_min || pt.p > settings.p_max || pt.q < settings.q_min || pt.q > settings.q_max) break;
+      if (pt.amplitude < 1e-6) break;   /* the cycle has shrunk onto an equilibrium */
+      std::vector<double> tn;
+      double tkn = 0.0;
+      if (!tangent(&tn, &tkn) || !set_rows(Z1, Z2)) break;
+      if (wdot(tn, t) + tkn * tk < 0) { for (double &v : tn) v = -v; tkn = -tkn; }
+      t = tn; tk = tkn; Y = Yn; kappa = kn;
+      refresh_borders(Y, kappa);
+      ds = std::min(h0, 2 * ds);
+    }
+  }
+  /* in order along the curve, q increasing from the first point to the last */
+  out.points.assign(side[1].rbegin(), side[1].rend());
+  out.points.push_back(make_point(Y0));
+  out.points.insert(out.points.end(), side[0].begin(), side[0].end());
+  if (out.points.front().q > out.points.back().q) std::reverse(out.points.begin(), out.points.end());
+  out.ok = out.points.size() >= 2;
+  return out;
+}
+
+LPCCurve lpc_curve(const Model2 &m,
+                   const std::vector<std::vector<double>> &guess_points,
+                   double period_guess, double p0, double q0,
+                   const TwoParamSettings &settings, const CycleSettings &cyc) {
+  LPCCurve out;
+  const CycleBifCurve c = cycle_bif_direct(m, guess_points, period_guess, p0, q0, settings, cyc, CycleBifKind::LPC);
+  for (const CycleBifPoint &b : c.points) {
+    LPCPoint pt; pt.p = b.p; pt.q = b.q; pt.period = b.period; pt.amplitude = b.amplitude;
+    out.points.push_back(pt);
+  }
+  out.ok = c.ok;
+  out.message = out.ok ? ("traced " + std::to_string(out.points.size()) + " LPC points")
+                       : (c.message.empty() ? "could not continue the fold-of-cycles curve" : c.message);
+  return out;
+}
+
+/* Shared by the PD and NS curves: the direct continuation above, then a scan
+ * of the points for codim-2 cycle bifurcations. */
+static CycleBifCurve cycle_bif_curve(const Model2 &m,
+                                     const std::vector<std::vector<double>> &guess_points,
+                                     double period_guess, double p0, double q0,
+                                     const TwoParamSettings &settings,
+                                     const CycleSettings &cyc, bool want_pd) {
+  CycleBifCurve out = cycle_bif_direct(m, guess_points, period_guess, p0, q0, settings, cyc,
+                                       want_pd ? CycleBifKind::PD : CycleBifKind::NS);
+  /* CODIM-2 points on the curve: scan consecutive points (in order along the
+   * curve) for a second condition becoming satisfied along the (PD or NS) locus.
+   *  - FoldFlip (LPPD): the cycle FOLD test changes sign along the curve => an
+   *    LPC coincides with the PD/NS at that q (refined by interpolation).
+   *  - PDNS: the OTHER cycle test (NS test on a PD curve, or PD test on an NS
+   *    curve) changes sign => PD and NS loci cross (a strong-resonance / PDNS
+   *    interaction point).
+   *  - DegeneratePD: the cycle amplitude collapses toward 0 => the curve runs
+   *    into a Hopf point (the cycle bifurcation degenerates as the orbit
+   *    shrinks to the equilibrium). */
+  auto interp_q = [](const CycleBifPoint &a, const CycleBifPoint &b, double fa, double fb) {
+    const double t = fa / (fa - fb); return a.q + t * (b.q - a.q);
+  };
+  auto interp_p = [](const CycleBifPoint &a, const CycleBifPoint &b, double fa, double fb) {
+    const double t = fa / (fa - fb); return a.p + t * (b.p - a.p);
+  };
+  for (std::size_t i = 1; i < out.points.size(); ++i) {
+    const CycleBifPoint &a = out.points[i-1], &b = out.points[i];
+    const double fa = a.fold_test, fb = b.fold_test;
+    if (std::isfinite(fa) && std::isfinite(fb) && fa * fb < 0.0) {
+      CycleCodim2Point c2; c2.kind = CycleCodim2Kind::FoldFlip;
+      c2.q = interp_q(a,b,fa,fb); c2.p = interp_p(a,b,fa,fb);
+      out.codim2.push_back(c2);
     }
     const double na = a.ns_test, nb = b.ns_test;
     if (std::isfinite(na) && std::isfinite(nb) && na * nb < 0.0) {
@@ -2913,7 +5147,8 @@ static CycleBifCurve cycle_bif_curve(const Model2 &m,
   const char *what = want_pd ? "PD" : "NS";
   out.message = out.ok ? ("traced " + std::to_string(out.points.size()) + std::string(" ") + what + " points" +
                           (out.codim2.empty() ? "" : (", " + std::to_string(out.codim2.size()) + " codim-2 point(s)")))
-                       : (std::string("no ") + what + " bifurcation found in this (p,q) window");
+                       : (out.message.empty() ? std::string("no ") + what + " bifurcation found in this (p,q) window"
+                                              : out.message);
   return out;
 }
 
@@ -4200,6 +6435,61 @@ bool saddle_left_subspaces(const std::vector<double> &A, std::size_t n,
   return true;
 }
 
+/* A boundary or phase row of a truncated connecting-orbit BVP: linear in the
+ * mesh point `node`, with gradient `coef`. */
+struct OrbitBcRow { std::size_t node; const std::vector<double> *coef; };
+
+/* Gauss-Newton step for the connecting-orbit BVPs of solve_homoclinic and
+ * solve_heteroclinic: trapezoidal collocation of x' = 2T f(x) on M intervals
+ * (unknowns: the M+1 mesh points, then T), followed by the rows `bc`. J is
+ * assembled blockwise from one field Jacobian per mesh point (exact when the
+ * model has jacobian_x), and J^T J, J^T F are accumulated over each row's
+ * few nonzeros. Solves (J^T J + 1e-9 I) dU = -J^T F. */
+bool orbit_gauss_newton_step(const Model &m, double p, int M, bool free_T,
+                             const std::vector<OrbitBcRow> &bc,
+                             const std::vector<double> &Uv, const std::vector<double> &F,
+                             std::vector<double> *dU) {
+  const std::size_t n = m.n, NV = (std::size_t)(M + 1) * n + 1;
+  const double T = Uv[NV - 1], h = 1.0 / (double)M;
+  std::vector<double> f((std::size_t)(M + 1) * n), Jn((std::size_t)(M + 1) * n * n), Jx;
+  std::string err;
+  for (int j = 0; j <= M; ++j) {
+    const double *x = &Uv[(std::size_t)j * n];
+    if (!m.vector_field(x, p, &f[(std::size_t)j * n], &err)) return false;
+    if (!jacobian_x(m, x, p, &Jx, &err)) return false;
+    std::copy(Jx.begin(), Jx.end(), Jn.begin() + (std::ptrdiff_t)((std::size_t)j * n * n));
+  }
+  std::vector<double> JTJ(NV * NV, 0.0), JTF(NV, 0.0), v(2 * n + 1);
+  std::vector<std::size_t> idx(2 * n + 1);
+  auto accumulate = [&](std::size_t nz, double Fr) {
+    for (std::size_t a = 0; a < nz; ++a) {
+      if (v[a] == 0.0) continue;
+      JTF[idx[a]] += v[a] * Fr;
+      double *row = &JTJ[idx[a] * NV];
+      for (std::size_t b = 0; b < nz; ++b) row[idx[b]] += v[a] * v[b];
+    }
+  };
+  for (int i = 0; i < M; ++i) {
+    const std::size_t xi = (std::size_t)i * n, xj = xi + n;
+    const double *Ji = &Jn[xi * n], *Jj = &Jn[xj * n];
+    for (std::size_t r = 0; r < n; ++r) {
+      std::size_t nz = 0;
+      for (std::size_t k = 0; k < n; ++k) { idx[nz] = xi + k; v[nz++] = -h * T * Ji[r * n + k] - (k == r ? 1.0 : 0.0); }
+      for (std::size_t k = 0; k < n; ++k) { idx[nz] = xj + k; v[nz++] = -h * T * Jj[r * n + k] + (k == r ? 1.0 : 0.0); }
+      if (free_T) { idx[nz] = NV - 1; v[nz++] = -h * (f[xi + r] + f[xj + r]); }
+      accumulate(nz, F[xi + r]);
+    }
+  }
+  std::size_t row = (std::size_t)M * n;
+  for (const OrbitBcRow &b : bc) {
+    for (std::size_t k = 0; k < n; ++k) { idx[k] = b.node * n + k; v[k] = (*b.coef)[k]; }
+    accumulate(n, F[row++]);
+  }
+  for (std::size_t a = 0; a < NV; ++a) JTJ[a * NV + a] += 1e-9;
+  for (std::size_t a = 0; a < NV; ++a) JTF[a] = -JTF[a];
+  return solve_linear(JTJ, JTF, dU);
+}
+
 } /* anonymous namespace */
 
 bool seed_homoclinic_by_integration(const Model &m, const std::vector<double> &saddle,
@@ -4347,10 +6637,15 @@ HomoclinicResult solve_homoclinic(const Model &m,
     return true;
   };
 
-  /* 4. Gauss-Newton with finite-difference Jacobian (NF x NV, NF<=NV). Solve
-   *    the normal equations (J^T J) dU = -J^T F with a little regularization
-   *    (the system is rectangular: one fewer equation than unknowns, the extra
-   *    freedom is the orbit's overall position which the phase pins softly). */
+  /* 4. Gauss-Newton on the normal equations (J^T J) dU = -J^T F with a little
+   *    regularization (the system is rectangular: one fewer equation than
+   *    unknowns, the extra freedom is the orbit's overall position which the
+   *    phase pins softly). With free_T off, T's column is dropped from J so
+   *    the step leaves T alone. */
+  std::vector<OrbitBcRow> bc;
+  for (const auto &v : Ls) bc.push_back({0, &v});
+  for (const auto &v : Lu) bc.push_back({(std::size_t)M, &v});
+  bc.push_back({(std::size_t)(M / 2), &phase_normal});
   std::vector<double> F(NF), Uv = U;
   double resn = 0;
   int step = 0;
@@ -4358,37 +6653,8 @@ HomoclinicResult solve_homoclinic(const Model &m,
     if (!residual(Uv, &F)) { R.message = "field eval failed during Newton"; return R; }
     resn = 0; for (double f : F) resn += f*f; resn = std::sqrt(resn);
     if (resn < settings.newton_tol) break;
-
-    /* finite-difference Jacobian J (NF x NV) */
-    std::vector<double> J((size_t)NF*NV, 0.0), F2(NF);
-    std::vector<double> Up = Uv;
-    for (int c = 0; c < NV; ++c) {
-      const double save = Up[c];
-      const double dh = 1e-7 * (std::fabs(save) + 1e-3);
-      Up[c] = save + dh;
-      if (!residual(Up, &F2)) { Up[c] = save; continue; }
-      Up[c] = save;
-      for (int r = 0; r < NF; ++r) J[(size_t)r*NV + c] = (F2[r]-F[r])/dh;
-    }
-    if (!settings.free_T) {
-      /* freeze T: zero its whole column so the normal equations give dT ~ 0 */
-      for (int r = 0; r < NF; ++r) J[(size_t)r*NV + (NV-1)] = 0.0;
-    }
-    /* normal equations: (J^T J + mu I) dU = -J^T F */
-    std::vector<double> JTJ((size_t)NV*NV, 0.0), JTF(NV, 0.0);
-    for (int a = 0; a < NV; ++a) {
-      double g = 0; for (int r = 0; r < NF; ++r) g += J[(size_t)r*NV+a]*F[r];
-      JTF[a] = g;
-      for (int b = 0; b < NV; ++b) {
-        double s = 0; for (int r = 0; r < NF; ++r) s += J[(size_t)r*NV+a]*J[(size_t)r*NV+b];
-        JTJ[(size_t)a*NV+b] = s;
-      }
-    }
-    const double mu = 1e-9;
-    for (int a = 0; a < NV; ++a) JTJ[(size_t)a*NV+a] += mu;
-    std::vector<double> dU, rhs(NV);
-    for (int a = 0; a < NV; ++a) rhs[a] = -JTF[a];
-    if (!solve_linear(JTJ, rhs, &dU)) { R.message = "Newton linear solve failed"; break; }
+    std::vector<double> dU;
+    if (!orbit_gauss_newton_step(m, p, M, settings.free_T, bc, Uv, F, &dU)) { R.message = "Newton linear solve failed"; break; }
     double dn = 0; for (double v : dU) dn += v*v; dn = std::sqrt(dn);
     double damp = dn > 0.5 ? 0.5/dn : 1.0;   /* damp big steps */
     for (int a = 0; a < NV; ++a) Uv[a] += damp*dU[a];
@@ -4478,22 +6744,17 @@ HeteroclinicResult solve_heteroclinic(const Model &m,
     return true;
   };
 
+  std::vector<OrbitBcRow> bc;
+  for (const auto &v : Ls0) bc.push_back({0, &v});
+  for (const auto &v : Lu1) bc.push_back({(std::size_t)M, &v});
+  bc.push_back({(std::size_t)(M/2), &phase_normal});
   std::vector<double> F(NF), Uv=U; double resn=0; int step=0;
   for (; step<settings.newton_iters; ++step) {
     if(!residual(Uv,&F)){ R.message="field eval failed during Newton"; return R; }
     resn=0; for(double f:F) resn+=f*f; resn=std::sqrt(resn);
     if(resn<settings.newton_tol) break;
-    std::vector<double> J((size_t)NF*NV,0.0), F2(NF), Up=Uv;
-    for (int c=0;c<NV;c++){ const double save=Up[c]; const double dh=1e-7*(std::fabs(save)+1e-3);
-      Up[c]=save+dh; if(!residual(Up,&F2)){Up[c]=save;continue;} Up[c]=save;
-      for(int r=0;r<NF;r++) J[(size_t)r*NV+c]=(F2[r]-F[r])/dh; }
-    if(!settings.free_T) for(int r=0;r<NF;r++) J[(size_t)r*NV+(NV-1)]=0.0;
-    std::vector<double> JTJ((size_t)NV*NV,0.0), JTF(NV,0.0);
-    for (int a=0;a<NV;a++){ double g=0; for(int r=0;r<NF;r++) g+=J[(size_t)r*NV+a]*F[r]; JTF[a]=g;
-      for(int b=0;b<NV;b++){ double s=0; for(int r=0;r<NF;r++) s+=J[(size_t)r*NV+a]*J[(size_t)r*NV+b]; JTJ[(size_t)a*NV+b]=s; } }
-    for (int a=0;a<NV;a++) JTJ[(size_t)a*NV+a]+=1e-9;
-    std::vector<double> dU, rhs(NV); for(int a=0;a<NV;a++) rhs[a]=-JTF[a];
-    if(!solve_linear(JTJ,rhs,&dU)){ R.message="Newton linear solve failed"; break; }
+    std::vector<double> dU;
+    if(!orbit_gauss_newton_step(m,p,M,settings.free_T,bc,Uv,F,&dU)){ R.message="Newton linear solve failed"; break; }
     double dn=0; for(double v:dU) dn+=v*v; dn=std::sqrt(dn);
     double damp= dn>0.5?0.5/dn:1.0;
     for(int a=0;a<NV;a++) Uv[a]+=damp*dU[a];
@@ -5129,6 +7390,8 @@ BasinResult compute_basins(const std::function<bool(double, double, double *, do
       if (label < 0) {
         if ((int)R.attractors.size() < opt.max_attractors) {
           R.attractors.push_back({x, y});
+          R.attractor_kind.push_back(0);
+          R.attractor_period.push_back(1);
           label = (int)R.attractors.size() - 1;
         } else {
           /* over the cap: attach to nearest existing */
@@ -5152,162 +7415,865 @@ BasinResult compute_basins(const std::function<bool(double, double, double *, do
   return R;
 }
 
-BasinResult compute_basins_mt(const std::function<AdvanceFn(int tid)> &make_advance,
-                              const BasinOptions &opt) {
-  BasinResult R;
+namespace {
+
+/* Signature of a recurrent orbit sampled after its transient (basins with
+ * opt.fingerprint): a cycle (kind 1) -- for maps the smallest period k
+ * that returns the orbit onto itself, for flows k tight clusters of
+ * crossings of the section y = mean(y) -- else a chaotic set (kind 2) with
+ * an 8x8 occupancy mask over centroid +- 2.5 sd (at least cluster_tol, so
+ * an axis the orbit has collapsed on lands in one row). ex, ey, sx, sy are the
+ * centroid and spread, over whole periods for a cycle so they do not
+ * depend on where the window started. A signature narrower than
+ * cluster_tol is a point after all. */
+void classify_recurrent(const std::vector<double> &xs, const std::vector<double> &ys,
+                        const BasinOptions &opt, BasinCell *c) {
+  constexpr size_t kMaxPeriod = 64, kMaxLoops = 8;
+  const size_t n = std::min(xs.size(), ys.size());
+  auto moments = [&](size_t a, size_t b) {
+    const double m = (double)(b - a);
+    double mx = 0, my = 0, vx = 0, vy = 0;
+    for (size_t k = a; k < b; ++k) { mx += xs[k]; my += ys[k]; }
+    mx /= m; my /= m;
+    for (size_t k = a; k < b; ++k) {
+      vx += (xs[k] - mx) * (xs[k] - mx);
+      vy += (ys[k] - my) * (ys[k] - my);
+    }
+    c->ex = mx; c->ey = my;
+    c->sx = (float)std::sqrt(vx / m); c->sy = (float)std::sqrt(vy / m);
+  };
+  c->kind = 2; c->period = 0; c->occ = 0;
+  if (n < 8) { c->state = 2; return; }
+  if (!opt.flow) {
+    const double ptol = std::max(opt.settle_tol, 1e-12);
+    for (size_t k = 1; k <= std::min(kMaxPeriod, n / 4) && c->kind == 2; ++k) {
+      bool back = true;
+      for (size_t m = n - 2 * k; back && m < n; ++m)
+        back = std::fabs(xs[m] - xs[m - k]) + std::fabs(ys[m] - ys[m - k]) <=
+               ptol * (1.0 + std::fabs(xs[m]) + std::fabs(ys[m]));
+      if (back) { c->kind = 1; c->period = (int)k; moments(n - k, n); }
+    }
+  } else {
+    double cy = 0, xlo = xs[0], xhi = xs[0];
+    for (size_t k = 0; k < n; ++k) { cy += ys[k]; xlo = std::min(xlo, xs[k]); xhi = std::max(xhi, xs[k]); }
+    cy /= (double)n;
+    std::vector<double> xc;
+    std::vector<size_t> at;
+    for (size_t m = 1; m < n; ++m)
+      if (ys[m - 1] < cy && ys[m] >= cy) {
+        const double t = (cy - ys[m - 1]) / (ys[m] - ys[m - 1]);
+        xc.push_back(xs[m - 1] + t * (xs[m] - xs[m - 1]));
+        at.push_back(m);
+      }
+    if (xc.size() >= 3) {
+      const double gap = std::max(opt.cluster_tol, 0.01 * (xhi - xlo));
+      std::vector<double> sorted = xc;
+      std::sort(sorted.begin(), sorted.end());
+      size_t loops = 1;
+      bool tight = true;
+      double first = sorted[0];
+      for (size_t k = 1; k < sorted.size(); ++k) {
+        if (sorted[k] - sorted[k - 1] > gap) { ++loops; first = sorted[k]; }
+        else if (sorted[k] - first > gap) tight = false;
+      }
+      if (tight && loops <= kMaxLoops && xc.size() >= 2 * loops + 1) {
+        c->kind = 1; c->period = (int)loops;
+        moments(at[0], at[(xc.size() - 1) / loops * loops]);
+      }
+    }
+  }
+  if (c->kind == 2) {
+    moments(0, n);
+    const double wx = 5.0 * std::max((double)c->sx, opt.cluster_tol), wy = 5.0 * std::max((double)c->sy, opt.cluster_tol);
+    const double x0 = c->ex - 0.5 * wx, y0 = c->ey - 0.5 * wy;
+    for (size_t k = 0; k < n; ++k) {
+      const double gx = std::floor((xs[k] - x0) / wx * 8.0), gy = std::floor((ys[k] - y0) / wy * 8.0);
+      if (gx >= 0 && gx < 8 && gy >= 0 && gy < 8) c->occ |= std::uint64_t(1) << ((int)gy * 8 + (int)gx);
+    }
+  }
+  if ((double)c->sx + (double)c->sy < 0.5 * opt.cluster_tol) {
+    c->state = 0; c->kind = 0; c->period = 0; c->sx = c->sy = 0; c->occ = 0;
+  } else {
+    c->state = 3;
+  }
+}
+
+/* Whether two basin cells reached the same attractor: the same status and,
+ * for settled cells, endpoints within tol; fingerprinted cells must match
+ * in kind and period, and in centroid and spread to within tol or a share
+ * of the spread (a twentieth for cycles, whose statistics are exact, a
+ * quarter for chaotic sets, which are sampled), and chaotic ones must
+ * overlap in at least half of their occupied boxes. */
+bool same_attractor_signature(const BasinCell &a, const BasinCell &b, double tol) {
+  const double dx = a.ex - b.ex, dy = a.ey - b.ey;
+  if (a.kind != b.kind || a.period != b.period) return false;
+  const double spread = 0.5 * ((double)a.sx + a.sy + b.sx + b.sy);
+  const double t = std::max(tol, (a.kind == 1 ? 0.05 : 0.25) * spread);
+  if (std::fabs(dx) > t || std::fabs(dy) > t || std::fabs((double)a.sx - b.sx) > t ||
+      std::fabs((double)a.sy - b.sy) > t)
+    return false;
+  if (a.kind != 2) return true;
+  const size_t both = std::bitset<64>(a.occ & b.occ).count(), any = std::bitset<64>(a.occ | b.occ).count();
+  return 2 * both >= any;
+}
+
+inline bool same_attractor(const BasinCell &a, const BasinCell &b, double tol) {
+  if (a.state != b.state) return false;
+  if (a.state == 1 || a.state == 2) return true;
+  if (a.state == 0) {
+    const double dx = a.ex - b.ex, dy = a.ey - b.ey;
+    return dx * dx + dy * dy < tol * tol;
+  }
+  return same_attractor_signature(a, b, tol);
+}
+
+/* Spatial hash of an attractor signature: centroid and spread quantized on
+ * a grid of step h, with points using (x, y) only. h is cluster_tol / sqrt2
+ * for points and cluster_tol for cycles; for chaotic sets it follows the
+ * spread in powers of two (`scale`), so neighbouring keys cover the
+ * tolerance of same_attractor. */
+struct AttractorKey {
+  int state = 0, kind = 0, period = 0, scale = 0;
+  std::int64_t q[4] = {0, 0, 0, 0};
+  bool operator==(const AttractorKey &o) const {
+    return state == o.state && kind == o.kind && period == o.period && scale == o.scale && q[0] == o.q[0] &&
+           q[1] == o.q[1] && q[2] == o.q[2] && q[3] == o.q[3];
+  }
+};
+
+struct AttractorKeyHash {
+  size_t operator()(const AttractorKey &k) const {
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&](std::int64_t v) { h = (h ^ (std::uint64_t)v) * 1099511628211ull; };
+    mix(k.state); mix(k.kind); mix(k.period); mix(k.scale);
+    for (std::int64_t v : k.q) mix(v);
+    return (size_t)h;
+  }
+};
+
+int attractor_scale(const BasinCell &c) {
+  if (c.state != 3 || c.kind != 2) return 0;
+  return std::ilogb(std::max(0.5 * ((double)c.sx + c.sy), 1e-300));
+}
+
+AttractorKey attractor_key(const BasinCell &c, double tol, int scale) {
+  AttractorKey k;
+  k.state = c.state; k.kind = c.kind; k.period = c.period; k.scale = scale;
+  const double inv = c.state == 0 ? 1.4142135623730951 / tol : (c.kind == 1 ? 1.0 / tol : std::ldexp(1.0, 1 - scale));
+  auto quant = [inv](double v) {
+    const double g = std::floor(v * inv);
+    return (std::int64_t)std::max(-4.0e18, std::min(4.0e18, g));
+  };
+  k.q[0] = quant(c.ex); k.q[1] = quant(c.ey);
+  if (c.state == 3) { k.q[2] = quant(c.sx); k.q[3] = quant(c.sy); }
+  return k;
+}
+
+}  // namespace
+
+void integrate_basin_cells(const std::function<AdvanceFn(int tid)> &make_advance,
+                           const BasinOptions &opt, std::vector<BasinCell> *cells,
+                           bool parallel) {
   const int W = std::max(2, opt.width), H = std::max(2, opt.height);
-  R.width = W; R.height = H;
-  R.cell_attractor.assign((size_t)W * H, -1);
-  R.cell_speed.assign((size_t)W * H, 0.0f);
   const double R2 = opt.diverge_r * opt.diverge_r;
+  cells->assign((size_t)W * H, BasinCell());
+
+  /* Each worker thread owns a private advance (private eval scratch) so there
+   * is no shared mutable state in the hot loop. Rows go through the shared
+   * pool, which balances slow bands by stealing; the advance for a slot is
+   * made the first time that slot runs a row. */
+  const unsigned nslots = (!parallel || H < 8) ? 1u : pool::threads();
+  std::vector<AdvanceFn> advances(nslots);
+
+  /* memoize: resolved[k] goes 0 (open) -> 1 (being written, by whoever
+   * claimed it) -> 2 (published, release); a reader that acquires 2 can read
+   * cell k. Besides its own cell, a resolved orbit publishes the open cells
+   * it passed through with the same outcome, as in simple cell mapping. */
+  const bool memo = opt.memoize;
+  const int confirm = std::max(1, opt.memo_confirm);
   const double clus2 = opt.cluster_tol * opt.cluster_tol;
+  constexpr size_t kMaxPath = 512;
+  std::unique_ptr<std::atomic<unsigned char>[]> resolved;
+  if (memo) {
+    resolved.reset(new std::atomic<unsigned char>[(size_t)W * H]);
+    for (size_t k = 0; k < (size_t)W * H; ++k) resolved[k].store(0, std::memory_order_relaxed);
+  }
+  const double sx = (W - 1) / (opt.xmax - opt.xmin), sy = (H - 1) / (opt.ymax - opt.ymin);
+  auto cell_index = [&](double x, double y) -> long {
+    const double fi = (x - opt.xmin) * sx, fj = (y - opt.ymin) * sy;
+    if (!(fi > -0.5 && fi < W - 0.5 && fj > -0.5 && fj < H - 0.5)) return -1;
+    return std::lround(fj) * W + std::lround(fi);
+  };
+  auto publish = [&](size_t k, const BasinCell &c) {
+    unsigned char open = 0;
+    if (!resolved[k].compare_exchange_strong(open, 1, std::memory_order_acq_rel)) return;
+    (*cells)[k] = c;
+    resolved[k].store(2, std::memory_order_release);
+  };
 
-  /* Phase 1 (parallel): integrate each cell independently, recording endpoint,
-   * status and step count. Each worker thread owns a private advance (private
-   * eval scratch) so there is no shared mutable state in the hot loop. */
-  struct CellOut { double ex = 0, ey = 0; long steps = 0; int state = 1; }; /* 0 settled,1 diverged,2 nonconv */
-  std::vector<CellOut> cells((size_t)W * H);
-
-  unsigned hw = std::thread::hardware_concurrency();
-  unsigned nthreads = (hw < 2 || H < 8) ? 1u : std::min<unsigned>(hw, (unsigned)H);
-
-  auto do_rows = [&](int tid, int j0, int j1) {
-    AdvanceFn advance = make_advance(tid);
-    for (int j = j0; j < j1; ++j) {
-      const double y0 = opt.ymin + (opt.ymax - opt.ymin) * (double)j / (H - 1);
-      for (int i = 0; i < W; ++i) {
-        const double x0 = opt.xmin + (opt.xmax - opt.xmin) * (double)i / (W - 1);
-        double x = x0, y = y0;
-        long steps = 0; bool diverged = false, settled = false;
-        double px = x, py = y; const long stride = 8;
-        for (; steps < opt.max_steps; ++steps) {
-          double nx = x, ny = y;
-          if (!advance(x, y, &nx, &ny)) { diverged = true; break; }
-          if (!std::isfinite(nx) || !std::isfinite(ny) || nx * nx + ny * ny > R2) { diverged = true; break; }
-          x = nx; y = ny;
-          if ((steps % stride) == (stride - 1)) {
-            const double drift = std::fabs(x - px) + std::fabs(y - py);
-            if (drift < opt.settle_tol) settled = true;
-            px = x; py = y;
-            if (settled) break;
-          }
+  /* Without memoize a cell is only ever written by the thread that owns its
+   * row (or its block, when adaptive), so a plain flag marks it solved. */
+  std::vector<unsigned char> solved(memo ? 0 : (size_t)W * H, 0);
+  auto known = [&](size_t k) {
+    return memo ? resolved[k].load(std::memory_order_acquire) == 2 : solved[k] != 0;
+  };
+  auto store = [&](size_t k, const BasinCell &c) {
+    if (memo) { publish(k, c); return; }
+    (*cells)[k] = c;
+    solved[k] = 1;
+  };
+
+  /* fingerprint: run on from (x, y) and classify the recurrent orbit; a
+   * settled map only needs enough steps to expose a cycle hiding under the
+   * drift stride */
+  constexpr long kCycleWindow = 32;
+  struct Orbit { std::vector<double> xs, ys; };
+  auto fingerprint_orbit = [&](double x, double y, AdvanceFn &advance, Orbit &orbit, BasinCell *c) {
+    const long n = c->state == 0 ? kCycleWindow : std::max(kCycleWindow, opt.fp_steps);
+    orbit.xs.clear(); orbit.ys.clear();
+    for (long k = 0; k < n; ++k) {
+      double nx = x, ny = y;
+      if (!advance(x, y, &nx, &ny) || !std::isfinite(nx) || !std::isfinite(ny) || nx * nx + ny * ny > R2) {
+        c->state = 1; c->ex = x; c->ey = y;
+        return;
+      }
+      x = nx; y = ny;
+      orbit.xs.push_back(x); orbit.ys.push_back(y);
+    }
+    classify_recurrent(orbit.xs, orbit.ys, opt, c);
+  };
+
+  /* integrate the orbit of cell (i, j) and store its outcome */
+  using Path = std::vector<std::pair<long, long>>; /* (cell, step it was entered) */
+  auto solve = [&](int i, int j, AdvanceFn &advance, Path &path, Orbit &orbit) {
+    const size_t idx = (size_t)j * W + i;
+    if (known(idx)) return; /* labelled by a path */
+    const double x0 = opt.xmin + (opt.xmax - opt.xmin) * (double)i / (W - 1);
+    const double y0 = opt.ymin + (opt.ymax - opt.ymin) * (double)j / (H - 1);
+    double x = x0, y = y0;
+    long steps = 0; bool diverged = false, settled = false;
+    double px = x, py = y; const long stride = 8;
+    const BasinCell *run_ref = nullptr; /* outcome the current run agrees on */
+    int run = 0;
+    path.clear();
+    for (; steps < opt.max_steps; ++steps) {
+      double nx = x, ny = y;
+      if (!advance(x, y, &nx, &ny)) { diverged = true; break; }
+      if (!std::isfinite(nx) || !std::isfinite(ny) || nx * nx + ny * ny > R2) { diverged = true; break; }
+      x = nx; y = ny;
+      if (memo) {
+        const long k = cell_index(x, y);
+        const BasinCell *o = nullptr;
+        if (k >= 0 && resolved[k].load(std::memory_order_acquire) == 2) o = &(*cells)[k];
+        else if (k >= 0 && k != (long)idx && (path.empty() || path.back().first != k) && path.size() < kMaxPath)
+          path.push_back({k, steps});
+        if (!o || o->state >= 2) {
+          run = 0;
+        } else if (run > 0 && (o->state != run_ref->state ||
+                               (o->state == 0 && (o->ex - run_ref->ex) * (o->ex - run_ref->ex) +
+                                                     (o->ey - run_ref->ey) * (o->ey - run_ref->ey) >= clus2))) {
+          run = 1; run_ref = o;
+        } else {
+          if (run == 0) run_ref = o;
+          if (++run >= confirm) break;
         }
-        CellOut &c = cells[(size_t)j * W + i];
-        c.ex = x; c.ey = y; c.steps = steps;
-        c.state = diverged ? 1 : (settled ? 0 : 2);
+      }
+      if ((steps % stride) == (stride - 1)) {
+        const double drift = std::fabs(x - px) + std::fabs(y - py);
+        if (drift < opt.settle_tol) settled = true;
+        px = x; py = y;
+        if (settled) break;
       }
     }
+    BasinCell c;
+    if (memo && run >= confirm && !settled) {
+      c.ex = run_ref->ex; c.ey = run_ref->ey;
+      c.steps = std::min(opt.max_steps, steps + 1 + run_ref->steps);
+      c.state = run_ref->state;
+      c.inherited = 1;
+    } else {
+      c.ex = x; c.ey = y; c.steps = steps;
+      c.state = diverged ? 1 : (settled ? 0 : 2);
+      if (opt.fingerprint && (c.state == 2 || (c.state == 0 && !opt.flow)))
+        fingerprint_orbit(x, y, advance, orbit, &c);
+    }
+    store(idx, c);
+    if (!memo || c.state >= 2) return; /* an orbit that never settled labels nothing else */
+    for (const auto &pe : path) {
+      BasinCell pc = c;
+      pc.steps = std::max(0L, c.steps - pe.second);
+      pc.inherited = 1;
+      publish((size_t)pe.first, pc);
+    }
+  };
+
+  auto slot_advance = [&](unsigned slot) -> AdvanceFn & {
+    AdvanceFn &advance = advances[slot];
+    if (!advance) advance = make_advance((int)slot);
+    return advance;
   };
 
-  if (nthreads <= 1) {
-    do_rows(0, 0, H);
+  if (!opt.adaptive) {
+    auto do_row = [&](int j, unsigned slot) {
+      AdvanceFn &advance = slot_advance(slot);
+      Path path;
+      Orbit orbit;
+      for (int i = 0; i < W; ++i) solve(i, j, advance, path, orbit);
+    };
+    if (nslots <= 1) {
+      for (int j = 0; j < H; ++j) do_row(j, 0);
+    } else {
+      pool::parallel_for((std::size_t)H, [&](std::size_t j, unsigned slot) { do_row((int)j, slot); });
+    }
+    return;
+  }
+
+  /* Adaptive: the fractal view's boundary tracing (trace::subdivide) on
+   * disjoint blocks of the grid. A block whose border cells all share one
+   * outcome is filled without integration, otherwise it is split down to
+   * trace::kMinSplit, where the interior is simply integrated. Filled cells
+   * copy the corner's endpoint and interpolate the step count between the
+   * four corners, so speed shading stays smooth. */
+  const int B = std::max(2 * trace::kMinSplit, (std::max(W, H) + std::max(1, opt.adaptive_grid) - 1) /
+                                                   std::max(1, opt.adaptive_grid));
+  const int BW = (W + B - 1) / B, BH = (H + B - 1) / B;
+  auto same = [&](const BasinCell &a, const BasinCell &b) { return same_attractor(a, b, opt.cluster_tol); };
+  auto do_block = [&](size_t item, unsigned slot) {
+    AdvanceFn &advance = slot_advance(slot);
+    Path path;
+    Orbit orbit;
+    /* the outcome of (i, j), integrating it if needed; under memoize another
+     * thread may own the cell's write, which is a plain struct copy */
+    auto at = [&](int i, int j) -> const BasinCell & {
+      solve(i, j, advance, path, orbit);
+      const size_t k = (size_t)j * W + i;
+      if (memo)
+        while (resolved[k].load(std::memory_order_acquire) != 2) std::this_thread::yield();
+      return (*cells)[k];
+    };
+    auto fill = [&](const trace::Rect &r, const BasinCell &c0) {
+      const double s00 = (double)c0.steps, s10 = (double)at(r.gx1, r.gy0).steps;
+      const double s01 = (double)at(r.gx0, r.gy1).steps, s11 = (double)at(r.gx1, r.gy1).steps;
+      for (int j = r.gy0 + 1; j < r.gy1; ++j) {
+        const double v = (double)(j - r.gy0) / (r.gy1 - r.gy0);
+        for (int i = r.gx0 + 1; i < r.gx1; ++i) {
+          const size_t k = (size_t)j * W + i;
+          if (known(k)) continue;
+          const double u = (double)(i - r.gx0) / (r.gx1 - r.gx0);
+          BasinCell f = c0;
+          f.steps = std::lround((1 - v) * ((1 - u) * s00 + u * s10) + v * ((1 - u) * s01 + u * s11));
+          f.inherited = 1;
+          store(k, f);
+        }
+      }
+    };
+    auto full = [&](const trace::Rect &r) {
+      for (int j = r.gy0 + 1; j < r.gy1; ++j)
+        for (int i = r.gx0 + 1; i < r.gx1; ++i) solve(i, j, advance, path, orbit);
+    };
+    const int bx = (int)(item % BW), by = (int)(item / BW);
+    trace::subdivide({bx * B, by * B, std::min(W, (bx + 1) * B) - 1, std::min(H, (by + 1) * B) - 1}, at, same,
+                     fill, full);
+  };
+  const size_t nblocks = (size_t)BW * BH;
+  if (nslots <= 1) {
+    for (size_t b = 0; b < nblocks; ++b) do_block(b, 0);
   } else {
-    std::vector<std::thread> pool;
-    pool.reserve(nthreads);
-    int per = (H + (int)nthreads - 1) / (int)nthreads;
-    for (unsigned t = 0; t < nthreads; ++t) {
-      int j0 = (int)t * per, j1 = std::min(H, j0 + per);
-      if (j0 >= j1) break;
-      pool.emplace_back(do_rows, (int)t, j0, j1);
+    pool::parallel_for(nblocks, [&](std::size_t b, unsigned slot) { do_block(b, slot); });
+  }
+}
+
+BasinResult cluster_basin_cells(const std::vector<BasinCell> &cells, int width, int height,
+                                const BasinOptions &opt) {
+  BasinResult R;
+  const int W = std::max(2, width), H = std::max(2, height);
+  R.width = W; R.height = H;
+  if (cells.size() != (size_t)W * H) { R.message = "cell grid does not match its size"; return R; }
+  const size_t N = (size_t)W * H;
+  R.cell_attractor.assign(N, -1);
+  R.cell_speed.assign(N, 0.0f);
+  const double tol = opt.cluster_tol;
+
+  /* 1. (parallel over fixed row bands) bucket the settled and fingerprinted
+   * cells by the spatial hash of their signature, and split each bucket into
+   * nodes: a cell joins the first node whose founding cell it matches, else
+   * founds one. Almost every bucket holds a single node. A few recent keys
+   * are kept at hand, since neighbouring cells mostly share one. Speeds,
+   * counts and the labels of unsettled cells are written on the way. */
+  struct Band {
+    std::unordered_map<AttractorKey, std::uint32_t, AttractorKeyHash> bucket_of;
+    std::vector<AttractorKey> keys;                   /* bucket -> key */
+    std::vector<std::vector<std::uint32_t>> nodes;    /* bucket -> its nodes */
+    std::vector<std::uint32_t> founder, node_bucket;  /* node -> founding cell, bucket */
+    std::vector<std::uint32_t> global;                /* node -> node of the whole grid */
+  };
+  const size_t rows_per_band = std::max<size_t>(1, (size_t)H / 64);
+  const size_t nbands = ((size_t)H + rows_per_band - 1) / rows_per_band;
+  std::vector<Band> bands(nbands);
+  constexpr std::uint32_t kNoNode = 0xffffffffu;
+  std::vector<std::uint32_t> cell_node(N, kNoNode); /* node within the cell's band */
+  struct Counts { long converged = 0, diverged = 0, nonconvergent = 0, inherited = 0; };
+  std::vector<Counts> counts(nbands);
+  pool::parallel_for(nbands, [&](size_t bi, unsigned) {
+    Band &band = bands[bi];
+    constexpr int kRecent = 4;
+    AttractorKey recent_key[kRecent];
+    std::uint32_t recent_bucket[kRecent];
+    int nrecent = 0, next = 0;
+    Counts &n = counts[bi];
+    const size_t end = std::min((size_t)H, (bi + 1) * rows_per_band) * W;
+    for (size_t idx = bi * rows_per_band * W; idx < end; ++idx) {
+      const BasinCell &c = cells[idx];
+      n.inherited += c.inherited;
+      if (c.state == 1) { ++n.diverged; continue; }
+      if (c.state != 0 && c.state != 3) { R.cell_attractor[idx] = -2; ++n.nonconvergent; continue; }
+      ++n.converged;
+      R.cell_speed[idx] = (float)(1.0 - (double)std::min(c.steps, opt.max_steps) / (double)opt.max_steps);
+      const AttractorKey k = attractor_key(c, tol, attractor_scale(c));
+      int r = 0;
+      while (r < nrecent && !(recent_key[r] == k)) ++r;
+      std::uint32_t b;
+      if (r < nrecent) {
+        b = recent_bucket[r];
+      } else {
+        auto ins = band.bucket_of.emplace(k, (std::uint32_t)band.keys.size());
+        if (ins.second) { band.keys.push_back(k); band.nodes.emplace_back(); }
+        b = ins.first->second;
+        recent_key[next] = k; recent_bucket[next] = b;
+        next = (next + 1) % kRecent;
+        nrecent = std::min(kRecent, nrecent + 1);
+      }
+      std::vector<std::uint32_t> &nodes = band.nodes[b];
+      size_t f = 0;
+      while (f < nodes.size() && !same_attractor(cells[band.founder[nodes[f]]], c, tol)) ++f;
+      if (f == nodes.size()) {
+        nodes.push_back((std::uint32_t)band.founder.size());
+        band.founder.push_back((std::uint32_t)idx);
+        band.node_bucket.push_back(b);
+      }
+      cell_node[idx] = nodes[f];
+    }
+  });
+
+  /* 2. merge the bands in order into nodes of the whole grid, again matching
+   * a band's node to the first global node of its bucket that fits */
+  std::unordered_map<AttractorKey, size_t, AttractorKeyHash> bucket_of;
+  std::vector<std::vector<std::uint32_t>> bucket_nodes;
+  std::vector<std::uint32_t> founder;
+  for (Band &band : bands) {
+    band.global.resize(band.founder.size());
+    for (size_t n = 0; n < band.founder.size(); ++n) {
+      auto ins = bucket_of.emplace(band.keys[band.node_bucket[n]], bucket_nodes.size());
+      if (ins.second) bucket_nodes.emplace_back();
+      std::vector<std::uint32_t> &nodes = bucket_nodes[ins.first->second];
+      const BasinCell &c = cells[band.founder[n]];
+      size_t f = 0;
+      while (f < nodes.size() && !same_attractor(cells[founder[nodes[f]]], c, tol)) ++f;
+      if (f == nodes.size()) {
+        nodes.push_back((std::uint32_t)founder.size());
+        founder.push_back(band.founder[n]);
+      }
+      band.global[n] = nodes[f];
+    }
+    decltype(band.bucket_of)().swap(band.bucket_of);
+  }
+  const size_t nnodes = founder.size();
+
+  /* 3. join matching nodes of neighbouring buckets (single linkage); a set
+   * is represented by its earliest founding cell */
+  std::vector<size_t> parent(nnodes);
+  for (size_t v = 0; v < nnodes; ++v) parent[v] = v;
+  auto find = [&](size_t v) {
+    while (parent[v] != v) v = parent[v] = parent[parent[v]];
+    return v;
+  };
+  auto unite = [&](size_t a, size_t b) {
+    a = find(a); b = find(b);
+    if (a == b) return;
+    if (founder[b] < founder[a]) std::swap(a, b);
+    parent[b] = a;
+  };
+  for (size_t v = 0; v < nnodes; ++v) {
+    const BasinCell &c = cells[founder[v]];
+    const int s0 = attractor_scale(c);
+    const int dims = c.state == 3 ? 4 : 2;
+    int span = 1;
+    for (int d = 0; d < dims; ++d) span *= 3;
+    for (int s = (c.kind == 2 ? s0 - 1 : s0); s <= (c.kind == 2 ? s0 + 1 : s0); ++s) {
+      const AttractorKey home = attractor_key(c, tol, s);
+      for (int off = 0; off < span; ++off) {
+        AttractorKey k = home;
+        for (int d = 0, o = off; d < dims; ++d, o /= 3) k.q[d] += o % 3 - 1;
+        auto it = bucket_of.find(k);
+        if (it == bucket_of.end()) continue;
+        for (std::uint32_t u : bucket_nodes[it->second])
+          if (u != v && same_attractor(c, cells[founder[u]], tol)) unite(u, v);
+      }
     }
-    for (auto &th : pool) th.join();
   }
 
-  /* Phase 2 (serial): cluster endpoints into attractors with deterministic
-   * labels (identical to the serial compute_basins). */
-  for (int j = 0; j < H; ++j) {
-    for (int i = 0; i < W; ++i) {
-      const size_t idx = (size_t)j * W + i;
-      const CellOut &c = cells[idx];
-      if (c.state == 1) { R.cell_attractor[idx] = -1; ++R.n_diverged; continue; }
-      if (c.state == 2) { R.cell_attractor[idx] = -2; ++R.n_nonconvergent; continue; }
-      const double x = c.ex, y = c.ey;
-      int label = -1;
-      for (size_t a = 0; a < R.attractors.size(); ++a) {
-        const double dx = x - R.attractors[a].first, dy = y - R.attractors[a].second;
-        if (dx * dx + dy * dy < clus2) { label = (int)a; break; }
+  /* 4. label the sets in order of their first cell; past max_attractors a
+   * set goes to the nearest labelled attractor of the same kind (any kind
+   * if there is none) */
+  std::vector<size_t> roots;
+  for (size_t v = 0; v < nnodes; ++v)
+    if (find(v) == v) roots.push_back(v);
+  std::sort(roots.begin(), roots.end(), [&](size_t a, size_t b) { return founder[a] < founder[b]; });
+  std::vector<int> root_label(nnodes, -1);
+  std::vector<size_t> labelled;
+  for (size_t r : roots) {
+    const BasinCell &c = cells[founder[r]];
+    if ((int)R.attractors.size() < opt.max_attractors) {
+      root_label[r] = (int)R.attractors.size();
+      R.attractors.push_back({c.ex, c.ey});
+      R.attractor_kind.push_back(c.state == 0 ? 0 : c.kind);
+      R.attractor_period.push_back(c.state == 0 ? 1 : (c.kind == 1 ? c.period : 0));
+      labelled.push_back(r);
+      continue;
+    }
+    double best = 1e300;
+    for (int pass = 0; pass < 2 && root_label[r] < 0; ++pass)
+      for (size_t a = 0; a < labelled.size(); ++a) {
+        const BasinCell &o = cells[founder[labelled[a]]];
+        if (pass == 0 && (o.state != c.state || o.kind != c.kind)) continue;
+        const double dx = c.ex - o.ex, dy = c.ey - o.ey, d = dx * dx + dy * dy;
+        if (d < best) { best = d; root_label[r] = (int)a; }
       }
-      if (label < 0) {
-        if ((int)R.attractors.size() < opt.max_attractors) {
-          R.attractors.push_back({x, y});
-          label = (int)R.attractors.size() - 1;
-        } else {
-          double best = 1e300; int bi = -1;
-          for (size_t a = 0; a < R.attractors.size(); ++a) {
-            const double dx = x - R.attractors[a].first, dy = y - R.attractors[a].second;
-            const double d = dx * dx + dy * dy;
-            if (d < best) { best = d; bi = (int)a; }
+  }
+  std::vector<int> node_label(nnodes);
+  for (size_t v = 0; v < nnodes; ++v) node_label[v] = root_label[find(v)];
+
+  /* 5. (parallel over the bands) label the settled cells */
+  pool::parallel_for(nbands, [&](size_t bi, unsigned) {
+    const std::vector<std::uint32_t> &global = bands[bi].global;
+    const size_t end = std::min((size_t)H, (bi + 1) * rows_per_band) * W;
+    for (size_t idx = bi * rows_per_band * W; idx < end; ++idx)
+      if (cell_node[idx] != kNoNode) R.cell_attractor[idx] = node_label[global[cell_node[idx]]];
+  });
+  for (const Counts &n : counts) {
+    R.n_converged += n.converged; R.n_diverged += n.diverged;
+    R.n_nonconvergent += n.nonconvergent; R.n_inherited += n.inherited;
+  }
+  R.ok = true; R.message = "ok";
+  return R;
+}
+
+BasinResult compute_basins_mt(const std::function<AdvanceFn(int tid)> &make_advance,
+                              const BasinOptions &opt) {
+  /* Phase 1 (parallel): integrate each cell independently, recording endpoint,
+   * status and step count (and signature, with fingerprint). Phase 2: cluster
+   * them. */
+  std::vector<BasinCell> cells;
+  integrate_basin_cells(make_advance, opt, &cells);
+  return cluster_basin_cells(cells, opt.width, opt.height, opt);
+}
+
+std::vector<int> basin_volume_slice_order(int depth) {
+  std::vector<int> order;
+  if (depth <= 0) return order;
+  std::vector<char> seen((size_t)depth, 0);
+  auto add = [&](int k) {
+    if (!seen[(size_t)k]) { seen[(size_t)k] = 1; order.push_back(k); }
+  };
+  add(0);
+  add(depth - 1);
+  /* breadth-first bisection: each pass halves every gap */
+  std::vector<std::pair<int, int>> gaps{{0, depth - 1}}, next;
+  while (!gaps.empty()) {
+    next.clear();
+    for (const auto &g : gaps) {
+      if (g.second - g.first < 2) continue;
+      const int m = (g.first + g.second) / 2;
+      add(m);
+      next.push_back({g.first, m});
+      next.push_back({m, g.second});
+    }
+    gaps.swap(next);
+  }
+  return order;
+}
+
+bool compute_basin_volume(const std::function<AdvanceFn3(int tid)> &make_advance,
+                          const BasinVolumeOptions &opt, BasinVolume *vol,
+                          const std::function<bool(int slice)> &on_slice, bool parallel) {
+  const int W = std::max(2, opt.size[0]), H = std::max(2, opt.size[1]), D = std::max(1, opt.size[2]);
+  volume::LabelVolume &labels = vol->labels;
+  bool same_box = true;
+  for (int d = 0; d < 3; ++d) same_box = same_box && vol->lo[(size_t)d] == opt.lo[d] && vol->hi[(size_t)d] == opt.hi[d];
+  if (labels.width() != W || labels.height() != H || labels.depth() != D || labels.filled() == 0 || !same_box) {
+    labels.reset(W, H, D);
+    for (int d = 0; d < 3; ++d) {
+      vol->lo[(size_t)d] = opt.lo[d];
+      vol->hi[(size_t)d] = opt.hi[d];
+    }
+    vol->attractors.clear();
+    vol->n_converged = vol->n_diverged = vol->n_nonconvergent = 0;
+  }
+  vol->ok = false;
+  const double R2 = opt.diverge_r * opt.diverge_r;
+  const double tol = opt.cluster_tol, tol2 = tol * tol;
+  const unsigned nslots = (!parallel || H < 8) ? 1u : pool::threads();
+  std::vector<AdvanceFn3> advances(nslots);
+
+  /* attractors found so far, hashed on a grid of side tol so a match can
+   * only sit in the 27 grid cells around an endpoint */
+  struct GridKey {
+    std::int64_t q[3];
+    bool operator==(const GridKey &o) const { return q[0] == o.q[0] && q[1] == o.q[1] && q[2] == o.q[2]; }
+  };
+  struct GridKeyHash {
+    size_t operator()(const GridKey &k) const {
+      std::uint64_t h = 1469598103934665603ull;
+      for (std::int64_t v : k.q) h = (h ^ (std::uint64_t)v) * 1099511628211ull;
+      return (size_t)h;
+    }
+  };
+  auto grid_key = [tol](const double *p) {
+    GridKey k;
+    for (int d = 0; d < 3; ++d) k.q[d] = (std::int64_t)std::max(-4.0e18, std::min(4.0e18, std::floor(p[d] / tol)));
+    return k;
+  };
+  std::unordered_map<GridKey, std::vector<int>, GridKeyHash> grid;
+  for (size_t a = 0; a < vol->attractors.size(); ++a) grid[grid_key(vol->attractors[a].data())].push_back((int)a);
+  auto dist2 = [](const double *p, const std::array<double, 3> &a) {
+    const double dx = p[0] - a[0], dy = p[1] - a[1], dz = p[2] - a[2];
+    return dx * dx + dy * dy + dz * dz;
+  };
+  auto classify = [&](const double *p) -> int {
+    const GridKey home = grid_key(p);
+    int label = -1;
+    for (int off = 0; off < 27; ++off) {
+      GridKey k = home;
+      k.q[0] += off % 3 - 1; k.q[1] += off / 3 % 3 - 1; k.q[2] += off / 9 - 1;
+      auto it = grid.find(k);
+      if (it == grid.end()) continue;
+      for (int a : it->second)
+        if ((label < 0 || a < label) && dist2(p, vol->attractors[(size_t)a]) < tol2) label = a;
+    }
+    if (label >= 0) return label;
+    if ((int)vol->attractors.size() < opt.max_attractors) {
+      vol->attractors.push_back({{p[0], p[1], p[2]}});
+      grid[home].push_back((int)vol->attractors.size() - 1);
+      return (int)vol->attractors.size() - 1;
+    }
+    double best = 1e300;
+    for (size_t a = 0; a < vol->attractors.size(); ++a) {
+      const double d = dist2(p, vol->attractors[a]);
+      if (d < best) { best = d; label = (int)a; }
+    }
+    return label;
+  };
+
+  struct End {
+    double p[3];
+    int state; /* 0 settled, 1 diverged, 2 did not settle */
+  };
+  std::vector<End> ends((size_t)W * H);
+  std::vector<std::int16_t> slice((size_t)W * H);
+  auto axis = [&](int d, int i, int n) { return n < 2 ? opt.lo[d] : opt.lo[d] + (opt.hi[d] - opt.lo[d]) * (double)i / (n - 1); };
+  for (int k : basin_volume_slice_order(D)) {
+    if (labels.has_slice(k)) continue;
+    const double z = axis(2, k, D);
+    auto do_row = [&](size_t j, unsigned slot) {
+      AdvanceFn3 &advance = advances[slot];
+      if (!advance) advance = make_advance((int)slot);
+      const double y = axis(1, (int)j, H);
+      for (int i = 0; i < W; ++i) {
+        double p[3] = {axis(0, i, W), y, z}, np[3], pp[3] = {p[0], p[1], p[2]};
+        int state = 2;
+        for (long step = 0; step < opt.max_steps; ++step) {
+          np[0] = p[0]; np[1] = p[1]; np[2] = p[2];
+          if (!advance(p, np) || !std::isfinite(np[0]) || !std::isfinite(np[1]) || !std::isfinite(np[2]) ||
+              np[0] * np[0] + np[1] * np[1] + np[2] * np[2] > R2) {
+            state = 1;
+            break;
+          }
+          p[0] = np[0]; p[1] = np[1]; p[2] = np[2];
+          if ((step & 7) == 7) {
+            const double drift = std::fabs(p[0] - pp[0]) + std::fabs(p[1] - pp[1]) + std::fabs(p[2] - pp[2]);
+            pp[0] = p[0]; pp[1] = p[1]; pp[2] = p[2];
+            if (drift < opt.settle_tol) { state = 0; break; }
           }
-          label = bi;
         }
+        End &e = ends[j * W + i];
+        e.p[0] = p[0]; e.p[1] = p[1]; e.p[2] = p[2];
+        e.state = state;
       }
-      R.cell_attractor[idx] = label;
-      ++R.n_converged;
-      R.cell_speed[idx] = (float)(1.0 - (double)c.steps / (double)opt.max_steps);
+    };
+    if (nslots <= 1) {
+      for (int j = 0; j < H; ++j) do_row((size_t)j, 0);
+    } else {
+      pool::parallel_for((size_t)H, do_row);
     }
+    /* cluster serially in row-major order: labels come out in first-cell
+     * order along the slice order */
+    for (size_t c = 0; c < ends.size(); ++c) {
+      const End &e = ends[c];
+      if (e.state == 1) { slice[c] = -1; ++vol->n_diverged; continue; }
+      if (e.state == 2) { slice[c] = -2; ++vol->n_nonconvergent; continue; }
+      slice[c] = (std::int16_t)classify(e.p);
+      ++vol->n_converged;
+    }
+    labels.set_slice(k, slice.data());
+    if (on_slice && !on_slice(k)) break;
   }
-  R.ok = true; R.message = "ok";
-  return R;
+  vol->ok = true;
+  vol->message = labels.complete() ? "ok" : "partial";
+  return true;
+}
+
+namespace {
+
+/* splitmix64 of (seed, k): independent starting states for parallel chains */
+std::uint64_t rng_seed(std::uint64_t seed, std::uint64_t k) {
+  std::uint64_t z = seed + 0x9e3779b97f4a7c15ull * (k + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  return z ? z : 1;
 }
-BoxCountResult box_counting_dimension(const std::vector<double> &xs,
-                                      const std::vector<double> &ys,
-                                      int n_levels) {
-  BoxCountResult R;
-  const size_t N = std::min(xs.size(), ys.size());
-  if (N < 8) { R.message = "too few points"; return R; }
-  if (n_levels < 3) n_levels = 3;
-  if (n_levels > 24) n_levels = 24;
 
-  double xmin = xs[0], xmax = xs[0], ymin = ys[0], ymax = ys[0];
-  for (size_t i = 1; i < N; ++i) {
-    if (std::isfinite(xs[i])) { xmin = std::min(xmin, xs[i]); xmax = std::max(xmax, xs[i]); }
-    if (std::isfinite(ys[i])) { ymin = std::min(ymin, ys[i]); ymax = std::max(ymax, ys[i]); }
+/* xorshift64*, uniform in [0, 1) */
+double rng_uniform(std::uint64_t &s) {
+  s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+  return (double)((s * 0x2545f4914f6cdd1dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+}  // namespace
+
+void accumulate_buddhabrot(const std::function<BuddhaStepFn(int tid)> &make_step, const BuddhaOptions &opt,
+                           BuddhaState *st, bool parallel) {
+  const int W = std::max(2, opt.width), H = std::max(2, opt.height);
+  const size_t nchains = (size_t)std::max(1, opt.chains);
+  if (st->width != W || st->height != H || st->chains.size() != nchains ||
+      st->accum.size() != (size_t)W * H) {
+    st->accum.assign((size_t)W * H, 0);
+    st->width = W; st->height = H;
+    st->chains.assign(nchains, BuddhaState::Chain());
+    for (size_t c = 0; c < nchains; ++c) st->chains[c].rng = rng_seed(opt.seed, c);
+    st->samples = st->contributing = st->accepted = 0;
   }
-  double span = std::max(xmax - xmin, ymax - ymin);
-  if (!(span > 0.0)) { R.message = "degenerate point set (zero extent)"; return R; }
-  /* pad slightly so boundary points fall inside the coarse box */
-  span *= 1.0000001;
+  const double vx = opt.xmax - opt.xmin, vy = opt.ymax - opt.ymin;
+  if (!(vx > 0) || !(vy > 0) || opt.samples <= 0) return;
+  const double sx = (W - 1) / vx, sy = (H - 1) / vy;
+  const double R2 = opt.escape_r * opt.escape_r;
+  const int dim = std::max(2, opt.dim), maxit = std::max(1, opt.max_iter);
+  const long per_chain = (opt.samples + (long)nchains - 1) / (long)nchains;
+
+  const unsigned nslots = parallel ? pool::threads() : 1u;
+  std::vector<BuddhaStepFn> steps(nslots);
+  /* splats are binned by row band per slot and summed band by band below:
+   * integer adds, so the order they arrive in does not matter */
+  struct Hit {
+    std::uint32_t pix, w;
+  };
+  const int bands = std::min(64, H);
+  std::vector<std::vector<std::vector<Hit>>> bins(nslots, std::vector<std::vector<Hit>>((size_t)bands));
+  std::vector<long> contributing(nslots, 0), accepted(nslots, 0);
+
+  /* the orbit of 0 under c: the view pixels it visits if it escapes, and
+   * their count; 0 if it stays bounded (or the step fails) */
+  auto orbit = [&](BuddhaStepFn &step, double cre, double cim, std::vector<double> &x, std::vector<double> &xn,
+                   std::vector<std::uint32_t> *pix) -> int {
+    pix->clear();
+    std::fill(x.begin(), x.end(), 0.0);
+    for (int it = 0; it < maxit; ++it) {
+      if (!step(cre, cim, x.data(), xn.data())) return 0;
+      const double a = xn[0], b = xn[1];
+      if (a >= opt.xmin && a <= opt.xmax && b >= opt.ymin && b <= opt.ymax) {
+        const int px = std::min(W - 1, (int)((a - opt.xmin) * sx + 0.5));
+        const int py = std::min(H - 1, (int)((b - opt.ymin) * sy + 0.5));
+        pix->push_back((std::uint32_t)py * (std::uint32_t)W + (std::uint32_t)px);
+      }
+      if (!std::isfinite(a) || !std::isfinite(b) || a * a + b * b > R2) return (int)pix->size();
+      std::swap(x, xn);
+    }
+    pix->clear();
+    return 0;
+  };
+  auto splat = [&](unsigned slot, const std::vector<std::uint32_t> &pix, std::uint32_t w) {
+    std::vector<std::vector<Hit>> &b = bins[slot];
+    for (std::uint32_t p : pix) b[(size_t)(p / (std::uint32_t)W) * bands / H].push_back(Hit{p, w});
+  };
 
-  for (int level = 0; level < n_levels; ++level) {
-    const int grid = 1 << level;          /* 1, 2, 4, ... boxes per side */
-    const double eps = span / grid;
-    /* count occupied cells via a hash set of packed (ix,iy) */
-    std::unordered_set<long long> occupied;
-    occupied.reserve(N * 2);
-    for (size_t i = 0; i < N; ++i) {
-      if (!std::isfinite(xs[i]) || !std::isfinite(ys[i])) continue;
-      int ix = (int)((xs[i] - xmin) / eps);
-      int iy = (int)((ys[i] - ymin) / eps);
-      if (ix < 0) ix = 0;
-      if (ix >= grid) ix = grid - 1;
-      if (iy < 0) iy = 0;
-      if (iy >= grid) iy = grid - 1;
-      occupied.insert(((long long)ix << 32) | (unsigned int)iy);
-    }
-    const double count = (double)occupied.size();
-    if (count > 0) {
-      R.log_inv_eps.push_back(std::log(1.0 / eps));
-      R.log_count.push_back(std::log(count));
+  auto run_chain = [&](size_t c, unsigned slot) {
+    BuddhaStepFn &step = steps[slot];
+    if (!step) step = make_step((int)slot);
+    BuddhaState::Chain &ch = st->chains[c];
+    std::vector<double> x((size_t)dim), xn((size_t)dim);
+    std::vector<std::uint32_t> pix;
+    for (long s = 0; s < per_chain; ++s) {
+      double cre, cim;
+      if (!opt.importance || ch.f == 0 || rng_uniform(ch.rng) < opt.p_uniform) {
+        cre = opt.sxmin + (opt.sxmax - opt.sxmin) * rng_uniform(ch.rng);
+        cim = opt.symin + (opt.symax - opt.symin) * rng_uniform(ch.rng);
+      } else {
+        /* a symmetric jump, 5% of the view down to 0.1% (log-uniform) */
+        const double r = 0.05 * std::exp(-4.0 * rng_uniform(ch.rng));
+        cre = ch.cre + (2.0 * rng_uniform(ch.rng) - 1.0) * r * vx;
+        cim = ch.cim + (2.0 * rng_uniform(ch.rng) - 1.0) * r * vy;
+      }
+      const bool in_box = cre >= opt.sxmin && cre <= opt.sxmax && cim >= opt.symin && cim <= opt.symax;
+      const int f = in_box ? orbit(step, cre, cim, x, xn, &pix) : 0;
+      if (f > 0) ++contributing[slot];
+      if (!opt.importance) {
+        if (f > 0) splat(slot, pix, 1u << 16);
+        continue;
+      }
+      /* Metropolis-Hastings on the target f(c): both proposals are
+       * symmetric, so accept with min(1, f'/f) */
+      if (f > 0 && (ch.f == 0 || f >= ch.f || rng_uniform(ch.rng) * ch.f < f)) {
+        ch.cre = cre; ch.cim = cim; ch.f = f;
+        ch.pix.swap(pix);
+        ++accepted[slot];
+      }
+      if (ch.f > 0) splat(slot, ch.pix, std::max<std::uint32_t>(1u, (std::uint32_t)((65536.0 + 0.5 * ch.f) / ch.f)));
     }
+  };
+  if (nslots > 1) {
+    pool::parallel_for(nchains, run_chain);
+  } else {
+    for (size_t c = 0; c < nchains; ++c) run_chain(c, 0);
   }
 
+  auto merge = [&](size_t b, unsigned) {
+    for (unsigned s = 0; s < nslots; ++s)
+      for (const Hit &h : bins[s][b]) st->accum[h.pix] += h.w;
+  };
+  if (nslots > 1) {
+    pool::parallel_for((size_t)bands, merge);
+  } else {
+    for (size_t b = 0; b < (size_t)bands; ++b) merge(b, 0);
+  }
+  st->samples += per_chain * (long)nchains;
+  for (unsigned s = 0; s < nslots; ++s) {
+    st->contributing += contributing[s];
+    st->accepted += accepted[s];
+  }
+}
+
+namespace {
+
+/* Fits log N(eps) against log(1/eps) (already in R) and sets dimension,
+ * r_squared, ok and message. */
+bool fit_box_counts(BoxCountResult *R) {
   /* Least-squares slope of log N vs log(1/eps). Use the middle of the
    * range: the coarsest levels (few boxes) and the finest (each point in
    * its own box -> N saturates at #points) bias the slope, so trim a
    * couple from each end when we have enough levels. */
-  size_t lo = 0, hi = R.log_count.size();
-  if (hi >= 7) { lo = 1; hi = R.log_count.size() - 2; }
-  else if (hi >= 5) { lo = 1; hi = R.log_count.size() - 1; }
+  size_t lo = 0, hi = R->log_count.size();
+  if (hi >= 7) { lo = 1; hi = R->log_count.size() - 2; }
+  else if (hi >= 5) { lo = 1; hi = R->log_count.size() - 1; }
   const size_t m = (hi > lo) ? (hi - lo) : 0;
-  if (m < 2) { R.message = "insufficient scales for a fit"; return R; }
+  if (m < 2) { R->message = "insufficient scales for a fit"; return false; }
 
   double sx = 0, sy = 0, sxx = 0, sxy = 0;
   for (size_t i = lo; i < hi; ++i) {
-    const double X = R.log_inv_eps[i], Y = R.log_count[i];
+    const double X = R->log_inv_eps[i], Y = R->log_count[i];
     sx += X; sy += Y; sxx += X * X; sxy += X * Y;
   }
   const double denom = m * sxx - sx * sx;
-  if (std::fabs(denom) < 1e-300) { R.message = "degenerate fit"; return R; }
+  if (std::fabs(denom) < 1e-300) { R->message = "degenerate fit"; return false; }
   const double slope = (m * sxy - sx * sy) / denom;
   const double intercept = (sy - slope * sx) / m;
 
@@ -5315,13 +8281,554 @@ BoxCountResult box_counting_dimension(const std::vector<double> &xs,
   const double ymean = sy / m;
   double ss_tot = 0, ss_res = 0;
   for (size_t i = lo; i < hi; ++i) {
-    const double X = R.log_inv_eps[i], Y = R.log_count[i];
+    const double X = R->log_inv_eps[i], Y = R->log_count[i];
     const double pred = slope * X + intercept;
     ss_res += (Y - pred) * (Y - pred);
     ss_tot += (Y - ymean) * (Y - ymean);
   }
-  R.dimension = slope;
-  R.r_squared = (ss_tot > 0) ? (1.0 - ss_res / ss_tot) : 1.0;
+  R->dimension = slope;
+  R->r_squared = (ss_tot > 0) ? (1.0 - ss_res / ss_tot) : 1.0;
+  R->ok = true;
+  R->message = "ok";
+  return true;
+}
+
+
+/* ---- Morton-code box counting ------------------------------------ *
+ * Every point is quantized once on the finest grid (2^bits boxes per
+ * side) and its per-axis cell indices are bit-interleaved, most
+ * significant bit first, into one 64-bit code. Two points share a box at
+ * level l exactly when their codes agree on the top dim * l bits, so in
+ * sorted order each code that differs from its predecessor opens a new box
+ * at the level where they first differ and at every finer level. */
+struct MortonGrid {
+  int dim = 0, bits = 0;
+  std::vector<double> lo;
+  double span = 0, eps = 0;  /* cube side, finest box side */
+
+  std::uint64_t encode(const double *p) const {
+    const long top = (1L << bits) - 1;
+    std::uint32_t q[32];
+    for (int d = 0; d < dim; ++d) {
+      const long i = (long)((p[d] - lo[d]) / eps);
+      q[d] = (std::uint32_t)(i < 0 ? 0 : i > top ? top : i);
+    }
+    std::uint64_t c = 0;
+    for (int b = bits - 1; b >= 0; --b)
+      for (int d = 0; d < dim; ++d) c = (c << 1) | ((q[d] >> b) & 1u);
+    return c;
+  }
+
+  /* level (1..bits) at which b opens a new box after a, for a != b */
+  int split_level(std::uint64_t a, std::uint64_t b) const {
+    std::uint64_t v = a ^ b;
+    int h = 0;
+    if (v >> 32) { v >>= 32; h += 32; }
+    if (v >> 16) { v >>= 16; h += 16; }
+    if (v >> 8) { v >>= 8; h += 8; }
+    if (v >> 4) { v >>= 4; h += 4; }
+    if (v >> 2) { v >>= 2; h += 2; }
+    if (v >> 1) h += 1;
+    return bits - h / dim;
+  }
+};
+
+bool finite_point(const double *p, int dim) {
+  for (int d = 0; d < dim; ++d)
+    if (!std::isfinite(p[d])) return false;
+  return true;
+}
+
+/* Sets up the grid from per-axis bounds of the finite points. Levels are
+ * clamped to [3, 24] and so that dim * (levels - 1) bits fit in a code. */
+bool morton_grid(int dim, int n_levels, const std::vector<double> &mn, const std::vector<double> &mx,
+                 MortonGrid *g, BoxCountResult *R) {
+  int levels = std::max(3, std::min(n_levels, 24));
+  levels = std::min(levels, 64 / dim + 1);
+  double span = 0;
+  for (int d = 0; d < dim; ++d) span = std::max(span, mx[d] - mn[d]);
+  if (!(span > 0.0)) { R->message = "degenerate point set (zero extent)"; return false; }
+  /* pad slightly so boundary points fall inside the coarse box */
+  span *= 1.0000001;
+  g->dim = dim;
+  g->bits = levels - 1;
+  g->lo = mn;
+  g->span = span;
+  g->eps = span / (double)(1L << g->bits);
+  return true;
+}
+
+/* first item of chunk c when n items are split into nchunks near-equal chunks */
+inline size_t chunk_edge(size_t n, size_t nchunks, size_t c) { return n / nchunks * c + std::min(c, n % nchunks); }
+
+size_t chunks_for(size_t n) {
+  return std::max<size_t>(1, std::min<size_t>(n / 16384 + 1, 4 * (size_t)pool::threads()));
+}
+
+/* Codes of point(i, p) for i in [0, n), chunked on the pool. Points with
+ * a non-finite coordinate get `fill`, the code of a finite point, which
+ * adds no box. */
+template <class Point>
+void encode_points(const MortonGrid &g, size_t n, const Point &point, std::uint64_t fill,
+                   std::vector<std::uint64_t> *codes) {
+  codes->resize(n);
+  const size_t nchunks = chunks_for(n);
+  pool::parallel_for(nchunks, [&](size_t c, unsigned) {
+    double p[32];
+    for (size_t i = chunk_edge(n, nchunks, c), e = chunk_edge(n, nchunks, c + 1); i < e; ++i) {
+      point(i, p);
+      (*codes)[i] = finite_point(p, g.dim) ? g.encode(p) : fill;
+    }
+  });
+}
+
+/* LSD radix sort on the low `nbits` bits, one byte per pass. Each chunk
+ * histograms and then scatters its own range on the pool; offsets run in
+ * (digit, chunk) order, so the sort is stable and the result does not
+ * depend on the thread count. */
+void radix_sort_codes(std::vector<std::uint64_t> *a, int nbits) {
+  const size_t n = a->size();
+  if (n < 65536) { std::sort(a->begin(), a->end()); return; }
+  std::vector<std::uint64_t> tmp(n);
+  const size_t nchunks = chunks_for(n);
+  std::vector<std::array<size_t, 256>> hist(nchunks);
+  for (int shift = 0; shift < nbits; shift += 8) {
+    const std::uint64_t *src = a->data();
+    std::uint64_t *dst = tmp.data();
+    pool::parallel_for(nchunks, [&](size_t c, unsigned) {
+      hist[c].fill(0);
+      for (size_t i = chunk_edge(n, nchunks, c), e = chunk_edge(n, nchunks, c + 1); i < e; ++i)
+        ++hist[c][(src[i] >> shift) & 255];
+    });
+    size_t off = 0;
+    for (int d = 0; d < 256; ++d)
+      for (size_t c = 0; c < nchunks; ++c) {
+        const size_t h = hist[c][d];
+        hist[c][d] = off;
+        off += h;
+      }
+    pool::parallel_for(nchunks, [&](size_t c, unsigned) {
+      std::array<size_t, 256> &o = hist[c];
+      for (size_t i = chunk_edge(n, nchunks, c), e = chunk_edge(n, nchunks, c + 1); i < e; ++i)
+        dst[o[(src[i] >> shift) & 255]++] = src[i];
+    });
+    a->swap(tmp);
+  }
+}
+
+/* opened[l] += number of sorted neighbours opening a new box at level l */
+void tally_sorted_codes(const MortonGrid &g, const std::vector<std::uint64_t> &codes, std::vector<long> *opened) {
+  const size_t n = codes.size();
+  const size_t nchunks = chunks_for(n);
+  std::vector<std::vector<long>> part(nchunks, std::vector<long>(g.bits + 1, 0));
+  pool::parallel_for(nchunks, [&](size_t c, unsigned) {
+    std::vector<long> &o = part[c];
+    for (size_t i = std::max<size_t>(1, chunk_edge(n, nchunks, c)), e = chunk_edge(n, nchunks, c + 1); i < e; ++i)
+      if (codes[i] != codes[i - 1]) ++o[g.split_level(codes[i - 1], codes[i])];
+  });
+  for (const std::vector<long> &o : part)
+    for (int l = 0; l <= g.bits; ++l) (*opened)[l] += o[l];
+}
+
+/* N(l) = 1 + boxes opened at level l or coarser, for l = 0..bits */
+void finish_box_counts(const MortonGrid &g, const std::vector<long> &opened, BoxCountResult *R) {
+  long count = 1;
+  for (int l = 0; l <= g.bits; ++l) {
+    count += opened[l];
+    const double eps = g.span / (double)(1L << l);
+    R->log_inv_eps.push_back(std::log(1.0 / eps));
+    R->log_count.push_back(std::log((double)count));
+  }
+  fit_box_counts(R);
+}
+
+/* In-memory box count of n points given by point(i, p), dim coordinates each. */
+template <class Point>
+BoxCountResult box_count_points(size_t n, int dim, int n_levels, const Point &point) {
+  BoxCountResult R;
+  if (dim < 1 || dim > 32) { R.message = "dimension must be 1..32"; return R; }
+  std::vector<double> mn(dim, HUGE_VAL), mx(dim, -HUGE_VAL), first(dim);
+  size_t valid = 0;
+  double p[32];
+  for (size_t i = 0; i < n; ++i) {
+    point(i, p);
+    if (!finite_point(p, dim)) continue;
+    if (valid++ == 0) first.assign(p, p + dim);
+    for (int d = 0; d < dim; ++d) { mn[d] = std::min(mn[d], p[d]); mx[d] = std::max(mx[d], p[d]); }
+  }
+  if (valid < 8) { R.message = "too few points"; return R; }
+  MortonGrid g;
+  if (!morton_grid(dim, n_levels, mn, mx, &g, &R)) return R;
+
+  std::vector<std::uint64_t> codes;
+  encode_points(g, n, point, g.encode(first.data()), &codes);
+  radix_sort_codes(&codes, dim * g.bits);
+  std::vector<long> opened(g.bits + 1, 0);
+  tally_sorted_codes(g, codes, &opened);
+  finish_box_counts(g, opened, &R);
+  return R;
+}
+
+struct FileCloser {
+  void operator()(std::FILE *f) const { if (f) std::fclose(f); }
+};
+using FilePtr = std::unique_ptr<std::FILE, FileCloser>;
+
+/* one sorted run of unique codes on a temporary file, read back in blocks */
+struct CodeRun {
+  FilePtr file;
+  std::vector<std::uint64_t> buf;
+  size_t pos = 0, len = 0;
+
+  bool next(std::uint64_t *c) {
+    if (pos == len) {
+      len = std::fread(buf.data(), sizeof(std::uint64_t), buf.size(), file.get());
+      pos = 0;
+      if (len == 0) return false;
+    }
+    *c = buf[pos++];
+    return true;
+  }
+};
+
+}  // namespace
+
+BoxCountResult box_counting_dimension(const std::vector<double> &xs,
+                                      const std::vector<double> &ys,
+                                      int n_levels) {
+  const size_t N = std::min(xs.size(), ys.size());
+  return box_count_points(N, 2, n_levels, [&](size_t i, double *p) {
+    p[0] = xs[i];
+    p[1] = ys[i];
+  });
+}
+
+BoxCountResult box_counting_dimension_nd(const std::vector<double> &points, int dim, int n_levels) {
+  if (dim < 1) {
+    BoxCountResult R;
+    R.message = "dimension must be 1..32";
+    return R;
+  }
+  return box_count_points(points.size() / (size_t)dim, dim, n_levels,
+                          [&](size_t i, double *p) { std::copy_n(&points[i * (size_t)dim], dim, p); });
+}
+
+BoxCountResult box_counting_dimension_file(const char *path, int dim, int n_levels, std::size_t chunk_points) {
+  BoxCountResult R;
+  if (dim < 1 || dim > 32) { R.message = "dimension must be 1..32"; return R; }
+  FilePtr in(std::fopen(path, "rb"));
+  if (!in) { R.message = "cannot open point file"; return R; }
+  chunk_points = std::max<size_t>(chunk_points, 64);
+  std::vector<double> buf(chunk_points * (size_t)dim);
+  auto read_chunk = [&]() { return std::fread(buf.data(), sizeof(double) * (size_t)dim, chunk_points, in.get()); };
+  auto point = [&](size_t i, double *p) { std::copy_n(&buf[i * (size_t)dim], dim, p); };
+
+  /* pass 1: bounds of the finite points */
+  std::vector<double> mn(dim, HUGE_VAL), mx(dim, -HUGE_VAL), first(dim);
+  size_t valid = 0;
+  for (size_t n; (n = read_chunk()) > 0;) {
+    for (size_t i = 0; i < n; ++i) {
+      const double *p = &buf[i * (size_t)dim];
+      if (!finite_point(p, dim)) continue;
+      if (valid++ == 0) first.assign(p, p + dim);
+      for (int d = 0; d < dim; ++d) { mn[d] = std::min(mn[d], p[d]); mx[d] = std::max(mx[d], p[d]); }
+    }
+  }
+  if (std::ferror(in.get())) { R.message = "cannot read point file"; return R; }
+  if (valid < 8) { R.message = "too few points"; return R; }
+  MortonGrid g;
+  if (!morton_grid(dim, n_levels, mn, mx, &g, &R)) return R;
+  const std::uint64_t fill = g.encode(first.data());
+
+  /* pass 2: sorted unique runs; a file that fits in one chunk is counted
+   * in memory */
+  std::rewind(in.get());
+  std::vector<long> opened(g.bits + 1, 0);
+  std::vector<CodeRun> runs;
+  std::vector<std::uint64_t> codes;
+  for (size_t n; (n = read_chunk()) > 0;) {
+    encode_points(g, n, point, fill, &codes);
+    radix_sort_codes(&codes, dim * g.bits);
+    codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+    if (runs.empty() && n < chunk_points) break;  /* the whole file: no runs */
+    CodeRun run;
+    run.file.reset(std::tmpfile());
+    if (!run.file || std::fwrite(codes.data(), sizeof(std::uint64_t), codes.size(), run.file.get()) != codes.size()) {
+      R.message = "cannot write temporary sort run";
+      return R;
+    }
+    runs.push_back(std::move(run));
+    codes.clear();
+  }
+  if (std::ferror(in.get())) { R.message = "cannot read point file"; return R; }
+  in.reset();
+
+  if (runs.empty()) {
+    tally_sorted_codes(g, codes, &opened);
+  } else {
+    /* k-way merge, splitting about one chunk of buffer between the runs */
+    const size_t block = std::max<size_t>(1024, chunk_points * (size_t)dim / runs.size());
+    using Head = std::pair<std::uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+    for (size_t r = 0; r < runs.size(); ++r) {
+      std::rewind(runs[r].file.get());
+      runs[r].buf.resize(block);
+      std::uint64_t c;
+      if (runs[r].next(&c)) heap.push({c, r});
+    }
+    bool have_prev = false;
+    std::uint64_t prev = 0;
+    while (!heap.empty()) {
+      const Head h = heap.top();
+      heap.pop();
+      if (have_prev && h.first != prev) ++opened[g.split_level(prev, h.first)];
+      prev = h.first;
+      have_prev = true;
+      std::uint64_t c;
+      if (runs[h.second].next(&c)) heap.push({c, h.second});
+    }
+  }
+  finish_box_counts(g, opened, &R);
+  return R;
+}
+
+namespace {
+
+/* k-d tree over the finite points of a trajectory, for counting pairs by
+ * distance. Leaves hold up to 16 points; every node keeps its bounding box
+ * and the points below it are contiguous in `pts`. */
+struct KdTree {
+  struct Node {
+    size_t begin = 0, end = 0;
+    int left = -1, right = -1;
+  };
+  int dim = 0;
+  std::vector<double> pts;   /* coordinates in tree order */
+  std::vector<size_t> index; /* trajectory index of each point in tree order */
+  std::vector<double> box;   /* per node: lo[dim] then hi[dim] */
+  std::vector<Node> nodes;
+
+  void build(const std::vector<double> &points, int d, const std::vector<size_t> &which) {
+    dim = d;
+    std::vector<size_t> perm = which;
+    nodes.clear();
+    box.clear();
+    nodes.reserve(2 * (perm.size() / 8 + 1));
+    split(points, perm, 0, perm.size());
+    pts.resize(perm.size() * (size_t)dim);
+    for (size_t k = 0; k < perm.size(); ++k)
+      std::copy_n(&points[perm[k] * (size_t)dim], dim, &pts[k * (size_t)dim]);
+    index.swap(perm);
+  }
+
+  int split(const std::vector<double> &points, std::vector<size_t> &perm, size_t b, size_t e) {
+    const int id = (int)nodes.size();
+    nodes.push_back({b, e, -1, -1});
+    box.resize(box.size() + 2 * (size_t)dim);
+    double *lo = &box[(size_t)id * 2 * dim], *hi = lo + dim;
+    std::fill(lo, hi, HUGE_VAL);
+    std::fill(hi, hi + dim, -HUGE_VAL);
+    for (size_t k = b; k < e; ++k)
+      for (int a = 0; a < dim; ++a) {
+        const double v = points[perm[k] * (size_t)dim + a];
+        lo[a] = std::min(lo[a], v);
+        hi[a] = std::max(hi[a], v);
+      }
+    if (e - b <= 16) return id;
+    int axis = 0;
+    for (int a = 1; a < dim; ++a)
+      if (hi[a] - lo[a] > hi[axis] - lo[axis]) axis = a;
+    if (!(hi[axis] > lo[axis])) return id;  /* all points coincide */
+    const size_t mid = b + (e - b) / 2;
+    std::nth_element(perm.begin() + (long)b, perm.begin() + (long)mid, perm.begin() + (long)e,
+                     [&](size_t u, size_t v) { return points[u * (size_t)dim + axis] < points[v * (size_t)dim + axis]; });
+    const int l = split(points, perm, b, mid);
+    const int r = split(points, perm, mid, e);
+    nodes[id].left = l;
+    nodes[id].right = r;
+    return id;
+  }
+
+  /* hist[k] += points at squared distance in [r2[k-1], r2[k]) from x, for
+   * k < K (r2[-1] = 0); farther points are not counted. A node whose
+   * nearest and farthest corners land in the same shell is added whole.
+   * Shells are found by stepping out from the parent's nearest shell: a
+   * child is never nearer than its parent, and a leaf spans few shells. */
+  void count_shells(const double *x, const std::vector<double> &r2, long *hist, int id = 0,
+                    size_t shell = 0) const {
+    const double *lo = &box[(size_t)id * 2 * dim], *hi = lo + dim;
+    double dmin = 0, dmax = 0;
+    for (int a = 0; a < dim; ++a) {
+      const double below = lo[a] - x[a], above = x[a] - hi[a];
+      const double gap = below > 0 ? below : above > 0 ? above : 0.0;
+      const double far = std::max(x[a] - lo[a], hi[a] - x[a]);
+      dmin += gap * gap;
+      dmax += far * far;
+    }
+    const size_t K = r2.size();
+    while (shell < K && r2[shell] <= dmin) ++shell;
+    if (shell == K) return;
+    if (dmax < r2[shell]) {
+      hist[shell] += (long)(nodes[id].end - nodes[id].begin);
+      return;
+    }
+    const Node &nd = nodes[id];
+    if (nd.left < 0) {
+      for (size_t k = nd.begin; k < nd.end; ++k) {
+        const double *p = &pts[k * (size_t)dim];
+        double d2 = 0;
+        for (int a = 0; a < dim; ++a) d2 += (p[a] - x[a]) * (p[a] - x[a]);
+        size_t s = shell;
+        while (s < K && r2[s] <= d2) ++s;
+        if (s < K) ++hist[s];
+      }
+      return;
+    }
+    count_shells(x, r2, hist, nd.left, shell);
+    count_shells(x, r2, hist, nd.right, shell);
+  }
+};
+
+/* least-squares slope of y against x over [first, last], finite y only */
+bool fit_slope(const std::vector<double> &x, const std::vector<double> &y, int first, int last, double *slope,
+               double *r2) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+  int m = 0;
+  for (int k = first; k <= last; ++k) {
+    if (!std::isfinite(y[k])) continue;
+    sx += x[k]; sy += y[k]; sxx += x[k] * x[k]; sxy += x[k] * y[k]; syy += y[k] * y[k];
+    ++m;
+  }
+  if (m < 3) return false;
+  const double vx = m * sxx - sx * sx, vy = m * syy - sy * sy, cxy = m * sxy - sx * sy;
+  if (!(vx > 0)) return false;
+  *slope = cxy / vx;
+  *r2 = vy > 0 ? cxy * cxy / (vx * vy) : 1.0;
+  return true;
+}
+
+}  // namespace
+
+DimensionSpectrum correlation_dimensions(const std::vector<double> &points, int dim,
+                                         const DimensionSpectrumOptions &opt) {
+  DimensionSpectrum R;
+  R.qs = opt.qs;
+  if (dim < 1) { R.message = "dimension must be positive"; return R; }
+  const size_t n = points.size() / (size_t)dim;
+  auto finite_at = [&](size_t i) { return finite_point(&points[i * (size_t)dim], dim); };
+  std::vector<size_t> valid;
+  valid.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    if (finite_at(i)) valid.push_back(i);
+  const long w = std::max(0, opt.theiler);
+  if ((long)valid.size() < 4 * w + 100) { R.message = "too few points"; return R; }
+  R.points = (long)valid.size();
+
+  double extent = 0;
+  for (int a = 0; a < dim; ++a) {
+    double lo = HUGE_VAL, hi = -HUGE_VAL;
+    for (size_t i : valid) {
+      lo = std::min(lo, points[i * (size_t)dim + a]);
+      hi = std::max(hi, points[i * (size_t)dim + a]);
+    }
+    extent = std::max(extent, hi - lo);
+  }
+  if (!(extent > 0.0)) { R.message = "degenerate point set (zero extent)"; return R; }
+  if (!(opt.r_min > 0.0) || !(opt.r_max > opt.r_min)) { R.message = "need 0 < r_min < r_max"; return R; }
+
+  const int K = std::max(4, std::min(opt.n_radii, 64));
+  std::vector<double> r2(K);
+  R.log_r.resize(K);
+  for (int k = 0; k < K; ++k) {
+    const double r = extent * opt.r_min * std::pow(opt.r_max / opt.r_min, (double)k / (K - 1));
+    r2[k] = r * r;
+    R.log_r[k] = std::log(r);
+  }
+
+  KdTree tree;
+  tree.build(points, dim, valid);
+
+  const size_t M = (opt.max_centres <= 0 || valid.size() <= (size_t)opt.max_centres) ? valid.size()
+                                                                                        : (size_t)opt.max_centres;
+  R.centres = (long)M;
+  /* p[m * K + k] = p_i(r_k) for centre m. Centres are taken evenly in
+   * tree order, so consecutive ones are spatial neighbours and walk the
+   * same nodes while they are still in cache. */
+  std::vector<double> p(M * (size_t)K);
+  pool::parallel_for(M, [&](size_t m, unsigned) {
+    const size_t at = (size_t)((double)m * valid.size() / M);
+    const size_t i = tree.index[at];
+    const double *x = &tree.pts[at * (size_t)dim];
+    std::vector<long> hist(K + 1, 0);
+    tree.count_shells(x, r2, hist.data());
+    /* the tree counted the centre and its Theiler window too: take them out */
+    long excluded = 0;
+    const size_t jb = i > (size_t)w ? i - (size_t)w : 0, je = std::min(n, i + (size_t)w + 1);
+    for (size_t j = jb; j < je; ++j) {
+      if (!finite_at(j)) continue;
+      ++excluded;
+      double d2 = 0;
+      for (int a = 0; a < dim; ++a) {
+        const double d = points[j * (size_t)dim + a] - x[a];
+        d2 += d * d;
+      }
+      if (d2 < r2[K - 1]) --hist[std::upper_bound(r2.begin(), r2.end(), d2) - r2.begin()];
+    }
+    const double others = (double)valid.size() - (double)excluded;
+    long within = 0;
+    for (int k = 0; k < K; ++k) {
+      within += hist[k];
+      p[m * K + k] = (double)within / others;
+    }
+  });
+
+  /* fit where the mean neighbour count is large enough to be reliable */
+  const double others = (double)valid.size() - (2.0 * w + 1.0);
+  R.log_correlation.assign(K, NAN);
+  R.fit_first = K;
+  for (int k = 0; k < K; ++k) {
+    double mean = 0;
+    for (size_t m = 0; m < M; ++m) mean += p[m * K + k];
+    mean /= (double)M;
+    R.log_correlation[k] = mean > 0 ? std::log(mean) : NAN;
+    if (R.fit_first == K && mean * others >= opt.min_neighbours) R.fit_first = k;
+  }
+  R.fit_last = K - 1;
+  if (R.fit_last - R.fit_first < 2) {
+    R.message = "too few neighbours at every radius (longer trajectory or larger r_max)";
+    return R;
+  }
+  if (!fit_slope(R.log_r, R.log_correlation, R.fit_first, R.fit_last, &R.correlation_dimension,
+                 &R.correlation_r_squared)) {
+    R.message = "degenerate fit";
+    return R;
+  }
+
+  /* C_q: a centre with no neighbour at r leaves C_q(r) undefined for q <= 1 */
+  R.dq.assign(R.qs.size(), NAN);
+  R.log_cq.assign(R.qs.size(), std::vector<double>(K, NAN));
+  for (size_t iq = 0; iq < R.qs.size(); ++iq) {
+    const double q = R.qs[iq];
+    const bool shannon = std::fabs(q - 1.0) < 1e-12;
+    for (int k = 0; k < K; ++k) {
+      double acc = 0;
+      bool defined = true;
+      for (size_t m = 0; m < M && defined; ++m) {
+        const double pk = p[m * K + k];
+        if (pk <= 0) {
+          if (q <= 1.0) defined = false;
+          continue;
+        }
+        acc += shannon ? std::log(pk) : std::pow(pk, q - 1.0);
+      }
+      if (!defined) continue;
+      acc /= (double)M;
+      if (shannon) R.log_cq[iq][k] = acc;
+      else if (acc > 0) R.log_cq[iq][k] = std::log(acc) / (q - 1.0);
+    }
+    double slope, r2q;
+    if (fit_slope(R.log_r, R.log_cq[iq], R.fit_first, R.fit_last, &slope, &r2q)) R.dq[iq] = slope;
+  }
   R.ok = true;
   R.message = "ok";
   return R;
@@ -5380,6 +8887,359 @@ IFSResult chaos_game(const std::vector<AffineMap> &maps, long iterations,
   return R;
 }
 
+IFSDensity chaos_game_stream(const std::vector<AffineMap> &maps, const IFSStreamOptions &opt, bool parallel) {
+  IFSDensity R;
+  if (maps.empty()) { R.message = "no maps"; return R; }
+  std::vector<double> cum(maps.size());
+  double sum = 0.0;
+  for (size_t i = 0; i < maps.size(); ++i) { sum += std::max(0.0, maps[i].p); cum[i] = sum; }
+  const bool uniform = !(sum > 1e-12);
+  auto pick = [&](std::uint64_t &rng) -> const AffineMap & {
+    if (uniform) return maps[std::min(maps.size() - 1, (size_t)(rng_uniform(rng) * maps.size()))];
+    const double r = rng_uniform(rng) * sum;
+    size_t k = 0;
+    while (k + 1 < maps.size() && r > cum[k]) ++k;
+    return maps[k];
+  };
+  const long burn = 50;
+
+  /* pilot: the bounding box everything else is laid out in */
+  {
+    std::uint64_t rng = rng_seed(opt.seed, ~0ull);
+    double x = 0, y = 0;
+    double xmin = 1e300, xmax = -1e300, ymin = 1e300, ymax = -1e300;
+    const long n = std::max(100L, opt.pilot);
+    for (long it = 0; it < burn + n; ++it) {
+      const AffineMap &m = pick(rng);
+      const double nx = m.a * x + m.b * y + m.e, ny = m.c * x + m.d * y + m.f;
+      x = nx; y = ny;
+      if (!std::isfinite(x) || !std::isfinite(y)) { x = 0; y = 0; continue; }
+      if (it < burn) continue;
+      xmin = std::min(xmin, x); xmax = std::max(xmax, x);
+      ymin = std::min(ymin, y); ymax = std::max(ymax, y);
+    }
+    if (!(xmin <= xmax)) { R.message = "no points"; return R; }
+    R.xmin = xmin; R.xmax = xmax; R.ymin = ymin; R.ymax = ymax;
+  }
+  const int W = std::max(2, opt.width), H = std::max(2, opt.height);
+  R.width = W; R.height = H;
+  {
+    const double spanx = std::max(1e-9, R.xmax - R.xmin), spany = std::max(1e-9, R.ymax - R.ymin);
+    R.scale = std::min(W * (1 - 2 * opt.margin) / spanx, H * (1 - 2 * opt.margin) / spany);
+    R.x0 = 0.5 * (R.xmin + R.xmax) - 0.5 * W / R.scale;
+    R.y0 = 0.5 * (R.ymin + R.ymax) - 0.5 * H / R.scale;
+  }
+  /* the box-counting square, as box_counting_dimension lays it out */
+  const int L = std::max(3, std::min(opt.box_levels, 14));
+  const std::uint32_t G = 1u << (L - 1);
+  const double span = std::max(R.xmax - R.xmin, R.ymax - R.ymin) * 1.0000001;
+  const double beps = span > 0 ? G / span : 0.0;
+  const size_t words = ((size_t)G * G + 63) / 64;
+
+  const size_t nstreams = (size_t)std::max(1, opt.streams);
+  const unsigned nslots = parallel ? pool::threads() : 1u;
+  struct Slot {
+    std::vector<std::uint32_t> dens;
+    std::vector<std::uint64_t> bits;
+    long outside = 0;
+  };
+  std::vector<Slot> slots(nslots);
+  struct Stream {
+    std::uint64_t rng;
+    double x = 0, y = 0;
+    long left = 0;
+    bool burnt = false;
+  };
+  std::vector<Stream> streams(nstreams);
+  const long total = std::max(0L, opt.iterations);
+  for (size_t s = 0; s < nstreams; ++s) {
+    streams[s].rng = rng_seed(opt.seed, s);
+    streams[s].left = total / (long)nstreams + ((long)s < total % (long)nstreams ? 1 : 0);
+  }
+  R.density.assign((size_t)W * H, 0);
+
+  /* rounds keep a slot's 32-bit counts from overflowing: at most 2^31
+   * points between merges into the 64-bit density */
+  const long round_len = std::max(1L, (1L << 31) / (long)nstreams);
+  auto run_stream = [&](size_t s, unsigned slot) {
+    Stream &st = streams[s];
+    Slot &sl = slots[slot];
+    if (sl.dens.empty()) sl.dens.assign((size_t)W * H, 0);
+    if (sl.bits.empty()) sl.bits.assign(words, 0);
+    for (long it = st.burnt ? burn : 0; it < burn; ++it) {
+      const AffineMap &m = pick(st.rng);
+      const double nx = m.a * st.x + m.b * st.y + m.e, ny = m.c * st.x + m.d * st.y + m.f;
+      st.x = std::isfinite(nx) ? nx : 0.0; st.y = std::isfinite(ny) ? ny : 0.0;
+    }
+    st.burnt = true;
+    const long n = std::min(st.left, round_len);
+    st.left -= n;
+    for (long it = 0; it < n; ++it) {
+      const AffineMap &m = pick(st.rng);
+      const double nx = m.a * st.x + m.b * st.y + m.e, ny = m.c * st.x + m.d * st.y + m.f;
+      st.x = nx; st.y = ny;
+      if (!std::isfinite(st.x) || !std::isfinite(st.y)) { st.x = 0; st.y = 0; continue; }
+      const double fx = (st.x - R.x0) * R.scale, fy = (st.y - R.y0) * R.scale;
+      if (fx >= 0 && fx < W && fy >= 0 && fy < H)
+        ++sl.dens[(size_t)fy * W + (size_t)fx];
+      else
+        ++sl.outside;
+      if (beps > 0) {
+        const std::uint32_t ix = (std::uint32_t)std::max(0.0, std::min((double)G - 1, (st.x - R.xmin) * beps));
+        const std::uint32_t iy = (std::uint32_t)std::max(0.0, std::min((double)G - 1, (st.y - R.ymin) * beps));
+        const size_t b = (size_t)iy * G + ix;
+        sl.bits[b >> 6] |= 1ull << (b & 63);
+      }
+    }
+  };
+  const int bands = std::min(64, H);
+  auto merge_band = [&](size_t band, unsigned) {
+    const size_t r0 = band * (size_t)H / bands, r1 = (band + 1) * (size_t)H / bands;
+    for (Slot &sl : slots) {
+      if (sl.dens.empty()) continue;
+      for (size_t p = r0 * W; p < r1 * W; ++p) { R.density[p] += sl.dens[p]; sl.dens[p] = 0; }
+    }
+  };
+  for (bool more = total > 0; more;) {
+    if (nslots > 1) {
+      pool::parallel_for(nstreams, run_stream);
+      pool::parallel_for((size_t)bands, merge_band);
+    } else {
+      for (size_t s = 0; s < nstreams; ++s) run_stream(s, 0);
+      for (size_t b = 0; b < (size_t)bands; ++b) merge_band(b, 0);
+    }
+    more = false;
+    for (const Stream &st : streams) more = more || st.left > 0;
+  }
+  R.points = total;
+  for (const Slot &sl : slots) R.outside += sl.outside;
+  for (std::uint64_t v : R.density) R.max_density = std::max(R.max_density, v);
+
+  /* box counts: OR the slots' finest bitmaps, then halve level by level */
+  if (beps > 0) {
+    std::vector<std::uint64_t> occ(words, 0);
+    for (const Slot &sl : slots)
+      for (size_t w = 0; w < sl.bits.size(); ++w) occ[w] |= sl.bits[w];
+    std::vector<double> counts((size_t)L);
+    for (int level = L - 1; level >= 0; --level) {
+      const std::uint32_t g = 1u << level;
+      const size_t nw = ((size_t)g * g + 63) / 64;
+      long c = 0;
+      for (size_t w = 0; w < nw; ++w) c += (long)std::bitset<64>(occ[w]).count();
+      counts[(size_t)level] = (double)c;
+      if (level == 0) break;
+      const std::uint32_t h = g / 2;
+      std::vector<std::uint64_t> up(((size_t)h * h + 63) / 64, 0);
+      for (std::uint32_t y = 0; y < g; ++y)
+        for (std::uint32_t x = 0; x < g; ++x) {
+          const size_t b = (size_t)y * g + x;
+          if (occ[b >> 6] >> (b & 63) & 1) {
+            const size_t u = (size_t)(y / 2) * h + x / 2;
+            up[u >> 6] |= 1ull << (u & 63);
+          }
+        }
+      occ.swap(up);
+    }
+    for (int level = 0; level < L; ++level) {
+      if (counts[(size_t)level] <= 0) continue;
+      R.box.log_inv_eps.push_back(std::log((double)(1u << level) / span));
+      R.box.log_count.push_back(std::log(counts[(size_t)level]));
+    }
+    fit_box_counts(&R.box);
+  } else {
+    R.box.message = "degenerate point set (zero extent)";
+  }
+  R.ok = true;
+  R.message = "ok";
+  return R;
+}
+
+/* ---- FFT ------------------------------------------------------- */
+namespace {
+
+/* exp(-2 pi i k / n) for k < n / 2. A table for n serves every
+ * power-of-two transform up to n. Entries are the product of a coarse
+ * angle (every 64th, from cos/sin) and a fine one (the first 64), so each
+ * costs one complex multiply instead of a cos/sin pair and carries no
+ * recurrence error. */
+struct Twiddles {
+  size_t n;
+  std::vector<double> re, im;
+  explicit Twiddles(size_t size) : n(size), re(size / 2), im(size / 2) {
+    const size_t fine = std::min<size_t>(64, size / 2);
+    std::vector<double> fr(fine), fi(fine);
+    for (size_t k = 0; k < fine; ++k) {
+      const double th = 2.0 * M_PI * (double)k / (double)size;
+      fr[k] = std::cos(th);
+      fi[k] = -std::sin(th);
+    }
+    for (size_t hi = 0; hi < size / 2; hi += fine) {
+      const double th = 2.0 * M_PI * (double)hi / (double)size;
+      const double cr = std::cos(th), ci = -std::sin(th);
+      for (size_t k = 0; k < fine; ++k) {
+        re[hi + k] = cr * fr[k] - ci * fi[k];
+        im[hi + k] = cr * fi[k] + ci * fr[k];
+      }
+    }
+  }
+};
+
+/* In-place iterative radix-2 FFT; a.size() must be a power of two no
+ * larger than w.n. Butterflies multiply by hand: std::complex's operator*
+ * goes through the C99 Annex G NaN/inf fixups (__muldc3) unless
+ * -ffast-math is on, which costs more than the transform. The inverse is
+ * unscaled. */
+void fft_inplace(std::vector<Complex> &a, const Twiddles &w, bool inverse) {
+  const size_t n = a.size();
+  if (n < 2) return;
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  const double sign = inverse ? -1.0 : 1.0;
+  double *d = reinterpret_cast<double *>(a.data());  /* [re, im] pairs */
+  for (size_t len = 2; len <= n; len <<= 1) {
+    const size_t half = len / 2, stride = w.n / len;
+    for (size_t i = 0; i < n; i += len)
+      for (size_t k = 0; k < half; ++k) {
+        double *u = d + 2 * (i + k), *v = d + 2 * (i + k + half);
+        const double c = w.re[k * stride], s = sign * w.im[k * stride];
+        const double tr = v[0] * c - v[1] * s, ti = v[0] * s + v[1] * c;
+        v[0] = u[0] - tr;
+        v[1] = u[1] - ti;
+        u[0] += tr;
+        u[1] += ti;
+      }
+  }
+}
+
+size_t next_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+/* raw lag sums s[lag] = sum_i c_i c_(i+lag), lag = 0..max_lag < c.size().
+ * The zero-padded signal (length M) is real and so is its power spectrum,
+ * so both transforms run at half length: the signal is packed as
+ * z[k] = c[2k] + i c[2k+1] and unpacked after the transform, and the even
+ * spectrum is packed back the same way for the inverse. */
+std::vector<double> lag_sums(const std::vector<double> &c, size_t max_lag) {
+  const size_t n = c.size();
+  const size_t M = std::max<size_t>(4, next_pow2(n + max_lag + 1)), H = M / 2;
+  const Twiddles w(M);
+  std::vector<Complex> z(H);
+  double *d = reinterpret_cast<double *>(z.data());
+  std::copy(c.begin(), c.end(), d);
+  fft_inplace(z, w, false);
+
+  /* X[k] = E[k] + exp(-2 pi i k / M) O[k], with E, O the transforms of the
+   * even and odd samples recovered from Z[k] and conj(Z[H - k]) */
+  std::vector<double> P(H + 1);
+  for (size_t k = 0; k <= H; ++k) {
+    const double a = d[2 * (k % H)], b = d[2 * (k % H) + 1];
+    const double cc = d[2 * ((H - k) % H)], dd = d[2 * ((H - k) % H) + 1];
+    const double er = 0.5 * (a + cc), ei = 0.5 * (b - dd);
+    const double orr = 0.5 * (b + dd), oi = -0.5 * (a - cc);
+    const double wr = k < H ? w.re[k] : -1.0, wi = k < H ? w.im[k] : 0.0;
+    const double xr = er + wr * orr - wi * oi, xi = ei + wr * oi + wi * orr;
+    P[k] = xr * xr + xi * xi;
+  }
+  /* inverse: Z[k] = (P[k] + P[k+H]) + i (P[k] - P[k+H]) exp(2 pi i k / M),
+   * and P[k + H] = P[H - k] since the spectrum is even */
+  for (size_t k = 0; k < H; ++k) {
+    const double e = P[k] + P[H - k], o = P[k] - P[H - k];
+    d[2 * k] = e + o * w.im[k];
+    d[2 * k + 1] = o * w.re[k];
+  }
+  fft_inplace(z, w, true);
+  std::vector<double> s(max_lag + 1);
+  const double scale = 1.0 / (double)M;
+  for (size_t k = 0; k <= max_lag; ++k) s[k] = d[k] * scale;
+  return s;
+}
+
+}  // namespace
+
+std::vector<double> autocorrelation(const std::vector<double> &y, std::size_t max_lag) {
+  const size_t n = y.size();
+  if (n < 2) return {};
+  double mean = 0.0;
+  for (double v : y) {
+    if (!std::isfinite(v)) return {};
+    mean += v;
+  }
+  mean /= (double)n;
+  std::vector<double> c(y);
+  double c0 = 0.0;
+  for (double &v : c) { v -= mean; c0 += v * v; }
+  if (!(c0 > 0)) return {};
+  std::vector<double> r = lag_sums(c, std::min(max_lag, n - 1));
+  for (double &v : r) v /= c0;
+  return r;
+}
+
+PowerSpectrum power_spectrum(const std::vector<double> &y, double dt, std::size_t segment) {
+  PowerSpectrum R;
+  const size_t n = y.size();
+  if (!(dt > 0)) { R.message = "sample spacing must be positive"; return R; }
+  for (double v : y)
+    if (!std::isfinite(v)) { R.message = "non-finite signal"; return R; }
+  if (segment == 0) {
+    segment = 64;
+    while (segment * 2 <= n / 4) segment *= 2;
+  }
+  if ((segment & (segment - 1)) != 0 || segment < 8) { R.message = "segment must be a power of two >= 8"; return R; }
+  if (n < segment) { R.message = "signal too short"; return R; }
+
+  /* Hann window; U normalizes the periodogram to a density */
+  std::vector<double> win(segment);
+  double U = 0.0;
+  for (size_t i = 0; i < segment; ++i) {
+    win[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * (double)i / (double)segment);
+    U += win[i] * win[i];
+  }
+  const size_t bins = segment / 2 + 1, hop = segment / 2;
+  R.power.assign(bins, 0.0);
+  const Twiddles w(segment);
+  std::vector<Complex> f(segment);
+  for (size_t start = 0; start + segment <= n; start += hop) {
+    double mean = 0.0;
+    for (size_t i = 0; i < segment; ++i) mean += y[start + i];
+    mean /= (double)segment;
+    for (size_t i = 0; i < segment; ++i) f[i] = (y[start + i] - mean) * win[i];
+    fft_inplace(f, w, false);
+    for (size_t k = 0; k < bins; ++k) R.power[k] += std::norm(f[k]);
+    ++R.segments;
+  }
+  R.frequency.resize(bins);
+  const double df = 1.0 / ((double)segment * dt);
+  for (size_t k = 0; k < bins; ++k) {
+    /* one-sided: double every bin but DC and Nyquist */
+    const double one_sided = (k == 0 || k == bins - 1) ? 1.0 : 2.0;
+    R.power[k] *= one_sided * dt / (U * (double)R.segments);
+    R.frequency[k] = (double)k * df;
+  }
+
+  size_t peak = 1;
+  for (size_t k = 2; k < bins; ++k)
+    if (R.power[k] > R.power[peak]) peak = k;
+  double offset = 0.0;
+  if (peak + 1 < bins && R.power[peak - 1] > 0 && R.power[peak + 1] > 0 && R.power[peak] > 0) {
+    /* parabola through the log powers (exact for a Gaussian peak) */
+    const double am = std::log(R.power[peak - 1]), a0 = std::log(R.power[peak]), ap = std::log(R.power[peak + 1]);
+    const double denom = am - 2 * a0 + ap;
+    if (std::fabs(denom) > 1e-12) offset = 0.5 * (am - ap) / denom;
+  }
+  R.peak_frequency = ((double)peak + offset) * df;
+  R.peak_period = R.peak_frequency > 0 ? 1.0 / R.peak_frequency : 0.0;
+  R.ok = true;
+  R.message = "ok";
+  return R;
+}
+
 /* ---- Limit-cycle period & amplitude --------------------------- */
 LimitCycleResult limit_cycle_period_amplitude(const std::vector<double> &y, double dt) {
   LimitCycleResult R;
@@ -5401,38 +9261,33 @@ LimitCycleResult limit_cycle_period_amplitude(const std::vector<double> &y, doub
   const double scale = std::max(1.0, std::fabs(ymax) + std::fabs(ymin));
   if (ptp < 1e-6 * scale) { R.message = "no oscillation (fixed point)"; return R; }
 
-  /* Autocorrelation of the mean-removed signal; the first strong peak after
-   * the zero-lag descent gives the period. */
+  /* Autocorrelation of the mean-removed signal, every lag at once by FFT;
+   * the first strong peak after the zero-lag descent gives the period. */
   std::vector<double> c(y.begin(), y.end());
   for (double &v : c) v -= mean;
   const size_t maxlag = n / 2;
   double c0 = 0.0;
   for (size_t i = 0; i < n; ++i) c0 += c[i] * c[i];
   if (c0 <= 0) { R.message = "degenerate signal"; return R; }
-
-  auto acf = [&](size_t lag) {
-    double s = 0.0;
-    for (size_t i = 0; i + lag < n; ++i) s += c[i] * c[i + lag];
-    return s / c0;
-  };
+  std::vector<double> acf = lag_sums(c, maxlag);
+  for (double &v : acf) v /= c0;
 
   /* find first lag where ACF rises back to a local max above a threshold,
    * after it has first dropped below zero (one full oscillation). */
   bool dropped = false;
-  size_t best_lag = 0; double best_val = 0.0;
+  size_t best_lag = 0;
   for (size_t lag = 1; lag < maxlag; ++lag) {
-    const double a = acf(lag);
+    const double a = acf[lag];
     if (!dropped && a < 0.0) dropped = true;
     if (dropped) {
-      const double am = acf(lag - 1), ap = (lag + 1 < maxlag) ? acf(lag + 1) : a;
-      if (a > am && a >= ap && a > 0.2) { best_lag = lag; best_val = a; break; }
+      const double am = acf[lag - 1], ap = (lag + 1 < maxlag) ? acf[lag + 1] : a;
+      if (a > am && a >= ap && a > 0.2) { best_lag = lag; break; }
     }
-    (void)best_val;
   }
   if (best_lag == 0) { R.message = "no clear period (aperiodic or too few cycles)"; return R; }
 
   /* refine the peak with a parabolic fit around best_lag */
-  const double am = acf(best_lag - 1), a0 = acf(best_lag), ap = acf(best_lag + 1);
+  const double am = acf[best_lag - 1], a0 = acf[best_lag], ap = acf[best_lag + 1];
   double offset = 0.0;
   const double denom = (am - 2 * a0 + ap);
   if (std::fabs(denom) > 1e-12) offset = 0.5 * (am - ap) / denom;
@@ -21,12 +21,16 @@
  * All matrices are row-major, size n*n, indexed J[row*n + col].
  * ============================================================ */
 
+#include <array>
 #include <complex>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
 
+#include "label_volume.h"
+
 namespace dynsys::analysis {
 
 using Complex = std::complex<double>;
@@ -105,6 +109,20 @@ struct Model {
   std::function<bool(const double *x, double p, double *dfdp_out,
                      std::string *err)>
       dfdp;
+
+  /* Optional product f_x(x, p) v (length n), for the matrix-free
+   * continuation; a forward difference of vector_field (one call per
+   * product) when null. */
+  std::function<bool(const double *x, double p, const double *v,
+                     double *jv_out, std::string *err)>
+      jacobian_vec;
+
+  /* Optional preconditioner for the matrix-free continuation: out ~
+   * (f_x(x, p) - shift I)^{-1} r, both of length n. It only has to be
+   * cheap and roughly right; GMRES makes up the rest. */
+  std::function<bool(const double *x, double p, double shift,
+                     const double *r, double *out, std::string *err)>
+      precondition;
 };
 
 /* Build d f / d x by finite differences using only vector_field.
@@ -127,7 +145,7 @@ enum class SpecialPointKind { None, Fold, Hopf, BogdanovTakens, Cusp,
 struct BranchPoint {
   double p = 0.0;               /* parameter value                  */
   std::vector<double> x;        /* equilibrium coordinates (len n)  */
-  std::vector<Complex> eigenvalues;
+  std::vector<Complex> eigenvalues; /* empty where not computed, see below */
   int n_unstable = 0;           /* unstable eigenvalue count        */
   bool stable = false;          /* n_unstable == 0                  */
   SpecialPointKind special = SpecialPointKind::None;
@@ -143,6 +161,36 @@ struct BranchPoint {
   std::vector<double> second_tangent; /* length n+1, only at BranchPoint */
 };
 
+/* Corrector iteration of the continuation engines. Newton evaluates and
+ * factors the Jacobian at every iterate. Chord keeps one factorization for
+ * the whole corrector, starting from the last Jacobian the engine evaluated
+ * (the previous point's, where it has one); Broyden also updates that
+ * factorization's inverse by rank one per iterate. Both refactor at the
+ * iterate when the residual shrinks by less than the contraction factor.
+ * They take a few more cheap iterations and far fewer Jacobians, which pays
+ * on models with an expensive right-hand side. */
+enum class CorrectorKind { Newton, Chord, Broyden };
+
+/* Corrector work summed over a run. */
+struct CorrectorCounts {
+  long iterations = 0;      /* corrector steps taken                    */
+  long jacobians = 0;       /* Jacobian evaluations by the corrector    */
+  long factorizations = 0;  /* LU factorizations by the corrector       */
+  long krylov_iterations = 0; /* GMRES iterations (matrix-free mode)    */
+  long products = 0;        /* f_x v products (matrix-free mode)        */
+};
+
+/* Matrix-free continuation (ContinuationSettings::matrix_free). */
+struct KrylovSettings {
+  int restart = 40;            /* GMRES restart length                    */
+  int max_iters = 400;         /* GMRES iterations per linear solve       */
+  double tol = 1e-6;           /* GMRES relative residual in the corrector */
+  int block = 0;               /* block-Jacobi block size; 0: none        */
+  int arnoldi_dim = 30;        /* Krylov dimension of the eigenvalue test */
+  int n_eigs = 6;              /* eigenvalues kept, those nearest shift   */
+  double shift = 0.0;          /* shift-invert centre of the eigenvalues  */
+};
+
 struct ContinuationSettings {
   double h0 = 1e-2;             /* initial arclength step           */
   double h_min = 1e-6;
@@ -156,6 +204,10 @@ struct ContinuationSettings {
   int direction = +1;          /* +1 or -1: which way along tangent */
   bool detect_fold = true;
   bool detect_hopf = true;
+  CorrectorKind corrector = CorrectorKind::Newton;
+  double contraction = 0.5;    /* chord/Broyden: refactor above this rate */
+  bool matrix_free = false;    /* Newton-Krylov for large n, see below    */
+  KrylovSettings krylov;
 };
 
 struct Branch {
@@ -163,11 +215,35 @@ struct Branch {
   std::vector<std::size_t> special_indices; /* into points[] */
   std::string message;                      /* status / why it stopped */
   bool ok = false;
+  CorrectorCounts counts;                   /* corrector work, all steps */
 };
 
 /* Continue an equilibrium branch starting from (x0, p0), which
  * should already be an approximate equilibrium (the engine corrects
- * it first). The continuation parameter is the scalar `p`. */
+ * it first). The continuation parameter is the scalar `p`.
+ *
+ * Fold and branch-point tests are determinants of the bordered matrix
+ * the step already factors, and the Hopf test follows one complex pair
+ * by bordered Newton, so a regular point costs no eigen-solve. The full
+ * spectrum is taken every few points, at special points and after an
+ * event; in between n_unstable / stable are carried forward and
+ * eigenvalues is left empty. A spectrum that disagrees with the events
+ * found since the last one rewinds the branch and replays it with the
+ * spectrum at every point.
+ *
+ * With settings.matrix_free nothing of size n^2 is formed, for n in the
+ * thousands (discretized PDEs, large networks). The corrector is Newton on
+ * the same bordered system, solved by restarted GMRES from products f_x v
+ * (m.jacobian_vec, or forward differences) and preconditioned by
+ * m.precondition, or else by block-Jacobi on diagonal blocks of f_x probed
+ * with 3 * krylov.block products (exact when the coupling reaches less
+ * than two blocks, as in banded discretizations). The fold test is the
+ * tangent's p-component. Stability and Hopf points come from the
+ * krylov.n_eigs eigenvalues nearest krylov.shift, by shift-invert Arnoldi;
+ * those are what eigenvalues holds and what n_unstable counts. Branch
+ * points and normal-form coefficients are not computed in this mode, the
+ * corrector is always Newton, and counts has its Krylov iterations,
+ * products and block-Jacobi factorizations. */
 Branch continue_equilibrium(const Model &m, const std::vector<double> &x0,
                             double p0, const ContinuationSettings &settings);
 
@@ -270,6 +346,14 @@ struct Model2 {
   /* f(x, p, q) -> f_out (length n). */
   std::function<bool(const double *x, double p, double q, double *f_out, std::string *err)>
       vector_field;
+  /* Optional exact d f / d x (row-major n*n) and d f / d p at (x, p, q), as
+   * in Model. Used by the fold / Hopf curve correctors and passed through to
+   * the cycle continuations behind the LPC / PD / NS curves; finite
+   * differences are used when null. */
+  std::function<bool(const double *x, double p, double q, double *jac_out, std::string *err)>
+      jacobian_x;
+  std::function<bool(const double *x, double p, double q, double *dfdp_out, std::string *err)>
+      dfdp;
 };
 
 /* One point on a two-parameter curve: the two parameter values and the
@@ -307,6 +391,7 @@ struct TwoParamCurve {
   std::string message;
   bool ok = false;
   SpecialPointKind kind = SpecialPointKind::Fold;
+  CorrectorCounts counts;
 };
 
 enum class TwoParamKind { Fold, Hopf };
@@ -318,13 +403,19 @@ struct TwoParamSettings {
   int max_points = 800;
   int max_corrector_iters = 20;
   double corrector_tol = 1e-9;
+  CorrectorKind corrector = CorrectorKind::Newton;  /* fold / Hopf curves */
+  double contraction = 0.5;
 };
 
 /* Trace a fold or Hopf curve in the (p,q) plane, starting from a codim-1 point
- * found at (p0,q0,x0). The extended system is G(x,p,q) = [ f ; g ] = 0 where g
- * is the fold test det(f_x) (Fold) or the real-part-sum proxy (Hopf); this is
- * n+1 equations in n+2 unknowns, whose solution set is the 1-D curve. Returns
- * points sampled along it, both directions from the start. */
+ * found at (p0,q0,x0). The defining system is minimally augmented: f = 0 plus
+ * the bordered test function g that vanishes where f_x is singular (Fold), or
+ * two entries of the 2x2 bordered block of f_x^2 + kappa I with kappa = omega^2
+ * as an extra unknown (Hopf). Its derivatives use the adjoint solution and
+ * derivatives of m.jacobian_x along the null vectors (finite differences when
+ * jacobian_x is null), so a corrector step costs a few Jacobians and one
+ * bordered LU. Returns points sampled along the curve, both directions from
+ * the start. */
 TwoParamCurve two_param_curve(const Model2 &m, TwoParamKind kind,
                               const std::vector<double> &x0, double p0, double q0,
                               const TwoParamSettings &settings);
@@ -360,15 +451,21 @@ Codim2Point locate_bogdanov_takens(const Model2 &m, const std::vector<double> &x
 /* ---- CODIM-2 CURVE CONTINUATION (a codim-2 point in 3 parameters) -------- *
  * A Bogdanov-Takens point is codim-2 (two defining conditions). With a THIRD
  * free parameter its solution set is a 1-D CURVE in (p,q,r) space. We continue
- * it by pseudo-arclength on the defining system
- *   { f(x,p,q,r) = 0  (n eqns) ;  mu_prod = 0 ;  mu_sum = 0 }
- * which is n+2 equations in the n+3 unknowns (x, p, q, r). This is MatCont's
- * "BT curve" (a codim-2 locus continued in three parameters). */
+ * it by pseudo-arclength on a minimally augmented defining system
+ *   { f(x,p,q,r) = 0  (n eqns) ;  g1 = 0 ;  g2 = 0 }
+ * where g1, g2 are entries of small bordered systems built on f_x (the same
+ * engine as the fold / Hopf curves), plus a frequency unknown per Hopf pair.
+ * This is MatCont's "BT curve" (a codim-2 locus continued in three
+ * parameters); the zero-Hopf, cusp and Hopf-Hopf curves below share it. */
 struct Model3 {
   std::size_t n = 0;
   /* f(x, p, q, r) -> f_out (length n). */
   std::function<bool(const double *x, double p, double q, double r, double *f_out, std::string *err)>
       vector_field;
+  /* Optional exact d f / d x (row-major n*n), as in Model2; finite
+   * differences are used when null. */
+  std::function<bool(const double *x, double p, double q, double r, double *jac_out, std::string *err)>
+      jacobian_x;
 };
 
 struct BTCurvePoint {
@@ -401,8 +498,8 @@ BTCurve bt_curve(const Model3 &m, const std::vector<double> &x0,
 
 /* Continue a ZERO-HOPF (fold-Hopf) point as a curve in three parameters.
  * The zero-Hopf defining conditions are: one real eigenvalue = 0 AND one
- * complex-conjugate pair on the imaginary axis (Re = 0). Over the unknowns
- * (x,p,q,r) this is n+2 equations -> a 1-D locus, traced by the same
+ * complex-conjugate pair on the imaginary axis (Re = 0), i.e. a fold block on
+ * f_x and a Hopf block on f_x^2 + omega^2 I. Traced by the same
  * pseudo-arclength scheme as bt_curve. Reuses BTCurve/BTCurveSettings (the
  * BTCurvePoint a,b fields carry the zero-Hopf b and Re(c) here). */
 BTCurve zh_curve(const Model3 &m, const std::vector<double> &x0,
@@ -410,8 +507,9 @@ BTCurve zh_curve(const Model3 &m, const std::vector<double> &x0,
 
 /* Continue a CUSP point as a curve in three parameters. A cusp sits on the fold
  * curve where the fold (saddle-node) normal-form coefficient a vanishes. The
- * defining conditions over (x,p,q,r) are: one real eigenvalue = 0 (fold) AND
- * the cusp coefficient a = 0. Traced by the same pseudo-arclength scheme as
+ * defining conditions over (x,p,q,r) are: the fold block's test function = 0
+ * AND the cusp coefficient a = 0 (its row is differenced: it needs third
+ * derivatives). Traced by the same pseudo-arclength scheme as
  * bt_curve. The BTCurvePoint a,b fields carry the cusp coefficient c (a) and the
  * fold-eigenvalue residual (b). */
 BTCurve cusp_curve(const Model3 &m, const std::vector<double> &x0,
@@ -419,8 +517,8 @@ BTCurve cusp_curve(const Model3 &m, const std::vector<double> &x0,
 
 /* Continue a HOPF-HOPF (double-Hopf) point as a curve in three parameters. The
  * defining conditions are: TWO distinct complex-conjugate pairs simultaneously
- * on the imaginary axis (both Re = 0). Over (x,p,q,r) this is n+2 equations ->
- * a 1-D locus, traced by the same scheme. The BTCurvePoint a,b fields carry the
+ * on the imaginary axis (both Re = 0): two Hopf blocks, each with its own
+ * frequency unknown. Traced by the same scheme. The BTCurvePoint a,b fields carry the
  * two frequencies omega1, omega2 at each point. */
 BTCurve hh_curve(const Model3 &m, const std::vector<double> &x0,
                  double p0, double q0, double r0, const BTCurveSettings &settings);
@@ -604,9 +702,9 @@ struct LPCCurve {
 
 /* Two-parameter loci of cycle codim-1 bifurcations: period-doubling (PD, a real
  * Floquet multiplier = -1) and Neimark-Sacker (NS, a complex multiplier pair on
- * the unit circle). Same point type as LPC. Traced by scanning the secondary
- * parameter q, continuing the cycle in p at each q (with Floquet on), and
- * picking the bracketed PD / NS sample on that branch. */
+ * the unit circle). Same point type as LPC. Continued directly in (p, q) from
+ * the PD / NS point bracketed on a cycle branch at the seed q; points come in
+ * order along the curve. */
 struct CycleBifPoint {
   double p = 0.0, q = 0.0; double period = 0.0; double amplitude = 0.0;
   /* secondary cycle test-function values AT this curve point, used to flag
@@ -729,7 +827,10 @@ struct BasinResult {
   std::vector<int> cell_attractor;   /* width*height; index into attractors, or -1 = diverged, -2 = did not settle (chaotic) */
   std::vector<float> cell_speed;     /* width*height; 0..1 convergence speed (1 = fast) */
   std::vector<std::pair<double,double>> attractors; /* representative (x,y) of each basin */
+  std::vector<int> attractor_kind;   /* per attractor: 0 point, 1 cycle, 2 chaotic (fingerprint) */
+  std::vector<int> attractor_period; /* per attractor: 1 for a point, k for a cycle, 0 chaotic */
   long n_converged = 0, n_diverged = 0, n_nonconvergent = 0;
+  long n_inherited = 0;              /* cells not integrated themselves (memoize, adaptive) */
   std::string message;
 };
 
@@ -741,6 +842,39 @@ struct BasinOptions {
   double cluster_tol = 1e-2;   /* endpoints within this = same attractor */
   double diverge_r = 1e6;      /* |state| beyond this = diverged */
   int max_attractors = 16;     /* cap distinct basins */
+  /* Cell-to-cell memoization, as in simple cell mapping (compute_basins_mt and
+   * integrate_basin_cells only): an orbit that spends memo_confirm
+   * consecutive steps in grid cells already resolved to the same outcome
+   * (same status; for settled cells, endpoints within cluster_tol) stops
+   * there and inherits it, and the still-open cells it passed through take
+   * its outcome without being integrated themselves. Far less integration
+   * on smooth flows; cells right at a basin boundary may take a
+   * neighbour's label, and with several threads which cells resolve first
+   * varies by run. */
+  bool memoize = false;
+  int memo_confirm = 4;
+  /* Quadtree boundary refinement (same functions): the grid is cut into
+   * adaptive_grid x adaptive_grid coarse blocks (at least 8 cells a side),
+   * and a block whose border cells all reach the same outcome is filled
+   * without integrating its interior; others are split until every
+   * boundary is resolved to the cell. Integrated cells then scale with the
+   * basin boundaries, not the area. A basin island that lies wholly inside
+   * a uniform-bordered block is missed. */
+  bool adaptive = false;
+  int adaptive_grid = 16;
+  /* Attractor fingerprints (same functions): an orbit still moving after
+   * max_steps runs fp_steps more and is classified by what it does there --
+   * a cycle of period k <= 64 for maps, a closed orbit crossing the section
+   * y = mean(y) at k <= 8 distinct places for flows (set `flow`), otherwise
+   * a chaotic set described by centroid, spread and an 8x8 occupancy mask.
+   * Orbits with matching signatures share a label, so coexisting limit
+   * cycles and chaotic attractors get basins of their own instead of one
+   * "did not settle" region. Maps are also checked right after settling,
+   * since the drift test cannot tell a fixed point from a cycle whose
+   * period divides its stride. */
+  bool fingerprint = false;
+  bool flow = false;
+  long fp_steps = 1024;
 };
 
 /* advance: one step of the dynamics, (x,y) -> (*nx,*ny); return false on
@@ -750,15 +884,139 @@ BasinResult compute_basins(const std::function<bool(double x, double y, double *
                            const BasinOptions &opt);
 
 /* Parallel variant: `make_advance(tid)` returns an advance function private to
- * worker thread tid (so each thread can own its own evaluation scratch and
- * avoid data races). The expensive per-cell integration runs across hardware
- * threads; the attractor clustering is done serially afterwards so labels stay
- * deterministic. Produces the same result as compute_basins, just faster on
- * multi-core machines. Falls back to serial when only one core is available. */
+ * worker slot tid in [0, pool::threads()) (so each thread can own its own
+ * evaluation scratch and avoid data races); it is called lazily, once per slot
+ * that actually runs rows. The expensive per-cell integration runs row by row on
+ * the shared work-stealing pool (thread_pool.h); the attractor clustering runs
+ * afterwards, also on the pool, over a spatial hash of the attractor
+ * signatures. Labels are deterministic and numbered in first-cell order
+ * like compute_basins; the two agree whenever each attractor's endpoints
+ * lie within cluster_tol of one another (the clustering here is single
+ * linkage, so a slowly converging attractor whose endpoints smear along a
+ * manifold stays one basin instead of splitting). Falls back to serial
+ * when the pool has one thread. */
 using AdvanceFn = std::function<bool(double x, double y, double *nx, double *ny)>;
 BasinResult compute_basins_mt(const std::function<AdvanceFn(int tid)> &make_advance,
                               const BasinOptions &opt);
 
+/* The two phases of compute_basins_mt, for callers that assemble the grid
+ * from pieces (the basin view composes it from cached tiles):
+ * integrate_basin_cells runs phase 1 over opt's grid into `cells`
+ * (width*height, row-major) -- on the pool when `parallel`, else serially
+ * with make_advance(0) -- and cluster_basin_cells runs phase 2 over any such
+ * grid. A cell's endpoint does not depend on its neighbours, so a grid
+ * stitched from separately integrated pieces clusters exactly like one
+ * integrated whole. */
+struct BasinCell {
+  double ex = 0, ey = 0; /* endpoint; the centroid when state 3 */
+  long steps = 0;
+  int state = 1;         /* 0 settled, 1 diverged, 2 did not settle, 3 fingerprinted */
+  int inherited = 0;     /* 1 = outcome taken from other cells (memoize, adaptive) */
+  int kind = 0;          /* state 3: 1 cycle, 2 chaotic */
+  int period = 0;        /* state 3 cycle: its period */
+  float sx = 0, sy = 0;  /* state 3: standard deviation about the centroid */
+  std::uint64_t occ = 0; /* state 3 chaotic: 8x8 occupancy of centroid +- 2.5 sd */
+};
+void integrate_basin_cells(const std::function<AdvanceFn(int tid)> &make_advance,
+                           const BasinOptions &opt, std::vector<BasinCell> *cells,
+                           bool parallel = true);
+BasinResult cluster_basin_cells(const std::vector<BasinCell> &cells, int width, int height,
+                                const BasinOptions &opt);
+
+/* ---- Volumetric basins ---------------------------------------- *
+ * The basin picture over three state axes: a width x height x depth grid
+ * of initial conditions (other components held at the caller's start
+ * state), each integrated until it settles, escapes or runs out of steps
+ * as in compute_basins. Labels go into a run-length LabelVolume
+ * (label_volume.h) one z slice at a time, and slices are classified
+ * coarse to fine -- 0, D-1, the middle, the quarters, ... -- so a partial
+ * volume already spans the whole depth.
+ *
+ * Endpoints are clustered in 3-D against a spatial hash of the attractors
+ * found so far, slice by slice, so labels stay stable while the volume
+ * fills. Calling again on a partly filled result with the same grid and
+ * box resumes: filled slices are skipped and attractors keep their labels.
+ * on_slice(k) runs on the caller's thread after slice k; returning false
+ * stops (the result is then partial, ok = true, labels.complete() false).
+ * Rows of a slice run on the shared pool when `parallel`, with one
+ * make_advance(tid) per worker slot as in compute_basins_mt. */
+using AdvanceFn3 = std::function<bool(const double *p, double *np)>; /* p, np: 3 coordinates */
+struct BasinVolumeOptions {
+  double lo[3] = {-2, -2, -2}, hi[3] = {2, 2, 2};
+  int size[3] = {64, 64, 64};  /* cells along each axis */
+  long max_steps = 2000;
+  double settle_tol = 1e-4;
+  double cluster_tol = 1e-2;
+  double diverge_r = 1e6;
+  int max_attractors = 16;
+};
+struct BasinVolume {
+  bool ok = false;
+  std::string message;
+  volume::LabelVolume labels;   /* attractor index, -1 escaped, -2 did not settle */
+  std::array<double, 3> lo{}, hi{}; /* the box the labels span (opt.lo / opt.hi) */
+  std::vector<std::array<double, 3>> attractors;
+  long n_converged = 0, n_diverged = 0, n_nonconvergent = 0;
+};
+bool compute_basin_volume(const std::function<AdvanceFn3(int tid)> &make_advance,
+                          const BasinVolumeOptions &opt, BasinVolume *vol,
+                          const std::function<bool(int slice)> &on_slice = nullptr, bool parallel = true);
+/* The order compute_basin_volume fills the depth slices in. */
+std::vector<int> basin_volume_slice_order(int depth);
+
+/* ---- Buddhabrot accumulation ---------------------------------- *
+ * Density of the orbits of escaping parameters c: every state an orbit
+ * (started at 0) visits inside the view before it escapes is splatted
+ * into a width x height histogram (row 0 = ymin, as the fractal view).
+ *
+ * With `importance`, c is drawn by Metropolis-Hastings instead of
+ * uniformly over the sample box: chains prefer c whose orbits put many
+ * points f(c) in the view, proposing a small jump (scaled to the view)
+ * or, with probability p_uniform, a fresh uniform c. Every state the
+ * chain holds is splatted with weight 1/f(c), so the image converges to
+ * the same density as uniform sampling up to scale -- but on a zoomed
+ * view nearly every sample lands in it instead of almost none.
+ *
+ * Work is split over a fixed set of chains (each with its own RNG) run on
+ * the shared pool; splats go into per-thread band bins merged on the pool
+ * with integer adds, so the histogram does not depend on the thread
+ * count. The state persists between calls; a call adds `samples` more.
+ * make_step(tid) gives each worker slot its own map step
+ * x_{k+1} = step(c, x_k) over `dim` components (plotted: 0 and 1). */
+using BuddhaStepFn = std::function<bool(double cre, double cim, const double *x, double *xn)>;
+struct BuddhaOptions {
+  double xmin = -2.0, xmax = 1.0, ymin = -1.5, ymax = 1.5; /* the view */
+  int width = 256, height = 256;
+  double sxmin = -2.2, sxmax = 0.8, symin = -1.4, symax = 1.4; /* where c is drawn */
+  int dim = 2;
+  int max_iter = 200;
+  double escape_r = 4.0;
+  long samples = 20000;   /* per call */
+  bool importance = true;
+  double p_uniform = 0.2;
+  int chains = 64;
+  std::uint64_t seed = 22695477u;
+};
+struct BuddhaState {
+  struct Chain {
+    std::uint64_t rng = 0;
+    double cre = 0, cim = 0;
+    int f = 0;                       /* orbit points in the view, 0 = no state yet */
+    std::vector<std::uint32_t> pix;  /* where they land */
+  };
+  std::vector<std::uint64_t> accum; /* fixed point: 1 << 16 per unit weight */
+  int width = 0, height = 0;
+  std::vector<Chain> chains;
+  long samples = 0;                 /* proposals so far */
+  long contributing = 0;            /* of which splatted something into the view */
+  long accepted = 0;
+};
+/* Resets `st` when its grid or chain count does not match `opt`. A step
+ * that returns false ends the orbit as bounded (nothing is splatted), so
+ * a cancelled caller drains the batch quickly. */
+void accumulate_buddhabrot(const std::function<BuddhaStepFn(int tid)> &make_step, const BuddhaOptions &opt,
+                           BuddhaState *st, bool parallel = true);
+
 /* ---- Box-counting fractal dimension --------------------------- *
  * Estimate the box-counting (Minkowski–Bouligand) dimension of a set of
  * 2D points: cover the bounding box with a grid of boxes of side eps,
@@ -782,6 +1040,68 @@ BoxCountResult box_counting_dimension(const std::vector<double> &xs,
                                       const std::vector<double> &ys,
                                       int n_levels = 10);
 
+/* The same over n-dimensional points: `points` holds n_points rows of
+ * `dim` coordinates, boxed in the bounding hypercube. Points with a
+ * non-finite coordinate are skipped. Every box counter here runs in one
+ * pass: points are quantized to Morton codes on the finest grid, radix-
+ * sorted on the pool, and one scan of the sorted codes counts all levels
+ * at once (neighbours whose codes first differ at bit h share a box at
+ * every level coarser than h / dim). dim * (n_levels - 1) must fit in 64
+ * bits, so n_levels is capped at 64 / dim + 1 as well as at 24. */
+BoxCountResult box_counting_dimension_nd(const std::vector<double> &points, int dim, int n_levels = 10);
+
+/* Box counting over a raw file of little-endian float64 points, `dim`
+ * per point (numpy's tofile()), that need not fit in memory: one pass for
+ * the bounds, one that sorts chunk_points codes at a time into runs on
+ * temporary files, then a k-way merge of the runs feeding the same scan. */
+BoxCountResult box_counting_dimension_file(const char *path, int dim, int n_levels = 10,
+                                           std::size_t chunk_points = std::size_t(1) << 22);
+
+/* ---- Correlation and generalized (Renyi) dimensions ----------- *
+ * Grassberger-Procaccia on an n-D trajectory (`points`: rows of `dim`
+ * coordinates in time order). For a centre x_i let p_i(r) be the fraction
+ * of the other points within distance r of it, skipping the Theiler window
+ * |i - j| <= theiler so that neighbours along the same stretch of orbit do
+ * not count. Then
+ *     C_q(r) = [ mean_i p_i(r)^(q-1) ]^(1/(q-1)),   C_1(r) = exp(mean_i log p_i(r)),
+ * and D_q is the slope of log C_q against log r. C_2 is the correlation
+ * sum and D_2 the correlation dimension; D_0 >= D_1 >= D_2 >= ... for a
+ * multifractal, all equal for a uniform measure.
+ *
+ * Pairs are counted with a k-d tree: every centre walks it once for all
+ * radii, and a node whose whole box falls between two neighbouring radii
+ * is counted without visiting its points. Centres run in parallel on the
+ * pool. With more than max_centres points an evenly spaced subset of
+ * centres is used (still against all points), which keeps 10^6-point
+ * attractors to seconds; the result does not depend on the thread count. */
+struct DimensionSpectrumOptions {
+  int theiler = 10;                /* |i - j| <= theiler is not a pair */
+  int n_radii = 24;                /* log-spaced radii ... */
+  double r_min = 1e-3;             /* ... from r_min to r_max times the */
+  double r_max = 0.3;              /* largest extent of the point set */
+  long max_centres = 20000;        /* <= 0: every point is a centre */
+  double min_neighbours = 10.0;    /* fit only radii with at least this
+                                      mean neighbour count */
+  std::vector<double> qs = {0, 1, 2, 3, 4};
+};
+
+struct DimensionSpectrum {
+  bool ok = false;
+  double correlation_dimension = 0.0;     /* D_2 */
+  double correlation_r_squared = 0.0;
+  std::vector<double> log_r;              /* x of every fit */
+  std::vector<double> log_correlation;    /* log C_2(r) */
+  std::vector<double> qs;                 /* as requested */
+  std::vector<double> dq;                 /* D_q, NaN where no fit */
+  std::vector<std::vector<double>> log_cq;  /* [q][radius], NaN where undefined */
+  int fit_first = 0, fit_last = 0;        /* radius indices fitted, inclusive */
+  long points = 0, centres = 0;
+  std::string message;
+};
+
+DimensionSpectrum correlation_dimensions(const std::vector<double> &points, int dim,
+                                         const DimensionSpectrumOptions &opt = {});
+
 /* ---- Iterated Function System (chaos game) -------------------- *
  * An IFS is a set of affine contraction maps with probabilities; its
  * attractor (Barnsley fern, Sierpinski, dragon, ...) is drawn by the
@@ -805,6 +1125,41 @@ struct IFSResult {
 IFSResult chaos_game(const std::vector<AffineMap> &maps, long iterations,
                      unsigned int seed = 12345u);
 
+/* Streaming chaos game: the same attractor without storing a point. A
+ * short serial pilot run fixes the bounding box; then `streams`
+ * independent chains (own RNG, own burn-in) run on the shared pool and
+ * bin every point straight into a density grid -- the attractor fitted
+ * into width x height with `margin`, aspect kept, row 0 at ymin -- and
+ * into an occupancy bitmap of 2^(box_levels-1) boxes per side over the
+ * square box_counting_dimension uses. Coarser box levels are ORs of the
+ * finest one, so `box` holds the same fit as box_counting_dimension
+ * without a hash set per level. Memory is per worker slot (one density
+ * and one bitmap), not per point; slots are merged with integer adds and
+ * ORs, so the result does not depend on the thread count. */
+struct IFSStreamOptions {
+  long iterations = 400000;  /* points in total, after burn-in */
+  int width = 512, height = 512;
+  double margin = 0.06;
+  int streams = 64;
+  int box_levels = 12;       /* 1 .. 14 */
+  long pilot = 20000;        /* points that fix the bounding box */
+  unsigned int seed = 12345u;
+};
+struct IFSDensity {
+  bool ok = false;
+  std::string message;
+  int width = 0, height = 0;
+  std::vector<std::uint64_t> density;  /* width * height, row-major */
+  std::uint64_t max_density = 0;
+  double xmin = 0, xmax = 0, ymin = 0, ymax = 0; /* pilot bounding box */
+  double x0 = 0, y0 = 0, scale = 1;    /* cell = ((x - x0) * scale, (y - y0) * scale) */
+  long points = 0;
+  long outside = 0;                    /* points that fell off the density grid */
+  BoxCountResult box;
+};
+IFSDensity chaos_game_stream(const std::vector<AffineMap> &maps, const IFSStreamOptions &opt,
+                             bool parallel = true);
+
 /* ---- Limit-cycle period & amplitude (foundation for LC continuation) -- *
  * Given a settled, sampled scalar signal y(t) from an oscillating system,
  * estimate the oscillation PERIOD and AMPLITUDE. The period is found from
@@ -822,6 +1177,31 @@ struct LimitCycleResult {
 
 LimitCycleResult limit_cycle_period_amplitude(const std::vector<double> &y, double dt);
 
+/* ---- FFT autocorrelation and power spectrum ------------------ *
+ * Both run on a small in-house radix-2 FFT, so there is no outside
+ * dependency. autocorrelation() returns r[lag] = sum_i c_i c_(i+lag) /
+ * sum_i c_i^2 of the mean-removed signal c for lag = 0..max_lag (clamped to
+ * n - 1), by Wiener-Khinchin: zero-pad to a power of two >= n + max_lag,
+ * transform, take |.|^2, transform back. O(n log n) instead of
+ * O(n * max_lag). Empty for a constant or non-finite signal. */
+std::vector<double> autocorrelation(const std::vector<double> &y, std::size_t max_lag);
+
+/* Welch estimate of the one-sided power spectral density of y sampled every
+ * dt: Hann-windowed segments of `segment` samples (a power of two; 0 picks
+ * n / 4 rounded down, at least 64) overlapping by half, averaged. The
+ * integral of power over frequency is the signal's variance. */
+struct PowerSpectrum {
+  bool ok = false;
+  std::vector<double> frequency;   /* cycles per unit time, 0 .. 1 / (2 dt) */
+  std::vector<double> power;       /* PSD per frequency bin */
+  double peak_frequency = 0.0;     /* strongest non-DC bin, parabola-refined */
+  double peak_period = 0.0;        /* 1 / peak_frequency */
+  int segments = 0;
+  std::string message;
+};
+
+PowerSpectrum power_spectrum(const std::vector<double> &y, double dt, std::size_t segment = 0);
+
 /* ---- periodic-orbit continuation by collocation ------------------------- *
  * Represents a periodic orbit on a uniform mesh of m points in [0,1) with the
  * BVP  x'(s) = T f(x(s)),  x(0) = x(1),  plus an integral phase condition that
@@ -840,7 +1220,10 @@ struct CycleSample {
   bool is_fold = false;    /* an LPC (cycle fold) was bracketed at this sample */
   /* Floquet multipliers of the cycle (the monodromy matrix eigenvalues). One
    * multiplier is always ~1 (the trivial one, along the flow); the rest govern
-   * stability. Populated when compute_floquet is on. */
+   * stability. Populated when compute_floquet is on. With Gauss collocation
+   * (ncol >= 1) they are read off the same condensed factorization the Newton
+   * step uses, one small n x n eigenproblem; the trapezoidal scheme (ncol = 0)
+   * integrates the variational equation over the period instead. */
   std::vector<double> floquet_re, floquet_im;
   double max_nontrivial_mult = 0.0; /* |largest non-trivial multiplier|     */
   bool is_pd = false;      /* period-doubling (a multiplier passed -1)      */
@@ -863,9 +1246,16 @@ struct CycleBranch {
   std::string message;
   bool ok = false;
   bool turned = false;     /* true if arclength continuation went around a fold */
+  CorrectorCounts counts;
 };
 struct CycleSettings {
-  int mesh = 60;                 /* collocation points around the orbit     */
+  int mesh = 60;                 /* collocation points around the orbit
+                                  * (with ncol > 0: mesh intervals, ntst)   */
+  /* 0: trapezoidal collocation on `mesh` points (second order). 1..7:
+   * piecewise-polynomial orthogonal collocation, `mesh` intervals each with
+   * ncol Gauss-Legendre points (order 2*ncol at the mesh points), so the
+   * orbit is stored at mesh*ncol points and the guess is resampled to that. */
+  int ncol = 0;
   double p_min = -1e9, p_max = 1e9;
   double dp = 0.02;              /* parameter step (monotone mode)          */
   int max_steps = 400;
@@ -875,6 +1265,8 @@ struct CycleSettings {
   double ds = 0.05;              /* arclength step size                      */
   bool compute_floquet = true;   /* compute Floquet multipliers per sample   */
   bool adaptive_mesh = true;     /* redistribute mesh by arclength (stiff cycles) */
+  CorrectorKind corrector = CorrectorKind::Newton;
+  double contraction = 0.5;
 };
 
 /* Trace a branch of periodic orbits starting from an initial guess (a set of
@@ -888,9 +1280,13 @@ CycleBranch continue_limit_cycle(const Model &m,
 
 /* Two-parameter fold-of-cycles (LPC) curve: traces, in the (p,q) plane, the
  * locus where a limit cycle folds (a saddle-node of cycles; a nontrivial
- * Floquet multiplier passes +1). For each q it continues the cycle in p and
- * records where the fold-of-cycles test changes sign. Seeded from a cycle
- * guess + period at (p0,q0). */
+ * Floquet multiplier passes +1). The cycle is continued in p at q0 from the
+ * guess + period at (p0,q0) until a fold is bracketed (other q in the window
+ * are tried if none is), and the curve is then continued directly: the
+ * collocation BVP plus a bordered test function that vanishes on the curve,
+ * followed by pseudo-arclength in (orbit, period, p, q) with settings.h0 as
+ * the step and at most settings.max_points points. The same engine traces the
+ * PD and NS curves below. */
 LPCCurve lpc_curve(const Model2 &m,
                    const std::vector<std::vector<double>> &guess_points,
                    double period_guess, double p0, double q0,
@@ -0,0 +1,124 @@
+#pragma once
+
+/* ============================================================
+ * dynsys boundary tracing (Mariani-Silver) on a sample grid.
+ *
+ * The escape-time view can skip most of an image whose colour
+ * regions are large: the grid is cut into tiles of kTile samples,
+ * and each tile is processed as a stack of rectangles. Only a
+ * rectangle's border is computed; when every border sample has the
+ * same value the interior is filled with it, otherwise the
+ * rectangle is split along its longer side. Rectangles at or below
+ * kMinSplit samples are computed in full.
+ *
+ * This is an approximation. The fill is right only if a uniform frame
+ * cannot enclose a different value. That holds for the escape-count
+ * regions of Mandelbrot / Julia-type maps, which are connected. It
+ * does not hold for a general map, and even there a feature thinner
+ * than the sample spacing can slip between two border samples. Those
+ * pixels take the frame's value.
+ *
+ * Header-only like tile_cache.h. Tiles are disjoint, so different
+ * threads may trace different tiles of one Grid at once. Callers with
+ * their own sample storage and block size (the adaptive basin grid)
+ * run subdivide() directly.
+ * ============================================================ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dynsys::trace {
+
+constexpr int kTile = 32;    /* samples per tile side */
+constexpr int kMinSplit = 4; /* rectangles this small are computed in full */
+
+struct Rect { int gx0, gy0, gx1, gy1; }; /* inclusive sample bounds */
+
+/* The subdivision behind Grid::trace_tile, for callers that keep their own
+ * samples. at(gx, gy) returns a sample's value (computing it on first use is
+ * the caller's business), same(a, b) tells whether two values belong to one
+ * region, fill(r, v) fills the interior of r, whose border is uniformly v,
+ * and full(r) computes the interior of r sample by sample. */
+template <class At, class Same, class Fill, class Full>
+void subdivide(Rect root, At &&at, Same &&same, Fill &&fill, Full &&full) {
+  std::vector<Rect> todo{root};
+  while (!todo.empty()) {
+    const Rect r = todo.back();
+    todo.pop_back();
+    const auto c0 = at(r.gx0, r.gy0);
+    bool uniform = true;
+    for (int gx = r.gx0; gx <= r.gx1; ++gx) {
+      if (!same(at(gx, r.gy0), c0)) uniform = false;
+      if (!same(at(gx, r.gy1), c0)) uniform = false;
+    }
+    for (int gy = r.gy0 + 1; gy < r.gy1; ++gy) {
+      if (!same(at(r.gx0, gy), c0)) uniform = false;
+      if (!same(at(r.gx1, gy), c0)) uniform = false;
+    }
+    if (r.gx1 - r.gx0 < 2 || r.gy1 - r.gy0 < 2) continue; /* no interior */
+    if (uniform) {
+      fill(r, c0);
+    } else if (r.gx1 - r.gx0 <= kMinSplit && r.gy1 - r.gy0 <= kMinSplit) {
+      full(r);
+    } else if (r.gx1 - r.gx0 >= r.gy1 - r.gy0) {
+      const int mid = (r.gx0 + r.gx1) / 2;
+      todo.push_back({r.gx0, r.gy0, mid, r.gy1});
+      todo.push_back({mid, r.gy0, r.gx1, r.gy1});
+    } else {
+      const int mid = (r.gy0 + r.gy1) / 2;
+      todo.push_back({r.gx0, r.gy0, r.gx1, mid});
+      todo.push_back({r.gx0, mid, r.gx1, r.gy1});
+    }
+  }
+}
+
+/* GW x GH samples of type T and which of them are set */
+template <class T>
+struct Grid {
+  int gw = 0, gh = 0;
+  std::vector<T> value;
+  std::vector<std::uint8_t> known;
+
+  Grid(int gw_, int gh_) : gw(gw_), gh(gh_), value((size_t)gw_ * gh_), known((size_t)gw_ * gh_, 0) {}
+
+  int tiles_x() const { return (gw + kTile - 1) / kTile; }
+  int tiles() const { return tiles_x() * ((gh + kTile - 1) / kTile); }
+
+  /* Trace tile `item` (row-major over tiles()). compute(gx, gy) returns a
+   * sample's value; put(gx, gy, v, filled) is called once for every sample
+   * of the tile, with filled set when v was filled in, not computed. */
+  template <class Compute, class Put>
+  void trace_tile(int item, Compute &&compute, Put &&put) {
+    const int tx = item % tiles_x(), ty = item / tiles_x();
+    auto sample = [&](int gx, int gy) -> T {
+      const size_t k = (size_t)gy * gw + gx;
+      if (!known[k]) {
+        value[k] = compute(gx, gy);
+        known[k] = 1;
+        put(gx, gy, value[k], false);
+      }
+      return value[k];
+    };
+    subdivide(
+        Rect{tx * kTile, ty * kTile, std::min(gw, (tx + 1) * kTile) - 1, std::min(gh, (ty + 1) * kTile) - 1},
+        sample, [](const T &a, const T &b) { return a == b; },
+        [&](const Rect &r, const T &c0) {
+          for (int gy = r.gy0 + 1; gy < r.gy1; ++gy)
+            for (int gx = r.gx0 + 1; gx < r.gx1; ++gx) {
+              const size_t k = (size_t)gy * gw + gx;
+              if (known[k]) continue;
+              value[k] = c0;
+              known[k] = 1;
+              put(gx, gy, c0, true);
+            }
+        },
+        [&](const Rect &r) {
+          for (int gy = r.gy0 + 1; gy < r.gy1; ++gy)
+            for (int gx = r.gx0 + 1; gx < r.gx1; ++gx) sample(gx, gy);
+        });
+  }
+};
+
+}  // namespace dynsys::trace
@@ -30,6 +30,7 @@
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <mutex>
 
 extern "C" {
 #include "arena.h"
@@ -41,7 +42,12 @@ extern "C" {
 
 #include "analysis.h"
 #include "expr_ir_ad.h"
+#include "expr_ir_perturb.h"
 #include "cas_bridge.h"
+#include "thread_pool.h"
+#include "tile_cache.h"
+#include "boundary_trace.h"
+#include "fractal_period.h"
 
 #define PNG_WRITER_IMPLEMENTATION
 #include "png_writer.h"
@@ -172,6 +178,19 @@ const char *integrator_name(Integrator integrator) {
   return "unknown";
 }
 
+struct ViewJob;
+
+/* One cached tile of the fractal (colours) or basin (raw cells) view. */
+struct ViewTile {
+  std::vector<uint32_t> rgba;
+  std::vector<dynsys::analysis::BasinCell> cells;
+  size_t bytes() const {
+    return sizeof(ViewTile) + rgba.size() * sizeof(uint32_t) +
+           cells.size() * sizeof(dynsys::analysis::BasinCell);
+  }
+};
+using ViewTileCache = dynsys::tiles::Cache<ViewTile>;
+
 struct AppState {
   arena_t system_arena{};
   bool arena_ready = false;
@@ -368,6 +387,30 @@ struct AppState {
   double perf_frame_ms = 16.0;   /* smoothed ms/frame */
   double perf_throttle = 0.0;    /* 0..1 current throttle level */
   bool perf_throttle_active = false; /* true while throttling (for the HUD note) */
+  /* Background view jobs: the fractal, basin, 2-parameter scan and 3D bridge
+   * rebuilds run off the UI thread on a snapshot of the fields they read (see
+   * ViewSnapshot), so the frame rate no longer depends on their cost.
+   * job_cancel is set only in a job's state; the compute loops poll it to stop
+   * a stale job. phase_view_fixed, also job-only, makes the phase window the
+   * one the UI resolved (phase_view_*) instead of refitting the history.
+   * async_views = false computes them on the UI thread as before (--shot). */
+  bool async_views = true;
+  std::shared_ptr<ViewJob> fractal_job, basin_job, scan_job, bridge_job;
+  std::vector<std::shared_ptr<ViewJob>> retired_jobs; /* cancelled, not yet joined */
+  const dynsys::pool::Cancel *job_cancel = nullptr;
+  bool phase_view_fixed = false;
+  /* Fractal and basin views are composed from world-aligned tiles kept in
+   * an LRU cache (tile_cache.h), shared with the job snapshots, so panning,
+   * zooming back and revisiting only compute what was never on screen.
+   * system_hash (of the compiled text) is part of every tile key.
+   * Tiles are sampled on a power-of-two grid and resampled to the view, so
+   * the cache is opt-in: tile_cache_mb = 0 (the default) renders whole
+   * views directly at their own pixel pitch. */
+  std::uint64_t system_hash = 0;
+  int tile_cache_mb = 0;
+  std::shared_ptr<ViewTileCache> view_tiles = std::make_shared<ViewTileCache>(0);
+  long fractal_tiles_reused = 0, fractal_tiles_computed = 0;
+  long basin_tiles_reused = 0, basin_tiles_computed = 0;
   int window_width = 1100;
   int window_height = 820;
   std::string screenshot_msg;     /* transient "saved <path>" toast */
@@ -447,7 +490,9 @@ struct AppState {
   double boxdim_value = 0.0;
   double boxdim_r2 = 0.0;
   long boxdim_n_points = 0;
+  int boxdim_dim = 2;
   std::string boxdim_msg;
+  bool boxdim_full_state = false;  /* all state variables, not the 2D plane */
 
   /* PHASE D step 2 (foundation): limit-cycle period & amplitude of the
    * current trajectory (oscillating ODEs). */
@@ -456,6 +501,16 @@ struct AppState {
   double lc_amplitude = 0.0;
   std::string lc_msg;
 
+  /* Power spectrum (Welch, analysis::power_spectrum) of one state variable
+   * or observable over the trajectory history, refreshed a few times a
+   * second while the panel is open. */
+  char spectrum_observable[128] = "";
+  bool spectrum_log = true;
+  dynsys::analysis::PowerSpectrum spectrum;
+  std::string spectrum_of;         /* name the cached spectrum was built for */
+  double spectrum_t_last = 0.0;    /* history.back().t at that time */
+  double spectrum_built_at = -1.0; /* glfwGetTime() of the last rebuild */
+
   /* PHASE D step 2: limit-cycle continuation diagram. Sweep a parameter,
    * measure the periodic orbit's period & amplitude at each value, and plot
    * both curves vs the parameter (amplitude growing from zero marks a Hopf
@@ -513,19 +568,36 @@ struct AppState {
    *   - Julia      = same map, fixed c, sweeping the initial point
    *   - logistic bifurcation = the real-axis analog of the Mandelbrot set
    */
-  enum class FractalMode { ParameterSpace /*Mandelbrot-like*/, StateSpace /*Julia-like*/, Buddhabrot /*trajectory density*/ };
+  enum class FractalMode { ParameterSpace /*Mandelbrot-like*/, StateSpace /*Julia-like*/, Buddhabrot /*trajectory density*/,
+                           DeepZoom /*parameter space by perturbation, past double precision*/ };
   FractalMode fractal_mode = FractalMode::ParameterSpace;
   double fractal_xmin = -2.5, fractal_xmax = 1.0;   /* view window (re) */
   double fractal_ymin = -1.5, fractal_ymax = 1.5;   /* view window (im) */
   /* Buddhabrot accumulation (trajectory-density rendering) */
-  std::vector<uint32_t> buddha_accum;
-  int buddha_w = 0, buddha_h = 0;
-  uint32_t buddha_max = 1u;
-  long buddha_samples = 0;
-  uint32_t buddha_rng = 22695477u;
+  dynsys::analysis::BuddhaState buddha;
+  bool buddha_importance = true; /* Metropolis sampling of c instead of uniform */
   int fractal_max_iter = 200;
   double fractal_escape_r = 4.0;
   bool fractal_smooth = true;
+  /* Mariani-Silver boundary tracing (boundary_trace.h): iterate only
+   * rectangle borders and fill uniform ones. Approximate: detail inside a
+   * uniform frame is lost, so it is off unless the user turns it on. */
+  bool fractal_boundary_trace = false;
+  /* Brent periodicity check: stop iterating a point once its orbit revisits
+   * a saved reference (attracting cycle), optionally colouring it by period. */
+  bool fractal_periodicity = true;
+  bool fractal_color_period = false;
+  double fractal_iterated_fraction = 1.0; /* share of samples iterated last pass */
+  /* Deep zoom: the view is a double-double centre plus half extents, so it
+   * keeps resolving far below the ~1e-13 width where xmin/xmax run out of
+   * bits. One high-precision reference orbit, pixels as perturbations. */
+  dynsys::ir::DD fractal_deep_cx{-0.75, 0.0}, fractal_deep_cy{0.0, 0.0};
+  double fractal_deep_hw = 1.75, fractal_deep_hh = 1.5;
+  bool fractal_deep_series = true;  /* series approximation on/off */
+  int fractal_deep_skip = 0;        /* iterations the series skipped */
+  int fractal_deep_refs = 0;        /* reference orbits used last pass */
+  long fractal_deep_glitched = 0;   /* pixels no reference could fix */
+  std::string fractal_deep_status;  /* non-empty: why deep zoom fell back */
   int fractal_param_cx_index = 0;  /* which params are the two plane axes */
   int fractal_param_cy_index = 1;  /* (ParameterSpace mode) */
   /* Julia constant for StateSpace mode = current values of those params. */
@@ -586,8 +658,24 @@ struct AppState {
   int basin_res = 1;             /* unused placeholder for future supersampling */
   double basin_cluster_tol = 1e-2;
   bool basin_shade_speed = true; /* modulate brightness by convergence speed */
+  bool basin_memoize = false;    /* stop orbits in already-classified cells (cell mapping) */
+  bool basin_adaptive = false;   /* integrate only near basin boundaries (quadtree) */
+  bool basin_fingerprint = false; /* label cycles and chaotic sets by their signature */
   int basin_attractor_count = 0;
+  int basin_n_cycles = 0, basin_n_chaotic = 0; /* of basin_attractor_count */
   long basin_n_converged = 0, basin_n_diverged = 0, basin_n_nonconvergent = 0;
+  /* 3-D volume mode: a third state axis, classified slice by slice into a
+   * run-length label volume; the view shows one slice or the first-hit
+   * surface looking down z. Slices land coarse to fine. */
+  bool basin_volume_mode = false;
+  int basin_z_index = 2;
+  double basin_z_min = -2.0, basin_z_max = 2.0;
+  int basin_vol_res = 48;        /* cells per axis */
+  int basin_vol_slice = 24;
+  bool basin_vol_project = false; /* first-hit rendering instead of one slice */
+  std::shared_ptr<const dynsys::analysis::BasinVolume> basin_vol;
+  dynsys::analysis::BasinVolume basin_vol_work; /* resumed one slice per frame when not async */
+  char basin_vol_path[256] = "dynsys_basins.dsbv";
 
   /* PHASE D: equilibrium continuation (the MatCont-style bifurcation
    * diagram) — drawing/view state. The sweep scalars (cont_param,
@@ -2619,6 +2707,7 @@ bool compile_system(AppState &app, const char *system_text, std::string *error)
     else if (fam >= 0)
       app.bridge_mode = AppState::BridgeMode::ProjectionSolid;
   }
+  app.system_hash = dynsys::tiles::Hasher().add(system_text).value(); /* keys the view tiles */
   app.fractal_dirty = true;
   app.basin_dirty = true;
   app.scan_view_init = false;
@@ -3974,6 +4063,11 @@ bool eval_phase_component(AppState &app, const State &s, size_t component, doubl
 
 PlotBounds current_phase_bounds(AppState &app, size_t ix, size_t iy) {
   PlotBounds b{};
+  if (app.phase_view_fixed) {
+    b.xmin = app.phase_view_xmin; b.xmax = app.phase_view_xmax;
+    b.ymin = app.phase_view_ymin; b.ymax = app.phase_view_ymax;
+    return sanitize_bounds(b);
+  }
   if (!app.phase_auto_bounds) {
     b.xmin = app.phase_x_min;
     b.xmax = app.phase_x_max;
@@ -5035,116 +5129,227 @@ ImU32 fractal_palette(double t) {
   return IM_COL32(r, g, b, 255);
 }
 
-/* Buddhabrot: instead of colouring each c by its escape time, we accumulate the
- * TRAJECTORIES of escaping points into a density histogram. Points that escape
- * leave a ghostly trace of where their orbit wandered; summed over many samples
- * this produces the famous Buddha-like figure. This is meaningful for the
- * complex-quadratic map z->z^2+c (state-space orbit in the (Re,Im) plane); for
- * other systems we fall back to the normal escape-time fractal.
- *
- * We render progressively: each call adds another batch of random samples to a
- * persistent accumulation buffer (app.buddha_accum) and re-maps it to colour,
- * so the image converges and sharpens the longer you watch. */
-void compute_buddhabrot(AppState &app, int W, int H, std::vector<uint32_t> &out, bool reset) {
-  if (W < 2) W = 2;
-  if (H < 2) H = 2;
-  const size_t npix = (size_t)W * H;
-  out.assign(npix, 0xff000000u);
-  const size_t n = app.state_names.size();
-  if (n < 2 || app.mode != SystemMode::Map) return;
-
-  if (reset || app.buddha_accum.size() != npix ||
-      app.buddha_w != W || app.buddha_h != H) {
-    app.buddha_accum.assign(npix, 0u);
-    app.buddha_samples = 0;
-    app.buddha_w = W; app.buddha_h = H;
-    app.buddha_max = 1u;
-  }
-
-  const double x0 = app.fractal_xmin, x1 = app.fractal_xmax;
-  const double y0 = app.fractal_ymin, y1 = app.fractal_ymax;
-  const double R2 = app.fractal_escape_r * app.fractal_escape_r;
-  const int maxit = std::max(20, app.fractal_max_iter);
-
-  State cur = make_state_like(n, 0.0), nx = make_state_like(n, 0.0);
-  std::vector<double> saved = app.param_values;
-  char err[128] = {0};
+/* ============================================================
+ * Background view jobs.
+ * A heavy view (escape-time / deep-zoom fractal, basins, 2-parameter scan,
+ * 3D bridge) is rebuilt by a job thread on a private AppState, so the UI
+ * keeps drawing while it works. The UI thread copies only what the views
+ * read into a ViewSnapshot; the job fills a fresh AppState from it. The job runs the view's progressive
+ * levels coarse -> fine; each finished level is handed back as a landing, a
+ * closure the UI thread runs on its next frame to upload the result into the
+ * view's texture / buffers and copy the stats the HUD shows. The displayed
+ * texture is the front buffer and the job's image the back buffer: the
+ * texture only ever changes to a complete level, and a level the UI had no
+ * time to land is replaced by the next one.
+ * A job is never waited for. When the view or the parameters change, the
+ * running job is cancelled through its pool::Cancel (the compute loops poll
+ * app.job_cancel) and retired; retired jobs are joined once they notice.
+ * ============================================================ */
 
-  /* a deterministic-ish RNG so the image is reproducible per session */
-  uint32_t &rng = app.buddha_rng;
-  auto urand = [&]() { rng = rng * 1664525u + 1013904223u; return (double)(rng >> 8) * (1.0 / 16777216.0); };
+/* The inputs of the heavy views: the compiled system, the parameters, the
+ * view windows and each view's settings. The orbit history, plot buffers,
+ * analysis results and GL objects are left behind. The phase-plane window is
+ * the one the UI last resolved (phase_view_*), since the history it was
+ * fitted to is not copied. */
+struct ViewSnapshot {
+  /* compiled system */
+  SystemMode mode = SystemMode::ODE;
+  Integrator integrator = Integrator::RK4;
+  double dt = 0.01, adaptive_tol = 1e-6, adaptive_dt_min = 1e-7, adaptive_dt_max = 0.1;
+  std::vector<std::string> state_names;
+  std::vector<AppState::Definition> definitions;
+  std::vector<AppState::Observable> observables;
+  std::vector<node_t *> equations;
+  std::vector<dynsys::ir::Program> equation_programs, next_equation_programs;
+  std::vector<dynsys::ir::Program> definition_programs, observable_programs;
+  dynsys::ir::Scratch eval_scratch;
+  std::uint64_t system_hash = 0;
+  bool use_ast_fallback = false;
+  /* parameters and seed */
+  std::vector<AppState::Param> params;
+  std::vector<double> param_values;
+  State start, current;
+  /* phase-plane window (basins) */
+  int phase_x_index = 0, phase_y_index = 1;
+  bool phase_auto_bounds = true, phase_bounds_valid = false;
+  float phase_x_min = 0, phase_x_max = 0, phase_y_min = 0, phase_y_max = 0;
+  double phase_view_xmin = 0, phase_view_xmax = 0, phase_view_ymin = 0, phase_view_ymax = 0;
+  /* escape-time / deep-zoom fractal */
+  AppState::FractalMode fractal_mode = AppState::FractalMode::ParameterSpace;
+  double fractal_xmin = 0, fractal_xmax = 0, fractal_ymin = 0, fractal_ymax = 0;
+  dynsys::ir::DD fractal_deep_cx{}, fractal_deep_cy{};
+  double fractal_deep_hw = 0, fractal_deep_hh = 0;
+  bool fractal_deep_series = true;
+  int fractal_max_iter = 0;
+  double fractal_escape_r = 0;
+  bool fractal_smooth = true, fractal_color_period = false, fractal_periodicity = true, fractal_boundary_trace = false;
+  int fractal_param_cx_index = 0, fractal_param_cy_index = 1;
+  /* basins */
+  int basin_steps = 0;
+  double basin_cluster_tol = 0;
+  bool basin_adaptive = false, basin_fingerprint = false, basin_memoize = false, basin_shade_speed = true;
+  int basin_vol_res = 0, basin_z_index = 2;
+  double basin_z_min = 0, basin_z_max = 0;
+  /* 2-parameter scan */
+  int scan_px_index = 0, scan_py_index = 1;
+  double scan_xmin = 0, scan_xmax = 0, scan_ymin = 0, scan_ymax = 0;
+  int scan_iterations = 0, scan_transient = 0;
+  double lyapunov_epsilon = 1e-6;
+  /* 3D bridge */
+  char bif_param[64] = "";
+  char bif_observable[128] = "";
+  double bif_start = 0, bif_end = 0;
+  AppState::BridgeMode bridge_mode = AppState::BridgeMode::ProjectionSolid;
+  AppState::BridgeFamily bridge_family = AppState::BridgeFamily::Quadratic;
+  float bridge_height = 0;
+  int bridge_mandel_res = 0, bridge_bif_slices = 0, bridge_bif_keep = 0, bridge_p2_slices = 0;
+  bool bridge_color_by_period = true, bridge_show_bifurcation = true, bridge_show_mandelbrot = true;
+  char bridge_param2[64] = "";
+  double bridge_p2_min = 0, bridge_p2_max = 0;
+  /* shared */
+  double perf_throttle = 0;
+  int tile_cache_mb = 0;
+  std::shared_ptr<ViewTileCache> view_tiles;
+};
 
-  /* trajectory buffer to record visited (re,im) before knowing if it escapes */
-  static std::vector<std::pair<float,float>> traj;
-  traj.clear();
+/* Copies the ViewSnapshot fields from src to dst: AppState -> snapshot on
+ * the UI thread, snapshot -> the job's AppState on the job thread. */
+template <class Dst, class Src>
+void copy_view_inputs(Dst &d, const Src &s) {
+  d.mode = s.mode; d.integrator = s.integrator; d.dt = s.dt;
+  d.adaptive_tol = s.adaptive_tol; d.adaptive_dt_min = s.adaptive_dt_min; d.adaptive_dt_max = s.adaptive_dt_max;
+  d.state_names = s.state_names; d.definitions = s.definitions; d.observables = s.observables;
+  d.equations = s.equations;
+  d.equation_programs = s.equation_programs; d.next_equation_programs = s.next_equation_programs;
+  d.definition_programs = s.definition_programs; d.observable_programs = s.observable_programs;
+  d.eval_scratch = s.eval_scratch; d.system_hash = s.system_hash; d.use_ast_fallback = s.use_ast_fallback;
+  d.params = s.params; d.param_values = s.param_values; d.start = s.start; d.current = s.current;
+  d.phase_x_index = s.phase_x_index; d.phase_y_index = s.phase_y_index;
+  d.phase_auto_bounds = s.phase_auto_bounds; d.phase_bounds_valid = s.phase_bounds_valid;
+  d.phase_x_min = s.phase_x_min; d.phase_x_max = s.phase_x_max; d.phase_y_min = s.phase_y_min; d.phase_y_max = s.phase_y_max;
+  d.phase_view_xmin = s.phase_view_xmin; d.phase_view_xmax = s.phase_view_xmax;
+  d.phase_view_ymin = s.phase_view_ymin; d.phase_view_ymax = s.phase_view_ymax;
+  d.fractal_mode = s.fractal_mode;
+  d.fractal_xmin = s.fractal_xmin; d.fractal_xmax = s.fractal_xmax; d.fractal_ymin = s.fractal_ymin; d.fractal_ymax = s.fractal_ymax;
+  d.fractal_deep_cx = s.fractal_deep_cx; d.fractal_deep_cy = s.fractal_deep_cy;
+  d.fractal_deep_hw = s.fractal_deep_hw; d.fractal_deep_hh = s.fractal_deep_hh; d.fractal_deep_series = s.fractal_deep_series;
+  d.fractal_max_iter = s.fractal_max_iter; d.fractal_escape_r = s.fractal_escape_r; d.fractal_smooth = s.fractal_smooth;
+  d.fractal_color_period = s.fractal_color_period; d.fractal_periodicity = s.fractal_periodicity;
+  d.fractal_boundary_trace = s.fractal_boundary_trace;
+  d.fractal_param_cx_index = s.fractal_param_cx_index; d.fractal_param_cy_index = s.fractal_param_cy_index;
+  d.basin_steps = s.basin_steps; d.basin_cluster_tol = s.basin_cluster_tol; d.basin_adaptive = s.basin_adaptive;
+  d.basin_fingerprint = s.basin_fingerprint; d.basin_memoize = s.basin_memoize; d.basin_shade_speed = s.basin_shade_speed;
+  d.basin_vol_res = s.basin_vol_res; d.basin_z_index = s.basin_z_index; d.basin_z_min = s.basin_z_min; d.basin_z_max = s.basin_z_max;
+  d.scan_px_index = s.scan_px_index; d.scan_py_index = s.scan_py_index;
+  d.scan_xmin = s.scan_xmin; d.scan_xmax = s.scan_xmax; d.scan_ymin = s.scan_ymin; d.scan_ymax = s.scan_ymax;
+  d.scan_iterations = s.scan_iterations; d.scan_transient = s.scan_transient; d.lyapunov_epsilon = s.lyapunov_epsilon;
+  std::memcpy(d.bif_param, s.bif_param, sizeof(d.bif_param));
+  std::memcpy(d.bif_observable, s.bif_observable, sizeof(d.bif_observable));
+  d.bif_start = s.bif_start; d.bif_end = s.bif_end;
+  d.bridge_mode = s.bridge_mode; d.bridge_family = s.bridge_family; d.bridge_height = s.bridge_height;
+  d.bridge_mandel_res = s.bridge_mandel_res; d.bridge_bif_slices = s.bridge_bif_slices;
+  d.bridge_bif_keep = s.bridge_bif_keep; d.bridge_p2_slices = s.bridge_p2_slices;
+  d.bridge_color_by_period = s.bridge_color_by_period; d.bridge_show_bifurcation = s.bridge_show_bifurcation;
+  d.bridge_show_mandelbrot = s.bridge_show_mandelbrot;
+  std::memcpy(d.bridge_param2, s.bridge_param2, sizeof(d.bridge_param2));
+  d.bridge_p2_min = s.bridge_p2_min; d.bridge_p2_max = s.bridge_p2_max;
+  d.perf_throttle = s.perf_throttle; d.tile_cache_mb = s.tile_cache_mb; d.view_tiles = s.view_tiles;
+}
+
+struct ViewJob {
+  ViewSnapshot inputs;
+  dynsys::pool::Cancel cancel;
+  std::thread thread;
+  std::atomic<bool> finished{false};
+  std::mutex mu;
+  std::function<void(AppState &)> landing; /* newest result not yet landed */
+};
 
-  /* sample budget per call: enough to make progress, capped to stay responsive */
-  const int batch = 20000;
-  /* sample c over a slightly padded box so orbits that wander in from outside
-   * the view are represented too. */
-  const double sx0 = -2.2, sx1 = 0.8, sy0 = -1.4, sy1 = 1.4;
-  for (int sIdx = 0; sIdx < batch; ++sIdx) {
-    const double cre = sx0 + (sx1 - sx0) * urand();
-    const double cim = sy0 + (sy1 - sy0) * urand();
-    /* iterate z=0 under z^2+c, recording the orbit; if it escapes, splat it */
-    set_state_at(cur, 0, 0.0); set_state_at(cur, 1, 0.0);
-    for (size_t i = 2; i < n; ++i) set_state_at(cur, i, 0.0);
-    /* the complex-quadratic preset reads c from the FIRST two params (cx,cy) */
-    if (app.param_values.size() >= 1) app.param_values[0] = cre;
-    if (app.param_values.size() >= 2) app.param_values[1] = cim;
-    traj.clear();
-    bool escaped = false;
-    for (int it = 0; it < maxit; ++it) {
-      if (!step_map_state(app, cur, &nx, err, sizeof(err))) { escaped = false; break; }
-      const double xx = state_at(nx, 0), yy = state_at(nx, 1);
-      traj.emplace_back((float)xx, (float)yy);
-      if (!std::isfinite(xx) || xx * xx + yy * yy > R2) { escaped = true; break; }
-      std::swap(cur.v, nx.v); cur.t = nx.t;
-    }
-    if (escaped) {
-      for (const auto &pt : traj) {
-        if (pt.first < x0 || pt.first > x1 || pt.second < y0 || pt.second > y1) continue;
-        const int px = (int)((pt.first - x0) / (x1 - x0) * (W - 1) + 0.5);
-        const int py = (int)((pt.second - y0) / (y1 - y0) * (H - 1) + 0.5);
-        if (px < 0 || px >= W || py < 0 || py >= H) continue;
-        uint32_t &cell = app.buddha_accum[(size_t)py * W + px];
-        cell++;
-        if (cell > app.buddha_max) app.buddha_max = cell;
-      }
-    }
+bool job_cancelled(const AppState &app) {
+  return app.job_cancel != nullptr && app.job_cancel->cancelled();
+}
+
+void view_job_publish(ViewJob &job, std::function<void(AppState &)> landing) {
+  std::lock_guard<std::mutex> lk(job.mu);
+  job.landing = std::move(landing);
+}
+
+void retire_view_job(AppState &app, std::shared_ptr<ViewJob> &job) {
+  if (!job) return;
+  job->cancel.cancel();
+  app.retired_jobs.push_back(std::move(job));
+  job.reset();
+}
+
+/* Starts `work` in the given job slot, retiring the job that ran there. The
+ * UI thread takes a ViewSnapshot of app; the job thread builds its private
+ * AppState from it, so nothing else of app is copied. */
+void start_view_job(AppState &app, std::shared_ptr<ViewJob> &slot,
+                    std::function<void(AppState &, ViewJob &)> work) {
+  retire_view_job(app, slot);
+  auto job = std::make_shared<ViewJob>();
+  copy_view_inputs(job->inputs, app);
+  ViewJob *j = job.get();
+  job->thread = std::thread([j, work]() {
+    auto snap = std::make_unique<AppState>();
+    copy_view_inputs(*snap, j->inputs);
+    snap->phase_view_fixed = snap->phase_auto_bounds && snap->phase_bounds_valid;
+    snap->job_cancel = &j->cancel;
+    work(*snap, *j);
+    j->finished.store(true, std::memory_order_release);
+  });
+  slot = std::move(job);
+}
+
+/* UI thread, once per frame: lands the job's newest result. Returns true
+ * while the job is still computing; a finished job is joined and cleared. */
+bool land_view_job(AppState &app, std::shared_ptr<ViewJob> &slot) {
+  if (!slot) return false;
+  const bool done = slot->finished.load(std::memory_order_acquire);
+  std::function<void(AppState &)> landing;
+  {
+    std::lock_guard<std::mutex> lk(slot->mu);
+    landing.swap(slot->landing);
   }
-  app.buddha_samples += batch;
-  app.param_values = saved; sync_param_values(app);
+  if (landing) landing(app);
+  if (!done) return true;
+  slot->thread.join();
+  slot.reset();
+  return false;
+}
 
-  /* map accumulated density -> colour. Use a robust high-percentile as the
-   * white point (a few hot pixels shouldn't wash everything out) and a steep
-   * curve so the structure glows on a DARK background rather than a bright haze
-   * swamping it. */
-  uint32_t hi = 1;
-  {
-    /* find ~99.5th percentile of nonzero counts as the white point */
-    std::vector<uint32_t> nz;
-    nz.reserve(npix / 4);
-    for (size_t i = 0; i < npix; ++i) if (app.buddha_accum[i]) nz.push_back(app.buddha_accum[i]);
-    if (!nz.empty()) {
-      size_t k = (size_t)(nz.size() * 0.995);
-      if (k >= nz.size()) k = nz.size() - 1;
-      std::nth_element(nz.begin(), nz.begin() + k, nz.end());
-      hi = std::max<uint32_t>(1, nz[k]);
+/* Joins retired jobs that have stopped. */
+void reap_view_jobs(AppState &app) {
+  auto &r = app.retired_jobs;
+  for (size_t i = 0; i < r.size();) {
+    if (r[i]->finished.load(std::memory_order_acquire)) {
+      r[i]->thread.join();
+      r.erase(r.begin() + (std::ptrdiff_t)i);
+    } else {
+      ++i;
     }
   }
-  const double inv_hi = 1.0 / (double)hi;
-  for (size_t i = 0; i < npix; ++i) {
-    const uint32_t d = app.buddha_accum[i];
-    double t = (double)d * inv_hi;       /* 0..1 (clamped) against the white point */
-    if (t > 1.0) t = 1.0;
-    t = std::pow(t, 0.45);               /* lift faint filaments */
-    const uint8_t v = (uint8_t)(t * 255.0);
-    const uint8_t r = v;                 /* warm parchment */
-    const uint8_t g = (uint8_t)(v * 0.82);
-    const uint8_t b = (uint8_t)(v * 0.55);
-    out[i] = 0xff000000u | r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
-  }
+}
+
+/* Cancels every job and waits for all of them (shutdown). */
+void stop_view_jobs(AppState &app) {
+  retire_view_job(app, app.fractal_job);
+  retire_view_job(app, app.basin_job);
+  retire_view_job(app, app.scan_job);
+  retire_view_job(app, app.bridge_job);
+  for (auto &j : app.retired_jobs) j->thread.join();
+  app.retired_jobs.clear();
+}
+
+/* Uploads an RGBA image into a view texture (created on first use). */
+void upload_view_texture(GLuint &tex, int W, int H, const std::vector<uint32_t> &img, GLint mag_filter) {
+  if (tex == 0) glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, W, H, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
 /* Thread-safe stepper for parallel grid sweeps (basins). Owns its OWN eval
@@ -5210,24 +5415,245 @@ struct ThreadStepper {
   }
 };
 
-void compute_fractal_image(AppState &app, int W, int H, std::vector<uint32_t> &out, int step = 1) {
+/* Buddhabrot: instead of colouring each c by its escape time, we accumulate the
+ * TRAJECTORIES of escaping points into a density histogram. Points that escape
+ * leave a ghostly trace of where their orbit wandered; summed over many samples
+ * this produces the famous Buddha-like figure. This is meaningful for the
+ * complex-quadratic map z->z^2+c (state-space orbit in the (Re,Im) plane); for
+ * other systems we fall back to the normal escape-time fractal.
+ *
+ * We render progressively: each call adds another batch of samples to a
+ * persistent accumulation (app.buddha, see accumulate_buddhabrot) and re-maps it
+ * to colour, so the image converges and sharpens the longer you watch. Samples
+ * run on the thread pool, one ThreadStepper per worker with c written into its
+ * private parameter copy. With buddha_importance, c is drawn by Metropolis-
+ * Hastings, so a zoomed view fills in instead of waiting for the rare uniform
+ * sample whose orbit happens to pass through it. */
+void compute_buddhabrot(AppState &app, int W, int H, std::vector<uint32_t> &out, bool reset) {
   if (W < 2) W = 2;
   if (H < 2) H = 2;
-  if (step < 1) step = 1;
-  out.assign((size_t)W * H, 0xff000000u);
+  const size_t npix = (size_t)W * H;
+  out.assign(npix, 0xff000000u);
   const size_t n = app.state_names.size();
-  if (n < 2) return; /* needs a 2D plane */
-  if (app.mode != SystemMode::Map) return; /* escape-time is for maps */
+  if (n < 2 || app.mode != SystemMode::Map) return;
+  if (reset) app.buddha = dynsys::analysis::BuddhaState();
+
+  dynsys::analysis::BuddhaOptions opt;
+  opt.xmin = app.fractal_xmin; opt.xmax = app.fractal_xmax;
+  opt.ymin = app.fractal_ymin; opt.ymax = app.fractal_ymax;
+  opt.width = W; opt.height = H;
+  opt.dim = (int)n;
+  opt.max_iter = std::max(20, app.fractal_max_iter);
+  opt.escape_r = app.fractal_escape_r;
+  opt.importance = app.buddha_importance;
+  /* sample budget per call: enough to make progress, capped to stay responsive */
+  const bool thread_safe = !app.use_ast_fallback;
+  opt.samples = 20000L * (thread_safe ? (long)dynsys::pool::threads() : 1L);
+  if (thread_safe) {
+    auto make_step = [&app](int /*tid*/) -> dynsys::analysis::BuddhaStepFn {
+      auto stepper = std::make_shared<ThreadStepper>();
+      stepper->init(app);
+      return [stepper](double cre, double cim, const double *x, double *xn) {
+        /* the complex-quadratic preset reads c from the FIRST two params (cx,cy) */
+        stepper->set_param(0, cre);
+        stepper->set_param(1, cim);
+        return stepper->map_step(x, xn);
+      };
+    };
+    dynsys::analysis::accumulate_buddhabrot(make_step, opt, &app.buddha);
+  } else {
+    const std::vector<double> saved = app.param_values;
+    State cur = make_state_like(n, 0.0), nx = make_state_like(n, 0.0);
+    char err[128] = {0};
+    dynsys::analysis::BuddhaStepFn step = [&](double cre, double cim, const double *x, double *xn) {
+      if (app.param_values.size() >= 1) app.param_values[0] = cre;
+      if (app.param_values.size() >= 2) app.param_values[1] = cim;
+      for (size_t i = 0; i < n; ++i) set_state_at(cur, i, x[i]);
+      if (!step_map_state(app, cur, &nx, err, sizeof(err))) return false;
+      for (size_t i = 0; i < n; ++i) xn[i] = state_at(nx, i);
+      return true;
+    };
+    dynsys::analysis::accumulate_buddhabrot([&step](int) { return step; }, opt, &app.buddha, false);
+    app.param_values = saved; sync_param_values(app);
+  }
 
-  /* Honor the performance governor: when throttling, cap the per-pixel
-   * iteration budget (down to ~25% at full throttle, floor 10) so a deep zoom
-   * on a heavy fractal can't lock up the frame. The progressive refine still
-   * sharpens later once load drops and the throttle eases. */
+  /* map accumulated density -> colour. Use a robust high-percentile as the
+   * white point (a few hot pixels shouldn't wash everything out) and a steep
+   * curve so the structure glows on a DARK background rather than a bright haze
+   * swamping it. */
+  const std::vector<uint64_t> &acc = app.buddha.accum;
+  uint64_t hi = 1;
+  {
+    /* find ~99.5th percentile of nonzero counts as the white point */
+    std::vector<uint64_t> nz;
+    nz.reserve(npix / 4);
+    for (size_t i = 0; i < npix; ++i) if (acc[i]) nz.push_back(acc[i]);
+    if (!nz.empty()) {
+      size_t k = (size_t)(nz.size() * 0.995);
+      if (k >= nz.size()) k = nz.size() - 1;
+      std::nth_element(nz.begin(), nz.begin() + k, nz.end());
+      hi = std::max<uint64_t>(1, nz[k]);
+    }
+  }
+  const double inv_hi = 1.0 / (double)hi;
+  for (size_t i = 0; i < npix; ++i) {
+    double t = (double)acc[i] * inv_hi;  /* 0..1 (clamped) against the white point */
+    if (t > 1.0) t = 1.0;
+    t = std::pow(t, 0.45);               /* lift faint filaments */
+    const uint8_t v = (uint8_t)(t * 255.0);
+    const uint8_t r = v;                 /* warm parchment */
+    const uint8_t g = (uint8_t)(v * 0.82);
+    const uint8_t b = (uint8_t)(v * 0.55);
+    out[i] = 0xff000000u | r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
+  }
+}
+
+/* Boundary tracing (boundary_trace.h) for the escape-time view: on
+ * deep-iteration views the large bounded interior is paid for only along its
+ * outline. The fill assumes connected colour regions, as for Mandelbrot /
+ * Julia-type maps; on other maps, and wherever a feature is thinner than the
+ * sample spacing, the traced image differs from brute force. The panel
+ * toggle (fractal_boundary_trace) opts in. */
+/* Honor the performance governor: when throttling, cap the per-pixel
+ * iteration budget (down to ~25% at full throttle, floor 10) so a deep zoom
+ * on a heavy fractal can't lock up the frame. The progressive refine still
+ * sharpens later once load drops and the throttle eases. */
+int fractal_iteration_budget(const AppState &app) {
   int maxit = std::max(10, app.fractal_max_iter);
   if (app.perf_throttle > 0.02) {
     maxit = (int)(maxit * (1.0 - 0.75 * app.perf_throttle));
     if (maxit < 10) maxit = 10;
   }
+  return maxit;
+}
+
+/* colour of an orbit that left the escape radius at iteration `it` with
+ * |x|^2 = r2 (smooth: fractional escape count) */
+uint32_t fractal_escape_color(const AppState &app, int it, double r2) {
+  double mu = it;
+  if (app.fractal_smooth && r2 > 1.0) mu = it + 1.0 - std::log(std::log(std::sqrt(r2))) / std::log(2.0);
+  const double t = std::fmod(mu * 0.04, 1.0);
+  return fractal_palette(t < 0 ? t + 1.0 : t);
+}
+
+/* ---------------------------------------------------------------
+ * View tiles (tile_cache.h)
+ * ---------------------------------------------------------------
+ * Composes a W x H view of `win` from cached tiles, `coarsen` levels
+ * coarser than its own resolution. Missing tiles are made by
+ * compute(tile window, tile) and cached, unless the job was cancelled
+ * meanwhile: a partial tile must never be reused. Returns false, with
+ * `out` untouched, when the cache is off or the view can't be tiled;
+ * the caller then renders the view directly. */
+template <class T>
+bool compose_view_tiles(AppState &app, std::uint64_t content, const dynsys::tiles::Window &win, int W, int H,
+                        int coarsen, const std::function<void(const dynsys::tiles::Window &, ViewTile &)> &compute,
+                        std::vector<T> ViewTile::*field, std::vector<T> &out, long *reused, long *computed) {
+  *reused = *computed = 0;
+  if (app.tile_cache_mb <= 0 || !app.view_tiles) return false;
+  const dynsys::tiles::Range range = dynsys::tiles::covering(win, W, H, coarsen);
+  if (range.empty()) return false;
+  const size_t tile_len = (size_t)dynsys::tiles::kTile * dynsys::tiles::kTile;
+  std::vector<std::shared_ptr<const ViewTile>> held; /* keeps evicted tiles alive */
+  std::vector<const T *> data;
+  held.reserve(range.count());
+  data.reserve(range.count());
+  for (int64_t ty = range.ty0; ty <= range.ty1; ++ty) {
+    for (int64_t tx = range.tx0; tx <= range.tx1; ++tx) {
+      const dynsys::tiles::Key key{content, range.level, tx, ty};
+      std::shared_ptr<const ViewTile> t = app.view_tiles->find(key);
+      if (t) {
+        ++*reused;
+      } else {
+        auto fresh = std::make_shared<ViewTile>();
+        compute(dynsys::tiles::tile_window(range.level, tx, ty), *fresh);
+        if (job_cancelled(app)) return true; /* the job drops this view anyway */
+        if (((*fresh).*field).size() != tile_len) return false;
+        app.view_tiles->insert(key, fresh, fresh->bytes());
+        t = std::move(fresh);
+        ++*computed;
+      }
+      data.push_back(((*t).*field).data());
+      held.push_back(std::move(t));
+    }
+  }
+  dynsys::tiles::compose(win, W, H, range, data, out);
+  return true;
+}
+
+/* true when every tile a W x H view of `win` needs is already cached, so
+ * it can skip its coarse preview levels */
+bool view_tiles_cached(const AppState &app, std::uint64_t content, const dynsys::tiles::Window &win, int W, int H) {
+  if (app.tile_cache_mb <= 0 || !app.view_tiles) return false;
+  const dynsys::tiles::Range range = dynsys::tiles::covering(win, W, H);
+  if (range.empty()) return false;
+  for (int64_t ty = range.ty0; ty <= range.ty1; ++ty)
+    for (int64_t tx = range.tx0; tx <= range.tx1; ++tx)
+      if (!app.view_tiles->contains({content, range.level, tx, ty})) return false;
+  return true;
+}
+
+/* Everything besides the window that changes an escape-time sample. */
+std::uint64_t fractal_tile_content(const AppState &app) {
+  const bool param_mode = app.fractal_mode == AppState::FractalMode::ParameterSpace && !app.params.empty();
+  dynsys::tiles::Hasher h;
+  h.add("fractal").add(app.system_hash).add(param_mode);
+  int cx = -1, cy = -1; /* parameters set per sample from the plane */
+  if (param_mode) {
+    cx = std::max(0, std::min(app.fractal_param_cx_index, (int)app.params.size() - 1));
+    cy = std::max(0, std::min(app.fractal_param_cy_index, (int)app.params.size() - 1));
+    h.add(cx).add(cy);
+  }
+  for (size_t i = 0; i < app.param_values.size(); ++i)
+    if ((int)i != cx && (int)i != cy) h.add(app.param_values[i]);
+  for (size_t i = 0; i < app.state_names.size(); ++i) h.add(state_at(app.start, i));
+  h.add(fractal_iteration_budget(app)).add(app.fractal_escape_r).add(app.fractal_smooth)
+   .add(app.fractal_color_period).add(app.fractal_periodicity).add(app.fractal_boundary_trace);
+  return h.value();
+}
+
+void compute_fractal_image(AppState &app, int W, int H, std::vector<uint32_t> &out, int step = 1);
+
+/* The escape-time view composed from tiles; a progressive `step` of 2^k
+ * samples k levels coarser. Each missing tile is a kTile x kTile
+ * compute_fractal_image of its own window. */
+bool compose_fractal_tiles(AppState &app, int W, int H, std::vector<uint32_t> &out, int step) {
+  if (app.state_names.size() < 2 || app.mode != SystemMode::Map) return false;
+  int coarsen = 0;
+  while ((1 << coarsen) < step) ++coarsen;
+  const dynsys::tiles::Window win{app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax};
+  double iterated = 0.0;
+  auto compute = [&](const dynsys::tiles::Window &tw, ViewTile &t) {
+    app.fractal_xmin = tw.x0; app.fractal_xmax = tw.x1;
+    app.fractal_ymin = tw.y0; app.fractal_ymax = tw.y1;
+    compute_fractal_image(app, dynsys::tiles::kTile, dynsys::tiles::kTile, t.rgba, 1);
+    app.fractal_xmin = win.x0; app.fractal_xmax = win.x1;
+    app.fractal_ymin = win.y0; app.fractal_ymax = win.y1;
+    iterated += app.fractal_iterated_fraction;
+  };
+  out.assign((size_t)W * H, 0xff000000u);
+  if (!compose_view_tiles(app, fractal_tile_content(app), win, W, H, coarsen, compute, &ViewTile::rgba, out,
+                          &app.fractal_tiles_reused, &app.fractal_tiles_computed))
+    return false;
+  app.fractal_iterated_fraction = app.fractal_tiles_computed > 0 ? iterated / app.fractal_tiles_computed : 0.0;
+  return true;
+}
+
+bool fractal_tiles_cached(const AppState &app, int W, int H) {
+  return view_tiles_cached(app, fractal_tile_content(app),
+                           {app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax}, W, H);
+}
+
+void compute_fractal_image(AppState &app, int W, int H, std::vector<uint32_t> &out, int step) {
+  if (W < 2) W = 2;
+  if (H < 2) H = 2;
+  if (step < 1) step = 1;
+  out.assign((size_t)W * H, 0xff000000u);
+  const size_t n = app.state_names.size();
+  if (n < 2) return; /* needs a 2D plane */
+  if (app.mode != SystemMode::Map) return; /* escape-time is for maps */
+
+  const int maxit = fractal_iteration_budget(app);
   const double R2 = app.fractal_escape_r * app.fractal_escape_r;
   const double x0 = app.fractal_xmin, x1 = app.fractal_xmax;
   const double y0 = app.fractal_ymin, y1 = app.fractal_ymax;
@@ -5243,87 +5669,274 @@ void compute_fractal_image(AppState &app, int W, int H, std::vector<uint32_t> &o
   /* Save params we will temporarily override (param mode, serial path only). */
   std::vector<double> saved = app.param_values;
 
-  /* Per-pixel escape/convergence work for one row py, using a stepper `st` that
-   * owns private eval scratch + a private parameter snapshot (so multiple
-   * threads can run disjoint rows safely). Mirrors the serial logic exactly. */
-  auto do_row = [&](ThreadStepper &st, int py) {
+  /* Per-thread state: a stepper that owns private eval scratch + a private
+   * parameter snapshot (so multiple threads can run disjoint work safely),
+   * the orbit buffers, and a count of samples actually iterated. */
+  struct Worker {
+    ThreadStepper st;
+    std::vector<double> cur, nx;
+    dynsys::period::Brent brent;
+    long iterated = 0;
+  };
+  const bool periodicity = app.fractal_periodicity;
+
+  /* Escape/convergence colour of the sample at pixel (px, py). Identical for
+   * the brute-force and the boundary-traced paths. */
+  auto pixel_color = [&](Worker &w, int px, int py) -> uint32_t {
+    ++w.iterated;
+    const double a_re = x0 + (x1 - x0) * (double)px / (W - 1);
     const double b_im = y0 + (y1 - y0) * (double)py / (H - 1);
-    std::vector<double> sx(n), cur(n), nx(n);
-    for (int px = 0; px < W; px += step) {
-      const double a_re = x0 + (x1 - x0) * (double)px / (W - 1);
-      for (size_t i = 0; i < n; ++i) sx[i] = state_at(app.start, i);
-      if (param_mode) {
-        st.set_param(cxi, a_re);
-        st.set_param(cyi, b_im);
-      } else {
-        sx[0] = a_re; if (n > 1) sx[1] = b_im;
-      }
-      int it = 0; double r2 = 0.0;
-      for (size_t i = 0; i < n; ++i) cur[i] = sx[i];
-      bool escaped = false, converged = false; double conv_x = 0.0, conv_y = 0.0;
-      const bool allow_converge = app.params.empty();
-      for (; it < maxit; ++it) {
-        if (!st.map_step(cur.data(), nx.data())) { it = maxit; break; }
-        const double xx = nx[0], yy = (n > 1) ? nx[1] : 0.0;
-        r2 = xx * xx + yy * yy;
-        if (!std::isfinite(r2) || r2 > R2) { ++it; escaped = true; break; }
-        if (allow_converge) {
-          const double dx = xx - cur[0], dy = (n > 1) ? yy - cur[1] : 0.0;
-          if (dx * dx + dy * dy < 1e-20) { converged = true; conv_x = xx; conv_y = yy; ++it; break; }
-        }
-        std::swap(cur, nx);
-      }
-      uint32_t color = 0xff101014u;
-      if (escaped && it < maxit && r2 > R2) {
-        double mu = it;
-        if (app.fractal_smooth && r2 > 1.0) mu = it + 1.0 - std::log(std::log(std::sqrt(r2))) / std::log(2.0);
-        const double t = std::fmod(mu * 0.04, 1.0);
-        color = fractal_palette(t < 0 ? t + 1.0 : t);
-      } else if (converged) {
-        double ang = std::atan2(conv_y, conv_x) / (2.0 * 3.14159265358979) + 0.5;
-        const double shade = 1.0 - 0.6 * std::min(1.0, (double)it / 40.0);
-        uint32_t base = fractal_palette(std::fmod(ang, 1.0));
-        const uint8_t r = (uint8_t)(((base >> 0) & 0xff) * shade);
-        const uint8_t g = (uint8_t)(((base >> 8) & 0xff) * shade);
-        const uint8_t b = (uint8_t)(((base >> 16) & 0xff) * shade);
-        color = 0xff000000u | r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
-      }
-      for (int by = py; by < py + step && by < H; ++by)
-        for (int bx = px; bx < px + step && bx < W; ++bx)
-          out[(size_t)by * W + bx] = color;
+    std::vector<double> &cur = w.cur, &nx = w.nx;
+    for (size_t i = 0; i < n; ++i) cur[i] = state_at(app.start, i);
+    if (param_mode) {
+      w.st.set_param(cxi, a_re);
+      w.st.set_param(cyi, b_im);
+    } else {
+      cur[0] = a_re; if (n > 1) cur[1] = b_im;
+    }
+    int it = 0; double r2 = 0.0;
+    bool escaped = false, converged = false; double conv_x = 0.0, conv_y = 0.0;
+    const bool allow_converge = app.params.empty();
+    /* Brent cycle detection (fractal_period.h): stop once the orbit revisits
+     * a saved reference instead of burning the whole maxit budget on a point
+     * that is known to stay bounded. */
+    int period = 0;
+    if (periodicity) w.brent.reset(cur.data(), n);
+    for (; it < maxit; ++it) {
+      if (!w.st.map_step(cur.data(), nx.data())) { it = maxit; break; }
+      const double xx = nx[0], yy = (n > 1) ? nx[1] : 0.0;
+      r2 = xx * xx + yy * yy;
+      if (!std::isfinite(r2) || r2 > R2) { ++it; escaped = true; break; }
+      if (allow_converge) {
+        const double dx = xx - cur[0], dy = (n > 1) ? yy - cur[1] : 0.0;
+        if (dx * dx + dy * dy < 1e-20) { converged = true; conv_x = xx; conv_y = yy; ++it; break; }
+      }
+      if (periodicity && (period = w.brent.step(nx.data(), n)) > 0) { ++it; break; }
+      std::swap(cur, nx);
+    }
+    uint32_t color = 0xff101014u;
+    if (period > 0 && app.fractal_color_period) {
+      /* bounded, period-k: one palette hue per period, dimmed so the
+       * interior still reads as "in the set" next to the escape bands */
+      const uint32_t base = fractal_palette(std::fmod(0.137 * (period - 1) + 0.05, 1.0));
+      const uint8_t r = (uint8_t)(((base >> 0) & 0xff) * 0.55);
+      const uint8_t g = (uint8_t)(((base >> 8) & 0xff) * 0.55);
+      const uint8_t b = (uint8_t)(((base >> 16) & 0xff) * 0.55);
+      color = 0xff000000u | r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
+    } else if (escaped && it < maxit && r2 > R2) {
+      color = fractal_escape_color(app, it, r2);
+    } else if (converged) {
+      double ang = std::atan2(conv_y, conv_x) / (2.0 * 3.14159265358979) + 0.5;
+      const double shade = 1.0 - 0.6 * std::min(1.0, (double)it / 40.0);
+      uint32_t base = fractal_palette(std::fmod(ang, 1.0));
+      const uint8_t r = (uint8_t)(((base >> 0) & 0xff) * shade);
+      const uint8_t g = (uint8_t)(((base >> 8) & 0xff) * shade);
+      const uint8_t b = (uint8_t)(((base >> 16) & 0xff) * shade);
+      color = 0xff000000u | r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
+    }
+    return color;
+  };
+  /* paint one sample as its step x step block */
+  auto put = [&](int px, int py, uint32_t color) {
+    for (int by = py; by < py + step && by < H; ++by)
+      for (int bx = px; bx < px + step && bx < W; ++bx)
+        out[(size_t)by * W + bx] = color;
+  };
+
+  /* Work items: one per sample row (brute force) or one per tile (traced).
+   * Samples sit on the progressive grid, every `step` pixels. */
+  const int GW = (W + step - 1) / step, GH = (H + step - 1) / step;
+  const bool trace = app.fractal_boundary_trace;
+  /* traced path: per-sample colour + "already iterated" flag. Tiles are
+   * disjoint, so each byte is only ever touched by one thread. */
+  dynsys::trace::Grid<uint32_t> grid(trace ? GW : 0, trace ? GH : 0);
+  const size_t n_items = trace ? (size_t)grid.tiles() : (size_t)GH;
+
+  auto run_item = [&](Worker &w, size_t item) {
+    if (!trace) {
+      const int py = (int)item * step;
+      for (int px = 0; px < W; px += step) put(px, py, pixel_color(w, px, py));
+      return;
     }
+    grid.trace_tile((int)item, [&](int gx, int gy) { return pixel_color(w, gx * step, gy * step); },
+                    [&](int gx, int gy, uint32_t c, bool) { put(gx * step, gy * step, c); });
   };
 
   /* Use the PARALLEL path when the thread-safe IR evaluator is active (each
-   * thread gets a private ThreadStepper); else the serial fallback. Identical
+   * thread gets a private Worker); else the serial fallback. Identical
    * pixels either way. */
-  std::vector<int> rows;
-  for (int py = 0; py < H; py += step) rows.push_back(py);
+  std::atomic<long> iterated{0};
+  auto make_worker = [&](Worker &w) {
+    w.st.init(app);
+    w.cur.assign(n, 0.0); w.nx.assign(n, 0.0);
+  };
   const bool can_parallel = !app.use_ast_fallback &&
-                            std::thread::hardware_concurrency() > 1 && (int)rows.size() >= 8;
+                            dynsys::pool::threads() > 1 && n_items >= 8;
   if (can_parallel) {
-    unsigned hw = std::thread::hardware_concurrency();
-    unsigned nth = std::min<unsigned>(hw, (unsigned)rows.size());
-    std::atomic<size_t> next{0};
-    auto worker = [&]() {
-      ThreadStepper st; st.init(app);
-      for (;;) {
-        size_t k = next.fetch_add(1, std::memory_order_relaxed);
-        if (k >= rows.size()) break;
-        do_row(st, rows[k]);
-      }
-    };
-    std::vector<std::thread> pool; pool.reserve(nth);
-    for (unsigned t = 0; t < nth; ++t) pool.emplace_back(worker);
-    for (auto &th : pool) th.join();
+    /* one Worker per pool slot, set up the first time the slot runs an item */
+    std::vector<Worker> workers(dynsys::pool::threads());
+    std::vector<char> ready(workers.size(), 0);
+    dynsys::pool::parallel_for(n_items, [&](size_t k, unsigned slot) {
+      Worker &w = workers[slot];
+      if (!ready[slot]) { make_worker(w); ready[slot] = 1; }
+      run_item(w, k);
+    }, app.job_cancel);
+    for (const Worker &w : workers) iterated.fetch_add(w.iterated, std::memory_order_relaxed);
   } else {
-    ThreadStepper st; st.init(app);
-    for (int py : rows) do_row(st, py);
+    Worker w; make_worker(w);
+    for (size_t k = 0; k < n_items && !job_cancelled(app); ++k) run_item(w, k);
+    iterated.fetch_add(w.iterated, std::memory_order_relaxed);
   }
+  app.fractal_iterated_fraction = (double)iterated.load() / (double)((size_t)GW * GH);
   app.param_values = saved; /* restore (untouched on the parallel path) */
   sync_param_values(app);
 }
 
+/* Deep zoom (FractalMode::DeepZoom). Below a view width of ~1e-13 the plain
+ * escape-time loop can no longer tell neighbouring pixels apart. Here one
+ * reference orbit is iterated in double-double at the view centre and every
+ * pixel iterates only its tiny difference from it, in doubles, through the
+ * perturbation executor (expr_ir_perturb). The series approximation starts
+ * all pixels several iterations in. Pixels that glitch (their orbit dives
+ * far closer to 0 than the reference's) or outlive an escaping reference are
+ * re-rendered against a new reference placed at the worst of them, up to
+ * kFractalDeepMaxRefs references. Maps outside the executor's polynomial
+ * subset fall back to the plain renderer, with the reason on the HUD. */
+constexpr int kFractalDeepMaxRefs = 16;
+/* double-double resolves ~1e-32 relative: stop zooming well before that */
+constexpr double kFractalDeepMinHalfWidth = 1e-28;
+
+/* keep the double view window in step with the deep-zoom view (HUD, and
+ * what the other modes start from when the user switches back) */
+void fractal_deep_sync_window(AppState &app) {
+  app.fractal_xmin = app.fractal_deep_cx.hi - app.fractal_deep_hw;
+  app.fractal_xmax = app.fractal_deep_cx.hi + app.fractal_deep_hw;
+  app.fractal_ymin = app.fractal_deep_cy.hi - app.fractal_deep_hh;
+  app.fractal_ymax = app.fractal_deep_cy.hi + app.fractal_deep_hh;
+}
+
+void fractal_deep_from_window(AppState &app) {
+  app.fractal_deep_cx = {0.5 * (app.fractal_xmin + app.fractal_xmax), 0.0};
+  app.fractal_deep_cy = {0.5 * (app.fractal_ymin + app.fractal_ymax), 0.0};
+  app.fractal_deep_hw = 0.5 * (app.fractal_xmax - app.fractal_xmin);
+  app.fractal_deep_hh = 0.5 * (app.fractal_ymax - app.fractal_ymin);
+}
+
+void compute_fractal_deep(AppState &app, int W, int H, std::vector<uint32_t> &out, int step = 1) {
+  using dynsys::ir::DD;
+  if (W < 2) W = 2;
+  if (H < 2) H = 2;
+  if (step < 1) step = 1;
+  const size_t n = app.state_names.size();
+  const auto &maps = app.next_equation_programs;
+  dynsys::ir::PerturbSupport sup;
+  sup.why = "needs a 2D map";
+  if (app.mode == SystemMode::Map && n >= 2 && maps.size() == n) sup = dynsys::ir::perturb_check(maps);
+  if (!sup.ok) {
+    app.fractal_deep_status = sup.why;
+    fractal_deep_sync_window(app);
+    compute_fractal_image(app, W, H, out, step);
+    return;
+  }
+  app.fractal_deep_status.clear();
+  out.assign((size_t)W * H, 0xff000000u);
+  const int maxit = fractal_iteration_budget(app);
+  const double R2 = app.fractal_escape_r * app.fractal_escape_r;
+  const double hw = app.fractal_deep_hw, hh = app.fractal_deep_hh;
+
+  /* the plane: two parameters (Mandelbrot-type), or the state (x, y) for a
+   * map without parameters, as in compute_fractal_image */
+  dynsys::ir::PerturbPlane plane;
+  plane.params = !app.params.empty();
+  if (plane.params) {
+    plane.ix = (size_t)std::max(0, std::min(app.fractal_param_cx_index, (int)app.params.size() - 1));
+    plane.iy = (size_t)std::max(0, std::min(app.fractal_param_cy_index, (int)app.params.size() - 1));
+  }
+  auto ref_inputs = [&](DD re, DD im, std::vector<DD> &s0, std::vector<DD> &p) {
+    s0.assign(n, DD{});
+    p.assign(app.param_values.size(), DD{});
+    for (size_t i = 0; i < n; ++i) s0[i].hi = state_at(app.start, i);
+    for (size_t j = 0; j < p.size(); ++j) p[j].hi = app.param_values[j];
+    if (plane.params) { p[plane.ix] = re; p[plane.iy] = im; }
+    else { s0[0] = re; s0[1] = im; }
+  };
+  std::vector<DD> s0, p;
+  ref_inputs(app.fractal_deep_cx, app.fractal_deep_cy, s0, p);
+  dynsys::ir::ReferenceOrbit ref;
+  char err[128];
+  if (!dynsys::ir::reference_orbit(maps, s0, p, maxit, R2, &ref, err, sizeof(err))) {
+    app.fractal_deep_status = err;
+    return;
+  }
+  dynsys::ir::SeriesApprox sa;
+  if (app.fractal_deep_series && sup.analytic) dynsys::ir::series_approx(maps, ref, plane, hw, hh, &sa);
+
+  /* samples on the progressive grid, every `step` pixels */
+  const int GW = (W + step - 1) / step, GH = (H + step - 1) / step;
+  std::vector<dynsys::ir::PerturbPixel> res((size_t)GW * GH);
+  auto off_x = [&](size_t k) { return -hw + 2.0 * hw * (double)((int)(k % GW) * step) / (W - 1); };
+  auto off_y = [&](size_t k) { return -hh + 2.0 * hh * (double)((int)(k / GW) * step) / (H - 1); };
+
+  /* parallel over work items with one scratch per thread; the executor only
+   * reads the programs and the reference, so no stepper is needed */
+  auto for_items = [&](size_t count, const std::function<void(dynsys::ir::PerturbScratch &, size_t)> &body) {
+    if (dynsys::pool::threads() > 1 && count >= 8) {
+      std::vector<dynsys::ir::PerturbScratch> scratch(dynsys::pool::threads());
+      dynsys::pool::parallel_for(count, [&](size_t k, unsigned slot) { body(scratch[slot], k); }, app.job_cancel);
+    } else {
+      dynsys::ir::PerturbScratch ps;
+      for (size_t k = 0; k < count && !job_cancelled(app); ++k) body(ps, k);
+    }
+  };
+  for_items((size_t)GH, [&](dynsys::ir::PerturbScratch &ps, size_t gy) {
+    for (int gx = 0; gx < GW; ++gx) {
+      const size_t k = gy * GW + gx;
+      res[k] = dynsys::ir::perturb_pixel(maps, ref, plane, sa.skip > 0 ? &sa : nullptr, hw, hh,
+                                         off_x(k), off_y(k), maxit, R2, ps);
+    }
+  });
+
+  /* re-reference: a new reference at the glitched sample whose orbit came
+   * closest to 0 relative to the old reference (the glitch's core), then
+   * redo only the glitched samples against it */
+  std::vector<size_t> glitched;
+  for (size_t k = 0; k < res.size(); ++k)
+    if (res[k].glitched) glitched.push_back(k);
+  int refs = 1;
+  while (!glitched.empty() && refs < kFractalDeepMaxRefs && !job_cancelled(app)) {
+    size_t best = glitched[0];
+    for (size_t k : glitched)
+      if (res[k].glitch_ratio < res[best].glitch_ratio) best = k;
+    const double rox = off_x(best), roy = off_y(best);
+    ref_inputs(dynsys::ir::dd_add(app.fractal_deep_cx, rox), dynsys::ir::dd_add(app.fractal_deep_cy, roy), s0, p);
+    if (!dynsys::ir::reference_orbit(maps, s0, p, maxit, R2, &ref, err, sizeof(err))) break;
+    ++refs;
+    for_items(glitched.size(), [&](dynsys::ir::PerturbScratch &ps, size_t i) {
+      const size_t k = glitched[i];
+      res[k] = dynsys::ir::perturb_pixel(maps, ref, plane, nullptr, hw, hh,
+                                         off_x(k) - rox, off_y(k) - roy, maxit, R2, ps);
+    });
+    std::vector<size_t> still;
+    for (size_t k : glitched)
+      if (res[k].glitched) still.push_back(k);
+    glitched.swap(still);
+  }
+  app.fractal_deep_skip = sa.skip;
+  app.fractal_deep_refs = refs;
+  app.fractal_deep_glitched = (long)glitched.size();
+
+  for (size_t k = 0; k < res.size(); ++k) {
+    const uint32_t color = (res[k].escaped && res[k].iterations < maxit)
+                               ? fractal_escape_color(app, res[k].iterations, res[k].r2)
+                               : 0xff101014u;
+    const int px = (int)(k % GW) * step, py = (int)(k / GW) * step;
+    for (int by = py; by < py + step && by < H; ++by)
+      for (int bx = px; bx < px + step && bx < W; ++bx)
+        out[(size_t)by * W + bx] = color;
+  }
+  app.fractal_iterated_fraction = 1.0;
+}
+
 void render_fractal_background(AppState &app) {
   const float w = (float)app.window_width, h = (float)app.window_height;
   ImDrawList *draw = ImGui::GetBackgroundDrawList();
@@ -5352,12 +5965,35 @@ void render_fractal_background(AppState &app) {
       app.fractal_xmin = app.home_x_min; app.fractal_xmax = app.home_x_max;
       app.fractal_ymin = app.home_y_min; app.fractal_ymax = app.home_y_max;
     }
+    if (app.fractal_mode == AppState::FractalMode::DeepZoom) fractal_deep_from_window(app);
     app.fractal_dirty = true;
   }
 
   /* interaction: pan/zoom the complex window; mark dirty to recompute */
   ImGuiIO &io = ImGui::GetIO();
-  if (!io.WantCaptureMouse) {
+  const bool deep = (app.fractal_mode == AppState::FractalMode::DeepZoom);
+  if (!io.WantCaptureMouse && deep) {
+    /* deep zoom: move the double-double centre by double offsets, so panning
+     * and zooming stay exact however small the view gets */
+    if (io.MouseWheel != 0.0f) {
+      const double ox = ((double)io.MousePos.x / w * 2.0 - 1.0) * app.fractal_deep_hw;
+      const double oy = ((double)io.MousePos.y / h * 2.0 - 1.0) * app.fractal_deep_hh;
+      double f = std::pow(0.8, clamped_wheel((double)io.MouseWheel));
+      if (app.fractal_deep_hw * f < kFractalDeepMinHalfWidth) f = kFractalDeepMinHalfWidth / app.fractal_deep_hw;
+      app.fractal_deep_cx = dynsys::ir::dd_add(app.fractal_deep_cx, ox * (1.0 - f));
+      app.fractal_deep_cy = dynsys::ir::dd_add(app.fractal_deep_cy, oy * (1.0 - f));
+      app.fractal_deep_hw *= f;
+      app.fractal_deep_hh *= f;
+      fractal_deep_sync_window(app);
+      app.fractal_dirty = true;
+    }
+    if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && !ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+      app.fractal_deep_cx = dynsys::ir::dd_add(app.fractal_deep_cx, -(double)io.MouseDelta.x / w * 2.0 * app.fractal_deep_hw);
+      app.fractal_deep_cy = dynsys::ir::dd_add(app.fractal_deep_cy, -(double)io.MouseDelta.y / h * 2.0 * app.fractal_deep_hh);
+      fractal_deep_sync_window(app);
+      app.fractal_dirty = true;
+    }
+  } else if (!io.WantCaptureMouse) {
     auto invx = [&](float pxf){ return app.fractal_xmin + (double)pxf / w * (app.fractal_xmax - app.fractal_xmin); };
     auto invy = [&](float pyf){ return app.fractal_ymin + (double)pyf / h * (app.fractal_ymax - app.fractal_ymin); };
     if (io.MouseWheel != 0.0f) {
@@ -5396,6 +6032,7 @@ void render_fractal_background(AppState &app) {
      * a batch of samples each frame so the figure sharpens as you watch. */
     const bool reset = force || app.fractal_dirty;
     app.fractal_dirty = false;
+    retire_view_job(app, app.fractal_job); /* an escape-time job from before the switch */
     std::vector<uint32_t> img;
     compute_buddhabrot(app, CW, CH, img, reset);
     if (app.fractal_tex == 0) glGenTextures(1, &app.fractal_tex);
@@ -5410,45 +6047,107 @@ void render_fractal_background(AppState &app) {
       draw->AddImage((ImTextureID)(uintptr_t)app.fractal_tex, ImVec2(0, 0), ImVec2(w, h));
     char bhud[256];
     std::snprintf(bhud, sizeof(bhud),
-                  "Buddhabrot (trajectory density of escaping orbits)  |  %ld samples  |  re [%.3g, %.3g]  im [%.3g, %.3g]",
-                  app.buddha_samples, app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax);
+                  "Buddhabrot (trajectory density of escaping orbits)  |  %ld samples, %.1f%% in view  |  re [%.3g, %.3g]  im [%.3g, %.3g]",
+                  app.buddha.samples,
+                  app.buddha.samples > 0 ? 100.0 * app.buddha.contributing / app.buddha.samples : 0.0,
+                  app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax);
     draw->AddText(ImVec2(14, app.window_toolbar_h + 8.0f), IM_COL32(235, 235, 240, 235), bhud);
     draw->AddText(ImVec2(14, app.window_toolbar_h + 26.0f), IM_COL32(170, 170, 180, 220),
                   "accumulates as you watch (longer = sharper).  drag: pan   wheel: zoom");
     return;
   }
 
-  if (app.fractal_dirty) { app.fractal_settle = 5; app.fractal_dirty = false; }
-  bool start_progress = force;
-  if (app.fractal_settle > 0) { if (--app.fractal_settle == 0) start_progress = true; }
-  if (start_progress) app.fractal_prog_level = 8; /* begin coarse */
+  if (app.fractal_dirty) {
+    app.fractal_settle = 5; app.fractal_dirty = false;
+    retire_view_job(app, app.fractal_job); /* stale: stop it now, restart after the debounce */
+  }
+  bool start_progress = force && !app.fractal_job;
+  /* a view whose tiles are all cached needs neither the debounce nor the
+   * coarse levels: it is only a composition */
+  const bool cached = (start_progress || app.fractal_settle > 0) && !deep && fractal_tiles_cached(app, CW, CH);
+  if (app.fractal_settle > 0) {
+    if (--app.fractal_settle == 0 || cached) { app.fractal_settle = 0; start_progress = true; }
+  }
+  const int first_step = cached ? 1 : 8;
 
-  if (app.fractal_prog_level > 0) {
-    const int step = app.fractal_prog_level;
+  /* one progressive level, computed on `a` (the app or a job snapshot); the
+   * returned landing uploads it and copies the stats shown on the HUD */
+  auto fractal_level = [CW, CH, deep](AppState &a, int step) -> std::function<void(AppState &)> {
     std::vector<uint32_t> img;
-    compute_fractal_image(app, CW, CH, img, step);
-    if (app.fractal_tex == 0) glGenTextures(1, &app.fractal_tex);
-    glBindTexture(GL_TEXTURE_2D, app.fractal_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, CW, CH, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.data());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    app.fractal_tex_w = CW; app.fractal_tex_h = CH;
-    /* refine on the next frame: 8 -> 4 -> 2 -> 1 -> done */
-    app.fractal_prog_level = (step > 1) ? step / 2 : 0;
+    if (deep) compute_fractal_deep(a, CW, CH, img, step);
+    else if (!compose_fractal_tiles(a, CW, CH, img, step)) compute_fractal_image(a, CW, CH, img, step);
+    return [img = std::move(img), CW, CH, frac = a.fractal_iterated_fraction, skip = a.fractal_deep_skip,
+            refs = a.fractal_deep_refs, glitched = a.fractal_deep_glitched,
+            status = a.fractal_deep_status, reused = a.fractal_tiles_reused,
+            computed = a.fractal_tiles_computed](AppState &ui) {
+      upload_view_texture(ui.fractal_tex, CW, CH, img, GL_LINEAR);
+      ui.fractal_tex_w = CW; ui.fractal_tex_h = CH;
+      ui.fractal_iterated_fraction = frac;
+      ui.fractal_tiles_reused = reused; ui.fractal_tiles_computed = computed;
+      ui.fractal_deep_skip = skip; ui.fractal_deep_refs = refs;
+      ui.fractal_deep_glitched = glitched; ui.fractal_deep_status = status;
+    };
+  };
+  if (app.async_views && !app.use_ast_fallback) {
+    if (start_progress)
+      start_view_job(app, app.fractal_job, [fractal_level, first_step](AppState &snap, ViewJob &job) {
+        for (int step = first_step; step >= 1; step /= 2) { /* coarse first */
+          auto landing = fractal_level(snap, step);
+          if (job.cancel.cancelled()) return;
+          view_job_publish(job, std::move(landing));
+        }
+      });
+    app.fractal_prog_level = land_view_job(app, app.fractal_job) ? 1 : 0;
+  } else {
+    if (start_progress) app.fractal_prog_level = first_step; /* begin coarse */
+    if (app.fractal_prog_level > 0) {
+      const int step = app.fractal_prog_level;
+      fractal_level(app, step)(app);
+      /* refine on the next frame: 8 -> 4 -> 2 -> 1 -> done */
+      app.fractal_prog_level = (step > 1) ? step / 2 : 0;
+    }
   }
 
   if (app.fractal_tex != 0)
     draw->AddImage((ImTextureID)(uintptr_t)app.fractal_tex, ImVec2(0, 0), ImVec2(w, h));
 
+  if (deep) {
+    char hud[256];
+    std::snprintf(hud, sizeof(hud), "Fractal — deep zoom (perturbation)   |  centre %.17g %+.17gi  width %.3g  iters %d",
+                  app.fractal_deep_cx.hi, app.fractal_deep_cy.hi, 2.0 * app.fractal_deep_hw, app.fractal_max_iter);
+    draw->AddText(ImVec2(14, app.window_toolbar_h + 8.0f), IM_COL32(235, 235, 240, 235), hud);
+    char dhud[200];
+    if (!app.fractal_deep_status.empty())
+      std::snprintf(dhud, sizeof(dhud), "perturbation unavailable (%s): plain double rendering",
+                    app.fractal_deep_status.c_str());
+    else
+      std::snprintf(dhud, sizeof(dhud), "%d reference orbit%s, series skips %d iterations%s",
+                    app.fractal_deep_refs, app.fractal_deep_refs == 1 ? "" : "s", app.fractal_deep_skip,
+                    app.fractal_deep_glitched > 0 ? ", some glitches left" : "");
+    draw->AddText(ImVec2(14, app.window_toolbar_h + 26.0f), IM_COL32(170, 170, 180, 220), dhud);
+    if (!io.WantCaptureMouse)
+      draw->AddText(ImVec2(14, h - 24), IM_COL32(150, 150, 160, 200),
+                    "drag: pan   wheel: zoom (down to ~1e-28)   (raise max iterations as you go deeper)");
+    return;
+  }
   const char *mode = app.fractal_mode == AppState::FractalMode::ParameterSpace
                          ? "parameter space (Mandelbrot-type: orbit of the start point)"
                          : "state space (Julia-type: sweeping the initial condition)";
-  char hud[256];
-  std::snprintf(hud, sizeof(hud), "Fractal — %s   |  re [%.4g, %.4g]  im [%.4g, %.4g]  iters %d",
-                mode, app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax, app.fractal_max_iter);
+  char tiles[80] = "";
+  if (app.fractal_tiles_reused + app.fractal_tiles_computed > 0)
+    std::snprintf(tiles, sizeof(tiles), "  |  tiles %ld cached, %ld new",
+                  app.fractal_tiles_reused, app.fractal_tiles_computed);
+  char hud[320];
+  std::snprintf(hud, sizeof(hud), "Fractal — %s   |  re [%.4g, %.4g]  im [%.4g, %.4g]  iters %d%s",
+                mode, app.fractal_xmin, app.fractal_xmax, app.fractal_ymin, app.fractal_ymax, app.fractal_max_iter,
+                tiles);
   draw->AddText(ImVec2(14, app.window_toolbar_h + 8.0f), IM_COL32(235, 235, 240, 235), hud);
+  if (app.fractal_boundary_trace) {
+    char thud[96];
+    std::snprintf(thud, sizeof(thud), "boundary tracing: %.0f%% of pixels iterated",
+                  100.0 * app.fractal_iterated_fraction);
+    draw->AddText(ImVec2(14, app.window_toolbar_h + 26.0f), IM_COL32(170, 170, 180, 220), thud);
+  }
   if (!io.WantCaptureMouse)
     draw->AddText(ImVec2(14, h - 24), IM_COL32(150, 150, 160, 200),
                   "drag: pan   wheel: zoom   (set mode/params/iterations in the Setup tab)");
@@ -5457,8 +6156,8 @@ void render_fractal_background(AppState &app) {
 /* ============================================================
  * PHASE C: IFS / chaos game.
  * A built-in gallery of iterated function systems; the chaos game renders
- * each attractor into a density texture. The fractal dimension of the
- * result is measured with box_counting_dimension (cross-checking it).
+ * each attractor into a density texture. The fractal dimension is box-
+ * counted in the same streaming pass (chaos_game_stream).
  * ============================================================ */
 struct IFSPreset {
   const char *name;
@@ -5569,47 +6268,31 @@ void render_ifs_background(AppState &app) {
   const int CH = std::max(64, (int)h);
 
   if (app.ifs_dirty || app.ifs_tex == 0 || app.ifs_tex_w != CW || app.ifs_tex_h != CH) {
-    /* run the chaos game */
-    dynsys::analysis::IFSResult R =
-        dynsys::analysis::chaos_game(maps_to_use, app.ifs_iterations, 12345u);
-    if (R.ok && !R.xs.empty()) {
-      /* measure the dimension (cross-check) */
-      std::vector<double> xs(R.xs.begin(), R.xs.end()), ys(R.ys.begin(), R.ys.end());
-      auto D = dynsys::analysis::box_counting_dimension(xs, ys, 12);
-      app.ifs_box_dim = D.dimension; app.ifs_box_dim_ready = D.ok;
-
-      /* fit the attractor into the window with a margin, preserving aspect */
-      const double spanx = std::max(1e-9, R.xmax - R.xmin);
-      const double spany = std::max(1e-9, R.ymax - R.ymin);
-      const double margin = 0.06;
-      const double sx = (CW * (1 - 2 * margin)) / spanx;
-      const double sy = (CH * (1 - 2 * margin)) / spany;
-      const double s = std::min(sx, sy);
-      const double cx = 0.5 * (R.xmin + R.xmax), cy = 0.5 * (R.ymin + R.ymax);
-
-      /* density accumulation */
-      std::vector<float> dens((size_t)CW * CH, 0.0f);
-      float dmax = 0.0f;
-      for (size_t i = 0; i < R.xs.size(); ++i) {
-        const int px = (int)(CW * 0.5 + (R.xs[i] - cx) * s);
-        const int py = (int)(CH * 0.5 - (R.ys[i] - cy) * s); /* flip y */
-        if (px < 0 || px >= CW || py < 0 || py >= CH) continue;
-        float &c = dens[(size_t)py * CW + px];
-        c += 1.0f; if (c > dmax) dmax = c;
-      }
-      /* colorize: green-ish for botanical sets, gamma-lifted density */
+    /* stream the chaos game straight into a density grid and box-count
+     * bitmaps: no point cloud, so the iteration count only costs time */
+    dynsys::analysis::IFSStreamOptions so;
+    so.iterations = app.ifs_iterations;
+    so.width = CW; so.height = CH;
+    dynsys::analysis::IFSDensity R = dynsys::analysis::chaos_game_stream(maps_to_use, so);
+    if (R.ok) {
+      /* the dimension comes from the same pass (cross-check) */
+      app.ifs_box_dim = R.box.dimension; app.ifs_box_dim_ready = R.box.ok;
+
+      /* colorize: green-ish for botanical sets, gamma-lifted density; the
+       * grid's row 0 is ymin, so flip y */
       std::vector<uint32_t> img((size_t)CW * CH, 0xff0a0b0fu);
-      const float inv = dmax > 0 ? 1.0f / std::log(1.0f + dmax) : 0.0f;
-      for (size_t i = 0; i < img.size(); ++i) {
-        const float c = dens[i];
-        if (c <= 0) continue;
-        float t = std::log(1.0f + c) * inv;
-        t = std::pow(t, 0.6f);
-        const int r = (int)(40 + 120 * t);
-        const int g = (int)(120 + 135 * t);
-        const int b = (int)(70 + 80 * t);
-        img[i] = 0xff000000u | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
-      }
+      const float inv = R.max_density > 0 ? 1.0f / std::log(1.0f + (float)R.max_density) : 0.0f;
+      for (int row = 0; row < CH; ++row)
+        for (int col = 0; col < CW; ++col) {
+          const float c = (float)R.density[(size_t)row * CW + col];
+          if (c <= 0) continue;
+          float t = std::log(1.0f + c) * inv;
+          t = std::pow(t, 0.6f);
+          const int r = (int)(40 + 120 * t);
+          const int g = (int)(120 + 135 * t);
+          const int b = (int)(70 + 80 * t);
+          img[(size_t)(CH - 1 - row) * CW + col] = 0xff000000u | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
+        }
       if (app.ifs_tex == 0) glGenTextures(1, &app.ifs_tex);
       glBindTexture(GL_TEXTURE_2D, app.ifs_tex);
       glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, CW, CH, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.data());
@@ -5714,7 +6397,10 @@ void compute_basin_image(AppState &app, int W, int H, std::vector<uint32_t> &out
 
   char err[128] = {0};
   bool eval_err = false;
+  /* a cancelled background job makes every cell "diverge" at once, so the
+   * sweep drains in a few steps; its image is thrown away */
   auto advance = [&](double x, double y, double *nx, double *ny) -> bool {
+    if (job_cancelled(app)) return false;
     State s = app.start;
     resize_state(s, n);
     set_state_at(s, ix, x);
@@ -5738,6 +6424,10 @@ void compute_basin_image(AppState &app, int W, int H, std::vector<uint32_t> &out
                       ? std::min(std::max(50, app.basin_steps), 250)
                       : std::max(50, app.basin_steps);
   opt.cluster_tol = app.basin_cluster_tol;
+  opt.memoize = app.basin_memoize;
+  opt.adaptive = app.basin_adaptive;
+  opt.fingerprint = app.basin_fingerprint;
+  opt.flow = (app.mode != SystemMode::Map);
   opt.settle_tol = (app.mode == SystemMode::Map) ? 1e-6 : 1e-5;
 
   /* Use the PARALLEL basin solver when the (thread-safe) IR eval path is in
@@ -5748,30 +6438,65 @@ void compute_basin_image(AppState &app, int W, int H, std::vector<uint32_t> &out
    * match compute_basins' own (x0,y0) mapping exactly. */
   dynsys::analysis::BasinResult R;
   const bool can_parallel = !app.use_ast_fallback &&
-                            std::thread::hardware_concurrency() > 1 && ch >= 8;
-  if (can_parallel) {
-    const bool is_map = (app.mode == SystemMode::Map);
-    auto make_advance = [&app, n, ix, iy, is_map](int /*tid*/) {
-      auto stepper = std::make_shared<ThreadStepper>();
-      stepper->init(app);
-      std::vector<double> s(n), sn(n);
-      for (size_t i = 0; i < n; ++i) s[i] = state_at(app.start, i);
-      return [stepper, n, ix, iy, is_map, s, sn](double x, double y, double *nx, double *ny) mutable -> bool {
-        for (size_t i = 0; i < n; ++i) s[i] = state_at(stepper->app->start, i);
-        s[ix] = x; s[iy] = y;
-        bool ok = is_map ? stepper->map_step(s.data(), sn.data())
-                         : stepper->rk4_step(s.data(), sn.data());
-        if (!ok) return false;
-        *nx = sn[ix]; *ny = sn[iy];
-        return true;
-      };
+                            dynsys::pool::threads() > 1 && ch >= 8;
+  const bool is_map = (app.mode == SystemMode::Map);
+  auto make_advance = [&app, n, ix, iy, is_map](int /*tid*/) {
+    auto stepper = std::make_shared<ThreadStepper>();
+    stepper->init(app);
+    std::vector<double> s(n), sn(n);
+    for (size_t i = 0; i < n; ++i) s[i] = state_at(app.start, i);
+    const dynsys::pool::Cancel *cancel = app.job_cancel;
+    return [stepper, n, ix, iy, is_map, s, sn, cancel](double x, double y, double *nx, double *ny) mutable -> bool {
+      if (cancel && cancel->cancelled()) return false;
+      for (size_t i = 0; i < n; ++i) s[i] = state_at(stepper->app->start, i);
+      s[ix] = x; s[iy] = y;
+      bool ok = is_map ? stepper->map_step(s.data(), sn.data())
+                       : stepper->rk4_step(s.data(), sn.data());
+      if (!ok) return false;
+      *nx = sn[ix]; *ny = sn[iy];
+      return true;
     };
+  };
+
+  /* Compose the cell grid from cached tiles: each tile holds raw endpoints,
+   * and clustering runs over the whole composed view, so attractor labels
+   * and colours do not depend on which tiles happened to be cached. */
+  std::vector<dynsys::analysis::BasinCell> cells;
+  const bool thread_safe = !app.use_ast_fallback; /* tiles are 64 rows: always worth the pool */
+  auto integrate_tile = [&](const dynsys::tiles::Window &tw, ViewTile &t) {
+    dynsys::analysis::BasinOptions to = opt;
+    to.xmin = tw.x0; to.xmax = tw.x1; to.ymin = tw.y0; to.ymax = tw.y1;
+    to.width = to.height = dynsys::tiles::kTile;
+    to.adaptive_grid = 2; /* 32-cell blocks, as on a whole ~480-cell view */
+    if (thread_safe) {
+      dynsys::analysis::integrate_basin_cells(make_advance, to, &t.cells);
+    } else {
+      dynsys::analysis::integrate_basin_cells(
+          [&advance](int) -> dynsys::analysis::AdvanceFn { return advance; }, to, &t.cells, false);
+    }
+  };
+  dynsys::tiles::Hasher content;
+  content.add("basin").add(app.system_hash).add(is_map).add(ix).add(iy).add(app.dt)
+         .add(is_map || thread_safe ? -1 : (int)app.integrator)
+         .add(opt.max_steps).add(opt.settle_tol).add(opt.diverge_r).add(opt.memoize);
+  if (opt.memoize) content.add(opt.memo_confirm).add(opt.cluster_tol);
+  if (opt.adaptive) content.add("adaptive").add(opt.cluster_tol);
+  if (opt.fingerprint) content.add("fingerprint").add(opt.fp_steps).add(opt.cluster_tol);
+  for (double v : app.param_values) content.add(v);
+  for (size_t i = 0; i < n; ++i) content.add(state_at(app.start, i));
+  if (compose_view_tiles(app, content.value(), {opt.xmin, opt.xmax, opt.ymin, opt.ymax}, cw, ch, 0,
+                         integrate_tile, &ViewTile::cells, cells,
+                         &app.basin_tiles_reused, &app.basin_tiles_computed)) {
+    R = dynsys::analysis::cluster_basin_cells(cells, cw, ch, opt);
+  } else if (can_parallel) {
     R = dynsys::analysis::compute_basins_mt(make_advance, opt);
   } else {
     R = dynsys::analysis::compute_basins(advance, opt);
   }
   app.integrator = saved_integrator; /* restore the user's choice */
   app.basin_attractor_count = (int)R.attractors.size();
+  app.basin_n_cycles = (int)std::count(R.attractor_kind.begin(), R.attractor_kind.end(), 1);
+  app.basin_n_chaotic = (int)std::count(R.attractor_kind.begin(), R.attractor_kind.end(), 2);
   app.basin_n_converged = R.n_converged;
   app.basin_n_diverged = R.n_diverged;
   app.basin_n_nonconvergent = R.n_nonconvergent;
@@ -5790,6 +6515,95 @@ void compute_basin_image(AppState &app, int W, int H, std::vector<uint32_t> &out
   }
 }
 
+/* 3-D basins: the phase x/y window and basin_z_min..max on basin_z_index
+ * span a box of basin_vol_res^3 cells, classified by compute_basin_volume
+ * with the same forced fixed-step integrator as the plane. Other state dims
+ * are held at their start values. on_slice sees the volume after every
+ * slice and returns false to stop; a later call with the same grid resumes. */
+void compute_basin_volume_view(AppState &app, dynsys::analysis::BasinVolume *vol,
+                               const std::function<bool(int)> &on_slice) {
+  const size_t n = app.state_names.size();
+  if (n < 3) return;
+  const size_t ix = (size_t)app.phase_x_index, iy = (size_t)app.phase_y_index;
+  const size_t iz = (size_t)std::max(0, std::min(app.basin_z_index, (int)n - 1));
+  const PlotBounds b = sanitize_bounds(current_phase_bounds(app, ix, iy));
+  dynsys::analysis::BasinVolumeOptions opt;
+  opt.lo[0] = b.xmin; opt.hi[0] = b.xmax;
+  opt.lo[1] = b.ymin; opt.hi[1] = b.ymax;
+  opt.lo[2] = std::min(app.basin_z_min, app.basin_z_max);
+  opt.hi[2] = std::max(app.basin_z_min, app.basin_z_max);
+  if (opt.hi[2] - opt.lo[2] < 1e-9) opt.hi[2] = opt.lo[2] + 1.0;
+  const int res = std::max(8, std::min(app.basin_vol_res, 128));
+  for (int d = 0; d < 3; ++d) opt.size[d] = res;
+  const bool is_map = (app.mode == SystemMode::Map);
+  opt.max_steps = is_map ? std::min(std::max(50, app.basin_steps), 250) : std::max(50, app.basin_steps);
+  opt.cluster_tol = app.basin_cluster_tol;
+  opt.settle_tol = is_map ? 1e-6 : 1e-5;
+
+  const Integrator saved_integrator = app.integrator;
+  if (app.mode == SystemMode::ODE &&
+      (app.integrator == Integrator::RKF45 || app.integrator == Integrator::DOPRI45))
+    app.integrator = Integrator::RK4;
+  if (!app.use_ast_fallback) {
+    auto make_advance = [&app, n, ix, iy, iz, is_map](int /*tid*/) -> dynsys::analysis::AdvanceFn3 {
+      auto stepper = std::make_shared<ThreadStepper>();
+      stepper->init(app);
+      std::vector<double> s(n), sn(n);
+      const dynsys::pool::Cancel *cancel = app.job_cancel;
+      return [stepper, n, ix, iy, iz, is_map, s, sn, cancel](const double *p, double *np) mutable -> bool {
+        if (cancel && cancel->cancelled()) return false;
+        for (size_t i = 0; i < n; ++i) s[i] = state_at(stepper->app->start, i);
+        s[ix] = p[0]; s[iy] = p[1]; s[iz] = p[2];
+        if (!(is_map ? stepper->map_step(s.data(), sn.data()) : stepper->rk4_step(s.data(), sn.data())))
+          return false;
+        np[0] = sn[ix]; np[1] = sn[iy]; np[2] = sn[iz];
+        return true;
+      };
+    };
+    dynsys::analysis::compute_basin_volume(make_advance, opt, vol, on_slice);
+  } else {
+    char err[128] = {0};
+    dynsys::analysis::AdvanceFn3 advance = [&](const double *p, double *np) -> bool {
+      if (job_cancelled(app)) return false;
+      State s = app.start;
+      resize_state(s, n);
+      set_state_at(s, ix, p[0]); set_state_at(s, iy, p[1]); set_state_at(s, iz, p[2]);
+      State out_s{};
+      if (!step_state(app, s, &out_s, err, sizeof(err))) return false;
+      np[0] = state_at(out_s, ix); np[1] = state_at(out_s, iy); np[2] = state_at(out_s, iz);
+      return true;
+    };
+    dynsys::analysis::compute_basin_volume([&advance](int) { return advance; }, opt, vol, on_slice, false);
+  }
+  app.integrator = saved_integrator;
+}
+
+/* Paints app.basin_vol into basin_tex: slice basin_vol_slice (the nearest
+ * filled one while slices are still landing), or with basin_vol_project the
+ * first label that did not escape looking down z, darker the deeper it sits. */
+void upload_basin_volume(AppState &app) {
+  if (!app.basin_vol) return;
+  const dynsys::volume::LabelVolume &L = app.basin_vol->labels;
+  const int W = L.width(), H = L.height(), D = L.depth();
+  const int nl = (int)app.basin_vol->attractors.size();
+  std::vector<int16_t> lab;
+  std::vector<int> depth;
+  if (app.basin_vol_project) {
+    L.first_hit(-1, &lab, &depth);
+  } else {
+    app.basin_vol_slice = std::max(0, std::min(app.basin_vol_slice, D - 1));
+    L.decode_slice(L.nearest_slice(app.basin_vol_slice), &lab);
+  }
+  std::vector<uint32_t> img((size_t)W * H);
+  for (size_t p = 0; p < img.size(); ++p) {
+    if (lab[p] == dynsys::volume::kUnfilled) { img[p] = IM_COL32(40, 40, 46, 255); continue; }
+    const float shade = depth.empty() ? 1.0f : (float)(depth[p] + 1) / D;
+    img[p] = basin_color(lab[p], nl, shade, !depth.empty());
+  }
+  upload_view_texture(app.basin_tex, W, H, img, GL_NEAREST);
+  app.basin_tex_w = W; app.basin_tex_h = H;
+}
+
 void render_basin_background(AppState &app) {
   const float w = (float)app.window_width, h = (float)app.window_height;
   ImDrawList *draw = ImGui::GetBackgroundDrawList();
@@ -5860,45 +6674,133 @@ void render_basin_background(AppState &app) {
     }
   }
 
+  /* 3-D volume mode: same x/y frame, z from the panel. Slices land coarse to
+   * fine (ends, middle, quarters, ...): one per frame when synchronous, or
+   * published from the background job as each one finishes. */
+  if (app.basin_volume_mode && nstate >= 3) {
+    const bool vforce = !app.basin_vol && !app.basin_job && app.basin_prog_level == 0 && app.basin_settle == 0;
+    if (app.basin_dirty) {
+      app.basin_settle = 6; app.basin_dirty = false; app.basin_prog_level = 0;
+      retire_view_job(app, app.basin_job);
+    }
+    bool start = vforce;
+    if (app.basin_settle > 0 && --app.basin_settle == 0) start = true;
+    const bool async = app.async_views && !app.use_ast_fallback;
+    if (start) {
+      app.basin_vol = std::make_shared<const dynsys::analysis::BasinVolume>();
+      app.basin_vol_work = dynsys::analysis::BasinVolume();
+      if (async)
+        start_view_job(app, app.basin_job, [](AppState &snap, ViewJob &job) {
+          dynsys::analysis::BasinVolume vol;
+          compute_basin_volume_view(snap, &vol, [&](int) {
+            auto done = std::make_shared<const dynsys::analysis::BasinVolume>(vol);
+            view_job_publish(job, [done](AppState &ui) { ui.basin_vol = done; upload_basin_volume(ui); });
+            return !job.cancel.cancelled();
+          });
+        });
+      else
+        app.basin_prog_level = 1;
+    }
+    if (async) {
+      app.basin_prog_level = land_view_job(app, app.basin_job) ? 1 : 0;
+    } else if (app.basin_prog_level > 0) {
+      compute_basin_volume_view(app, &app.basin_vol_work, [](int) { return false; });
+      app.basin_vol = std::make_shared<const dynsys::analysis::BasinVolume>(app.basin_vol_work);
+      upload_basin_volume(app);
+      if (app.basin_vol_work.labels.complete()) app.basin_prog_level = 0;
+    }
+    if (app.basin_tex != 0 && app.basin_vol && app.basin_vol->labels.filled() > 0)
+      draw->AddImage((ImTextureID)(uintptr_t)app.basin_tex, ImVec2(0, 0), ImVec2(w, h));
+    const size_t iz = (size_t)std::max(0, std::min(app.basin_z_index, (int)nstate - 1));
+    char hud[400];
+    const dynsys::volume::LabelVolume *L = app.basin_vol ? &app.basin_vol->labels : nullptr;
+    char where[64];
+    if (app.basin_vol_project)
+      std::snprintf(where, sizeof(where), "first hit down %s", app.state_names[iz].c_str());
+    else
+      std::snprintf(where, sizeof(where), "%s slice %d", app.state_names[iz].c_str(),
+                    L ? std::max(0, L->nearest_slice(app.basin_vol_slice)) : 0);
+    std::snprintf(hud, sizeof(hud),
+                  "Basin volume — %d basin(s)  |  %s vs %s, %s  |  %d of %d slices, %.1f KiB%s",
+                  app.basin_vol ? (int)app.basin_vol->attractors.size() : 0, app.state_names[ix].c_str(),
+                  app.state_names[iy].c_str(), where, L ? L->filled() : 0, L && L->filled() ? L->depth() : 0,
+                  L ? L->bytes() / 1024.0 : 0.0, app.basin_prog_level > 0 ? "   [computing…]" : "");
+    draw->AddText(ImVec2(14, app.window_toolbar_h + 8.0f), IM_COL32(235, 235, 240, 235), hud);
+    if (!io.WantCaptureMouse)
+      draw->AddText(ImVec2(14, h - 24), IM_COL32(150, 150, 160, 200),
+                    "grey = not computed yet · black = escaped · colors = distinct attractors    drag: pan  wheel: zoom");
+    return;
+  }
+
   /* ODE basins integrate a trajectory PER CELL, far costlier than a map's
    * single step, so cap their grid lower; maps can afford the full grid. */
   const bool basin_is_ode = (app.mode == SystemMode::ODE);
   const int CW = std::min(app.window_width, basin_is_ode ? 380 : 480);
   const int CH = std::min(app.window_height, basin_is_ode ? 300 : 384);
-  const bool bforce = (app.basin_tex == 0 || app.basin_tex_w != CW || app.basin_tex_h != CH);
-  if (app.basin_dirty) { app.basin_settle = 6; app.basin_dirty = false; }
+  const bool bforce = (app.basin_tex == 0 || app.basin_tex_w != CW || app.basin_tex_h != CH) && !app.basin_job;
+  if (app.basin_dirty) {
+    app.basin_settle = 6; app.basin_dirty = false;
+    retire_view_job(app, app.basin_job);
+  }
   bool start_progress = bforce;
   if (app.basin_settle > 0) { if (--app.basin_settle == 0) start_progress = true; }
-  /* begin a coarse->fine pass: 16 -> 8 -> 4 -> 2 -> 1 (the coarse first frame
+  /* a coarse->fine pass: 16 -> 8 -> 4 -> 2 -> 1 (the coarse first level
    * appears almost instantly). Under the performance governor's throttle, stop
    * refining early (a coarser final level) so a heavy basin can't lock the UI. */
-  if (start_progress) app.basin_prog_level = 16;
-  if (app.basin_prog_level > 0) {
-    int step = app.basin_prog_level;
+  auto basin_floor = [](const AppState &a) {
+    if (a.perf_throttle > 0.6) return 4;
+    if (a.perf_throttle > 0.3) return 2;
+    return 1;
+  };
+  auto basin_level = [CW, CH](AppState &a, int step) -> std::function<void(AppState &)> {
     std::vector<uint32_t> img;
-    compute_basin_image(app, CW, CH, img, step);
-    if (app.basin_tex == 0) glGenTextures(1, &app.basin_tex);
-    glBindTexture(GL_TEXTURE_2D, app.basin_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, CW, CH, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.data());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    app.basin_tex_w = CW; app.basin_tex_h = CH;
-    /* next finer level; if heavily throttled, stop at a coarser floor */
-    int floor_level = 1;
-    if (app.perf_throttle > 0.6) floor_level = 4;
-    else if (app.perf_throttle > 0.3) floor_level = 2;
-    app.basin_prog_level = (step > floor_level) ? step / 2 : 0;
+    compute_basin_image(a, CW, CH, img, step);
+    return [img = std::move(img), CW, CH, count = a.basin_attractor_count, cycles = a.basin_n_cycles,
+            chaotic = a.basin_n_chaotic, conv = a.basin_n_converged, div = a.basin_n_diverged,
+            nonconv = a.basin_n_nonconvergent, reused = a.basin_tiles_reused,
+            computed = a.basin_tiles_computed](AppState &ui) {
+      upload_view_texture(ui.basin_tex, CW, CH, img, GL_NEAREST);
+      ui.basin_tex_w = CW; ui.basin_tex_h = CH;
+      ui.basin_tiles_reused = reused; ui.basin_tiles_computed = computed;
+      ui.basin_attractor_count = count; ui.basin_n_cycles = cycles; ui.basin_n_chaotic = chaotic;
+      ui.basin_n_converged = conv; ui.basin_n_diverged = div; ui.basin_n_nonconvergent = nonconv;
+    };
+  };
+  if (app.async_views && !app.use_ast_fallback) {
+    if (start_progress)
+      start_view_job(app, app.basin_job, [basin_level, floor_level = basin_floor(app)](AppState &snap, ViewJob &job) {
+        for (int step = 16; step >= floor_level; step /= 2) {
+          auto landing = basin_level(snap, step);
+          if (job.cancel.cancelled()) return;
+          view_job_publish(job, std::move(landing));
+        }
+      });
+    app.basin_prog_level = land_view_job(app, app.basin_job) ? 2 : 0;
+  } else {
+    if (start_progress) app.basin_prog_level = 16;
+    if (app.basin_prog_level > 0) {
+      const int step = app.basin_prog_level;
+      basin_level(app, step)(app);
+      /* next finer level; if heavily throttled, stop at a coarser floor */
+      const int floor_level = basin_floor(app);
+      app.basin_prog_level = (step > floor_level) ? step / 2 : 0;
+    }
   }
   if (app.basin_tex != 0)
     draw->AddImage((ImTextureID)(uintptr_t)app.basin_tex, ImVec2(0, 0), ImVec2(w, h));
 
-  char hud[360];
+  char tiles[80] = "";
+  if (app.basin_tiles_reused + app.basin_tiles_computed > 0)
+    std::snprintf(tiles, sizeof(tiles), "  |  tiles %ld cached, %ld new",
+                  app.basin_tiles_reused, app.basin_tiles_computed);
+  char kinds[64] = "";
+  if (app.basin_n_cycles + app.basin_n_chaotic > 0)
+    std::snprintf(kinds, sizeof(kinds), " (%d cycle, %d chaotic)", app.basin_n_cycles, app.basin_n_chaotic);
+  char hud[500];
   std::snprintf(hud, sizeof(hud),
-                "Basins of attraction — %d basin(s)  |  %s vs %s  |  converged %ld, escaped %ld, non-convergent %ld%s",
-                app.basin_attractor_count, app.state_names[ix].c_str(), app.state_names[iy].c_str(),
-                app.basin_n_converged, app.basin_n_diverged, app.basin_n_nonconvergent,
+                "Basins of attraction — %d basin(s)%s  |  %s vs %s  |  converged %ld, escaped %ld, non-convergent %ld%s%s",
+                app.basin_attractor_count, kinds, app.state_names[ix].c_str(), app.state_names[iy].c_str(),
+                app.basin_n_converged, app.basin_n_diverged, app.basin_n_nonconvergent, tiles,
                 app.basin_prog_level > 1 ? "   [refining…]" : "");
   draw->AddText(ImVec2(14, app.window_toolbar_h + 8.0f), IM_COL32(235, 235, 240, 235), hud);
 
@@ -5911,6 +6813,9 @@ void render_basin_background(AppState &app) {
                   "Most orbits don't settle to a point/cycle — this system has a chaotic or single global attractor.");
     draw->AddText(ImVec2(14, 52), IM_COL32(255, 210, 120, 240),
                   "Basins are meaningful for MULTISTABLE systems. Try the Duffing oscillator or the Newton fractal preset.");
+    if (!app.basin_fingerprint)
+      draw->AddText(ImVec2(14, 70), IM_COL32(255, 210, 120, 240),
+                    "Coexisting cycles or chaotic attractors? Tick \"classify cycles and chaotic sets\" to tell them apart.");
   }
   if (!io.WantCaptureMouse)
     draw->AddText(ImVec2(14, h - 24), IM_COL32(150, 150, 160, 200),
@@ -5966,7 +6871,7 @@ void compute_scan_image(AppState &app, int W, int H, std::vector<uint32_t> &out,
   double lo = 1e300, hi = -1e300;
   char err[128] = {0};
 
-  for (int j = 0; j < H; j += step) {
+  for (int j = 0; j < H && !job_cancelled(app); j += step) {
     const double py = app.scan_ymin + (app.scan_ymax - app.scan_ymin) * (double)j / (H - 1);
     for (int i = 0; i < W; i += step) {
       const double px = app.scan_xmin + (app.scan_xmax - app.scan_xmin) * (double)i / (W - 1);
@@ -6070,25 +6975,40 @@ void render_scan_background(AppState &app) {
    * over the next frames. This is what keeps ODE scans from freezing the UI. */
   const int CW = std::min(app.window_width, 400);
   const int CH = std::min(app.window_height, 320);
-  const bool sforce = (app.scan_tex == 0 || app.scan_tex_w != CW || app.scan_tex_h != CH);
-  if (app.scan_dirty) { app.scan_settle = 6; app.scan_dirty = false; }
+  const bool sforce = (app.scan_tex == 0 || app.scan_tex_w != CW || app.scan_tex_h != CH) && !app.scan_job;
+  if (app.scan_dirty) {
+    app.scan_settle = 6; app.scan_dirty = false;
+    retire_view_job(app, app.scan_job);
+  }
   bool sstart = sforce;
   if (app.scan_settle > 0) { if (--app.scan_settle == 0) sstart = true; }
-  if (sstart) app.scan_prog_level = 16;          /* (re)start the coarse->fine ladder */
-  if (app.scan_prog_level > 0) {
-    const int step = app.scan_prog_level;
+  auto scan_level = [CW, CH](AppState &a, int step) -> std::function<void(AppState &)> {
     std::vector<uint32_t> img;
-    compute_scan_image(app, CW, CH, img, step);
-    if (app.scan_tex == 0) glGenTextures(1, &app.scan_tex);
-    glBindTexture(GL_TEXTURE_2D, app.scan_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, CW, CH, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.data());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    app.scan_tex_w = CW; app.scan_tex_h = CH;
-    /* next, finer level: 16 -> 8 -> 4 -> 2 -> 1 -> 0 (done) */
-    app.scan_prog_level = (step > 1) ? step / 2 : 0;
+    compute_scan_image(a, CW, CH, img, step);
+    return [img = std::move(img), CW, CH, lo = a.scan_lyap_min, hi = a.scan_lyap_max](AppState &ui) {
+      upload_view_texture(ui.scan_tex, CW, CH, img, GL_LINEAR);
+      ui.scan_tex_w = CW; ui.scan_tex_h = CH;
+      ui.scan_lyap_min = lo; ui.scan_lyap_max = hi;
+    };
+  };
+  if (app.async_views && !app.use_ast_fallback) {
+    if (sstart)
+      start_view_job(app, app.scan_job, [scan_level](AppState &snap, ViewJob &job) {
+        for (int step = 16; step >= 1; step /= 2) { /* 16 -> 8 -> 4 -> 2 -> 1 */
+          auto landing = scan_level(snap, step);
+          if (job.cancel.cancelled()) return;
+          view_job_publish(job, std::move(landing));
+        }
+      });
+    app.scan_prog_level = land_view_job(app, app.scan_job) ? 1 : 0;
+  } else {
+    if (sstart) app.scan_prog_level = 16;          /* (re)start the coarse->fine ladder */
+    if (app.scan_prog_level > 0) {
+      const int step = app.scan_prog_level;
+      scan_level(app, step)(app);
+      /* next, finer level: 16 -> 8 -> 4 -> 2 -> 1 -> 0 (done) */
+      app.scan_prog_level = (step > 1) ? step / 2 : 0;
+    }
   }
   if (app.scan_tex != 0)
     draw->AddImage((ImTextureID)(uintptr_t)app.scan_tex, ImVec2(0, 0), ImVec2(w, h));
@@ -6195,9 +7115,12 @@ inline void period_color(int period, float *r, float *g, float *b) {
 }
 }  // namespace bridge_detail
 
-void build_bridge_geometry(AppState &app) {
-  std::vector<Point> pts;
-  std::vector<float> cols;
+/* Builds the bridge point cloud (positions + RGB colours) on the CPU. Reads
+ * only AppState, so it can run on a background job's snapshot; the GL upload
+ * is upload_bridge_geometry. */
+void compute_bridge_geometry(AppState &app, std::vector<Point> &pts, std::vector<float> &cols) {
+  pts.clear();
+  cols.clear();
   pts.reserve(200000);
   cols.reserve(600000);
 
@@ -6212,7 +7135,7 @@ void build_bridge_geometry(AppState &app) {
     AppState::Param *p1 = find_param(app, app.bif_param);
     AppState::Param *p2 = find_param(app, app.bridge_param2);
     const size_t dim = app.state_names.size();
-    if (p1 == nullptr || dim == 0) { app.bridge_point_count = 0; app.bridge_built = true; return; }
+    if (p1 == nullptr || dim == 0) return;
 
     /* observable: a state index if bif_observable names one, else state 0. */
     size_t obs_idx = 0;
@@ -6248,7 +7171,7 @@ void build_bridge_geometry(AppState &app) {
       State cur = app.start, nxt = app.start;
       resize_state(cur, dim); resize_state(nxt, dim);
       char ferr[128] = {0};
-      for (int jz = 0; jz < RES; ++jz) {
+      for (int jz = 0; jz < RES && !job_cancelled(app); ++jz) {
         const double v = (double)jz / (RES - 1);
         const double ic = ic_lo + (ic_hi - ic_lo) * v;
         for (int ix2 = 0; ix2 < RES; ++ix2) {
@@ -6301,7 +7224,7 @@ void build_bridge_geometry(AppState &app) {
      * Only the diagram points get height-rescaled/recolored below. */
     const size_t floor_count = pts.size();
 
-    for (int zi = 0; zi < zslices; ++zi) {
+    for (int zi = 0; zi < zslices && !job_cancelled(app); ++zi) {
       /* When there's no 2nd parameter we draw ONE diagram; place it at the
        * floor's center line (v=0.5) so it visibly rises out of the fractal
        * floor, mirroring how the logistic cascade sits on the Mandelbrot
@@ -6393,22 +7316,6 @@ void build_bridge_geometry(AppState &app) {
       cols[i * 3 + 2] = 0.9f - 0.6f * t;
     }
 
-    app.bridge_point_count = (int)pts.size();
-    if (pts.empty()) { app.bridge_built = true; return; }
-    if (app.bridge_vao == 0) glGenVertexArrays(1, &app.bridge_vao);
-    if (app.bridge_vbo == 0) glGenBuffers(1, &app.bridge_vbo);
-    if (app.bridge_cbo == 0) glGenBuffers(1, &app.bridge_cbo);
-    glBindVertexArray(app.bridge_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, app.bridge_vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(pts.size() * sizeof(Point)), pts.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Point), (void *)0);
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, app.bridge_cbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(cols.size() * sizeof(float)), cols.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-    app.bridge_built = true;
     return;
   }
 
@@ -6480,7 +7387,7 @@ void build_bridge_geometry(AppState &app) {
     const double sine_im_bail = 30.0;
     std::vector<double> zre((size_t)max_iter);
 
-    for (int vx = 0; vx < nx; ++vx) {
+    for (int vx = 0; vx < nx && !job_cancelled(app); ++vx) {
       for (int vz = 0; vz < nz; ++vz) {
         const double c_re = off_x + vx * step_x;
         const double c_im = off_z + vz * step_z;
@@ -6549,22 +7456,6 @@ void build_bridge_geometry(AppState &app) {
       }
     }
 
-    app.bridge_point_count = (int)pts.size();
-    if (pts.empty()) { app.bridge_built = true; return; }
-    if (app.bridge_vao == 0) glGenVertexArrays(1, &app.bridge_vao);
-    if (app.bridge_vbo == 0) glGenBuffers(1, &app.bridge_vbo);
-    if (app.bridge_cbo == 0) glGenBuffers(1, &app.bridge_cbo);
-    glBindVertexArray(app.bridge_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, app.bridge_vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(pts.size() * sizeof(Point)), pts.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Point), (void *)0);
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, app.bridge_cbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(cols.size() * sizeof(float)), cols.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-    app.bridge_built = true;
     return;
   }
 
@@ -6581,7 +7472,7 @@ void build_bridge_geometry(AppState &app) {
     const int RES = std::max(80, app.bridge_mandel_res);
     const int maxit = 200;
     const double R2 = 16.0;
-    for (int j = 0; j < RES; ++j) {
+    for (int j = 0; j < RES && !job_cancelled(app); ++j) {
       const double im = im_lo + (im_hi - im_lo) * j / (RES - 1);
       for (int i = 0; i < RES; ++i) {
         const double re = re_lo + (re_hi - re_lo) * i / (RES - 1);
@@ -6640,7 +7531,7 @@ void build_bridge_geometry(AppState &app) {
       }
       return maxp + 1;
     };
-    for (int s = 0; s < slices; ++s) {
+    for (int s = 0; s < slices && !job_cancelled(app); ++s) {
       const double r = 1.0 + (4.0 - 1.0) * s / (slices - 1);
       double x = 0.5;
       for (int k = 0; k < discard; ++k) x = r * x * (1.0 - x);
@@ -6693,10 +7584,12 @@ void build_bridge_geometry(AppState &app) {
       }
     }
   }
+}
 
+void upload_bridge_geometry(AppState &app, const std::vector<Point> &pts, const std::vector<float> &cols) {
   app.bridge_point_count = (int)pts.size();
-  if (pts.empty()) { app.bridge_built = true; return; }
-
+  app.bridge_built = true;
+  if (pts.empty()) return;
   if (app.bridge_vao == 0) glGenVertexArrays(1, &app.bridge_vao);
   if (app.bridge_vbo == 0) glGenBuffers(1, &app.bridge_vbo);
   if (app.bridge_cbo == 0) glGenBuffers(1, &app.bridge_cbo);
@@ -6710,14 +7603,35 @@ void build_bridge_geometry(AppState &app) {
   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
   glEnableVertexAttribArray(1);
   glBindVertexArray(0);
-  app.bridge_built = true;
+}
+
+void build_bridge_geometry(AppState &app) {
+  std::vector<Point> pts;
+  std::vector<float> cols;
+  compute_bridge_geometry(app, pts, cols);
+  upload_bridge_geometry(app, pts, cols);
 }
 
 void render_bridge_scene(AppState &app) {
   glViewport(0, 0, app.window_width, app.window_height);
   const float aspect = (float)app.window_width / std::max(1.0f, (float)app.window_height);
 
-  if (!app.bridge_built) build_bridge_geometry(app);
+  if (!app.bridge_built) {
+    app.bridge_built = true; /* requested; the job's geometry lands when it is done */
+    if (app.async_views && !app.use_ast_fallback)
+      start_view_job(app, app.bridge_job, [](AppState &snap, ViewJob &job) {
+        std::vector<Point> pts;
+        std::vector<float> cols;
+        compute_bridge_geometry(snap, pts, cols);
+        if (job.cancel.cancelled()) return;
+        view_job_publish(job, [pts = std::move(pts), cols = std::move(cols)](AppState &ui) {
+          upload_bridge_geometry(ui, pts, cols);
+        });
+      });
+    else
+      build_bridge_geometry(app);
+  }
+  land_view_job(app, app.bridge_job);
 
   /* Frame the geometry on first entry (or when it was just rebuilt for a new
    * mode). The point clouds span roughly +/-23 in X, 0..26 in Y, +/-17 in Z,
@@ -6867,7 +7781,9 @@ void render_bridge_scene(AppState &app) {
     draw->AddText(ImVec2(14, app.window_toolbar_h + 26.0f), IM_COL32(170, 170, 180, 220),
                   "this system has NO unified fractal<->bifurcation bridge (only logistic/cubic/sine/Mandelbrot do), "
                   "so this lifts its own bifurcation diagram into 3D instead.  drag: rotate   wheel: zoom");
-    if (app.bridge_point_count == 0)
+    if (app.bridge_job)
+      draw->AddText(ImVec2(14, 52), IM_COL32(170, 170, 180, 220), "building…");
+    else if (app.bridge_point_count == 0)
       draw->AddText(ImVec2(14, 52), IM_COL32(255, 210, 120, 240),
                     "no points — check the x param name/range and observable in the Setup tab, then Rebuild bridge.");
   } else if (app.bridge_mode == AppState::BridgeMode::ProjectionSolid) {
@@ -7494,6 +8410,64 @@ void draw_series_plot(AppState &app, const char *title, const char *value_name,
   ImGui::Dummy(size);
 }
 
+/* Welch power spectrum of app.spectrum_observable over the history, with
+ * the sample spacing taken from the history's mean time step. Rebuilt at
+ * most four times a second, and only when the orbit has moved on. */
+void draw_power_spectrum_plot(AppState &app, ImVec2 size) {
+  const char *name = app.spectrum_observable;
+  const double now = glfwGetTime();
+  const double t_last = app.history.empty() ? 0.0 : app.history.back().t;
+  if (app.spectrum_of != name || (now - app.spectrum_built_at > 0.25 && t_last != app.spectrum_t_last)) {
+    std::vector<double> vals;
+    vals.reserve(app.history.size());
+    for (const State &s : app.history) {
+      double v = 0.0;
+      if (value_by_name(app, s, name, &v) && std::isfinite(v)) vals.push_back(v);
+    }
+    const double span = app.history.size() > 1 ? app.history.back().t - app.history.front().t : 0.0;
+    const double dt = span > 0 ? span / (double)(app.history.size() - 1) : 1.0;
+    app.spectrum = dynsys::analysis::power_spectrum(vals, dt);
+    app.spectrum_of = name;
+    app.spectrum_t_last = t_last;
+    app.spectrum_built_at = now;
+  }
+  const dynsys::analysis::PowerSpectrum &S = app.spectrum;
+  ImDrawList *draw = ImGui::GetWindowDrawList();
+  ImVec2 p0 = ImGui::GetCursorScreenPos();
+  if (size.x <= 0) size.x = ImGui::GetContentRegionAvail().x;
+  ImVec2 p1(p0.x + size.x, p0.y + size.y);
+  draw->AddRectFilled(p0, p1, IM_COL32(20, 20, 24, 220));
+  draw->AddRect(p0, p1, IM_COL32(120, 120, 120, 200));
+  if (!S.ok) {
+    draw->AddText(ImVec2(p0.x + 4, p0.y + 4), IM_COL32(180, 180, 180, 220), S.message.c_str());
+    ImGui::Dummy(size);
+    return;
+  }
+  /* skip the DC bin; log scale spans the top 10 decades */
+  auto y_of = [&](double p) { return app.spectrum_log ? std::log10(std::max(p, 1e-300)) : p; };
+  double mx = -DBL_MAX, mn = DBL_MAX;
+  for (size_t k = 1; k < S.power.size(); ++k) {
+    mx = std::max(mx, y_of(S.power[k]));
+    mn = std::min(mn, y_of(S.power[k]));
+  }
+  if (app.spectrum_log) mn = std::max(mn, mx - 10.0);
+  else mn = 0.0;
+  if (mx <= mn) mx = mn + 1.0;
+  const double fmax = S.frequency.back();
+  auto sx = [&](double f) { return p0.x + (float)(f / fmax) * size.x; };
+  auto sy = [&](double p) { return p1.y - (float)((std::max(y_of(p), mn) - mn) / (mx - mn)) * size.y; };
+  for (size_t k = 2; k < S.power.size(); ++k)
+    draw->AddLine(ImVec2(sx(S.frequency[k - 1]), sy(S.power[k - 1])), ImVec2(sx(S.frequency[k]), sy(S.power[k])),
+                  IM_COL32(255, 190, 90, 255), 1.0f);
+  draw->AddLine(ImVec2(sx(S.peak_frequency), p0.y), ImVec2(sx(S.peak_frequency), p1.y), IM_COL32(120, 210, 255, 160),
+                1.0f);
+  char label[160];
+  std::snprintf(label, sizeof(label), "peak f = %.5g (T = %.5g), 0 .. %.4g, %d segments", S.peak_frequency,
+                S.peak_period, fmax, S.segments);
+  draw->AddText(ImVec2(p0.x + 4, p0.y + 4), IM_COL32(180, 180, 180, 220), label);
+  ImGui::Dummy(size);
+}
+
 void draw_scatter_plot(const char *title, const std::vector<Point2> &points, ImVec2 size) {
   ImGui::Text("%s (%zu points)", title, points.size());
   ImDrawList *draw = ImGui::GetWindowDrawList();
@@ -7894,6 +8868,71 @@ void find_fixed_point(AppState &app) {
  * implementation (Phase 3) will set model.jacobian_x without changing
  * any caller. n_state is fixed; the parameter is z[n].
  * ============================================================ */
+/* Forward-mode AD over the IR at the app's current parameter values. For
+ * column j every equation program runs once with the dual seed on state
+ * variable j; the derivative component is J[row][j]. df/dp seeds parameter
+ * param_index instead. */
+static dynsys::ir::RunContext ad_context(AppState &app, State &s) {
+  dynsys::ir::RunContext rc;
+  rc.state = s.v.data();
+  rc.n_state = s.v.size();
+  rc.t = s.t;
+  rc.params = app.param_values.data();
+  rc.n_params = app.param_values.size();
+  rc.defs = app.definition_programs.data();
+  rc.n_defs = app.definition_programs.size();
+  return rc;
+}
+
+static bool ad_jacobian_x(AppState &app, const double *x, double *jac_out, std::string *err) {
+  const size_t n = app.state_names.size();
+  if (app.equation_programs.size() != n) {
+    if (err) *err = "equations are not compiled";
+    return false;
+  }
+  State s = make_state_like(n, app.current.t);
+  for (size_t i = 0; i < n; ++i) set_state_at(s, i, x[i]);
+  const dynsys::ir::RunContext rc = ad_context(app, s);
+  char buf[256] = {0};
+  for (size_t col = 0; col < n; ++col) {
+    dynsys::ir::DualSeed seed{dynsys::ir::DualSeed::Kind::State, col};
+    for (size_t row = 0; row < n; ++row) {
+      double v = 0.0, d = 0.0;
+      if (!dynsys::ir::run_dual(app.equation_programs[row], rc, seed,
+                                app.ad_scratch, &v, &d, buf, sizeof(buf))) {
+        if (err) *err = buf;
+        return false;
+      }
+      jac_out[row * n + col] = d;
+    }
+  }
+  return true;
+}
+
+static bool ad_dfdp(AppState &app, const double *x, size_t param_index, double *dfdp_out,
+                    std::string *err) {
+  const size_t n = app.state_names.size();
+  if (app.equation_programs.size() != n) {
+    if (err) *err = "equations are not compiled";
+    return false;
+  }
+  State s = make_state_like(n, app.current.t);
+  for (size_t i = 0; i < n; ++i) set_state_at(s, i, x[i]);
+  const dynsys::ir::RunContext rc = ad_context(app, s);
+  char buf[256] = {0};
+  dynsys::ir::DualSeed seed{dynsys::ir::DualSeed::Kind::Param, param_index};
+  for (size_t row = 0; row < n; ++row) {
+    double v = 0.0, d = 0.0;
+    if (!dynsys::ir::run_dual(app.equation_programs[row], rc, seed,
+                              app.ad_scratch, &v, &d, buf, sizeof(buf))) {
+      if (err) *err = buf;
+      return false;
+    }
+    dfdp_out[row] = d;
+  }
+  return true;
+}
+
 dynsys::analysis::Model build_model(AppState &app, AppState::Param *param) {
   dynsys::analysis::Model model;
   model.n = app.state_names.size();
@@ -7920,100 +8959,34 @@ dynsys::analysis::Model build_model(AppState &app, AppState::Param *param) {
     for (size_t i = 0; i < n; ++i) f_out[i] = state_at(deriv, i);
     return true;
   };
-  /* PHASE3: exact Jacobian and df/dp via forward-mode AD over the IR.
-   * For column j we evaluate every equation program once with the dual
-   * seed on state variable j; the derivative component is J[row][j].
-   * df/dp seeds the active continuation parameter instead. This makes
-   * the continuation engine's linear algebra exact rather than
-   * finite-difference-noisy, with no change to any caller. */
+  /* PHASE3: exact Jacobian and df/dp via forward-mode AD over the IR
+   * (ad_jacobian_x / ad_dfdp). This makes the continuation engine's linear
+   * algebra exact rather than finite-difference-noisy, with no change to
+   * any caller. */
   size_t param_index = 0;
   for (size_t i = 0; i < app.params.size(); ++i)
     if (&app.params[i] == param) param_index = i;
 
-  model.jacobian_x = [&app, param, param_index](
-                         const double *x, double p, double *jac_out,
-                         std::string *err) -> bool {
-    const size_t n = app.state_names.size();
-    if (app.equation_programs.size() != n) {
-      if (err) *err = "equations are not compiled";
-      return false;
-    }
+  model.jacobian_x = [&app, param](const double *x, double p, double *jac_out,
+                                   std::string *err) -> bool {
     const double saved = param->value;
     param->value = p;
     sync_param_values(app);
-
-    State s = make_state_like(n, app.current.t);
-    for (size_t i = 0; i < n; ++i) set_state_at(s, i, x[i]);
-
-    dynsys::ir::RunContext rc;
-    rc.state = s.v.data();
-    rc.n_state = s.v.size();
-    rc.t = s.t;
-    rc.params = app.param_values.data();
-    rc.n_params = app.param_values.size();
-    rc.defs = app.definition_programs.data();
-    rc.n_defs = app.definition_programs.size();
-
-    char buf[256] = {0};
-    bool ok = true;
-    for (size_t col = 0; col < n && ok; ++col) {
-      dynsys::ir::DualSeed seed{dynsys::ir::DualSeed::Kind::State, col};
-      for (size_t row = 0; row < n; ++row) {
-        double v = 0.0, d = 0.0;
-        if (!dynsys::ir::run_dual(app.equation_programs[row], rc, seed,
-                                  app.ad_scratch, &v, &d, buf, sizeof(buf))) {
-          ok = false;
-          break;
-        }
-        jac_out[row * n + col] = d;
-      }
-    }
+    const bool ok = ad_jacobian_x(app, x, jac_out, err);
     param->value = saved;
     sync_param_values(app);
-    (void)param_index;
-    if (!ok && err) *err = buf;
     return ok;
   };
 
   model.dfdp = [&app, param, param_index](const double *x, double p,
                                           double *dfdp_out,
                                           std::string *err) -> bool {
-    const size_t n = app.state_names.size();
-    if (app.equation_programs.size() != n) {
-      if (err) *err = "equations are not compiled";
-      return false;
-    }
     const double saved = param->value;
     param->value = p;
     sync_param_values(app);
-
-    State s = make_state_like(n, app.current.t);
-    for (size_t i = 0; i < n; ++i) set_state_at(s, i, x[i]);
-
-    dynsys::ir::RunContext rc;
-    rc.state = s.v.data();
-    rc.n_state = s.v.size();
-    rc.t = s.t;
-    rc.params = app.param_values.data();
-    rc.n_params = app.param_values.size();
-    rc.defs = app.definition_programs.data();
-    rc.n_defs = app.definition_programs.size();
-
-    char buf[256] = {0};
-    bool ok = true;
-    dynsys::ir::DualSeed seed{dynsys::ir::DualSeed::Kind::Param, param_index};
-    for (size_t row = 0; row < n; ++row) {
-      double v = 0.0, d = 0.0;
-      if (!dynsys::ir::run_dual(app.equation_programs[row], rc, seed,
-                                app.ad_scratch, &v, &d, buf, sizeof(buf))) {
-        ok = false;
-        break;
-      }
-      dfdp_out[row] = d;
-    }
+    const bool ok = ad_dfdp(app, x, param_index, dfdp_out, err);
     param->value = saved;
     sync_param_values(app);
-    if (!ok && err) *err = buf;
     return ok;
   };
 
@@ -8021,8 +8994,10 @@ dynsys::analysis::Model build_model(AppState &app, AppState::Param *param) {
 }
 
 /* Two-parameter model for fold/Hopf-curve continuation: the vector field as a
- * function of (x, p, q) where p and q are two chosen parameters. Finite-diff
- * Jacobians inside two_param_curve do the rest, so we only need the field. */
+ * function of (x, p, q) where p and q are two chosen parameters. The AD
+ * Jacobian and df/dp feed the minimally augmented correctors of
+ * two_param_curve and the cycle continuations behind the LPC / PD / NS
+ * curves. */
 dynsys::analysis::Model2 build_model2(AppState &app, AppState::Param *pp, AppState::Param *qp) {
   dynsys::analysis::Model2 model;
   model.n = app.state_names.size();
@@ -8043,6 +9018,29 @@ dynsys::analysis::Model2 build_model2(AppState &app, AppState::Param *pp, AppSta
     for (size_t i = 0; i < n; ++i) f_out[i] = state_at(deriv, i);
     return true;
   };
+  size_t p_index = 0;
+  for (size_t i = 0; i < app.params.size(); ++i)
+    if (&app.params[i] == pp) p_index = i;
+  model.jacobian_x = [&app, pp, qp](const double *x, double p, double q, double *jac_out,
+                                    std::string *err) -> bool {
+    const double sp = pp->value, sq = qp->value;
+    pp->value = p; qp->value = q;
+    sync_param_values(app);
+    const bool ok = ad_jacobian_x(app, x, jac_out, err);
+    pp->value = sp; qp->value = sq;
+    sync_param_values(app);
+    return ok;
+  };
+  model.dfdp = [&app, pp, qp, p_index](const double *x, double p, double q, double *dfdp_out,
+                                       std::string *err) -> bool {
+    const double sp = pp->value, sq = qp->value;
+    pp->value = p; qp->value = q;
+    sync_param_values(app);
+    const bool ok = ad_dfdp(app, x, p_index, dfdp_out, err);
+    pp->value = sp; qp->value = sq;
+    sync_param_values(app);
+    return ok;
+  };
   return model;
 }
 
@@ -8257,7 +9255,11 @@ void run_cycle_collocation(AppState &app) {
   dynsys::analysis::CycleSettings cs;
   if (param->has_range) { cs.p_min = param->min_value; cs.p_max = param->max_value; }
   else { cs.p_min = param->value - 3.0; cs.p_max = param->value + 3.0; }
-  cs.mesh = mesh; cs.dp = std::max(1e-3, (cs.p_max - cs.p_min) / 120.0); cs.max_steps = 400;
+  cs.dp = std::max(1e-3, (cs.p_max - cs.p_min) / 120.0); cs.max_steps = 400;
+  /* 20 intervals x 4 Gauss points: the simulated loop is resampled onto them,
+   * and with the adaptive mesh this resolves relaxation cycles that the
+   * trapezoidal scheme needs several hundred points for */
+  cs.mesh = 20; cs.ncol = 4;
   /* pseudo-arclength so the branch follows folds of cycles (LPC), with Floquet
    * multipliers for stability / period-doubling / torus detection. The
    * arclength step is sized to the parameter window so we cover it in a sane
@@ -8277,8 +9279,8 @@ void run_cycle_collocation(AppState &app) {
 
 /* PHASE E (nicety): trace a FOLD-OF-CYCLES (LPC) curve in the
  * (cont_param, twopar_p2) plane. Seeds a cycle by simulation at the current
- * (p,q), then calls analysis::lpc_curve which, for each q, continues the cycle
- * in p and locates the saddle-node of cycles. */
+ * (p,q), then calls analysis::lpc_curve which brackets the saddle-node of
+ * cycles on a branch in p and continues it directly in (p,q). */
 void run_lpc_curve(AppState &app) {
   app.lpc_ready = false;
   if (app.mode != SystemMode::ODE) { app.lpc_msg = "fold-of-cycles curves are for ODE systems"; return; }
@@ -8876,17 +9878,32 @@ void run_lc_continuation(AppState &app) {
 }
 
 /* PHASE B/C: estimate the box-counting fractal dimension of the on-screen
- * set in the current 2D plane. For a MAP we iterate from the start state
- * (after a transient) to sample the attractor densely; for an ODE we use
- * the live trajectory history (already the settled attractor). */
+ * set in the current 2D plane, or of the whole state vector when
+ * boxdim_full_state is set (up to 32 variables). For a MAP we iterate from
+ * the start state (after a transient) to sample the attractor densely; for
+ * an ODE we use the live trajectory history (already the settled attractor). */
 void run_box_dimension(AppState &app) {
   app.boxdim_ready = false;
   const size_t n = app.state_names.size();
   if (n < 1) { app.boxdim_msg = "no system"; return; }
   const size_t ix = (size_t)std::max(0, std::min(app.phase_x_index, (int)n - 1));
   const size_t iy = (size_t)std::max(0, std::min(app.phase_y_index, (int)n - 1));
-
-  std::vector<double> xs, ys;
+  const bool full = app.boxdim_full_state && n <= 32;
+  const size_t dim = full ? n : 2;
+
+  /* row-major points, dim coordinates each */
+  std::vector<double> pts;
+  auto add_point = [&](const State &st) {
+    const size_t at = pts.size();
+    if (full) {
+      for (size_t k = 0; k < n; ++k) pts.push_back(state_at(st, k));
+    } else {
+      pts.push_back(state_at(st, ix));
+      pts.push_back(state_at(st, iy));
+    }
+    for (size_t k = at; k < pts.size(); ++k)
+      if (!std::isfinite(pts[k])) { pts.resize(at); return; }
+  };
   char err[128] = {0};
 
   if (app.mode == SystemMode::Map) {
@@ -8898,27 +9915,24 @@ void run_box_dimension(AppState &app) {
       State nx{}; if (!step_map_state(app, s, &nx, err, sizeof(err))) { app.boxdim_msg = err; return; }
       s = nx;
     }
-    xs.reserve(samples); ys.reserve(samples);
+    pts.reserve((size_t)samples * dim);
     for (int i = 0; i < samples; ++i) {
       State nx{}; if (!step_map_state(app, s, &nx, err, sizeof(err))) break;
       s = nx;
-      const double x = state_at(s, ix), y = state_at(s, iy);
-      if (std::isfinite(x) && std::isfinite(y)) { xs.push_back(x); ys.push_back(y); }
+      add_point(s);
     }
   } else {
     /* ODE: use the trajectory history (the visible orbit/attractor) */
-    for (const State &st : app.history) {
-      const double x = state_at(st, ix), y = state_at(st, iy);
-      if (std::isfinite(x) && std::isfinite(y)) { xs.push_back(x); ys.push_back(y); }
-    }
-    if (xs.size() < 500) {
+    for (const State &st : app.history) add_point(st);
+    if (pts.size() / dim < 500) {
       app.boxdim_msg = "need a longer trajectory — let the ODE run, then retry";
       return;
     }
   }
 
-  dynsys::analysis::BoxCountResult R = dynsys::analysis::box_counting_dimension(xs, ys, 12);
-  app.boxdim_n_points = (long)xs.size();
+  dynsys::analysis::BoxCountResult R = dynsys::analysis::box_counting_dimension_nd(pts, (int)dim, 12);
+  app.boxdim_n_points = (long)(pts.size() / dim);
+  app.boxdim_dim = (int)dim;
   if (!R.ok) { app.boxdim_msg = R.message; return; }
   app.boxdim_ready = true;
   app.boxdim_value = R.dimension;
@@ -9292,7 +10306,7 @@ void draw_top_toolbar(AppState &app) {
     ImGui::Text("IFS model: %zu maps", app.ifs_maps.size());
     ImGui::SameLine(); ImGui::SetNextItemWidth(120);
     int it = (int)app.ifs_iterations;
-    if (ImGui::SliderInt("iters##ifs", &it, 50000, 2000000)) { app.ifs_iterations = it; app.ifs_dirty = true; }
+    if (ImGui::SliderInt("iters##ifs", &it, 50000, 50000000)) { app.ifs_iterations = it; app.ifs_dirty = true; }
     ImGui::SameLine();
   }
   if (app.active_view == AppState::ActiveView::LimitCycle && !app.params.empty()) {
@@ -9384,6 +10398,32 @@ void draw_gui(AppState &app) {
     else
       ImGui::TextColored(ImVec4(0.5f, 0.85f, 0.6f, 1.0f), "headroom OK (%.0f ms/frame)", app.perf_frame_ms);
   }
+  if (ImGui::Checkbox("compute heavy views in the background", &app.async_views)) {
+    /* switch over cleanly: drop running jobs and let each view recompute */
+    stop_view_jobs(app);
+    app.fractal_dirty = true; app.basin_dirty = true; app.scan_dirty = true;
+    app.bridge_built = false;
+  }
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Fractal, basin, 2-parameter scan and 3D bridge rebuilds run on worker\n"
+                      "threads and appear level by level; the UI never waits for them.");
+  ImGui::SetNextItemWidth(160);
+  const bool tiles_were_on = app.tile_cache_mb > 0;
+  if (ImGui::SliderInt("view tile cache (MB)", &app.tile_cache_mb, 0, 2048)) {
+    app.tile_cache_mb = std::max(0, app.tile_cache_mb);
+    app.view_tiles->set_capacity((size_t)app.tile_cache_mb << 20);
+    if (app.tile_cache_mb == 0) app.view_tiles->clear();
+    if ((app.tile_cache_mb > 0) != tiles_were_on) { app.fractal_dirty = true; app.basin_dirty = true; }
+  }
+  if (ImGui::IsItemHovered()) {
+    const auto st = app.view_tiles->stats();
+    ImGui::SetTooltip("Fractal and basin views are built from cached 64x64 tiles, so pan, zoom\n"
+                      "and going back only compute what was never on screen. 0 = off (default).\n"
+                      "Tiles sit on a power-of-two grid and the view takes the nearest tile\n"
+                      "sample, so a cached view is resampled, not pixel-exact.\n"
+                      "%zu tiles, %.1f MB held; %ld hits, %ld misses, %ld evicted",
+                      st.tiles, st.bytes / 1048576.0, st.hits, st.misses, st.evictions);
+  }
   std::string state_line = "t " + std::to_string(app.current.t);
   for (size_t i = 0; i < app.state_names.size(); ++i) {
     char buf[96];
@@ -9490,29 +10530,48 @@ void draw_gui(AppState &app) {
     const bool can_buddha = (app.state_names.size() >= 2 && app.params.size() >= 2);
     if (!can_state_space) app.fractal_mode = AppState::FractalMode::ParameterSpace;
     if (ImGui::CollapsingHeader("Fractal", ImGuiTreeNodeFlags_DefaultOpen)) {
-      int mode = (int)app.fractal_mode;
+      const int mode = (int)app.fractal_mode;
       const char *modes[] = {"parameter space (Mandelbrot-type)", "state space (Julia-type)",
-                             "Buddhabrot (trajectory density)"};
-      const int nmodes = can_buddha ? 3 : 2;
+                             "Buddhabrot (trajectory density)", "deep zoom (perturbation)"};
+      const bool mode_ok[] = {true, true, can_buddha, true};
       if (!can_state_space) ImGui::BeginDisabled();
-      if (ImGui::Combo("mode", &mode, modes, nmodes)) {
-        app.fractal_mode = (AppState::FractalMode)mode;
-        app.fractal_dirty = true;
+      if (ImGui::BeginCombo("mode", modes[mode])) {
+        for (int i = 0; i < 4; ++i) {
+          if (!mode_ok[i]) continue;
+          if (ImGui::Selectable(modes[i], i == mode) && i != mode) {
+            app.fractal_mode = (AppState::FractalMode)i;
+            /* the deep view starts from the current window */
+            if (app.fractal_mode == AppState::FractalMode::DeepZoom) fractal_deep_from_window(app);
+            app.fractal_dirty = true;
+          }
+        }
+        ImGui::EndCombo();
       }
       if (!can_state_space) {
         ImGui::EndDisabled();
         if (ImGui::IsItemHovered())
           ImGui::SetTooltip("State-space (Julia) needs 2 state variables; this 1-D map only has parameter-space.");
       }
-      if (app.fractal_mode == AppState::FractalMode::Buddhabrot)
+      if (app.fractal_mode == AppState::FractalMode::Buddhabrot) {
         ImGui::TextWrapped("Buddhabrot: accumulates the orbits of ESCAPING points into a density "
                            "map. It builds up and sharpens the longer you leave it. Best on the "
                            "complex-quadratic (Mandelbrot) system.");
+        if (ImGui::Checkbox("importance sampling", &app.buddha_importance)) app.fractal_dirty = true;
+        if (ImGui::IsItemHovered())
+          ImGui::SetTooltip("Metropolis-Hastings: new samples are drawn near c whose orbits already\n"
+                            "cross the view, each weighted so the density stays the same. A zoomed\n"
+                            "view fills in orders of magnitude sooner than with uniform c.");
+      } else if (app.fractal_mode == AppState::FractalMode::DeepZoom)
+        ImGui::TextWrapped("Deep zoom: one reference orbit in double-double precision at the view "
+                           "centre, every other pixel as a double-precision perturbation from it. "
+                           "Zooms to ~1e-28 instead of ~1e-13. Needs a polynomial map "
+                           "(+, -, *, division by constants, integer powers, abs).");
       else
       ImGui::TextWrapped("Mandelbrot = which parameter values keep the start orbit bounded. "
                          "Julia = which initial points stay bounded for fixed parameters. "
                          "The logistic bifurcation diagram is the real-axis slice of this.");
-      if (app.fractal_mode == AppState::FractalMode::ParameterSpace && app.params.size() >= 1) {
+      if ((app.fractal_mode == AppState::FractalMode::ParameterSpace ||
+           app.fractal_mode == AppState::FractalMode::DeepZoom) && app.params.size() >= 1) {
         if (ImGui::BeginCombo("re axis = param", app.params[std::min((size_t)app.fractal_param_cx_index, app.params.size()-1)].name.c_str())) {
           for (int i = 0; i < (int)app.params.size(); ++i)
             if (ImGui::Selectable(app.params[i].name.c_str(), i == app.fractal_param_cx_index)) { app.fractal_param_cx_index = i; app.fractal_dirty = true; }
@@ -9527,12 +10586,34 @@ void draw_gui(AppState &app) {
           ImGui::TextColored(ImVec4(1.0f, 0.75f, 0.3f, 1.0f),
                              "both axes are the same parameter — the image collapses to a diagonal; pick two different parameters.");
       }
-      if (ImGui::SliderInt("max iterations", &app.fractal_max_iter, 20, 2000)) app.fractal_dirty = true;
+      const bool deep = (app.fractal_mode == AppState::FractalMode::DeepZoom);
+      if (ImGui::SliderInt("max iterations", &app.fractal_max_iter, 20, deep ? 100000 : 2000)) app.fractal_dirty = true;
       if (ImGui::InputDouble("escape radius", &app.fractal_escape_r, 0.5, 1.0, "%.3g")) app.fractal_dirty = true;
       if (ImGui::Checkbox("smooth coloring", &app.fractal_smooth)) app.fractal_dirty = true;
+      if (deep) {
+        if (ImGui::Checkbox("series approximation", &app.fractal_deep_series)) app.fractal_dirty = true;
+        if (ImGui::IsItemHovered())
+          ImGui::SetTooltip("Advance every pixel through the first iterations at once with a power series\n"
+                            "in the pixel offset, for as long as its high-order terms stay negligible.");
+      } else if (app.fractal_mode != AppState::FractalMode::Buddhabrot) {
+        if (ImGui::Checkbox("boundary tracing", &app.fractal_boundary_trace)) app.fractal_dirty = true;
+        if (ImGui::IsItemHovered())
+          ImGui::SetTooltip("Mariani-Silver: iterate only rectangle borders and fill the uniform ones.\n"
+                            "Much faster on large in-set regions, but approximate: detail enclosed by a\n"
+                            "uniform border is filled over. Close to exact only on Mandelbrot/Julia-type maps.");
+        if (ImGui::Checkbox("periodicity check", &app.fractal_periodicity)) app.fractal_dirty = true;
+        if (ImGui::IsItemHovered())
+          ImGui::SetTooltip("Stop iterating a point as soon as its orbit closes on an attracting cycle\n"
+                            "(Brent cycle detection) instead of running the full iteration budget.");
+        if (app.fractal_periodicity) {
+          ImGui::SameLine();
+          if (ImGui::Checkbox("color by period", &app.fractal_color_period)) app.fractal_dirty = true;
+        }
+      }
       if (ImGui::Button("Reset view")) {
         app.fractal_xmin = -2.5; app.fractal_xmax = 1.0;
         app.fractal_ymin = -1.5; app.fractal_ymax = 1.5;
+        fractal_deep_from_window(app);
         app.fractal_dirty = true;
       }
       ImGui::SameLine();
@@ -9666,6 +10747,65 @@ void draw_gui(AppState &app) {
       if (ImGui::SliderInt("steps per cell", &app.basin_steps, 100, 6000)) app.basin_dirty = true;
       if (ImGui::InputDouble("cluster tolerance", &app.basin_cluster_tol, 1e-3, 1e-2, "%.1e")) app.basin_dirty = true;
       if (ImGui::Checkbox("shade by convergence speed", &app.basin_shade_speed)) app.basin_dirty = true;
+      if (ImGui::Checkbox("reuse classified cells", &app.basin_memoize)) app.basin_dirty = true;
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Cell mapping: an orbit that runs through cells already classified\n"
+                          "to the same attractor stops and takes their label. Far fewer steps\n"
+                          "on smooth flows; cells right on a basin boundary may flip.");
+      if (ImGui::Checkbox("refine only at boundaries", &app.basin_adaptive)) app.basin_dirty = true;
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Quadtree refinement: blocks whose border cells all reach one attractor\n"
+                          "are filled without integration; only boundary blocks are subdivided.\n"
+                          "A tiny basin island inside such a block can be missed.");
+      if (ImGui::Checkbox("classify cycles and chaotic sets", &app.basin_fingerprint)) app.basin_dirty = true;
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Orbits that never settle run on and are fingerprinted: period for maps,\n"
+                          "section crossings for flows, occupancy for chaotic sets. Each limit\n"
+                          "cycle or chaotic attractor then gets its own basin instead of grey.");
+      if (app.state_names.size() >= 3) {
+        if (ImGui::Checkbox("3-D volume", &app.basin_volume_mode)) app.basin_dirty = true;
+        if (ImGui::IsItemHovered())
+          ImGui::SetTooltip("Classify a cube of initial conditions: the view's x/y window times a\n"
+                            "range of a third state variable. Slices fill in coarse to fine;\n"
+                            "view one slice or the first-hit surface, and export the labels.");
+      }
+      if (app.basin_volume_mode && app.state_names.size() >= 3) {
+        const int ns = (int)app.state_names.size();
+        app.basin_z_index = std::max(0, std::min(app.basin_z_index, ns - 1));
+        if (ImGui::BeginCombo("z axis", app.state_names[(size_t)app.basin_z_index].c_str())) {
+          for (int i = 0; i < ns; ++i)
+            if (ImGui::Selectable(app.state_names[(size_t)i].c_str(), i == app.basin_z_index)) {
+              app.basin_z_index = i;
+              app.basin_dirty = true;
+            }
+          ImGui::EndCombo();
+        }
+        if (app.basin_z_index == app.phase_x_index || app.basin_z_index == app.phase_y_index)
+          ImGui::TextColored(ImVec4(1.0f, 0.75f, 0.3f, 1.0f), "z should differ from the view's x and y variables.");
+        if (ImGui::InputDouble("z min", &app.basin_z_min, 0.0, 0.0, "%.4g")) app.basin_dirty = true;
+        ImGui::SameLine();
+        if (ImGui::InputDouble("z max", &app.basin_z_max, 0.0, 0.0, "%.4g")) app.basin_dirty = true;
+        if (ImGui::SliderInt("cells per axis", &app.basin_vol_res, 16, 128)) app.basin_dirty = true;
+        const int depth = app.basin_vol ? app.basin_vol->labels.depth() : app.basin_vol_res;
+        if (ImGui::Checkbox("render volume (first hit)", &app.basin_vol_project)) upload_basin_volume(app);
+        if (!app.basin_vol_project && ImGui::SliderInt("z slice", &app.basin_vol_slice, 0, std::max(0, depth - 1)))
+          upload_basin_volume(app);
+        ImGui::InputText("volume file", app.basin_vol_path, sizeof(app.basin_vol_path));
+        if (ImGui::Button("Export volume") && app.basin_vol) {
+          const dynsys::analysis::BasinVolume &v = *app.basin_vol;
+          dynsys::volume::VolumeMeta meta;
+          meta.lo = v.lo; /* the box it was computed on, not the view now */
+          meta.hi = v.hi;
+          meta.attractors = v.attractors;
+          meta.axes = {{app.state_names[(size_t)app.phase_x_index], app.state_names[(size_t)app.phase_y_index],
+                        app.state_names[(size_t)app.basin_z_index]}};
+          if (dynsys::volume::write_file(app.basin_vol_path, v.labels, meta))
+            app.analysis_message = std::string("exported basin volume (") + std::to_string(v.labels.filled()) + " of " +
+                                   std::to_string(v.labels.depth()) + " slices): " + app.basin_vol_path;
+          else
+            app.analysis_message = std::string("could not write basin volume: ") + app.basin_vol_path;
+        }
+      }
       if (ImGui::Button("Recompute basins")) app.basin_dirty = true;
       ImGui::TextDisabled("%d basins found. Pan/zoom shares the phase-plane view.", app.basin_attractor_count);
     }
@@ -10012,10 +11152,15 @@ void draw_gui(AppState &app) {
     /* PHASE B/C: box-counting fractal dimension of the on-screen set */
     ImGui::SeparatorText("Box-counting (fractal) dimension");
     if (ImGui::Button("Measure box-counting dimension")) run_box_dimension(app);
+    ImGui::SameLine();
+    ImGui::Checkbox("all state variables", &app.boxdim_full_state);
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Count boxes in the full state space (e.g. 3-D for Lorenz)\n"
+                        "instead of the 2D plane's projection.");
     if (app.boxdim_ready) {
       ImGui::TextColored(ImVec4(0.55f, 0.85f, 1.0f, 1.0f),
-                         "D_box = %.4f   (R^2 = %.3f, %ld points)",
-                         app.boxdim_value, app.boxdim_r2, app.boxdim_n_points);
+                         "D_box = %.4f   (R^2 = %.3f, %ld points in %d-D)",
+                         app.boxdim_value, app.boxdim_r2, app.boxdim_n_points, app.boxdim_dim);
       ImGui::TextDisabled("%s",
         app.mode == SystemMode::Map ? "sampled the map attractor"
                                     : "measured from the current trajectory");
@@ -10808,6 +11953,24 @@ void draw_gui(AppState &app) {
     for (const auto &obs : app.observables)
       draw_series_plot(app, obs.name.c_str(), obs.name.c_str(), ImVec2(-FLT_MIN, 90));
   }
+  if (ImGui::CollapsingHeader("Power spectrum")) {
+    if (app.spectrum_observable[0] == '\0' && !app.state_names.empty())
+      std::snprintf(app.spectrum_observable, sizeof(app.spectrum_observable), "%s", app.state_names[0].c_str());
+    if (ImGui::BeginCombo("signal", app.spectrum_observable)) {
+      for (const auto &nm : app.state_names)
+        if (ImGui::Selectable(nm.c_str(), nm == app.spectrum_observable))
+          std::snprintf(app.spectrum_observable, sizeof(app.spectrum_observable), "%s", nm.c_str());
+      for (const auto &obs : app.observables)
+        if (ImGui::Selectable(obs.name.c_str(), obs.name == app.spectrum_observable))
+          std::snprintf(app.spectrum_observable, sizeof(app.spectrum_observable), "%s", obs.name.c_str());
+      ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("log power", &app.spectrum_log);
+    draw_power_spectrum_plot(app, ImVec2(0, 140));
+    ImGui::TextDisabled("Welch estimate (Hann, half-overlapping segments) over the history buffer. "
+                        "A limit cycle shows a line and its harmonics, chaos a broad band.");
+  }
   if (ImGui::CollapsingHeader("Poincare section", ImGuiTreeNodeFlags_DefaultOpen)) {
     if (app.poincare_points.empty()) {
       ImGui::TextWrapped("No section points yet. Enable a section in the system text, e.g. for a "
@@ -10889,16 +12052,27 @@ void shutdown_imgui() {
  * step it N times, print the final state. Used for differential
  * testing (was the old simulation = new simulation?) and for
  * microbenchmarking the integrator hot loop in environments
- * without a display. */
+ * without a display. With --dimensions the steps after --transient are
+ * kept and their correlation dimension and D_q spectrum are printed
+ * (--theiler W sets the Theiler window in steps). */
 int run_headless(int argc, char **argv) {
   AppState app{};
   const char *path = nullptr;
   long long steps = 1000;
   bool dump_each = false;
   bool use_ast = false;
+  bool dimensions = false;
+  long long transient = 1000;
+  int theiler = 10;
   for (int i = 2; i < argc; ++i) {
     if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
       steps = std::strtoll(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--dimensions") == 0) {
+      dimensions = true;
+    } else if (std::strcmp(argv[i], "--transient") == 0 && i + 1 < argc) {
+      transient = std::strtoll(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--theiler") == 0 && i + 1 < argc) {
+      theiler = std::atoi(argv[++i]);
     } else if (std::strcmp(argv[i], "--dump") == 0) {
       dump_each = true;
     } else if (std::strcmp(argv[i], "--use-ast") == 0) {
@@ -10945,6 +12119,9 @@ int run_headless(int argc, char **argv) {
   std::printf("\n");
 
   char step_err[256] = {0};
+  const size_t dim = app.state_names.size();
+  std::vector<double> orbit; /* rows of dim, for --dimensions */
+  if (dimensions && steps > transient) orbit.reserve((size_t)(steps - transient) * dim);
   const auto t0 = std::chrono::steady_clock::now();
   for (long long s = 0; s < steps; ++s) {
     State next{};
@@ -10953,6 +12130,8 @@ int run_headless(int argc, char **argv) {
       return EXIT_FAILURE;
     }
     app.current = next;
+    if (dimensions && s >= transient)
+      for (size_t i = 0; i < dim; ++i) orbit.push_back(state_at(app.current, i));
     if (dump_each) {
       std::printf("%lld t=%.6f", s, app.current.t);
       for (size_t i = 0; i < app.state_names.size(); ++i) {
@@ -10972,6 +12151,24 @@ int run_headless(int argc, char **argv) {
   std::printf("elapsed: %.3f ms (%.1f ns/step)\n",
               elapsed_ns / 1e6, elapsed_ns / static_cast<double>(steps));
 
+  if (dimensions) {
+    dynsys::analysis::DimensionSpectrumOptions dopt;
+    dopt.theiler = theiler;
+    const auto d0 = std::chrono::steady_clock::now();
+    const dynsys::analysis::DimensionSpectrum D = dynsys::analysis::correlation_dimensions(orbit, (int)dim, dopt);
+    const double d_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - d0).count();
+    if (!D.ok) {
+      std::printf("dimensions: %s\n", D.message.c_str());
+    } else {
+      std::printf("dimensions: D2=%.4f (R^2 %.4f, radii %d..%d of %zu) points=%ld centres=%ld theiler=%d %.1f ms\n",
+                  D.correlation_dimension, D.correlation_r_squared, D.fit_first, D.fit_last, D.log_r.size(),
+                  D.points, D.centres, theiler, d_ms);
+      std::printf("D_q:");
+      for (size_t k = 0; k < D.qs.size(); ++k) std::printf(" q=%g:%.4f", D.qs[k], D.dq[k]);
+      std::printf("\n");
+    }
+  }
+
   if (app.arena_ready) arena_destroy(&app.system_arena);
   return EXIT_SUCCESS;
 }
@@ -11053,12 +12250,14 @@ int run_shot(int argc, char **argv) {
   if (!fractalmode_q.empty()) {
     if (fractalmode_q == "buddhabrot" || fractalmode_q == "buddha") app.fractal_mode = AppState::FractalMode::Buddhabrot;
     else if (fractalmode_q == "state" || fractalmode_q == "julia") app.fractal_mode = AppState::FractalMode::StateSpace;
+    else if (fractalmode_q == "deep") app.fractal_mode = AppState::FractalMode::DeepZoom;
     else app.fractal_mode = AppState::FractalMode::ParameterSpace;
     /* frame on the preset window, then mark init done so entry won't reset mode */
     if (app.home_view_set) {
       app.fractal_xmin = app.home_x_min; app.fractal_xmax = app.home_x_max;
       app.fractal_ymin = app.home_y_min; app.fractal_ymax = app.home_y_max;
     }
+    fractal_deep_from_window(app);
     app.fractal_view_init = true;
     app.fractal_dirty = true;
   }
@@ -11083,6 +12282,7 @@ int run_shot(int argc, char **argv) {
   /* else: leave whatever compile_system auto-detected for the loaded system */
 
   app.window_width = 1280; app.window_height = 1000; /* larger canvas for crisp shots */
+  app.async_views = false; /* a shot is taken after a fixed frame count: compute in-frame */
   GLFWwindow *window = nullptr;
   if (!init_glfw_window(app, &window)) { std::fprintf(stderr, "no GL window (need a display, e.g. Xvfb)\n"); return EXIT_FAILURE; }
   init_imgui(window);
@@ -11126,7 +12326,32 @@ int run_shot(int argc, char **argv) {
   return EXIT_SUCCESS;
 }
 
+/* --threads N / --pin-threads size the shared compute pool (thread_pool.h) in
+ * every mode. They are taken out of argv before the mode dispatch so the
+ * headless and --shot parsers never see them. */
+static bool take_pool_args(int &argc, char **argv) {
+  dynsys::pool::Config pc;
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--threads") == 0) {
+      if (i + 1 >= argc) { std::fprintf(stderr, "--threads needs a count\n"); return false; }
+      const long t = std::strtol(argv[++i], nullptr, 10);
+      if (t < 0 || t > 1024) { std::fprintf(stderr, "bad --threads: %s\n", argv[i]); return false; }
+      pc.threads = (unsigned)t;
+    } else if (std::strcmp(argv[i], "--pin-threads") == 0) {
+      pc.pin = true;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argc = out;
+  argv[argc] = nullptr;
+  dynsys::pool::configure(pc);
+  return true;
+}
+
 int main(int argc, char **argv) {
+  if (!take_pool_args(argc, argv)) return EXIT_FAILURE;
   if (argc >= 2 && std::strcmp(argv[1], "--headless") == 0) {
     return run_headless(argc, argv);
   }
@@ -11164,6 +12389,7 @@ int main(int argc, char **argv) {
     const double frame_start = glfwGetTime();
     update_perf_governor(app, (frame_start - prev_frame_time) * 1000.0);
     prev_frame_time = frame_start;
+    reap_view_jobs(app);
     if (!app.paused && app.mode != SystemMode::IFS) {
       /* throttle integration substeps: at full throttle do ~15% of the
        * requested steps (min 1). Keeps trajectory cost bounded when the
@@ -11235,6 +12461,7 @@ int main(int argc, char **argv) {
     }
     glfwSwapBuffers(window);
   }
+  stop_view_jobs(app);
   glDeleteVertexArrays(1, &app.vao);
   glDeleteBuffers(1, &app.vbo);
   glDeleteBuffers(1, &app.cbo);
@@ -0,0 +1,739 @@
+/* ============================================================
+ * Perturbation executor over the dynsys IR. See expr_ir_perturb.h.
+ *
+ * Three small VMs share the opcode subset perturb_check() admits:
+ * a double-double one for the reference orbit, a (reference,
+ * difference) pair one for the per-pixel orbit, and a truncated
+ * bivariate power series one for the series approximation. They are
+ * kept structurally parallel so the three are easy to diff.
+ * ============================================================ */
+
+#include "expr_ir_perturb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+namespace dynsys::ir {
+
+namespace {
+
+/* pi and e to double-double precision */
+constexpr DD kPiDD{3.141592653589793116e+00, 1.224646799147353207e-16};
+constexpr DD kEDD{2.718281828459045091e+00, 1.445646891729250158e-16};
+
+/* Pauldelbrot's glitch criterion: |Z + d| < kGlitchTol * |Z| */
+constexpr double kGlitchTol = 1e-3;
+/* the series is kept while its top-degree terms stay below this
+ * fraction of its linear ones (on the unit offset square) */
+constexpr double kSeriesTol = 1e-12;
+/* probe points must match the series to this relative accuracy */
+constexpr double kProbeTol = 1e-6;
+
+void set_err(char *buf, std::size_t cap, const char *fmt, ...) {
+  if (!buf || cap == 0) return;
+  va_list ap;
+  va_start(ap, fmt);
+  std::vsnprintf(buf, cap, fmt, ap);
+  va_end(ap);
+}
+
+DD quick_two_sum(double a, double b) {
+  const double s = a + b;
+  return DD{s, b - (s - a)};
+}
+
+DD two_sum(double a, double b) {
+  const double s = a + b;
+  const double bb = s - a;
+  return DD{s, (a - (s - bb)) + (b - bb)};
+}
+
+DD dd_neg(DD a) { return DD{-a.hi, -a.lo}; }
+
+DD dd_mul(DD a, double b) {
+  const double p = a.hi * b;
+  const double e = std::fma(a.hi, b, -p) + a.lo * b;
+  return quick_two_sum(p, e);
+}
+
+DD dd_powi(DD x, int k) {
+  DD r{1.0, 0.0};
+  while (k > 0) {
+    if (k & 1) r = dd_mul(r, x);
+    x = dd_mul(x, x);
+    k >>= 1;
+  }
+  return r;
+}
+
+/* |X + dx| - |X| without forming X + dx - X */
+double diffabs(double x, double dx) {
+  if (x >= 0.0) return (x + dx >= 0.0) ? dx : -(2.0 * x + dx);
+  return (x + dx > 0.0) ? (2.0 * x + dx) : -dx;
+}
+
+/* ---- monomial bookkeeping for the series VM ---- */
+
+struct SeriesTables {
+  int deg[kSeriesTerms];
+  int lin_u = -1, lin_v = -1;
+  /* every product of two monomials that stays within the order */
+  struct Prod {
+    int i, j, k;
+  };
+  std::vector<Prod> prods;
+
+  SeriesTables() {
+    int pu[kSeriesTerms], pv[kSeriesTerms];
+    int k = 0;
+    for (int g = 1; g <= kSeriesOrder; ++g)
+      for (int a = g; a >= 0; --a) {
+        pu[k] = a;
+        pv[k] = g - a;
+        deg[k] = g;
+        ++k;
+      }
+    for (int i = 0; i < kSeriesTerms; ++i) {
+      if (pu[i] == 1 && pv[i] == 0) lin_u = i;
+      if (pu[i] == 0 && pv[i] == 1) lin_v = i;
+    }
+    for (int i = 0; i < kSeriesTerms; ++i)
+      for (int j = 0; j < kSeriesTerms; ++j) {
+        if (deg[i] + deg[j] > kSeriesOrder) continue;
+        for (int m = 0; m < kSeriesTerms; ++m)
+          if (pu[m] == pu[i] + pu[j] && pv[m] == pv[i] + pv[j]) {
+            prods.push_back(Prod{i, j, m});
+            break;
+          }
+      }
+  }
+};
+
+const SeriesTables &series_tables() {
+  static const SeriesTables t;
+  return t;
+}
+
+/* A reference value plus a series in (u, v) with no constant term. */
+struct SVal {
+  double r = 0.0;
+  double c[kSeriesTerms] = {};
+};
+
+void s_mul(SVal &a, const SVal &b) {
+  const SeriesTables &T = series_tables();
+  double c[kSeriesTerms];
+  for (int i = 0; i < kSeriesTerms; ++i) c[i] = a.r * b.c[i] + b.r * a.c[i];
+  for (const auto &p : T.prods) c[p.k] += a.c[p.i] * b.c[p.j];
+  for (int i = 0; i < kSeriesTerms; ++i) a.c[i] = c[i];
+  a.r *= b.r;
+}
+
+/* Evaluates all maps on series values: ds_out[i] = F_i(Z_n + ds, P + dp)
+ * - F_i(Z_n, P), truncated. */
+void series_step(const std::vector<Program> &maps, const ReferenceOrbit &ref,
+                 int n, const std::vector<SVal> &ds,
+                 const std::vector<SVal> &dp, std::vector<SVal> &stack,
+                 std::vector<SVal> &ds_out) {
+  const double *Z = ref.z.data() + (std::size_t)n * ref.n_state;
+  for (std::size_t m = 0; m < maps.size(); ++m) {
+    const Program &program = maps[m];
+    stack.clear();
+    for (const Instr &ins : program.code) {
+      switch (ins.op) {
+        case Op::PushConst:
+          stack.emplace_back();
+          stack.back().r = program.constants[ins.a];
+          break;
+        case Op::PushState:
+          stack.push_back(ds[ins.a]);
+          stack.back().r = Z[ins.a];
+          break;
+        case Op::PushParam:
+          stack.push_back(dp[ins.a]);
+          stack.back().r = ref.params[ins.a];
+          break;
+        case Op::PushT:
+          stack.emplace_back();
+          break;
+        case Op::PushPi:
+          stack.emplace_back();
+          stack.back().r = kPiDD.hi;
+          break;
+        case Op::PushE:
+          stack.emplace_back();
+          stack.back().r = kEDD.hi;
+          break;
+        case Op::Neg: {
+          SVal &a = stack.back();
+          a.r = -a.r;
+          for (double &c : a.c) c = -c;
+          break;
+        }
+        case Op::Add:
+        case Op::Sub: {
+          const SVal b = stack.back();
+          stack.pop_back();
+          SVal &a = stack.back();
+          const double s = ins.op == Op::Add ? 1.0 : -1.0;
+          a.r += s * b.r;
+          for (int i = 0; i < kSeriesTerms; ++i) a.c[i] += s * b.c[i];
+          break;
+        }
+        case Op::Mul: {
+          const SVal b = stack.back();
+          stack.pop_back();
+          s_mul(stack.back(), b);
+          break;
+        }
+        case Op::Div: {
+          /* divisor is a constant (perturb_check) */
+          const double b = stack.back().r;
+          stack.pop_back();
+          SVal &a = stack.back();
+          a.r /= b;
+          for (double &c : a.c) c /= b;
+          break;
+        }
+        case Op::CallBuiltin: {
+          /* only pow(x, k) reaches here: abs() maps get no series */
+          const int k = (int)stack.back().r;
+          stack.pop_back();
+          const SVal x = stack.back();
+          SVal &r = stack.back();
+          r = SVal{};
+          r.r = 1.0;
+          for (int i = 0; i < k; ++i) s_mul(r, x);
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    ds_out[m] = stack.back();
+  }
+}
+
+/* Runs the series from iteration 0 while it stays accurate, up to
+ * max_skip iterations. Returns the number reached; ds holds d_skip. */
+int series_run(const std::vector<Program> &maps, const ReferenceOrbit &ref,
+               const PerturbPlane &plane, double scale_x, double scale_y,
+               int max_skip, std::vector<SVal> &ds) {
+  const SeriesTables &T = series_tables();
+  const std::size_t n = ref.n_state;
+  std::vector<SVal> dp(ref.params.size()), next(n), stack;
+  ds.assign(n, SVal{});
+  /* same axis twice: the y axis wins, as in perturb_pixel */
+  std::vector<SVal> &axes = plane.params ? dp : ds;
+  axes[plane.ix] = SVal{};
+  axes[plane.ix].c[T.lin_u] = scale_x;
+  axes[plane.iy] = SVal{};
+  axes[plane.iy].c[T.lin_v] = scale_y;
+  int skip = 0;
+  while (skip < max_skip) {
+    series_step(maps, ref, skip, ds, dp, stack, next);
+    const double *Z = ref.z.data() + (std::size_t)(skip + 1) * n;
+    bool ok = true;
+    double zz = 0.0, bb = 0.0, esc = 0.0;
+    for (std::size_t i = 0; i < n && ok; ++i) {
+      double lin = 0.0, top = 0.0, all = 0.0;
+      for (int k = 0; k < kSeriesTerms; ++k) {
+        const double a = std::fabs(next[i].c[k]);
+        if (T.deg[k] == 1) lin += a;
+        if (T.deg[k] == kSeriesOrder) top += a;
+        all += a;
+      }
+      if (!std::isfinite(all) || top > kSeriesTol * lin) ok = false;
+      zz += Z[i] * Z[i];
+      bb += all * all;
+      if (i < 2) esc += (std::fabs(Z[i]) + all) * (std::fabs(Z[i]) + all);
+    }
+    /* no pixel of the view may escape or glitch inside the skipped
+     * range: bound |d| by the sum of the coefficient magnitudes */
+    if (!ok || bb > 0.25 * zz) break;
+    if (esc > ref.escape_r2) break;
+    ds.swap(next);
+    ++skip;
+  }
+  return skip;
+}
+
+}  // namespace
+
+/* ---- double-double ---- */
+
+DD dd_add(DD a, DD b) {
+  DD s = two_sum(a.hi, b.hi);
+  const DD t = two_sum(a.lo, b.lo);
+  s.lo += t.hi;
+  s = quick_two_sum(s.hi, s.lo);
+  s.lo += t.lo;
+  return quick_two_sum(s.hi, s.lo);
+}
+
+DD dd_add(DD a, double b) {
+  DD s = two_sum(a.hi, b);
+  s.lo += a.lo;
+  return quick_two_sum(s.hi, s.lo);
+}
+
+DD dd_sub(DD a, DD b) { return dd_add(a, dd_neg(b)); }
+
+DD dd_mul(DD a, DD b) {
+  const double p = a.hi * b.hi;
+  const double e = std::fma(a.hi, b.hi, -p) + (a.hi * b.lo + a.lo * b.hi);
+  return quick_two_sum(p, e);
+}
+
+DD dd_div(DD a, DD b) {
+  const double q1 = a.hi / b.hi;
+  DD r = dd_sub(a, dd_mul(b, q1));
+  const double q2 = r.hi / b.hi;
+  r = dd_sub(r, dd_mul(b, q2));
+  const double q3 = r.hi / b.hi;
+  return dd_add(quick_two_sum(q1, q2), q3);
+}
+
+/* ---- static check ---- */
+
+PerturbSupport perturb_check(const std::vector<Program> &maps) {
+  PerturbSupport res;
+  if (maps.size() < 2) {
+    res.why = "needs a map with at least 2 state variables";
+    return res;
+  }
+  /* abstract stack: is the slot a compile-time constant, and its value */
+  struct Slot {
+    bool cst;
+    double v;
+  };
+  std::vector<Slot> st;
+  for (std::size_t m = 0; m < maps.size(); ++m) {
+    const Program &program = maps[m];
+    st.clear();
+    for (const Instr &ins : program.code) {
+      switch (ins.op) {
+        case Op::PushConst:
+          st.push_back({true, program.constants[ins.a]});
+          break;
+        case Op::PushT: /* maps are stepped at t = 0 */
+          st.push_back({true, 0.0});
+          break;
+        case Op::PushPi:
+          st.push_back({true, kPiDD.hi});
+          break;
+        case Op::PushE:
+          st.push_back({true, kEDD.hi});
+          break;
+        case Op::PushState:
+        case Op::PushParam:
+          st.push_back({false, 0.0});
+          break;
+        case Op::Neg:
+          st.back().v = -st.back().v;
+          break;
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul: {
+          const Slot b = st.back();
+          st.pop_back();
+          Slot &a = st.back();
+          a.v = ins.op == Op::Add ? a.v + b.v
+                : ins.op == Op::Sub ? a.v - b.v
+                                    : a.v * b.v;
+          a.cst = a.cst && b.cst;
+          break;
+        }
+        case Op::Div: {
+          const Slot b = st.back();
+          st.pop_back();
+          if (!b.cst || b.v == 0.0) {
+            res.why = "division by a non-constant is not supported";
+            return res;
+          }
+          st.back().v /= b.v;
+          break;
+        }
+        case Op::CallBuiltin: {
+          const Builtin id = static_cast<Builtin>(ins.a);
+          if (id == Builtin::Pow) {
+            const Slot e = st.back();
+            st.pop_back();
+            if (!e.cst || e.v != std::floor(e.v) || e.v < 0.0 || e.v > 64.0) {
+              res.why = "pow() needs a constant integer exponent in [0, 64]";
+              return res;
+            }
+            if (st.back().cst) st.back().v = std::pow(st.back().v, e.v);
+          } else if (id == Builtin::Abs) {
+            res.analytic = false;
+            st.back().v = std::fabs(st.back().v);
+          } else {
+            res.why = std::string(builtin_name(id)) + "() is not polynomial";
+            return res;
+          }
+          break;
+        }
+        case Op::CallDef:
+          res.why = "user definitions are not supported";
+          return res;
+        case Op::PushLocal:
+        case Op::BrIfZero:
+        case Op::Jump:
+          res.why = "select() is not supported";
+          return res;
+      }
+    }
+    if (st.size() != 1) {
+      res.why = "malformed program";
+      return res;
+    }
+  }
+  res.ok = true;
+  return res;
+}
+
+/* ---- reference orbit (double-double VM) ---- */
+
+bool reference_orbit(const std::vector<Program> &maps,
+                     const std::vector<DD> &state0,
+                     const std::vector<DD> &params, int maxit,
+                     double escape_r2, ReferenceOrbit *out, char *err_buf,
+                     std::size_t err_cap) {
+  const std::size_t n = maps.size();
+  if (n < 2 || state0.size() != n) {
+    set_err(err_buf, err_cap, "reference orbit needs one map per state");
+    return false;
+  }
+  out->n_state = n;
+  out->escaped = false;
+  out->escape_r2 = escape_r2;
+  out->params.resize(params.size());
+  for (std::size_t j = 0; j < params.size(); ++j) out->params[j] = params[j].hi;
+  out->z.clear();
+  out->z.reserve((std::size_t)(maxit + 1) * n);
+
+  std::vector<DD> cur = state0, nx(n), stack;
+  for (std::size_t i = 0; i < n; ++i) out->z.push_back(cur[i].hi);
+  int it = 0;
+  for (; it < maxit; ++it) {
+    for (std::size_t m = 0; m < n; ++m) {
+      const Program &program = maps[m];
+      stack.clear();
+      for (const Instr &ins : program.code) {
+        switch (ins.op) {
+          case Op::PushConst:
+            stack.push_back(DD{program.constants[ins.a], 0.0});
+            break;
+          case Op::PushState:
+            stack.push_back(cur[ins.a]);
+            break;
+          case Op::PushParam:
+            stack.push_back(params[ins.a]);
+            break;
+          case Op::PushT:
+            stack.push_back(DD{});
+            break;
+          case Op::PushPi:
+            stack.push_back(kPiDD);
+            break;
+          case Op::PushE:
+            stack.push_back(kEDD);
+            break;
+          case Op::Neg:
+            stack.back() = dd_neg(stack.back());
+            break;
+          case Op::Add:
+          case Op::Sub:
+          case Op::Mul:
+          case Op::Div: {
+            const DD b = stack.back();
+            stack.pop_back();
+            DD &a = stack.back();
+            a = ins.op == Op::Add   ? dd_add(a, b)
+                : ins.op == Op::Sub ? dd_sub(a, b)
+                : ins.op == Op::Mul ? dd_mul(a, b)
+                                    : dd_div(a, b);
+            break;
+          }
+          case Op::CallBuiltin:
+            if (static_cast<Builtin>(ins.a) == Builtin::Pow) {
+              const int k = (int)stack.back().hi;
+              stack.pop_back();
+              stack.back() = dd_powi(stack.back(), k);
+            } else if (stack.back().hi < 0.0) { /* abs */
+              stack.back() = dd_neg(stack.back());
+            }
+            break;
+          default:
+            set_err(err_buf, err_cap, "opcode not supported by the perturbation path");
+            return false;
+        }
+      }
+      nx[m] = stack.back();
+    }
+    cur.swap(nx);
+    for (std::size_t i = 0; i < n; ++i) out->z.push_back(cur[i].hi);
+    const double r2 = cur[0].hi * cur[0].hi + cur[1].hi * cur[1].hi;
+    if (!std::isfinite(r2) || r2 > escape_r2) {
+      out->escaped = true;
+      ++it;
+      break;
+    }
+  }
+  out->length = it;
+  return true;
+}
+
+/* ---- series approximation ---- */
+
+bool series_approx(const std::vector<Program> &maps,
+                   const ReferenceOrbit &ref, const PerturbPlane &plane,
+                   double scale_x, double scale_y, SeriesApprox *out) {
+  const std::size_t n = ref.n_state;
+  out->n_state = n;
+  out->skip = 0;
+  out->coeffs.assign(n * kSeriesTerms, 0.0);
+  if (ref.length < 2) return true;
+
+  /* probes: the 8 border points of the unit offset square */
+  static const double kProbe[8][2] = {{-1, -1}, {0, -1}, {1, -1}, {1, 0},
+                                      {1, 1},   {0, 1},  {-1, 1}, {-1, 0}};
+  PerturbScratch ps;
+  std::vector<double> direct(n), approx(n), dp(ref.params.size());
+  std::vector<SVal> ds;
+  int limit = ref.length - 1;
+  for (;;) {
+    const int skip = series_run(maps, ref, plane, scale_x, scale_y, limit, ds);
+    out->skip = skip;
+    for (std::size_t i = 0; i < n; ++i)
+      for (int k = 0; k < kSeriesTerms; ++k)
+        out->coeffs[i * kSeriesTerms + k] = ds[i].c[k];
+    if (skip == 0) return true;
+
+    bool agree = true;
+    for (const auto &p : kProbe) {
+      const double ox = p[0] * scale_x, oy = p[1] * scale_y;
+      std::fill(direct.begin(), direct.end(), 0.0);
+      std::fill(dp.begin(), dp.end(), 0.0);
+      if (plane.params) {
+        dp[plane.ix] = ox;
+        dp[plane.iy] = oy;
+      } else {
+        direct[plane.ix] = ox;
+        direct[plane.iy] = oy;
+      }
+      std::vector<double> nx(n);
+      for (int it = 0; it < skip; ++it) {
+        perturb_step(maps, ref, it, direct.data(), dp.data(), ps, nx.data());
+        direct.swap(nx);
+      }
+      series_eval(*out, p[0], p[1], approx.data());
+      double err = 0.0, mag = 0.0;
+      for (std::size_t i = 0; i < n; ++i) {
+        err += (direct[i] - approx[i]) * (direct[i] - approx[i]);
+        mag += direct[i] * direct[i];
+      }
+      if (!(err <= kProbeTol * kProbeTol * mag)) {
+        agree = false;
+        break;
+      }
+    }
+    if (agree) return true;
+    limit = skip / 2;
+  }
+}
+
+void series_eval(const SeriesApprox &sa, double u, double v, double *dz) {
+  /* monomials in the same order as SeriesTables: by degree, then by
+   * falling power of u */
+  double mono[kSeriesTerms];
+  int k = 0;
+  double ug[kSeriesOrder + 1], vg[kSeriesOrder + 1];
+  ug[0] = vg[0] = 1.0;
+  for (int g = 1; g <= kSeriesOrder; ++g) {
+    ug[g] = ug[g - 1] * u;
+    vg[g] = vg[g - 1] * v;
+  }
+  for (int g = 1; g <= kSeriesOrder; ++g)
+    for (int a = g; a >= 0; --a) mono[k++] = ug[a] * vg[g - a];
+  for (std::size_t i = 0; i < sa.n_state; ++i) {
+    const double *c = sa.coeffs.data() + i * kSeriesTerms;
+    double s = 0.0;
+    for (int j = kSeriesTerms - 1; j >= 0; --j) s += c[j] * mono[j];
+    dz[i] = s;
+  }
+}
+
+/* ---- per-pixel difference orbit (pair VM) ---- */
+
+bool perturb_step(const std::vector<Program> &maps, const ReferenceOrbit &ref,
+                  int n, const double *dz, const double *dp,
+                  PerturbScratch &scratch, double *dz_out) {
+  const double *Z = ref.z.data() + (std::size_t)n * ref.n_state;
+  const double *P = ref.params.data();
+  auto &R = scratch.stack_r;
+  auto &D = scratch.stack_d;
+  for (std::size_t m = 0; m < maps.size(); ++m) {
+    const Program &program = maps[m];
+    R.clear();
+    D.clear();
+    for (const Instr &ins : program.code) {
+      switch (ins.op) {
+        case Op::PushConst:
+          R.push_back(program.constants[ins.a]);
+          D.push_back(0.0);
+          break;
+        case Op::PushState:
+          R.push_back(Z[ins.a]);
+          D.push_back(dz[ins.a]);
+          break;
+        case Op::PushParam:
+          R.push_back(P[ins.a]);
+          D.push_back(dp[ins.a]);
+          break;
+        case Op::PushT:
+          R.push_back(0.0);
+          D.push_back(0.0);
+          break;
+        case Op::PushPi:
+          R.push_back(kPiDD.hi);
+          D.push_back(0.0);
+          break;
+        case Op::PushE:
+          R.push_back(kEDD.hi);
+          D.push_back(0.0);
+          break;
+        case Op::Neg:
+          R.back() = -R.back();
+          D.back() = -D.back();
+          break;
+        case Op::Add:
+        case Op::Sub: {
+          const double br = R.back(), bd = D.back();
+          R.pop_back();
+          D.pop_back();
+          if (ins.op == Op::Add) {
+            R.back() += br;
+            D.back() += bd;
+          } else {
+            R.back() -= br;
+            D.back() -= bd;
+          }
+          break;
+        }
+        case Op::Mul: {
+          /* (X+dx)(Y+dy) - XY = X dy + Y dx + dx dy */
+          const double br = R.back(), bd = D.back();
+          R.pop_back();
+          D.pop_back();
+          const double ar = R.back(), ad = D.back();
+          D.back() = ar * bd + br * ad + ad * bd;
+          R.back() = ar * br;
+          break;
+        }
+        case Op::Div: {
+          const double br = R.back();
+          R.pop_back();
+          D.pop_back();
+          R.back() /= br;
+          D.back() /= br;
+          break;
+        }
+        case Op::CallBuiltin:
+          if (static_cast<Builtin>(ins.a) == Builtin::Pow) {
+            int k = (int)R.back();
+            R.pop_back();
+            D.pop_back();
+            /* binary powering with the Mul rule */
+            double xr = R.back(), xd = D.back(), rr = 1.0, rd = 0.0;
+            while (k > 0) {
+              if (k & 1) {
+                rd = rr * xd + xr * rd + rd * xd;
+                rr *= xr;
+              }
+              xd = 2.0 * xr * xd + xd * xd;
+              xr *= xr;
+              k >>= 1;
+            }
+            R.back() = rr;
+            D.back() = rd;
+          } else { /* abs */
+            D.back() = diffabs(R.back(), D.back());
+            R.back() = std::fabs(R.back());
+          }
+          break;
+        default:
+          return false;
+      }
+    }
+    dz_out[m] = D.back();
+  }
+  return true;
+}
+
+PerturbPixel perturb_pixel(const std::vector<Program> &maps,
+                           const ReferenceOrbit &ref,
+                           const PerturbPlane &plane, const SeriesApprox *sa,
+                           double scale_x, double scale_y, double ox,
+                           double oy, int maxit, double escape_r2,
+                           PerturbScratch &scratch) {
+  const std::size_t n = ref.n_state;
+  auto &dz = scratch.dz;
+  auto &nx = scratch.dz_next;
+  auto &dp = scratch.dp;
+  dz.assign(n, 0.0);
+  nx.assign(n, 0.0);
+  dp.assign(ref.params.size(), 0.0);
+  if (plane.params) {
+    dp[plane.ix] = ox;
+    dp[plane.iy] = oy;
+  } else {
+    dz[plane.ix] = ox;
+    dz[plane.iy] = oy;
+  }
+  int it = 0;
+  if (sa && sa->skip > 0) {
+    series_eval(*sa, ox / scale_x, oy / scale_y, dz.data());
+    it = sa->skip;
+  }
+
+  PerturbPixel px;
+  for (; it < maxit; ++it) {
+    if (it >= ref.length) { /* the reference escaped first */
+      px.glitched = true;
+      break;
+    }
+    if (!perturb_step(maps, ref, it, dz.data(), dp.data(), scratch, nx.data())) {
+      it = maxit;
+      break;
+    }
+    const double *Z = ref.z.data() + (std::size_t)(it + 1) * n;
+    const double x = Z[0] + nx[0], y = Z[1] + nx[1];
+    const double r2 = x * x + y * y;
+    if (!std::isfinite(r2) || r2 > escape_r2) {
+      px.escaped = true;
+      px.r2 = r2;
+      ++it;
+      break;
+    }
+    double zz = 0.0, ff = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const double f = Z[i] + nx[i];
+      zz += Z[i] * Z[i];
+      ff += f * f;
+    }
+    if (ff < kGlitchTol * kGlitchTol * zz) {
+      px.glitched = true;
+      px.glitch_ratio = std::sqrt(ff / zz);
+      ++it;
+      break;
+    }
+    dz.swap(nx);
+  }
+  px.iterations = std::min(it, maxit);
+  return px;
+}
+
+}  // namespace dynsys::ir
@@ -0,0 +1,148 @@
+#pragma once
+
+/* ============================================================
+ * dynsys perturbation executor over the IR (deep-zoom fractals).
+ *
+ * Past a view width of ~1e-13 the escape-time view runs out of
+ * double precision: neighbouring pixels round to the same c and the
+ * image turns into blocks. Perturbation theory fixes that with one
+ * high-precision orbit and cheap double arithmetic everywhere else:
+ *
+ *   - a REFERENCE orbit Z_n is iterated once in double-double
+ *     (~106-bit mantissa) at a chosen point of the view;
+ *   - every pixel iterates only its difference from it,
+ *       d_{n+1} = F(Z_n + d_n, P + dp) - F(Z_n, P),
+ *     in plain doubles. The difference is formed symbolically, op
+ *     by op (X*Y - x*y = x dy + y dx + dx dy, ...), so the huge
+ *     common part never cancels and d keeps its full precision;
+ *   - a bivariate truncated power series in the pixel offset
+ *     replaces the first iterations of all pixels at once (series
+ *     approximation), as long as its high-order terms stay
+ *     negligible;
+ *   - a pixel whose orbit passes much closer to 0 than the
+ *     reference does (|Z + d| << |Z|) has lost the precision of d
+ *     ("glitch", Pauldelbrot's criterion) and is reported, so the
+ *     caller can re-render it against a new reference.
+ *
+ * The executor is generic over the map: any program set built from
+ * + - * /const, unary minus, pow(x, k) with a constant integer k and
+ * abs() is accepted (abs is folded with the exact |X+dx|-|X| split;
+ * the series approximation is switched off for such maps since they
+ * are not analytic). perturb_check() reports what is not supported.
+ * Like expr_ir_ad, this is a separate executor; run() is untouched.
+ * ============================================================ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "expr_ir.h"
+
+namespace dynsys::ir {
+
+/* Unevaluated sum hi + lo with |lo| <= ulp(hi)/2. */
+struct DD {
+  double hi = 0.0;
+  double lo = 0.0;
+};
+
+DD dd_add(DD a, DD b);
+DD dd_add(DD a, double b);
+DD dd_sub(DD a, DD b);
+DD dd_mul(DD a, DD b);
+DD dd_div(DD a, DD b);
+
+/* Which inputs the two image axes drive: the (ix, iy) parameters
+ * (Mandelbrot-type plane) or the (ix, iy) state components
+ * (Julia-type plane). */
+struct PerturbPlane {
+  bool params = true;
+  std::size_t ix = 0;
+  std::size_t iy = 1;
+};
+
+struct PerturbSupport {
+  bool ok = false;
+  bool analytic = true;  /* false when abs() is used: no series */
+  std::string why;       /* reason, when !ok                    */
+};
+
+/* Static check of the map programs (one per state component). */
+PerturbSupport perturb_check(const std::vector<Program> &maps);
+
+/* High-precision reference orbit, rounded to double for the pixel
+ * loop. z holds Z_0 .. Z_length (n_state values each). If the orbit
+ * escaped, Z_length is the first iterate past the escape radius;
+ * otherwise length == maxit. */
+struct ReferenceOrbit {
+  std::size_t n_state = 0;
+  int length = 0;
+  bool escaped = false;
+  std::vector<double> z;
+  std::vector<double> params;  /* reference parameters, rounded */
+  double escape_r2 = 0.0;
+};
+
+/* Iterates the maps from state0 with the given parameters in
+ * double-double. The escape test is the view's: x0^2 + x1^2 > r2. */
+bool reference_orbit(const std::vector<Program> &maps,
+                     const std::vector<DD> &state0,
+                     const std::vector<DD> &params, int maxit,
+                     double escape_r2, ReferenceOrbit *out, char *err_buf,
+                     std::size_t err_cap);
+
+/* Number of monomials u^a v^b with 1 <= a+b <= kSeriesOrder. */
+constexpr int kSeriesOrder = 6;
+constexpr int kSeriesTerms = (kSeriesOrder + 1) * (kSeriesOrder + 2) / 2 - 1;
+
+/* d_skip(u, v) for every state component, as a polynomial in the
+ * normalised pixel offset (u, v) = (ox / scale_x, oy / scale_y).
+ * skip == 0 means no iterations can be skipped. */
+struct SeriesApprox {
+  int skip = 0;
+  std::size_t n_state = 0;
+  std::vector<double> coeffs;  /* n_state * kSeriesTerms */
+};
+
+/* Builds the series for offsets with |u|, |v| <= 1 and checks the
+ * result against directly perturbed probe points on the view's
+ * border, shortening the skip until they agree. */
+bool series_approx(const std::vector<Program> &maps,
+                   const ReferenceOrbit &ref, const PerturbPlane &plane,
+                   double scale_x, double scale_y, SeriesApprox *out);
+
+void series_eval(const SeriesApprox &sa, double u, double v, double *dz);
+
+/* Per-thread working memory for the pixel loop. */
+struct PerturbScratch {
+  std::vector<double> stack_r, stack_d;
+  std::vector<double> dz, dz_next, dp;
+};
+
+/* One map step of the difference orbit:
+ *   dz_out = F(Z_n + dz, P + dp) - F(Z_n, P). */
+bool perturb_step(const std::vector<Program> &maps, const ReferenceOrbit &ref,
+                  int n, const double *dz, const double *dp,
+                  PerturbScratch &scratch, double *dz_out);
+
+struct PerturbPixel {
+  int iterations = 0;   /* escape iteration, or maxit if bounded */
+  double r2 = 0.0;      /* |x0, x1|^2 at escape (smooth colouring) */
+  bool escaped = false;
+  bool glitched = false;
+  double glitch_ratio = 0.0; /* |Z + d| / |Z| when the glitch hit */
+};
+
+/* Iterates one pixel at offset (ox, oy) from the REFERENCE point (in
+ * plane units). `sa` may be null; when set, (ox, oy) is normalised
+ * by (scale_x, scale_y) to evaluate it. A pixel still bounded when
+ * an escaped reference runs out is reported as glitched too: it
+ * needs a reference that lives longer. */
+PerturbPixel perturb_pixel(const std::vector<Program> &maps,
+                           const ReferenceOrbit &ref,
+                           const PerturbPlane &plane, const SeriesApprox *sa,
+                           double scale_x, double scale_y, double ox,
+                           double oy, int maxit, double escape_r2,
+                           PerturbScratch &scratch);
+
+}  // namespace dynsys::ir
@@ -0,0 +1,57 @@
+#pragma once
+
+/* ============================================================
+ * dynsys periodicity check (Brent cycle detection) for map orbits.
+ *
+ * The escape-time view gives up on a point once it knows the orbit
+ * stays bounded. Each iterate is compared with a saved reference
+ * point. The reference is re-saved at power-of-two intervals, so an
+ * attracting period-k orbit is caught within ~2k iterations of
+ * settling instead of burning the whole iteration budget.
+ *
+ * Points match when every component agrees to kFractalPeriodTol
+ * relative. That is tight enough that a slowly escaping orbit is not
+ * mistaken for a cycle.
+ *
+ * Header-only like boundary_trace.h. A Brent holds one orbit's state;
+ * give each thread its own.
+ * ============================================================ */
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace dynsys::period {
+
+/* relative per-component tolerance for a revisit */
+constexpr double kFractalPeriodTol = 1e-11;
+
+struct Brent {
+  std::vector<double> ref;
+  int lam = 0, power = 1;
+
+  /* start a new orbit at x[0..n) */
+  void reset(const double *x, std::size_t n) {
+    ref.assign(x, x + n);
+    lam = 0;
+    power = 1;
+  }
+
+  /* feed the next iterate x[0..n); returns the period once the orbit
+   * revisits the reference, 0 while no cycle has been seen */
+  int step(const double *x, std::size_t n) {
+    ++lam;
+    bool same = true;
+    for (std::size_t i = 0; i < n && same; ++i)
+      same = std::fabs(x[i] - ref[i]) <= kFractalPeriodTol * (1.0 + std::fabs(ref[i]));
+    if (same) return lam;
+    if (lam == power) {
+      ref.assign(x, x + n);
+      power *= 2;
+      lam = 0;
+    }
+    return 0;
+  }
+};
+
+} // namespace dynsys::period
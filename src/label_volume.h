@@ -0,0 +1,261 @@
+#pragma once
+
+/* ============================================================
+ * dynsys label volume.
+ *
+ * A W x H x D grid of small integer labels (the volumetric basin
+ * view: attractor index, -1 escaped, -2 did not settle), stored one
+ * z slice at a time as runs of equal labels in row-major order.
+ * Basins are large connected regions, so a slice costs a few runs
+ * per row instead of W * H labels; slices may be filled in any
+ * order, so a progressive solver can publish coarse-to-fine.
+ *
+ * The file format (write_file / read_file) is meant for offline
+ * tools and so is deliberately plain, all little-endian:
+ *   char[4]  "DSBV"
+ *   u32      version (1)
+ *   u32      header_bytes (offset of the label block)
+ *   i32      width, height, depth
+ *   f64      lo[3], hi[3]   cell (0,0,0) sits at lo, the last at hi
+ *   u32      n_attractors, then f64[3] per attractor
+ *   3 x      u32 length + bytes: the axis names
+ *   i16      labels[depth][height][width]   (x fastest), raw
+ * so e.g. numpy.fromfile(f, '<i2', offset=header_bytes) reads it.
+ * A slice that was never filled is written as -3.
+ *
+ * Header-only like tile_cache.h.
+ * ============================================================ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dynsys::volume {
+
+constexpr std::int16_t kUnfilled = -3; /* label of a slice not computed yet */
+
+class LabelVolume {
+ public:
+  LabelVolume() = default;
+  LabelVolume(int w, int h, int d) { reset(w, h, d); }
+
+  void reset(int w, int h, int d) {
+    w_ = std::max(1, w); h_ = std::max(1, h); d_ = std::max(1, d);
+    slices_.assign((std::size_t)d_, Slice());
+    filled_ = 0;
+  }
+
+  int width() const { return w_; }
+  int height() const { return h_; }
+  int depth() const { return d_; }
+  int filled() const { return filled_; }
+  bool complete() const { return filled_ == d_; }
+  bool has_slice(int k) const { return k >= 0 && k < d_ && slices_[(std::size_t)k].filled; }
+
+  /* Stores slice k from W * H labels (row-major, row = y). */
+  void set_slice(int k, const std::int16_t *labels) {
+    if (k < 0 || k >= d_) return;
+    Slice &s = slices_[(std::size_t)k];
+    s.runs.clear();
+    const std::uint32_t n = (std::uint32_t)w_ * (std::uint32_t)h_;
+    for (std::uint32_t p = 0; p < n; ++p)
+      if (p == 0 || labels[p] != labels[p - 1]) s.runs.push_back(Run{p, labels[p]});
+    s.runs.shrink_to_fit();
+    if (!s.filled) ++filled_;
+    s.filled = true;
+  }
+
+  /* Expands slice k into W * H labels; kUnfilled if it was never set. */
+  void decode_slice(int k, std::vector<std::int16_t> *out) const {
+    const std::size_t n = (std::size_t)w_ * h_;
+    out->assign(n, kUnfilled);
+    if (!has_slice(k)) return;
+    const std::vector<Run> &runs = slices_[(std::size_t)k].runs;
+    for (std::size_t r = 0; r < runs.size(); ++r) {
+      const std::size_t end = r + 1 < runs.size() ? runs[r + 1].start : n;
+      std::fill(out->begin() + runs[r].start, out->begin() + (std::ptrdiff_t)end, runs[r].label);
+    }
+  }
+
+  std::int16_t at(int i, int j, int k) const {
+    if (!has_slice(k) || i < 0 || i >= w_ || j < 0 || j >= h_) return kUnfilled;
+    const std::vector<Run> &runs = slices_[(std::size_t)k].runs;
+    const std::uint32_t p = (std::uint32_t)j * (std::uint32_t)w_ + (std::uint32_t)i;
+    auto it = std::upper_bound(runs.begin(), runs.end(), p,
+                               [](std::uint32_t v, const Run &r) { return v < r.start; });
+    return (it - 1)->label;
+  }
+
+  /* The filled slice nearest k (k itself if filled), or -1. */
+  int nearest_slice(int k) const {
+    for (int d = 0; d < d_; ++d) {
+      if (has_slice(k - d)) return k - d;
+      if (has_slice(k + d)) return k + d;
+    }
+    return -1;
+  }
+
+  /* Looking down z from the far end (k = D-1 towards 0): per (i, j) the
+   * first label that is not `clear`, and the slice it was found in (-1 if
+   * none). Unfilled slices are see-through. */
+  void first_hit(std::int16_t clear, std::vector<std::int16_t> *labels, std::vector<int> *slice) const {
+    const std::size_t n = (std::size_t)w_ * h_;
+    labels->assign(n, clear);
+    slice->assign(n, -1);
+    std::size_t open = n;
+    std::vector<std::int16_t> buf;
+    for (int k = d_ - 1; k >= 0 && open > 0; --k) {
+      if (!has_slice(k)) continue;
+      decode_slice(k, &buf);
+      for (std::size_t p = 0; p < n; ++p)
+        if ((*slice)[p] < 0 && buf[p] != clear) { (*labels)[p] = buf[p]; (*slice)[p] = k; --open; }
+    }
+  }
+
+  std::size_t runs() const {
+    std::size_t r = 0;
+    for (const Slice &s : slices_) r += s.runs.size();
+    return r;
+  }
+  std::size_t bytes() const { return runs() * sizeof(Run) + slices_.size() * sizeof(Slice); }
+
+ private:
+  struct Run {
+    std::uint32_t start; /* first cell of the run within the slice */
+    std::int16_t label;
+  };
+  struct Slice {
+    std::vector<Run> runs;
+    bool filled = false;
+  };
+  int w_ = 1, h_ = 1, d_ = 1;
+  int filled_ = 0;
+  std::vector<Slice> slices_ = std::vector<Slice>(1);
+};
+
+/* What a volume file records besides the labels. */
+struct VolumeMeta {
+  std::array<double, 3> lo{{0, 0, 0}}, hi{{1, 1, 1}};
+  std::vector<std::array<double, 3>> attractors;
+  std::array<std::string, 3> axes{{"x", "y", "z"}};
+};
+
+namespace detail {
+
+inline void put_u32(std::vector<unsigned char> &b, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) b.push_back((unsigned char)(v >> (8 * i)));
+}
+inline void put_f64(std::vector<unsigned char> &b, double v) {
+  std::uint64_t u;
+  std::memcpy(&u, &v, sizeof(u));
+  for (int i = 0; i < 8; ++i) b.push_back((unsigned char)(u >> (8 * i)));
+}
+inline bool get_u32(std::FILE *f, std::uint32_t *v) {
+  unsigned char c[4];
+  if (std::fread(c, 1, 4, f) != 4) return false;
+  *v = (std::uint32_t)c[0] | (std::uint32_t)c[1] << 8 | (std::uint32_t)c[2] << 16 | (std::uint32_t)c[3] << 24;
+  return true;
+}
+inline bool get_f64(std::FILE *f, double *v) {
+  unsigned char c[8];
+  if (std::fread(c, 1, 8, f) != 8) return false;
+  std::uint64_t u = 0;
+  for (int i = 7; i >= 0; --i) u = (u << 8) | c[i];
+  std::memcpy(v, &u, sizeof(u));
+  return true;
+}
+
+}  // namespace detail
+
+inline bool write_file(const char *path, const LabelVolume &vol, const VolumeMeta &meta) {
+  std::vector<unsigned char> h = {'D', 'S', 'B', 'V'};
+  detail::put_u32(h, 1);
+  detail::put_u32(h, 0); /* header_bytes, patched below */
+  detail::put_u32(h, (std::uint32_t)vol.width());
+  detail::put_u32(h, (std::uint32_t)vol.height());
+  detail::put_u32(h, (std::uint32_t)vol.depth());
+  for (double v : meta.lo) detail::put_f64(h, v);
+  for (double v : meta.hi) detail::put_f64(h, v);
+  detail::put_u32(h, (std::uint32_t)meta.attractors.size());
+  for (const auto &a : meta.attractors)
+    for (double v : a) detail::put_f64(h, v);
+  for (const std::string &s : meta.axes) {
+    detail::put_u32(h, (std::uint32_t)s.size());
+    h.insert(h.end(), s.begin(), s.end());
+  }
+  const std::uint32_t hb = (std::uint32_t)h.size();
+  for (int i = 0; i < 4; ++i) h[8 + i] = (unsigned char)(hb >> (8 * i));
+
+  std::FILE *f = std::fopen(path, "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(h.data(), 1, h.size(), f) == h.size();
+  std::vector<std::int16_t> slice;
+  std::vector<unsigned char> raw;
+  for (int k = 0; ok && k < vol.depth(); ++k) {
+    vol.decode_slice(k, &slice);
+    raw.resize(slice.size() * 2);
+    for (std::size_t p = 0; p < slice.size(); ++p) {
+      const std::uint16_t u = (std::uint16_t)slice[p];
+      raw[2 * p] = (unsigned char)(u & 0xff);
+      raw[2 * p + 1] = (unsigned char)(u >> 8);
+    }
+    ok = std::fwrite(raw.data(), 1, raw.size(), f) == raw.size();
+  }
+  return std::fclose(f) == 0 && ok;
+}
+
+inline bool read_file(const char *path, LabelVolume *vol, VolumeMeta *meta) {
+  std::FILE *f = std::fopen(path, "rb");
+  if (!f) return false;
+  long file_bytes = -1;
+  if (std::fseek(f, 0, SEEK_END) == 0) file_bytes = std::ftell(f);
+  std::rewind(f);
+  bool ok = false;
+  char magic[4];
+  std::uint32_t version = 0, hb = 0, w = 0, h = 0, d = 0, na = 0;
+  /* the label block must fit in the file, so a corrupt size never
+   * reaches an allocation */
+  if (std::fread(magic, 1, 4, f) == 4 && std::equal(magic, magic + 4, "DSBV") && detail::get_u32(f, &version) &&
+      version == 1 && detail::get_u32(f, &hb) && detail::get_u32(f, &w) && detail::get_u32(f, &h) &&
+      detail::get_u32(f, &d) && w > 0 && h > 0 && d > 0 && (std::uint64_t)w * h < (1ull << 31) &&
+      d < (1u << 31) && file_bytes >= 0 && (std::uint64_t)hb + (std::uint64_t)w * h * d * 2 <= (std::uint64_t)file_bytes) {
+    ok = true;
+    for (double &v : meta->lo) ok = ok && detail::get_f64(f, &v);
+    for (double &v : meta->hi) ok = ok && detail::get_f64(f, &v);
+    ok = ok && detail::get_u32(f, &na) && na < (1u << 20);
+    meta->attractors.assign(ok ? na : 0, {{0, 0, 0}});
+    for (auto &a : meta->attractors)
+      for (double &v : a) ok = ok && detail::get_f64(f, &v);
+    for (std::string &s : meta->axes) {
+      std::uint32_t len = 0;
+      ok = ok && detail::get_u32(f, &len) && len < 4096;
+      if (!ok) break;
+      s.assign(len, '\0');
+      ok = len == 0 || std::fread(&s[0], 1, len, f) == len;
+    }
+    ok = ok && std::fseek(f, (long)hb, SEEK_SET) == 0;
+  }
+  if (ok) {
+    vol->reset((int)w, (int)h, (int)d);
+    std::vector<unsigned char> raw((std::size_t)w * h * 2);
+    std::vector<std::int16_t> slice((std::size_t)w * h);
+    for (std::uint32_t k = 0; ok && k < d; ++k) {
+      ok = std::fread(raw.data(), 1, raw.size(), f) == raw.size();
+      bool filled = false;
+      for (std::size_t p = 0; ok && p < slice.size(); ++p) {
+        slice[p] = (std::int16_t)(std::uint16_t)(raw[2 * p] | raw[2 * p + 1] << 8);
+        filled = filled || slice[p] != kUnfilled;
+      }
+      if (ok && filled) vol->set_slice((int)k, slice.data());
+    }
+  }
+  std::fclose(f);
+  return ok;
+}
+
+}  // namespace dynsys::volume
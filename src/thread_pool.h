@@ -0,0 +1,327 @@
+#pragma once
+
+/* ============================================================
+ * dynsys process-wide worker pool.
+ *
+ * Every parallel compute path (escape-time and deep-zoom fractals,
+ * basins of attraction, analysis::parallel_for) used to spawn its
+ * own hardware_concurrency() std::threads per call, i.e. per
+ * progressive-refinement frame, and the basin solver split rows
+ * statically so one slow band left the other cores idle.
+ *
+ * This is one persistent pool instead:
+ *   - parallel_for(count, body) deals [0, count) into one contiguous
+ *     range per thread; a thread that runs dry steals the back half
+ *     of the fullest-looking neighbour's range (range stealing), so
+ *     uneven rows balance out without a shared counter hot spot;
+ *   - the calling thread takes part, so threads() == 1 is a plain
+ *     serial loop and a parallel_for nested inside a body cannot
+ *     deadlock (the inner caller always makes progress itself);
+ *   - body(item, slot) gets a slot in [0, threads()) that is unique
+ *     among the threads running that call, for per-thread scratch
+ *     (a stepper, an eval stack) indexed without locks;
+ *   - a Cancel token drops the items not yet started; parallel_for
+ *     then returns false;
+ *   - the thread count and optional core pinning are set once at
+ *     startup (dynsys --threads N, --pin-threads).
+ *
+ * Header-only like png_writer.h, so every test that links
+ * analysis.cpp picks it up without extra objects; the pool itself
+ * is a single function-local static shared by all translation
+ * units.
+ * ============================================================ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace dynsys::pool {
+
+struct Config {
+  unsigned threads = 0; /* computing threads incl. the caller; 0 = all cores */
+  bool pin = false;     /* pin worker k to core k (Linux only)              */
+};
+
+/* Cooperative cancellation for one or more parallel_for calls. Set
+ * from any thread; items already running finish, the rest are
+ * dropped. */
+class Cancel {
+ public:
+  void cancel() { flag_.store(true, std::memory_order_relaxed); }
+  void reset() { flag_.store(false, std::memory_order_relaxed); }
+  bool cancelled() const { return flag_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> flag_{false};
+};
+
+using Body = std::function<void(std::size_t item, unsigned slot)>;
+
+namespace detail {
+
+struct Range {
+  std::mutex m;
+  std::size_t begin = 0, end = 0;
+};
+
+/* One parallel_for call. Lives on the caller's stack; the pool only
+ * holds a pointer to it while it is registered. */
+struct Job {
+  const Body *body = nullptr;
+  const Cancel *cancel = nullptr;
+  std::size_t grain = 1;
+  unsigned parts = 0;
+  std::unique_ptr<Range[]> ranges;
+  std::atomic<std::size_t> unclaimed{0}; /* not yet taken by a thread  */
+  std::atomic<std::size_t> remaining{0}; /* not yet finished or dropped */
+  std::atomic<unsigned> next_slot{0};
+  std::atomic<bool> dropped{false};
+  unsigned active = 0; /* pool workers inside; guarded by Pool::mu_ */
+
+  /* Next chunk for `slot`: the front of its own range, else the back
+   * half of another thread's range. */
+  bool take(unsigned slot, std::size_t *b, std::size_t *e) {
+    {
+      Range &own = ranges[slot];
+      std::lock_guard<std::mutex> lk(own.m);
+      if (own.begin < own.end) {
+        *b = own.begin;
+        *e = std::min(own.end, own.begin + grain);
+        own.begin = *e;
+        unclaimed.fetch_sub(*e - *b, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (unsigned k = 1; k < parts; ++k) {
+      Range &victim = ranges[(slot + k) % parts];
+      std::size_t sb, se;
+      {
+        std::lock_guard<std::mutex> lk(victim.m);
+        const std::size_t n = victim.end - victim.begin;
+        if (n == 0) continue;
+        if (n <= 2 * grain) { /* too small to split: just take a chunk */
+          *b = victim.begin;
+          *e = std::min(victim.end, victim.begin + grain);
+          victim.begin = *e;
+          unclaimed.fetch_sub(*e - *b, std::memory_order_relaxed);
+          return true;
+        }
+        sb = victim.begin + n / 2;
+        se = victim.end;
+        victim.end = sb;
+      }
+      *b = sb;
+      *e = sb + grain;
+      {
+        Range &own = ranges[slot];
+        std::lock_guard<std::mutex> lk(own.m);
+        own.begin = *e;
+        own.end = se;
+      }
+      unclaimed.fetch_sub(grain, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void drop_all() {
+    dropped.store(true, std::memory_order_relaxed);
+    for (unsigned s = 0; s < parts; ++s) {
+      std::lock_guard<std::mutex> lk(ranges[s].m);
+      const std::size_t n = ranges[s].end - ranges[s].begin;
+      ranges[s].begin = ranges[s].end;
+      unclaimed.fetch_sub(n, std::memory_order_relaxed);
+      remaining.fetch_sub(n, std::memory_order_acq_rel);
+    }
+  }
+
+  void run(unsigned slot) {
+    std::size_t b, e;
+    while (take(slot, &b, &e)) {
+      std::size_t i = b;
+      for (; i < e; ++i) {
+        if (cancel && cancel->cancelled()) break;
+        (*body)(i, slot);
+      }
+      remaining.fetch_sub(e - b, std::memory_order_acq_rel);
+      if (i < e) {
+        drop_all();
+        return;
+      }
+    }
+  }
+};
+
+class Pool {
+ public:
+  static Pool &instance() {
+    static Pool p;
+    return p;
+  }
+
+  ~Pool() { stop(); }
+
+  void configure(const Config &c) {
+    std::lock_guard<std::mutex> lk(cfg_mu_);
+    stop();
+    cfg_ = c;
+  }
+
+  unsigned threads() {
+    std::lock_guard<std::mutex> lk(cfg_mu_);
+    return resolved_threads();
+  }
+
+  bool parallel_for(std::size_t count, const Body &body, const Cancel *cancel,
+                    std::size_t grain) {
+    if (count == 0) return true;
+    if (grain < 1) grain = 1;
+    unsigned parts;
+    {
+      std::lock_guard<std::mutex> lk(cfg_mu_);
+      parts = resolved_threads();
+      if (parts > 1 && workers_.empty()) start();
+    }
+    if (parts <= 1 || count <= grain) {
+      for (std::size_t i = 0; i < count; ++i) {
+        if (cancel && cancel->cancelled()) return false;
+        body(i, 0);
+      }
+      return true;
+    }
+
+    Job job;
+    job.body = &body;
+    job.cancel = cancel;
+    job.grain = grain;
+    job.parts = parts;
+    job.ranges.reset(new Range[parts]);
+    for (unsigned s = 0; s < parts; ++s) {
+      job.ranges[s].begin = count * s / parts;
+      job.ranges[s].end = count * (s + 1) / parts;
+    }
+    job.unclaimed.store(count);
+    job.remaining.store(count);
+    job.next_slot.store(1); /* the caller is slot 0 */
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      jobs_.push_back(&job);
+    }
+    cv_.notify_all();
+    job.run(0);
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      done_cv_.wait(lk, [&] {
+        return job.remaining.load(std::memory_order_acquire) == 0 && job.active == 0;
+      });
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+    }
+    return !job.dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Pool() = default;
+
+  unsigned resolved_threads() const {
+    unsigned n = cfg_.threads;
+    if (n == 0) n = std::thread::hardware_concurrency();
+    return std::max(1u, n);
+  }
+
+  /* cfg_mu_ held */
+  void start() {
+    stopping_ = false;
+    const unsigned n = resolved_threads();
+    for (unsigned k = 1; k < n; ++k) workers_.emplace_back(&Pool::worker_main, this, k);
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) t.join();
+    workers_.clear();
+  }
+
+  void worker_main(unsigned k) {
+#if defined(__linux__)
+    if (cfg_.pin) {
+      const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(k % cores, &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    for (;;) {
+      Job *j = nullptr;
+      unsigned slot = 0;
+      {
+        /* Slots are claimed under mu_ and a job with none left does not
+         * match, so a late worker goes back to sleep instead of spinning
+         * on a job it cannot join. */
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&] {
+          if (stopping_) return true;
+          for (Job *c : jobs_)
+            if (c->unclaimed.load(std::memory_order_relaxed) > 0 &&
+                c->next_slot.load(std::memory_order_relaxed) < c->parts) {
+              j = c;
+              return true;
+            }
+          return false;
+        });
+        if (stopping_) return;
+        slot = j->next_slot.fetch_add(1, std::memory_order_relaxed);
+        ++j->active;
+      }
+      j->run(slot);
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        --j->active;
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+  std::mutex cfg_mu_;
+  Config cfg_;
+  std::vector<std::thread> workers_;
+  std::mutex mu_;
+  std::condition_variable cv_, done_cv_;
+  std::vector<Job *> jobs_;
+  bool stopping_ = false;
+};
+
+}  // namespace detail
+
+/* Sets the thread count / pinning. Call at startup, before any
+ * parallel work; running workers are joined and restarted lazily. */
+inline void configure(const Config &c) { detail::Pool::instance().configure(c); }
+
+/* Threads a parallel_for runs on (including the caller), i.e. the
+ * number of distinct slots a body can see. */
+inline unsigned threads() { return detail::Pool::instance().threads(); }
+
+/* Runs body(i, slot) for every i in [0, count), on the pool plus the
+ * calling thread, and waits. Items are handed out `grain` at a time.
+ * Returns false if `cancel` fired before every item ran. */
+inline bool parallel_for(std::size_t count, const Body &body, const Cancel *cancel = nullptr,
+                         std::size_t grain = 1) {
+  return detail::Pool::instance().parallel_for(count, body, cancel, grain);
+}
+
+}  // namespace dynsys::pool
@@ -0,0 +1,268 @@
+#pragma once
+
+/* ============================================================
+ * dynsys view tile cache.
+ *
+ * The escape-time fractal and the basin view used to recompute the
+ * whole image on every pan or zoom, although most of the new window
+ * was on screen a moment before. They are now composed from tiles:
+ *   - tiles sit on a world-aligned grid of kTile x kTile samples;
+ *     level z samples the plane every 2^-z units, so a tile does not
+ *     depend on the view that first asked for it;
+ *   - a view uses the level whose spacing is nearest its own pixel
+ *     size, composes itself from the tiles it overlaps (nearest
+ *     sample) and computes only the ones that are missing;
+ *   - a tile is keyed by (content, level, tx, ty), where content is a
+ *     hash of everything else that changes a sample: the system,
+ *     parameter vector, mode, iteration budget, colouring;
+ *   - the least recently used tiles are evicted under a byte cap.
+ * A composed view is a nearest-sample resampling of the tile grid,
+ * not a render at the view's own pixel pitch, so the views use the
+ * cache only when it is switched on.
+ *
+ * Header-only like thread_pool.h. One cache is shared by the UI
+ * thread and the background view jobs, so every call takes its
+ * mutex; the values are immutable once inserted and handed out as
+ * shared_ptr, so an evicted tile stays valid for whoever holds it.
+ * ============================================================ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dynsys::tiles {
+
+constexpr int kTile = 64;         /* samples per tile side */
+constexpr int kMaxViewTiles = 4096; /* beyond this a view is not worth tiling */
+
+/* FNV-1a over the fields that define a tile's content. */
+class Hasher {
+ public:
+  Hasher &bytes(const void *p, std::size_t n) {
+    const unsigned char *c = static_cast<const unsigned char *>(p);
+    for (std::size_t i = 0; i < n; ++i) h_ = (h_ ^ c[i]) * 1099511628211ull;
+    return *this;
+  }
+  Hasher &add(double v) {
+    if (v == 0.0) v = 0.0; /* -0 and +0 sample the same */
+    return bytes(&v, sizeof(v));
+  }
+  Hasher &add(std::int64_t v) { return bytes(&v, sizeof(v)); }
+  Hasher &add(std::uint64_t v) { return bytes(&v, sizeof(v)); }
+  Hasher &add(int v) { return add((std::int64_t)v); }
+  Hasher &add(bool v) { return add((std::int64_t)v); }
+  Hasher &add(const char *s) {
+    bytes(s, std::strlen(s));
+    return add((std::int64_t)0); /* separator: ("ab","c") != ("a","bc") */
+  }
+  Hasher &add(const std::string &s) { return add(s.c_str()); }
+  std::uint64_t value() const { return h_; }
+
+ private:
+  std::uint64_t h_ = 1469598103934665603ull;
+};
+
+struct Key {
+  std::uint64_t content = 0;
+  int level = 0;
+  std::int64_t tx = 0, ty = 0;
+  bool operator==(const Key &o) const {
+    return content == o.content && level == o.level && tx == o.tx && ty == o.ty;
+  }
+};
+
+struct KeyHash {
+  std::size_t operator()(const Key &k) const {
+    return (std::size_t)Hasher().add(k.content).add(k.level).add(k.tx).add(k.ty).value();
+  }
+};
+
+/* A view or tile window in the renderers' convention: W samples from
+ * x0 to x1 inclusive (x0 + (x1 - x0) * i / (W - 1)), likewise in y. */
+struct Window {
+  double x0 = 0, x1 = 1, y0 = 0, y1 = 1;
+};
+
+inline double spacing(int level) { return std::ldexp(1.0, -level); }
+
+inline std::int64_t floor_div(std::int64_t a, std::int64_t b) {
+  return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+/* Sample window of tile (tx, ty) at `level`. */
+inline Window tile_window(int level, std::int64_t tx, std::int64_t ty) {
+  const double s = spacing(level);
+  Window w;
+  w.x0 = (double)(tx * kTile) * s;
+  w.x1 = (double)(tx * kTile + kTile - 1) * s;
+  w.y0 = (double)(ty * kTile) * s;
+  w.y1 = (double)(ty * kTile + kTile - 1) * s;
+  return w;
+}
+
+/* The tiles a W x H view of `view` overlaps. The level is the power of
+ * two nearest the view's finer pixel spacing (so the composed view is
+ * sampled at 1/sqrt2 .. sqrt2 of its own resolution), made `coarsen`
+ * levels coarser for a progressive preview. Empty when the window is
+ * degenerate or would need more than kMaxViewTiles tiles. */
+struct Range {
+  int level = 0;
+  std::int64_t tx0 = 0, tx1 = -1, ty0 = 0, ty1 = -1; /* inclusive */
+  std::size_t cols() const { return tx1 < tx0 ? 0 : (std::size_t)(tx1 - tx0 + 1); }
+  std::size_t rows() const { return ty1 < ty0 ? 0 : (std::size_t)(ty1 - ty0 + 1); }
+  std::size_t count() const { return cols() * rows(); }
+  bool empty() const { return count() == 0; }
+};
+
+inline Range covering(const Window &view, int W, int H, int coarsen = 0) {
+  Range r;
+  if (W < 2 || H < 2) return r;
+  const double px = (view.x1 - view.x0) / (W - 1), py = (view.y1 - view.y0) / (H - 1);
+  const double pixel = std::fmin(px, py);
+  if (!(pixel > 0.0) || !std::isfinite(pixel) || !(py > 0.0)) return r;
+  const double lz = -std::log2(pixel);
+  if (std::fabs(lz) > 900.0) return r;
+  const int level = (int)std::lround(lz) - coarsen;
+  const double s = spacing(level);
+  const double lim = 9.0e15; /* sample indices must stay exact in a double */
+  if (std::fabs(view.x0 / s) > lim || std::fabs(view.x1 / s) > lim ||
+      std::fabs(view.y0 / s) > lim || std::fabs(view.y1 / s) > lim)
+    return r;
+  r.level = level;
+  r.tx0 = floor_div(std::llround(view.x0 / s), kTile);
+  r.tx1 = floor_div(std::llround(view.x1 / s), kTile);
+  r.ty0 = floor_div(std::llround(view.y0 / s), kTile);
+  r.ty1 = floor_div(std::llround(view.y1 / s), kTile);
+  if ((double)r.cols() * (double)r.rows() > kMaxViewTiles) r = Range();
+  return r;
+}
+
+/* Fills a W x H view from the tiles of `range`: tiles[k] holds the
+ * kTile * kTile samples (row-major, row = y) of tile
+ * (tx0 + k % cols, ty0 + k / cols). Each pixel takes its nearest
+ * sample. */
+template <class T>
+void compose(const Window &view, int W, int H, const Range &range, const std::vector<const T *> &tiles,
+             std::vector<T> &out) {
+  out.resize((std::size_t)W * H);
+  const double s = spacing(range.level);
+  const std::int64_t gx0 = range.tx0 * kTile, gy0 = range.ty0 * kTile;
+  const std::int64_t gxn = (std::int64_t)range.cols() * kTile - 1, gyn = (std::int64_t)range.rows() * kTile - 1;
+  std::vector<std::int64_t> col((std::size_t)W);
+  for (int i = 0; i < W; ++i) {
+    const std::int64_t g = std::llround((view.x0 + (view.x1 - view.x0) * (double)i / (W - 1)) / s) - gx0;
+    col[(std::size_t)i] = g < 0 ? 0 : (g > gxn ? gxn : g);
+  }
+  const std::size_t cols = range.cols();
+  for (int j = 0; j < H; ++j) {
+    std::int64_t g = std::llround((view.y0 + (view.y1 - view.y0) * (double)j / (H - 1)) / s) - gy0;
+    g = g < 0 ? 0 : (g > gyn ? gyn : g);
+    const std::size_t trow = (std::size_t)(g / kTile) * cols;
+    const std::size_t srow = (std::size_t)(g % kTile) * kTile;
+    T *dst = &out[(std::size_t)j * W];
+    for (int i = 0; i < W; ++i) {
+      const std::int64_t c = col[(std::size_t)i];
+      dst[i] = tiles[trow + (std::size_t)(c / kTile)][srow + (std::size_t)(c % kTile)];
+    }
+  }
+}
+
+/* Thread-safe LRU map Key -> shared_ptr<const V> under a byte cap. */
+template <class V>
+class Cache {
+ public:
+  struct Stats {
+    long hits = 0, misses = 0, evictions = 0;
+    std::size_t tiles = 0, bytes = 0, capacity = 0;
+  };
+
+  explicit Cache(std::size_t capacity_bytes = (std::size_t)256 << 20) : cap_(capacity_bytes) {}
+
+  /* The tile for `k`, or null; a hit becomes the most recently used. */
+  std::shared_ptr<const V> find(const Key &k) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = index_.find(k);
+    if (it == index_.end()) {
+      ++misses_;
+      return nullptr;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->value;
+  }
+
+  /* Presence test that neither counts nor touches the LRU order. */
+  bool contains(const Key &k) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return index_.count(k) != 0;
+  }
+
+  void insert(const Key &k, std::shared_ptr<const V> v, std::size_t bytes) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = index_.find(k);
+    if (it != index_.end()) { /* two jobs raced to the same tile */
+      bytes_ -= it->second->bytes;
+      lru_.erase(it->second);
+      index_.erase(it);
+    }
+    lru_.push_front(Entry{k, std::move(v), bytes});
+    index_[k] = lru_.begin();
+    bytes_ += bytes;
+    evict();
+  }
+
+  void set_capacity(std::size_t capacity_bytes) {
+    std::lock_guard<std::mutex> lk(mu_);
+    cap_ = capacity_bytes;
+    evict();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lk(mu_);
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    Stats s;
+    s.hits = hits_; s.misses = misses_; s.evictions = evictions_;
+    s.tiles = index_.size(); s.bytes = bytes_; s.capacity = cap_;
+    return s;
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    std::shared_ptr<const V> value;
+    std::size_t bytes;
+  };
+
+  /* mu_ held */
+  void evict() {
+    while (bytes_ > cap_ && !lru_.empty()) {
+      const Entry &e = lru_.back();
+      bytes_ -= e.bytes;
+      index_.erase(e.key);
+      lru_.pop_back();
+      ++evictions_;
+    }
+  }
+
+  mutable std::mutex mu_;
+  std::size_t cap_;
+  std::size_t bytes_ = 0;
+  long hits_ = 0, misses_ = 0, evictions_ = 0;
+  std::list<Entry> lru_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, KeyHash> index_;
+};
+
+}  // namespace dynsys::tiles
@@ -0,0 +1,107 @@
+/* Locks quadtree boundary refinement in the basin solver
+ * (BasinOptions::adaptive): labels match the full sweep on basins with a
+ * straight and a curved boundary, the number of integrated cells grows with
+ * the boundary length rather than the area (doubling the resolution about
+ * doubles it), fills interpolate the convergence speed, and it combines with
+ * memoize on the pool (run under TSan too).
+ * make test-basinadaptive */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static std::atomic<long> g_orbits{0};
+
+/* two attractors (+-1, 0) split by the line x = 0 */
+static bool split(double x, double y, double *nx, double *ny) {
+  const double tx = x >= 0 ? 1.0 : -1.0;
+  *nx = x + 0.15 * (tx - x);
+  *ny = y + 0.15 * (0.0 - y);
+  return true;
+}
+/* the unit disc drains into the origin, everything outside escapes */
+static bool disc(double x, double y, double *nx, double *ny) {
+  const double f = x * x + y * y < 1.0 ? 0.8 : 1.25;
+  *nx = f * x;
+  *ny = f * y;
+  return true;
+}
+
+static BasinOptions grid(int n) {
+  BasinOptions o;
+  o.xmin = -2.03; o.xmax = 1.97; o.ymin = -1.98; o.ymax = 2.02;
+  o.width = o.height = n;
+  o.max_steps = 400; o.settle_tol = 1e-6; o.cluster_tol = 0.05; o.diverge_r = 1e6;
+  return o;
+}
+
+static long integrated(const BasinResult &r) { return (long)r.cell_attractor.size() - r.n_inherited; }
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+
+  for (int sys = 0; sys < 2; ++sys) {
+    auto adv = sys == 0 ? split : disc;
+    auto mk = [adv](int) {
+      return AdvanceFn([adv](double x, double y, double *nx, double *ny) { return adv(x, y, nx, ny); });
+    };
+    BasinOptions o = grid(512);
+    const BasinResult full = compute_basins_mt(mk, o);
+    o.adaptive = true;
+    const BasinResult ad = compute_basins_mt(mk, o);
+    long differ = 0;
+    double speed_err = 0.0;
+    for (size_t i = 0; i < full.cell_attractor.size(); ++i) {
+      if (full.cell_attractor[i] != ad.cell_attractor[i]) differ++;
+      speed_err = std::max(speed_err, (double)std::fabs(full.cell_speed[i] - ad.cell_speed[i]));
+    }
+    printf("  %s 512^2: %ld of %zu cells integrated (%.1f%%), %ld labels differ, worst speed error %.3f\n",
+           sys == 0 ? "line" : "disc", integrated(ad), full.cell_attractor.size(),
+           100.0 * integrated(ad) / full.cell_attractor.size(), differ, speed_err);
+    if (!ad.ok || differ != 0 || ad.attractors.size() != full.attractors.size()) { printf("  <-- FAIL\n"); fails++; }
+    if (integrated(ad) > (long)full.cell_attractor.size() / 5) { printf("  integrated too much <-- FAIL\n"); fails++; }
+    if (speed_err > 0.1) { printf("  fill shading off <-- FAIL\n"); fails++; }
+  }
+
+  /* scaling: doubling the side doubles (not quadruples) the integrated cells */
+  {
+    auto mk = [](int) { return AdvanceFn(disc); };
+    BasinOptions a = grid(1024), b = grid(2048);
+    a.adaptive = b.adaptive = true;
+    const BasinResult ra = compute_basins_mt(mk, a), rb = compute_basins_mt(mk, b);
+    const double growth = (double)integrated(rb) / (double)integrated(ra);
+    printf("  disc: %ld integrated at 1024^2, %ld at 2048^2 (x%.2f; a full sweep grows x4)\n",
+           integrated(ra), integrated(rb), growth);
+    if (growth > 2.6) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* adaptive + memoize together */
+  {
+    auto mk = [](int) {
+      return AdvanceFn([](double x, double y, double *nx, double *ny) {
+        g_orbits.fetch_add(1, std::memory_order_relaxed);
+        return split(x, y, nx, ny);
+      });
+    };
+    BasinOptions o = grid(384);
+    const BasinResult full = compute_basins_mt(mk, o);
+    o.adaptive = true; o.memoize = true;
+    g_orbits = 0;
+    const BasinResult both = compute_basins_mt(mk, o);
+    long differ = 0;
+    for (size_t i = 0; i < full.cell_attractor.size(); ++i)
+      if (full.cell_attractor[i] != both.cell_attractor[i]) differ++;
+    printf("  adaptive+memoize 384^2: %ld steps, %ld labels differ\n", g_orbits.load(), differ);
+    if (!both.ok || differ > (long)full.cell_attractor.size() / 100) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,190 @@
+/* Locks attractor fingerprinting in the basin solver (BasinOptions::
+ * fingerprint, cluster_basin_cells): two coexisting period-2 cycles of a
+ * map, two concentric limit cycles of a flow (same centroid, different
+ * spread) and two coexisting chaotic sets each get a basin of their own
+ * instead of one "did not settle" region, with the right kind and period;
+ * labels do not depend on the thread count; and the spatial-hash
+ * clustering keeps first-cell label order and stays cheap on a large grid
+ * with many attractors.
+ * make test-basinfingerprint */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static double sgn(double v) { return v < 0 ? -1.0 : 1.0; }
+
+/* |x| -> 1 while x flips sign every step, y -> sign(y): the period-2
+ * cycles {(1,1),(-1,1)} and {(1,-1),(-1,-1)} */
+static bool two_cycles(double x, double y, double *nx, double *ny) {
+  *nx = -(sgn(x) + 0.5 * (x - sgn(x)));
+  *ny = sgn(y) + 0.5 * (y - sgn(y));
+  return true;
+}
+
+/* RK4 step of r' = -(r-1)(r-2)(r-3), theta' = 1: limit cycles r = 1 and
+ * r = 3, separated by the unstable one at r = 2 */
+static bool rings(double x, double y, double *nx, double *ny) {
+  auto f = [](double u, double v, double *du, double *dv) {
+    const double r = std::hypot(u, v), g = -(r - 1) * (r - 2) * (r - 3) / r;
+    *du = g * u - v;
+    *dv = g * v + u;
+  };
+  const double h = 0.05;
+  double k1x, k1y, k2x, k2y, k3x, k3y, k4x, k4y;
+  f(x, y, &k1x, &k1y);
+  f(x + 0.5 * h * k1x, y + 0.5 * h * k1y, &k2x, &k2y);
+  f(x + 0.5 * h * k2x, y + 0.5 * h * k2y, &k3x, &k3y);
+  f(x + h * k3x, y + h * k3y, &k4x, &k4y);
+  *nx = x + h / 6.0 * (k1x + 2 * k2x + 2 * k3x + k4x);
+  *ny = y + h / 6.0 * (k1y + 2 * k2y + 2 * k3y + k4y);
+  return true;
+}
+
+/* the logistic map at r = 3.9 on [0,1] and a copy on [2,3]; y -> y/2 */
+static bool two_logistics(double x, double y, double *nx, double *ny) {
+  *nx = x < 1.5 ? 3.9 * x * (1 - x) : 2 + 3.9 * (x - 2) * (3 - x);
+  *ny = 0.5 * y;
+  return true;
+}
+
+static double coord(double lo, double hi, int i, int n) { return lo + (hi - lo) * (double)i / (n - 1); }
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+
+  /* 1. map cycles: without fingerprints the drift test takes the cycle for
+   * a fixed point at whichever phase it stopped, four spurious basins */
+  {
+    BasinOptions o;
+    o.xmin = -2; o.xmax = 2; o.ymin = -2; o.ymax = 2;
+    o.width = 100; o.height = 100;
+    o.max_steps = 200; o.settle_tol = 1e-9; o.cluster_tol = 0.05;
+    auto mk = [](int) { return AdvanceFn(two_cycles); };
+    const BasinResult plain = compute_basins_mt(mk, o);
+    o.fingerprint = true;
+    const BasinResult fp = compute_basins_mt(mk, o);
+    long wrong = 0;
+    for (int j = 0; j < o.height; ++j)
+      for (int i = 0; i < o.width; ++i) {
+        const int want = coord(o.ymin, o.ymax, j, o.height) > 0 ? fp.cell_attractor[o.width * (o.height - 1)]
+                                                                 : fp.cell_attractor[0];
+        if (fp.cell_attractor[(size_t)j * o.width + i] != want) wrong++;
+      }
+    bool kinds = fp.attractors.size() == 2;
+    for (size_t a = 0; kinds && a < 2; ++a) kinds = fp.attractor_kind[a] == 1 && fp.attractor_period[a] == 2;
+    printf("  map cycles: plain %zu attractors, fingerprinted %zu (period %d, %d), %ld cells off\n",
+           plain.attractors.size(), fp.attractors.size(), fp.attractor_period.empty() ? 0 : fp.attractor_period[0],
+           fp.attractor_period.size() < 2 ? 0 : fp.attractor_period[1], wrong);
+    if (!kinds || wrong != 0 || fp.cell_attractor[0] == fp.cell_attractor[o.width * (o.height - 1)]) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 2. concentric limit cycles: never settle, so one -2 region without
+   * fingerprints; with them the two rings split at r = 2 */
+  {
+    BasinOptions o;
+    o.xmin = -4; o.xmax = 4; o.ymin = -4; o.ymax = 4;
+    o.width = 80; o.height = 80;
+    o.max_steps = 400; o.settle_tol = 1e-6; o.cluster_tol = 0.05;
+    o.flow = true;
+    auto mk = [](int) { return AdvanceFn(rings); };
+    const BasinResult plain = compute_basins_mt(mk, o);
+    o.fingerprint = true;
+    o.fp_steps = 1024;
+    const BasinResult fp = compute_basins_mt(mk, o);
+    int inner = -9, outer = -9;
+    long wrong = 0, checked = 0;
+    for (int j = 0; j < o.height; ++j)
+      for (int i = 0; i < o.width; ++i) {
+        const double r = std::hypot(coord(o.xmin, o.xmax, i, o.width), coord(o.ymin, o.ymax, j, o.height));
+        if (std::fabs(r - 2) < 0.1 || r < 0.2) continue;
+        const int l = fp.cell_attractor[(size_t)j * o.width + i];
+        int &want = r < 2 ? inner : outer;
+        if (want == -9) want = l;
+        checked++;
+        if (l != want || l < 0) wrong++;
+      }
+    printf("  rings: plain %ld of %d cells unsettled | fingerprinted %zu attractors, %ld of %ld cells off\n",
+           plain.n_nonconvergent, o.width * o.height, fp.attractors.size(), wrong, checked);
+    bool kinds = fp.attractors.size() == 2;
+    for (size_t a = 0; kinds && a < 2; ++a) kinds = fp.attractor_kind[a] == 1 && fp.attractor_period[a] == 1;
+    if (plain.n_nonconvergent < (long)o.width * o.height / 2 || !kinds || inner == outer || wrong != 0) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 3. two chaotic sets: one basin each, and the same labels on 1 thread */
+  {
+    BasinOptions o;
+    o.xmin = -0.25; o.xmax = 3.25; o.ymin = -1; o.ymax = 1;
+    o.width = 120; o.height = 60;
+    o.max_steps = 300; o.settle_tol = 1e-9; o.cluster_tol = 0.02;
+    o.fingerprint = true;
+    auto mk = [](int) { return AdvanceFn(two_logistics); };
+    const BasinResult fp = compute_basins_mt(mk, o);
+    int left = -9, right = -9;
+    long wrong = 0;
+    for (int j = 0; j < o.height; ++j)
+      for (int i = 0; i < o.width; ++i) {
+        const double x = coord(o.xmin, o.xmax, i, o.width);
+        const int l = fp.cell_attractor[(size_t)j * o.width + i];
+        if (x > 0.02 && x < 0.98) { if (left == -9) left = l; if (l != left) wrong++; }
+        if (x > 2.02 && x < 2.98) { if (right == -9) right = l; if (l != right) wrong++; }
+      }
+    bool kinds = fp.attractors.size() == 2;
+    for (size_t a = 0; kinds && a < 2; ++a) kinds = fp.attractor_kind[a] == 2;
+    pool::configure({1, false});
+    const BasinResult one = compute_basins_mt(mk, o);
+    pool::configure({4, false});
+    const bool same = one.cell_attractor == fp.cell_attractor;
+    printf("  chaotic sets: %zu attractors, %ld cells off, labels on 1 thread %s\n", fp.attractors.size(), wrong,
+           same ? "identical" : "DIFFER");
+    if (!kinds || left == right || left < 0 || right < 0 || wrong != 0 || !same) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 4. clustering cost: 1024^2 settled cells over 12 attractors with jitter;
+   * labels come out in first-cell order */
+  {
+    const int W = 1024, H = 1024, A = 12;
+    BasinOptions o;
+    o.width = W; o.height = H; o.max_steps = 100; o.cluster_tol = 0.01;
+    std::vector<BasinCell> cells((size_t)W * H);
+    for (size_t k = 0; k < cells.size(); ++k) {
+      const int a = (int)((k / 37 + k / W) % A);
+      const double jit = 1e-3 * std::sin((double)k);
+      cells[k].state = 0;
+      cells[k].ex = std::cos(a * 0.5236) + jit;
+      cells[k].ey = std::sin(a * 0.5236) - jit;
+      cells[k].steps = (long)(k % 100);
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    const BasinResult R = cluster_basin_cells(cells, W, H, o);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    long wrong = 0;
+    for (size_t k = 0; k < cells.size(); ++k)
+      if (R.cell_attractor[k] != (int)((k / 37 + k / W) % A)) wrong++;
+    printf("  cluster %dx%d, %d attractors: %.1f ms, %zu found, %ld cells mislabelled\n", W, H, A, ms,
+           R.attractors.size(), wrong);
+    if (R.attractors.size() != (size_t)A || wrong != 0 || R.n_converged != (long)cells.size()) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,73 @@
+/* Locks cell-to-cell memoization in the basin solver (BasinOptions::memoize,
+ * integrate_basin_cells): on a smooth bistable flow the memoized sweep
+ * integrates an order of magnitude fewer steps than the plain one, labels
+ * agree except on a thin boundary layer, and the lock-free publication of
+ * resolved cells holds up with several threads (run under TSan too).
+ * make test-basinmemo */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static std::atomic<long> g_steps{0};
+
+/* one RK4 step of x' = x - x^3, y' = -y: attractors (+-1, 0), separatrix x = 0 */
+static bool flow(double x, double y, double *nx, double *ny) {
+  g_steps.fetch_add(1, std::memory_order_relaxed);
+  const double h = 0.05;
+  auto fx = [](double u) { return u - u * u * u; };
+  const double k1 = fx(x), k2 = fx(x + 0.5 * h * k1), k3 = fx(x + 0.5 * h * k2), k4 = fx(x + h * k3);
+  *nx = x + h / 6.0 * (k1 + 2 * k2 + 2 * k3 + k4);
+  *ny = y * std::exp(-h);
+  return true;
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+  BasinOptions o;
+  o.xmin = -2; o.xmax = 2; o.ymin = -2; o.ymax = 2;
+  o.width = 240; o.height = 240;
+  o.max_steps = 4000; o.settle_tol = 1e-6; o.cluster_tol = 0.05;
+  auto mk = [](int) { return AdvanceFn(flow); };
+
+  g_steps = 0;
+  const BasinResult plain = compute_basins_mt(mk, o);
+  const long plain_steps = g_steps.load();
+
+  o.memoize = true;
+  g_steps = 0;
+  const BasinResult memo = compute_basins_mt(mk, o);
+  const long memo_steps = g_steps.load();
+
+  long differ = 0;
+  const size_t N = (size_t)o.width * o.height;
+  for (size_t i = 0; i < N; ++i)
+    if (plain.cell_attractor[i] != memo.cell_attractor[i]) differ++;
+  const double speedup = (double)plain_steps / (double)std::max(1L, memo_steps);
+  printf("  plain: %ld steps, %zu attractors | memoized: %ld steps (%.1fx fewer), %zu attractors, %ld inherited\n",
+         plain_steps, plain.attractors.size(), memo_steps, speedup, memo.attractors.size(), memo.n_inherited);
+  printf("  labels differ on %ld of %zu cells (%.2f%%)\n", differ, N, 100.0 * differ / N);
+  if (!memo.ok || memo.attractors.size() != 2 || plain.attractors.size() != 2) { printf("  <-- FAIL\n"); fails++; }
+  if (speedup < 10.0) { printf("  memoization saved too little <-- FAIL\n"); fails++; }
+  if (differ > (long)(0.01 * N)) { printf("  labels drifted beyond the boundary layer <-- FAIL\n"); fails++; }
+  if (memo.n_inherited < (long)(N / 2)) { printf("  few cells inherited <-- FAIL\n"); fails++; }
+
+  /* one thread: same as the parallel run up to boundary cells */
+  pool::configure({1, false});
+  const BasinResult serial = compute_basins_mt(mk, o);
+  long sdiff = 0;
+  for (size_t i = 0; i < N; ++i)
+    if (serial.cell_attractor[i] != plain.cell_attractor[i]) sdiff++;
+  printf("  serial memoized: labels differ from plain on %ld cells\n", sdiff);
+  if (sdiff > (long)(0.01 * N)) { printf("  <-- FAIL\n"); fails++; }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
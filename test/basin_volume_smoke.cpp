@@ -0,0 +1,194 @@
+/* Locks the volumetric basin solver (compute_basin_volume) and its label
+ * store (label_volume.h): a 3-D flow with four point attractors is
+ * classified over a 48^3 grid with every cell in the right octant basin,
+ * the run-length volume is a small fraction of the raw labels, slices
+ * arrive coarse to fine and a stopped solve resumes with the same labels,
+ * the thread count does not change a label, the first-hit projection sees
+ * the near surface of a ball, and the binary export reads back exactly.
+ * make test-basinvolume */
+#include "analysis.h"
+#include "label_volume.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+/* RK4 step of x' = x - x^3, y' = -y, z' = z - z^3: attractors (+-1, 0, +-1),
+ * basins split by the signs of x and z */
+static bool flow3(const double *p, double *np) {
+  auto f = [](const double *u, double *du) {
+    du[0] = u[0] - u[0] * u[0] * u[0];
+    du[1] = -u[1];
+    du[2] = u[2] - u[2] * u[2] * u[2];
+  };
+  const double h = 0.1;
+  double k1[3], k2[3], k3[3], k4[3], t[3];
+  f(p, k1);
+  for (int d = 0; d < 3; ++d) t[d] = p[d] + 0.5 * h * k1[d];
+  f(t, k2);
+  for (int d = 0; d < 3; ++d) t[d] = p[d] + 0.5 * h * k2[d];
+  f(t, k3);
+  for (int d = 0; d < 3; ++d) t[d] = p[d] + h * k3[d];
+  f(t, k4);
+  for (int d = 0; d < 3; ++d) np[d] = p[d] + h / 6.0 * (k1[d] + 2 * k2[d] + 2 * k3[d] + k4[d]);
+  return true;
+}
+
+static double coord(const BasinVolumeOptions &o, int d, int i) {
+  return o.lo[d] + (o.hi[d] - o.lo[d]) * (double)i / (o.size[d] - 1);
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+  BasinVolumeOptions o;
+  for (int d = 0; d < 3; ++d) { o.lo[d] = -2; o.hi[d] = 2; o.size[d] = 48; }
+  o.max_steps = 2000; o.settle_tol = 1e-7; o.cluster_tol = 0.05;
+  auto mk = [](int) { return AdvanceFn3(flow3); };
+
+  /* 1. labels by octant, 4 attractors, compact storage */
+  BasinVolume vol;
+  std::vector<int> seen;
+  compute_basin_volume(mk, o, &vol, [&](int k) { seen.push_back(k); return true; });
+  long wrong = 0;
+  int lab[2][2] = {{-9, -9}, {-9, -9}};
+  for (int k = 0; k < o.size[2]; ++k)
+    for (int j = 0; j < o.size[1]; ++j)
+      for (int i = 0; i < o.size[0]; ++i) {
+        const int sx = coord(o, 0, i) > 0, sz = coord(o, 2, k) > 0;
+        const int l = vol.labels.at(i, j, k);
+        if (lab[sx][sz] == -9) lab[sx][sz] = l;
+        if (l != lab[sx][sz] || l < 0) wrong++;
+      }
+  const size_t raw = (size_t)48 * 48 * 48 * sizeof(std::int16_t);
+  printf("  48^3: %zu attractors, %ld cells off, %zu runs = %zu bytes (raw labels %zu)\n",
+         vol.attractors.size(), wrong, vol.labels.runs(), vol.labels.bytes(), raw);
+  if (!vol.ok || !vol.labels.complete() || vol.attractors.size() != 4 || wrong != 0 ||
+      lab[0][0] == lab[1][0] || lab[0][0] == lab[0][1] || lab[1][1] == lab[0][1]) {
+    printf("  <-- FAIL\n");
+    fails++;
+  }
+  if (vol.labels.bytes() * 5 > raw) { printf("  run-length store not compact <-- FAIL\n"); fails++; }
+
+  /* 2. coarse to fine: the ends and the middle come first, every slice once */
+  const std::vector<int> order = basin_volume_slice_order(48);
+  bool once = (int)order.size() == 48;
+  std::vector<int> hit(48, 0);
+  for (int k : order) once = once && ++hit[(size_t)k] == 1;
+  printf("  slice order: %d %d %d %d %d ... (%zu slices, callbacks %zu)\n", order[0], order[1], order[2],
+         order[3], order[4], order.size(), seen.size());
+  if (!once || order[0] != 0 || order[1] != 47 || order[2] != 23 || seen != order) {
+    printf("  <-- FAIL\n");
+    fails++;
+  }
+
+  /* 3. stop after 5 slices, then resume: same labels as the full run */
+  {
+    BasinVolume part;
+    int n = 0;
+    compute_basin_volume(mk, o, &part, [&](int) { return ++n < 5; });
+    const int after_stop = part.labels.filled();
+    const int near = part.labels.nearest_slice(20);
+    compute_basin_volume(mk, o, &part);
+    long differ = 0;
+    for (int k = 0; k < 48; ++k)
+      for (int j = 0; j < 48; ++j)
+        for (int i = 0; i < 48; ++i) differ += part.labels.at(i, j, k) != vol.labels.at(i, j, k);
+    printf("  stopped at %d slices (nearest to 20: %d), resumed: %ld cells differ\n", after_stop, near, differ);
+    if (after_stop != 5 || near != 23 || !part.labels.complete() || differ != 0) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 4. one thread gives the same volume */
+  {
+    pool::configure({1, false});
+    BasinVolume one;
+    compute_basin_volume(mk, o, &one);
+    pool::configure({4, false});
+    long differ = 0;
+    for (int k = 0; k < 48; ++k)
+      for (int j = 0; j < 48; ++j)
+        for (int i = 0; i < 48; ++i) differ += one.labels.at(i, j, k) != vol.labels.at(i, j, k);
+    printf("  1 thread vs 4: %ld cells differ\n", differ);
+    if (differ != 0) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 5. first hit on a ball of label 0 in empty (-1) space */
+  {
+    const int n = 33;
+    volume::LabelVolume ball(n, n, n);
+    std::vector<std::int16_t> s((size_t)n * n);
+    const double c = (n - 1) / 2.0, r = 12.0;
+    for (int k = 0; k < n; ++k) {
+      for (int j = 0; j < n; ++j)
+        for (int i = 0; i < n; ++i)
+          s[(size_t)j * n + i] = (i - c) * (i - c) + (j - c) * (j - c) + (k - c) * (k - c) <= r * r ? 0 : -1;
+      ball.set_slice(k, s.data());
+    }
+    std::vector<std::int16_t> top;
+    std::vector<int> depth;
+    ball.first_hit(-1, &top, &depth);
+    long off = 0;
+    for (int j = 0; j < n; ++j)
+      for (int i = 0; i < n; ++i) {
+        const double q = r * r - (i - c) * (i - c) - (j - c) * (j - c);
+        const size_t p = (size_t)j * n + i;
+        if (q < 0) { off += top[p] != -1 || depth[p] != -1; continue; }
+        off += top[p] != 0 || depth[p] != (int)std::floor(c + std::sqrt(q));
+      }
+    printf("  first hit on a ball: %ld pixels off\n", off);
+    if (off != 0) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 6. export and read back */
+  {
+    const char *path = "basin_volume_smoke.dsbv";
+    volume::VolumeMeta meta;
+    meta.lo = vol.lo; /* the box the volume was computed on */
+    meta.hi = vol.hi;
+    bool box_kept = true;
+    for (int d = 0; d < 3; ++d) box_kept = box_kept && vol.lo[(size_t)d] == o.lo[d] && vol.hi[(size_t)d] == o.hi[d];
+    meta.attractors = vol.attractors;
+    meta.axes = {{"x", "y", "z"}};
+    const bool wrote = volume::write_file(path, vol.labels, meta);
+    std::FILE *f = std::fopen(path, "rb");
+    long size = -1;
+    if (f) { std::fseek(f, 0, SEEK_END); size = std::ftell(f); std::fclose(f); }
+    volume::LabelVolume back;
+    volume::VolumeMeta mback;
+    const bool read = volume::read_file(path, &back, &mback);
+    /* a depth the file cannot hold is rejected before anything is sized */
+    bool corrupt_rejected = false;
+    if ((f = std::fopen(path, "r+b"))) {
+      const unsigned char huge[4] = {0xff, 0xff, 0xff, 0x7f};
+      std::fseek(f, 20, SEEK_SET); /* magic, version, header_bytes, width, height */
+      std::fwrite(huge, 1, 4, f);
+      std::fclose(f);
+      volume::LabelVolume bad;
+      volume::VolumeMeta mbad;
+      corrupt_rejected = !volume::read_file(path, &bad, &mbad);
+    }
+    std::remove(path);
+    long differ = 0;
+    for (int k = 0; read && k < 48; ++k)
+      for (int j = 0; j < 48; ++j)
+        for (int i = 0; i < 48; ++i) differ += back.at(i, j, k) != vol.labels.at(i, j, k);
+    printf("  export: %ld bytes (labels %zu), read back %s, %ld cells differ, %zu attractors, axes %s/%s/%s\n",
+           size, raw, read ? "ok" : "FAILED", differ, mback.attractors.size(), mback.axes[0].c_str(),
+           mback.axes[1].c_str(), mback.axes[2].c_str());
+    printf("  box %s, huge depth %s\n", box_kept && mback.lo == meta.lo && mback.hi == meta.hi ? "kept" : "LOST",
+           corrupt_rejected ? "rejected" : "ACCEPTED");
+    if (!wrote || !read || differ != 0 || size < (long)raw || size > (long)raw + 512 ||
+        mback.attractors != vol.attractors || mback.axes[2] != "z" || !box_kept || mback.lo != meta.lo ||
+        mback.hi != meta.hi || !corrupt_rejected) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
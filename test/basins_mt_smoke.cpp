@@ -1,4 +1,5 @@
 #include "analysis.h"
+#include "thread_pool.h"
 #include <cstdio>
 #include <cmath>
 #include <vector>
@@ -18,6 +19,7 @@ int main(){
   BasinOptions o; o.xmin=-2;o.xmax=2;o.ymin=-2;o.ymax=2;o.width=120;o.height=120;
   o.max_steps=300;o.settle_tol=1e-6;o.cluster_tol=0.05;o.diverge_r=1e6;o.max_attractors=8;
   BasinResult S=compute_basins(adv,o);
+  dynsys::pool::configure({4, false}); // exercise the pool even on one core
   auto mk=[&](int){ return AdvanceFn(adv); };
   BasinResult M=compute_basins_mt(mk,o);
   // compare
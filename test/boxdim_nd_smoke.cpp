@@ -0,0 +1,161 @@
+/* Locks the Morton-code box counter (box_counting_dimension,
+ * box_counting_dimension_nd, box_counting_dimension_file): counts equal a
+ * per-level hash set of occupied boxes exactly, in 2-D and n-D, non-finite
+ * points are skipped, a filled cube measures 3 and a Sierpinski tetrahedron
+ * 2, and the out-of-core path with many small runs matches the in-memory
+ * one. The single pass is timed against counting each level separately;
+ * the times are printed, not checked.
+ * make test-boxdimnd */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+/* the old counter: one hash set of box indices per level, same grid */
+static std::vector<long> naive_counts(const std::vector<double> &pts, int dim, int levels) {
+  const size_t n = pts.size() / dim;
+  std::vector<double> lo(dim, HUGE_VAL), hi(dim, -HUGE_VAL);
+  for (size_t i = 0; i < n; ++i)
+    for (int d = 0; d < dim; ++d) {
+      lo[d] = std::min(lo[d], pts[i * dim + d]);
+      hi[d] = std::max(hi[d], pts[i * dim + d]);
+    }
+  double span = 0;
+  for (int d = 0; d < dim; ++d) span = std::max(span, hi[d] - lo[d]);
+  span *= 1.0000001;
+  std::vector<long> out;
+  for (int l = 0; l < levels; ++l) {
+    const long grid = 1L << l;
+    const double eps = span / grid;
+    std::unordered_set<std::string> boxes;
+    for (size_t i = 0; i < n; ++i) {
+      std::string key;
+      for (int d = 0; d < dim; ++d) {
+        long k = (long)((pts[i * dim + d] - lo[d]) / eps);
+        k = k < 0 ? 0 : k >= grid ? grid - 1 : k;
+        key.append((const char *)&k, sizeof k);
+      }
+      boxes.insert(key);
+    }
+    out.push_back((long)boxes.size());
+  }
+  return out;
+}
+
+static std::vector<long> counts(const BoxCountResult &R) {
+  std::vector<long> out;
+  for (double v : R.log_count) out.push_back(std::lround(std::exp(v)));
+  return out;
+}
+
+static std::vector<double> tetrahedron(size_t n) {
+  const double V[4][3] = {{0, 0, 0}, {1, 0, 0}, {0.5, 0.8660254, 0}, {0.5, 0.2886751, 0.8164966}};
+  std::mt19937_64 rng(7);
+  std::vector<double> pts;
+  double x[3] = {0.1, 0.1, 0.1};
+  for (size_t i = 0; i < n + 20; ++i) {
+    const int k = (int)(rng() & 3);
+    for (int d = 0; d < 3; ++d) x[d] = 0.5 * (x[d] + V[k][d]);
+    if (i >= 20) pts.insert(pts.end(), x, x + 3);
+  }
+  return pts;
+}
+
+int main(int, char **argv) {
+  int fails = 0;
+  pool::configure({4, false});
+  std::mt19937_64 rng(3);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+
+  /* 1. exact counts against the hash-set counter: Henon in 2-D, Gaussian-ish
+   * clouds in 3-D and 5-D, with radix-sorted and std::sort-sized inputs */
+  {
+    std::vector<double> xs, ys, henon;
+    double x = 0.1, y = 0.1;
+    for (int i = 0; i < 200000; ++i) {
+      const double xn = 1.0 - 1.4 * x * x + y;
+      y = 0.3 * x;
+      x = xn;
+      if (i < 100) continue;
+      xs.push_back(x); ys.push_back(y);
+      henon.push_back(x); henon.push_back(y);
+    }
+    const bool h = counts(box_counting_dimension(xs, ys, 14)) == naive_counts(henon, 2, 14);
+    bool nd = true;
+    for (int dim : {3, 5})
+      for (size_t n : {(size_t)3000, (size_t)150000}) {
+        std::vector<double> pts(n * dim);
+        for (double &v : pts) v = U(rng) * U(rng);
+        nd = nd && counts(box_counting_dimension_nd(pts, dim, 12)) == naive_counts(pts, dim, std::min(12, 64 / dim + 1));
+      }
+    printf("  exact counts: Henon 2-D %s, 3-D / 5-D clouds %s\n", h ? "match" : "DIFFER", nd ? "match" : "DIFFER");
+    if (!h || !nd) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 2. known dimensions; NaN rows change nothing; thread count changes nothing */
+  {
+    std::vector<double> cube(3 * 2000000);
+    for (double &v : cube) v = U(rng);
+    const BoxCountResult C = box_counting_dimension_nd(cube, 3, 7);
+    std::vector<double> tet = tetrahedron(1000000);
+    const BoxCountResult T = box_counting_dimension_nd(tet, 3, 10);
+    std::vector<double> with_nan = tet;
+    with_nan.insert(with_nan.end(), {NAN, 0.5, 0.5, 0.5, INFINITY, 0.5});
+    const bool nan_same = box_counting_dimension_nd(with_nan, 3, 10).log_count == T.log_count;
+    pool::configure({1, false});
+    const bool threads_same = box_counting_dimension_nd(tet, 3, 10).log_count == T.log_count;
+    pool::configure({4, false});
+    printf("  filled cube D = %.3f (R2 %.4f), Sierpinski tetrahedron D = %.3f (R2 %.4f), NaN rows %s, 1 thread %s\n",
+           C.dimension, C.r_squared, T.dimension, T.r_squared, nan_same ? "skipped" : "COUNTED",
+           threads_same ? "identical" : "DIFFERS");
+    if (!C.ok || std::fabs(C.dimension - 3.0) > 0.1 || !T.ok || std::fabs(T.dimension - 2.0) > 0.1 || !nan_same ||
+        !threads_same) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+
+    /* 3. out of core: 20 runs of 50k points merged, and one chunk in memory */
+    const std::string path = std::string(argv[0]) + ".points";
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    std::fwrite(with_nan.data(), sizeof(double), with_nan.size(), f);
+    std::fclose(f);
+    const BoxCountResult F = box_counting_dimension_file(path.c_str(), 3, 10, 50000);
+    const BoxCountResult F1 = box_counting_dimension_file(path.c_str(), 3, 10, 4000000);
+    const BoxCountResult missing = box_counting_dimension_file((path + ".missing").c_str(), 3, 10);
+    std::remove(path.c_str());
+    printf("  file: merged runs %s, single chunk %s, missing file \"%s\"\n",
+           F.log_count == T.log_count ? "match" : "DIFFER", F1.log_count == T.log_count ? "match" : "DIFFER",
+           missing.message.c_str());
+    if (!F.ok || F.log_count != T.log_count || F1.log_count != T.log_count || missing.ok) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 4. a large set: one sort and scan against a hash set per level (timed,
+   * report only) */
+  {
+    std::vector<double> pts = tetrahedron(1000000);
+    auto t0 = std::chrono::steady_clock::now();
+    const BoxCountResult M = box_counting_dimension_nd(pts, 3, 12);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    t0 = std::chrono::steady_clock::now();
+    const std::vector<long> ref = naive_counts(pts, 3, 12);
+    const double naive_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("  10^6 points, 12 levels: dimension %.3f, counts %s; Morton %.0f ms, hash set per level %.0f ms (%.1fx)\n",
+           M.dimension, counts(M) == ref ? "match" : "DIFFER", ms, naive_ms, naive_ms / ms);
+    if (!M.ok || counts(M) != ref || std::fabs(M.dimension - 2.0) > 0.1) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
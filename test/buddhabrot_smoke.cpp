@@ -0,0 +1,97 @@
+/* Locks the Buddhabrot accumulator (accumulate_buddhabrot): the histogram
+ * does not depend on the thread count, accumulating in several calls
+ * matches one call, and on a zoomed view Metropolis-Hastings sampling gets
+ * close to the converged density with far fewer samples than uniform
+ * sampling, because nearly every sample puts orbit points in the view.
+ * make test-buddhabrot */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static bool quadratic(double cre, double cim, const double *x, double *xn) {
+  xn[0] = x[0] * x[0] - x[1] * x[1] + cre;
+  xn[1] = 2.0 * x[0] * x[1] + cim;
+  return true;
+}
+
+/* relative L1 distance between two histograms after scaling each to unit sum */
+static double l1(const std::vector<std::uint64_t> &a, const std::vector<std::uint64_t> &b) {
+  double sa = 0, sb = 0, d = 0;
+  for (size_t i = 0; i < a.size(); ++i) { sa += (double)a[i]; sb += (double)b[i]; }
+  if (sa <= 0 || sb <= 0) return 2.0;
+  for (size_t i = 0; i < a.size(); ++i) d += std::fabs(a[i] / sa - b[i] / sb);
+  return d;
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+  auto mk = [](int) { return BuddhaStepFn(quadratic); };
+
+  /* 1. same histogram on 1 and 4 threads, and in two calls as in one */
+  {
+    BuddhaOptions o;
+    o.width = 160; o.height = 160; o.samples = 40000;
+    BuddhaState four, one, once;
+    accumulate_buddhabrot(mk, o, &four);
+    accumulate_buddhabrot(mk, o, &four);
+    pool::configure({1, false});
+    accumulate_buddhabrot(mk, o, &one);
+    accumulate_buddhabrot(mk, o, &one);
+    pool::configure({4, false});
+    o.samples = 80000;
+    accumulate_buddhabrot(mk, o, &once);
+    long nz = 0;
+    for (std::uint64_t v : four.accum) nz += v != 0;
+    printf("  %ld samples: %ld pixels lit, 1 thread %s, one call %s\n", four.samples, nz,
+           four.accum == one.accum ? "identical" : "DIFFERS", four.accum == once.accum ? "identical" : "DIFFERS");
+    if (four.accum != one.accum || four.accum != once.accum || nz < 160 * 160 / 4) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 2. a zoomed view (0.06 wide): reference from a long uniform run on a
+   * coarse grid, then uniform and Metropolis sampling at a small budget, and
+   * Metropolis at 20x that to check it converges to the same density */
+  {
+    BuddhaOptions o;
+    o.xmin = -0.23; o.xmax = -0.17; o.ymin = 0.67; o.ymax = 0.73;
+    o.width = 12; o.height = 12;
+    o.importance = false;
+    o.samples = 8000000;
+    o.seed = 99;
+    BuddhaState ref;
+    auto t0 = std::chrono::steady_clock::now();
+    accumulate_buddhabrot(mk, o, &ref);
+    const double ref_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    o.seed = 1;
+    o.samples = 100000;
+    BuddhaState uni, mh, mh_long;
+    accumulate_buddhabrot(mk, o, &uni);
+    o.importance = true;
+    accumulate_buddhabrot(mk, o, &mh);
+    o.samples = 2000000;
+    accumulate_buddhabrot(mk, o, &mh_long);
+    const double eu = l1(uni.accum, ref.accum), em = l1(mh.accum, ref.accum), el = l1(mh_long.accum, ref.accum);
+    printf("  zoom, %ld samples: uniform %.1f%% in view, L1 %.3f | Metropolis %.1f%% in view (%.0f%% accepted), "
+           "L1 %.3f, at %ld samples %.3f | reference %ld uniform samples, %.0f ms\n",
+           uni.samples, 100.0 * uni.contributing / uni.samples, eu, 100.0 * mh.contributing / mh.samples,
+           100.0 * mh.accepted / mh.samples, em, mh_long.samples, el, ref.samples, ref_ms);
+    if (!(em < 0.5 * eu) || !(el < 0.15) || mh.contributing < 10 * uni.contributing) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,166 @@
+/* Locks the blockwise Jacobian assembly of the collocation solvers: with an
+ * exact jacobian_x / dfdp the cycle continuation, the homoclinic BVP and the
+ * LPC curve give the same answers as the finite-difference path, and a
+ * Newton step costs O(M) vector-field calls (one residual) instead of one
+ * residual per unknown.
+ * make test-collocad */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static long field_calls = 0, jac_calls = 0;
+
+/* 3-D Hopf oscillator with a slaved stable mode */
+static bool hopf3(const double *X, double mu, double *f, std::string *) {
+  ++field_calls;
+  const double r2 = X[0] * X[0] + X[1] * X[1];
+  f[0] = -X[1] + X[0] * (mu - r2); f[1] = X[0] + X[1] * (mu - r2); f[2] = -X[2] + X[0] * X[1];
+  return true;
+}
+static bool hopf3_jac(const double *X, double mu, double *J, std::string *) {
+  ++jac_calls;
+  const double r2 = X[0] * X[0] + X[1] * X[1];
+  J[0] = mu - r2 - 2 * X[0] * X[0]; J[1] = -1 - 2 * X[0] * X[1]; J[2] = 0;
+  J[3] = 1 - 2 * X[0] * X[1];       J[4] = mu - r2 - 2 * X[1] * X[1]; J[5] = 0;
+  J[6] = X[1];                      J[7] = X[0];                      J[8] = -1;
+  return true;
+}
+static bool hopf3_dfdp(const double *X, double, double *o, std::string *) {
+  o[0] = X[0]; o[1] = X[1]; o[2] = 0;
+  return true;
+}
+
+static bool homo(const double *X, double, double *o, std::string *) {
+  ++field_calls;
+  o[0] = X[1]; o[1] = X[0] - X[0] * X[0];
+  return true;
+}
+static bool homo_jac(const double *X, double, double *J, std::string *) {
+  ++jac_calls;
+  J[0] = 0; J[1] = 1; J[2] = 1 - 2 * X[0]; J[3] = 0;
+  return true;
+}
+
+int main() {
+  int fails = 0;
+
+  /* 1. cycle continuation: AD and finite differences agree; AD needs no
+   * per-column field evaluations */
+  {
+    const int mesh = 100;
+    std::vector<std::vector<double>> guess;
+    for (int i = 0; i < mesh; ++i) {
+      const double th = 2 * M_PI * i / mesh;
+      guess.push_back({std::cos(th), std::sin(th), 0.0});
+    }
+    CycleSettings s; s.mesh = mesh; s.p_min = 0.2; s.p_max = 2.0; s.ds = 0.1; s.max_steps = 16;
+    s.compute_floquet = false; s.adaptive_mesh = false;
+    Model fd; fd.n = 3; fd.vector_field = hopf3;
+    Model ad = fd; ad.jacobian_x = hopf3_jac; ad.dfdp = hopf3_dfdp;
+    field_calls = 0;
+    const CycleBranch a = continue_limit_cycle(fd, guess, 2 * M_PI, 1.0, s);
+    const long calls_fd = field_calls;
+    field_calls = 0; jac_calls = 0;
+    const CycleBranch b = continue_limit_cycle(ad, guess, 2 * M_PI, 1.0, s);
+    const long calls_ad = field_calls, jacs = jac_calls;
+    double dmax = 0;
+    const bool same_n = a.samples.size() == b.samples.size();
+    for (std::size_t i = 0; same_n && i < a.samples.size(); ++i)
+      dmax = std::max({dmax, std::fabs(a.samples[i].p - b.samples[i].p),
+                       std::fabs(a.samples[i].period - b.samples[i].period),
+                       std::fabs(a.samples[i].amplitude - b.samples[i].amplitude)});
+    /* one dense finite-difference Jacobian: (M n + 2) residuals of 2M calls */
+    const long dense_per_jac = (long)(mesh * 3 + 2) * 2 * mesh;
+    printf("  cycle, mesh %d: %zu samples, max |AD - FD| %.2e | field calls FD %ld, AD %ld (+%ld Jacobians); "
+           "a dense FD Jacobian alone took %ld\n",
+           mesh, b.samples.size(), dmax, calls_fd, calls_ad, jacs, dense_per_jac);
+    if (!a.ok || !b.ok || !same_n || dmax > 1e-6 || calls_ad * 2 > calls_fd || calls_fd > dense_per_jac) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 2. homoclinic BVP (x' = y, y' = x - x^2, peak 1.5) */
+  {
+    const double Tt = 8.0; const int Np = 300;
+    std::vector<std::vector<double>> seed(Np, std::vector<double>(2));
+    for (int i = 0; i < Np; ++i) {
+      const double t = -Tt + 2 * Tt * i / (Np - 1), bump = 1.3 * std::exp(-0.35 * t * t);
+      seed[i][0] = bump; seed[i][1] = 1.3 * (-0.7 * t) * std::exp(-0.35 * t * t);
+    }
+    HomoclinicSettings s; s.mesh = 200; s.T = Tt; s.newton_iters = 200; s.free_T = false;
+    Model fd; fd.n = 2; fd.vector_field = homo;
+    Model ad = fd; ad.jacobian_x = homo_jac;
+    field_calls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    const HomoclinicResult a = solve_homoclinic(fd, {0, 0}, 0.0, seed, s);
+    const double ms_fd = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const long calls_fd = field_calls;
+    field_calls = 0; jac_calls = 0;
+    t0 = std::chrono::steady_clock::now();
+    const HomoclinicResult b = solve_homoclinic(ad, {0, 0}, 0.0, seed, s);
+    const double ms_ad = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    double peak = 0, dmax = 0;
+    for (std::size_t j = 0; j < b.orbit.size(); ++j) {
+      peak = std::max(peak, b.orbit[j][0]);
+      if (j < a.orbit.size()) dmax = std::max(dmax, std::hypot(a.orbit[j][0] - b.orbit[j][0], a.orbit[j][1] - b.orbit[j][1]));
+    }
+    printf("  homoclinic, mesh 200: FD %d steps %.0f ms %ld field calls | AD %d steps %.0f ms %ld field calls, "
+           "%ld Jacobians | peak %.4f, max orbit difference %.2e\n",
+           a.newton_steps, ms_fd, calls_fd, b.newton_steps, ms_ad, field_calls, jac_calls, peak, dmax);
+    if (!a.ok || !b.ok || std::fabs(peak - 1.5) > 0.05 || dmax > 1e-5 || jac_calls == 0) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 3. LPC curve of the Bautin form (fold at mu = -a^2/4) with an exact
+   * two-parameter Jacobian passed through to the cycle continuations */
+  {
+    Model2 m; m.n = 2;
+    m.vector_field = [](const double *X, double mu, double a, double *f, std::string *) {
+      ++field_calls;
+      const double R = X[0] * X[0] + X[1] * X[1], g = mu + a * R - R * R;
+      f[0] = -X[1] + X[0] * g; f[1] = X[0] + X[1] * g;
+      return true;
+    };
+    m.jacobian_x = [](const double *X, double mu, double a, double *J, std::string *) {
+      ++jac_calls;
+      const double R = X[0] * X[0] + X[1] * X[1], g = mu + a * R - R * R, gR = a - 2 * R;
+      J[0] = g + 2 * X[0] * X[0] * gR;  J[1] = -1 + 2 * X[0] * X[1] * gR;
+      J[2] = 1 + 2 * X[0] * X[1] * gR;  J[3] = g + 2 * X[1] * X[1] * gR;
+      return true;
+    };
+    m.dfdp = [](const double *X, double, double, double *o, std::string *) {
+      o[0] = X[0]; o[1] = X[1];
+      return true;
+    };
+    const double mu0 = 0.1, a0 = 1.0, rad = std::sqrt((a0 + std::sqrt(a0 * a0 + 4 * mu0)) / 2);
+    const int mesh = 50;
+    std::vector<std::vector<double>> guess;
+    for (int i = 0; i < mesh; ++i) {
+      const double th = 2 * M_PI * i / mesh;
+      guess.push_back({rad * std::cos(th), rad * std::sin(th)});
+    }
+    TwoParamSettings s; s.p_min = -0.5; s.p_max = 0.5; s.q_min = 0.8; s.q_max = 1.4; s.max_points = 12;
+    CycleSettings cs; cs.mesh = mesh; cs.ds = 0.05; cs.max_steps = 200; cs.compute_floquet = false;
+    jac_calls = 0;
+    const LPCCurve c = lpc_curve(m, guess, 2 * M_PI, mu0, a0, s, cs);
+    double worst = 0;
+    for (const LPCPoint &pt : c.points) worst = std::max(worst, std::fabs(pt.p + pt.q * pt.q / 4));
+    printf("  LPC curve: %zu points, worst |mu + a^2/4| %.4f, %ld exact Jacobians used\n", c.points.size(), worst,
+           jac_calls);
+    if (!c.ok || c.points.size() < 5 || worst > 0.01 || jac_calls == 0) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
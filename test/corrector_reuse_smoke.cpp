@@ -0,0 +1,159 @@
+/* Locks the chord / Broyden correctors of the continuation engines on models
+ * whose Jacobians come from finite differences (each costs 2n right-hand
+ * sides): the equilibrium branch of a discretized Bratu problem, its fold
+ * curve under a constant forcing, and a Hopf oscillator's cycle branch come
+ * out the same as with full Newton, while the corrector evaluates at most
+ * half as many Jacobians and the runs as a whole at most 60% of the
+ * vector-field calls (reported by the counts on each result).
+ * make test-qncorr */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static const int N = 40;
+static long field_calls = 0;
+
+/* x_i'' + p exp(x_i) + q = 0 on a uniform grid, x = 0 at both ends */
+static void bratu(const double *X, double p, double q, double *f) {
+  ++field_calls;
+  const double h2 = 1.0 / ((N + 1.0) * (N + 1.0));
+  for (int i = 0; i < N; ++i) {
+    const double l = i > 0 ? X[i - 1] : 0.0, r = i + 1 < N ? X[i + 1] : 0.0;
+    f[i] = (l - 2 * X[i] + r) / h2 + p * std::exp(X[i]) + q;
+  }
+}
+
+/* 3-D Hopf oscillator with a slaved stable mode: amplitude 2 sqrt(mu) */
+static bool hopf3(const double *X, double mu, double *f, std::string *) {
+  ++field_calls;
+  const double r2 = X[0] * X[0] + X[1] * X[1];
+  f[0] = -X[1] + X[0] * (mu - r2); f[1] = X[0] + X[1] * (mu - r2); f[2] = -X[2] + X[0] * X[1];
+  return true;
+}
+
+static const char *kKind[3] = {"Newton", "chord", "Broyden"};
+
+static void report(const char *what, int k, long calls, double ms, const CorrectorCounts &c) {
+  printf("  %s, %-7s: %6ld field calls in %6.1f ms | %4ld corrector steps, %4ld Jacobians, %4ld factorizations\n",
+         what, kKind[k], calls, ms, c.iterations, c.jacobians, c.factorizations);
+}
+
+int main() {
+  int fails = 0;
+  using clock = std::chrono::steady_clock;
+
+  /* 1. equilibrium branch through the Bratu fold */
+  {
+    Model m; m.n = N;
+    m.vector_field = [](const double *X, double p, double *f, std::string *) { bratu(X, p, 0.0, f); return true; };
+    ContinuationSettings s; s.h0 = 0.05; s.h_max = 0.5; s.p_min = 0.5; s.p_max = 4; s.max_points = 200;
+    long calls[3]; double fold[3]; CorrectorCounts cnt[3]; std::size_t pts[3];
+    for (int k = 0; k < 3; ++k) {
+      s.corrector = (CorrectorKind)k;
+      field_calls = 0;
+      const auto t0 = clock::now();
+      const Branch b = continue_equilibrium(m, std::vector<double>(N, 0.1), 1.0, s);
+      const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+      calls[k] = field_calls; cnt[k] = b.counts; pts[k] = b.points.size();
+      fold[k] = std::nan("");
+      for (std::size_t i : b.special_indices)
+        if (b.points[i].special == SpecialPointKind::Fold) fold[k] = b.points[i].p;
+      report("equilibrium", k, calls[k], ms, cnt[k]);
+      if (!b.ok) fails++;
+    }
+    printf("  fold at p = %.9f / %.9f / %.9f (continuum 3.513830719), %zu / %zu / %zu points\n", fold[0], fold[1],
+           fold[2], pts[0], pts[1], pts[2]);
+    for (int k = 1; k < 3; ++k)
+      if (!(std::fabs(fold[k] - fold[0]) < 1e-7) || 2 * cnt[k].jacobians > cnt[0].jacobians ||
+          10 * calls[k] > 6 * calls[0]) {
+        printf("  <-- FAIL (%s)\n", kKind[k]);
+        fails++;
+      }
+    if (!(std::fabs(fold[0] - 3.5138) < 0.01)) { printf("  <-- FAIL (fold)\n"); fails++; }
+  }
+
+  /* 2. the fold curve in (p, q) */
+  {
+    Model2 m; m.n = N;
+    m.vector_field = [](const double *X, double p, double q, double *f, std::string *) { bratu(X, p, q, f); return true; };
+    std::vector<double> x0;
+    {
+      /* the fold at q = 0, from the branch */
+      Model m1; m1.n = N;
+      m1.vector_field = [](const double *X, double p, double *f, std::string *) { bratu(X, p, 0.0, f); return true; };
+      ContinuationSettings s; s.h0 = 0.05; s.h_max = 0.5; s.p_min = 0.5; s.p_max = 4; s.max_points = 200;
+      const Branch b = continue_equilibrium(m1, std::vector<double>(N, 0.1), 1.0, s);
+      for (std::size_t i : b.special_indices)
+        if (b.points[i].special == SpecialPointKind::Fold) x0 = b.points[i].x;
+    }
+    TwoParamSettings s; s.p_min = 1; s.p_max = 6; s.q_min = -2; s.q_max = 2; s.h0 = 0.2; s.max_points = 60;
+    long calls[3]; CorrectorCounts cnt[3]; double worst[3];
+    for (int k = 0; k < 3; ++k) {
+      s.corrector = (CorrectorKind)k;
+      field_calls = 0;
+      const auto t0 = clock::now();
+      const TwoParamCurve c = two_param_curve(m, TwoParamKind::Fold, x0, 3.5138, 0.0, s);
+      const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+      calls[k] = field_calls; cnt[k] = c.counts;
+      /* each point: smallest |eigenvalue| of f_x relative to the largest */
+      worst[k] = c.points.empty() ? 1.0 : 0.0;
+      for (const TwoParamPoint &pt : c.points) {
+        Model mq; mq.n = N;
+        const double q = pt.q;
+        mq.vector_field = [q](const double *X, double p, double *f, std::string *) { bratu(X, p, q, f); return true; };
+        std::vector<double> J;
+        std::vector<Complex> ev;
+        std::string e;
+        finite_diff_jacobian(mq, pt.x.data(), pt.p, &J, &e);
+        eigenvalues(J, N, &ev);
+        double lo = 1e300, hi = 0;
+        for (const Complex &z : ev) { lo = std::min(lo, std::abs(z)); hi = std::max(hi, std::abs(z)); }
+        worst[k] = std::max(worst[k], lo / hi);
+      }
+      report("fold curve ", k, calls[k], ms, cnt[k]);
+      printf("    %zu points, max |lambda|min / |lambda|max %.2e\n", c.points.size(), worst[k]);
+      if (!c.ok || c.points.size() < 20 || worst[k] > 1e-8) fails++;
+    }
+    for (int k = 1; k < 3; ++k)
+      if (2 * cnt[k].jacobians > cnt[0].jacobians || 10 * calls[k] > 6 * calls[0]) {
+        printf("  <-- FAIL (%s)\n", kKind[k]);
+        fails++;
+      }
+  }
+
+  /* 3. cycle branch (pseudo-arclength, trapezoidal mesh) */
+  {
+    const int mesh = 60;
+    std::vector<std::vector<double>> guess;
+    for (int i = 0; i < mesh; ++i) {
+      const double th = 2 * M_PI * i / mesh;
+      guess.push_back({std::cos(th), std::sin(th), 0.0});
+    }
+    CycleSettings s; s.mesh = mesh; s.p_min = 0.2; s.p_max = 2.0; s.ds = 0.1; s.max_steps = 30;
+    s.compute_floquet = false; s.adaptive_mesh = false;
+    Model m; m.n = 3; m.vector_field = hopf3;
+    CorrectorCounts cnt[3]; double err[3];
+    for (int k = 0; k < 3; ++k) {
+      s.corrector = (CorrectorKind)k;
+      field_calls = 0;
+      const auto t0 = clock::now();
+      const CycleBranch b = continue_limit_cycle(m, guess, 2 * M_PI, 1.0, s);
+      const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+      cnt[k] = b.counts;
+      err[k] = b.samples.empty() ? 1.0 : 0.0;
+      for (const CycleSample &x : b.samples) err[k] = std::max(err[k], std::fabs(x.amplitude - 2 * std::sqrt(x.p)));
+      report("cycles     ", k, field_calls, ms, cnt[k]);
+      if (!b.ok || err[k] > 1e-3) { printf("  <-- FAIL (amplitude error %.2e)\n", err[k]); fails++; }
+    }
+    for (int k = 1; k < 3; ++k)
+      if (2 * cnt[k].jacobians > cnt[0].jacobians) { printf("  <-- FAIL (%s)\n", kKind[k]); fails++; }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
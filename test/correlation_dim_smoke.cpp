@@ -0,0 +1,200 @@
+/* Locks the correlation / generalized dimensions (correlation_dimensions):
+ * the k-d tree pair counts equal brute force, the Henon map gives
+ * D_2 ~ 1.21 and the Lorenz flow D_2 ~ 2.05, a uniform cube has D_q = 3
+ * for every q, a weighted Cantor measure has the analytic D_q spectrum,
+ * and the result does not depend on the thread count. 10^6 points are
+ * timed against all pairs; the times are printed, not checked.
+ * make test-corrdim */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static std::vector<double> henon(size_t n) {
+  std::vector<double> pts;
+  double x = 0.1, y = 0.1;
+  for (size_t i = 0; i < n + 1000; ++i) {
+    const double xn = 1.0 - 1.4 * x * x + y;
+    y = 0.3 * x;
+    x = xn;
+    if (i >= 1000) { pts.push_back(x); pts.push_back(y); }
+  }
+  return pts;
+}
+
+static std::vector<double> lorenz(size_t n, double dt) {
+  std::vector<double> pts;
+  double s[3] = {1, 1, 20};
+  auto f = [](const double *u, double *du) {
+    du[0] = 10.0 * (u[1] - u[0]);
+    du[1] = u[0] * (28.0 - u[2]) - u[1];
+    du[2] = u[0] * u[1] - 8.0 / 3.0 * u[2];
+  };
+  for (size_t i = 0; i < n + 5000; ++i) {
+    double k1[3], k2[3], k3[3], k4[3], t[3];
+    f(s, k1);
+    for (int a = 0; a < 3; ++a) t[a] = s[a] + 0.5 * dt * k1[a];
+    f(t, k2);
+    for (int a = 0; a < 3; ++a) t[a] = s[a] + 0.5 * dt * k2[a];
+    f(t, k3);
+    for (int a = 0; a < 3; ++a) t[a] = s[a] + dt * k3[a];
+    f(t, k4);
+    for (int a = 0; a < 3; ++a) s[a] += dt / 6.0 * (k1[a] + 2 * k2[a] + 2 * k3[a] + k4[a]);
+    if (i >= 5000) pts.insert(pts.end(), s, s + 3);
+  }
+  return pts;
+}
+
+static double dq_of(const DimensionSpectrum &R, double q) {
+  for (size_t i = 0; i < R.qs.size(); ++i)
+    if (R.qs[i] == q) return R.dq[i];
+  return NAN;
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+
+  /* 1. pair counts against all pairs, Theiler window included */
+  {
+    const std::vector<double> pts = henon(3000);
+    DimensionSpectrumOptions o;
+    o.theiler = 5;
+    o.max_centres = 0;
+    const DimensionSpectrum R = correlation_dimensions(pts, 2, o);
+    const size_t n = pts.size() / 2;
+    double extent = 0;
+    for (int a = 0; a < 2; ++a) {
+      double lo = 1e300, hi = -1e300;
+      for (size_t i = 0; i < n; ++i) { lo = std::min(lo, pts[2 * i + a]); hi = std::max(hi, pts[2 * i + a]); }
+      extent = std::max(extent, hi - lo);
+    }
+    double worst = 0;
+    for (size_t k = 0; k < R.log_r.size(); ++k) {
+      const double r = extent * o.r_min * std::pow(o.r_max / o.r_min, (double)k / (R.log_r.size() - 1));
+      double sum = 0;
+      for (size_t i = 0; i < n; ++i) {
+        long c = 0, others = 0;
+        for (size_t j = 0; j < n; ++j) {
+          if ((i > j ? i - j : j - i) <= 5) continue;
+          ++others;
+          const double dx = pts[2 * i] - pts[2 * j], dy = pts[2 * i + 1] - pts[2 * j + 1];
+          c += dx * dx + dy * dy < r * r;
+        }
+        sum += (double)c / others;
+      }
+      const double brute = sum / n;
+      if (brute > 0) worst = std::max(worst, std::fabs(std::exp(R.log_correlation[k]) / brute - 1.0));
+    }
+    printf("  3000 Henon points, all pairs: worst relative difference in C(r) %.1e\n", worst);
+    if (!R.ok || worst > 1e-9) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 2. known correlation dimensions */
+  {
+    DimensionSpectrumOptions o;
+    o.max_centres = 5000;
+    const DimensionSpectrum H = correlation_dimensions(henon(200000), 2, o);
+    o.theiler = 200;
+    o.r_min = 5e-3;
+    o.r_max = 0.2;
+    const DimensionSpectrum L = correlation_dimensions(lorenz(200000, 0.02), 3, o);
+    printf("  Henon D2 = %.3f (R2 %.4f, radii %d..%d), Lorenz D2 = %.3f (R2 %.4f)\n", H.correlation_dimension,
+           H.correlation_r_squared, H.fit_first, H.fit_last, L.correlation_dimension, L.correlation_r_squared);
+    if (!H.ok || std::fabs(H.correlation_dimension - 1.21) > 0.06 || !L.ok ||
+        std::fabs(L.correlation_dimension - 2.05) > 0.1) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 3. D_q spectra: flat for a uniform cube, analytic for a weighted
+   * two-scale Cantor measure (weights 0.2 / 0.8 on thirds):
+   * D_q = log(0.2^q + 0.8^q) / ((1 - q) log 3) */
+  {
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> U(0.0, 1.0);
+    std::vector<double> cube(3 * 200000);
+    for (double &v : cube) v = U(rng);
+    DimensionSpectrumOptions o;
+    o.theiler = 0;
+    o.max_centres = 5000;
+    o.r_min = 1e-2;
+    o.r_max = 0.08;
+    const DimensionSpectrum C = correlation_dimensions(cube, 3, o);
+    std::vector<double> cantor;
+    double x = 0.3;
+    for (int i = 0; i < 400000; ++i) {
+      x = U(rng) < 0.2 ? x / 3.0 : x / 3.0 + 2.0 / 3.0;
+      if (i >= 50) cantor.push_back(x);
+    }
+    o.r_min = 1e-4;
+    o.r_max = 0.3;
+    o.n_radii = 40;
+    const DimensionSpectrum K = correlation_dimensions(cantor, 1, o);
+    bool good = C.ok && K.ok;
+    printf("  q:      ");
+    for (double q : o.qs) printf("%8.0f", q);
+    printf("\n  cube:   ");
+    for (double q : o.qs) {
+      printf("%8.3f", dq_of(C, q));
+      good = good && std::fabs(dq_of(C, q) - 3.0) < 0.12;
+    }
+    printf("\n  Cantor: ");
+    for (double q : o.qs) {
+      printf("%8.3f", dq_of(K, q));
+      const double exact = q == 1 ? -(0.2 * std::log(0.2) + 0.8 * std::log(0.8)) / std::log(3.0)
+                                  : std::log(std::pow(0.2, q) + std::pow(0.8, q)) / ((1 - q) * std::log(3.0));
+      good = good && std::fabs(dq_of(K, q) - exact) < 0.06;
+    }
+    printf("\n  exact:  ");
+    for (double q : o.qs)
+      printf("%8.3f", q == 1 ? -(0.2 * std::log(0.2) + 0.8 * std::log(0.8)) / std::log(3.0)
+                             : std::log(std::pow(0.2, q) + std::pow(0.8, q)) / ((1 - q) * std::log(3.0)));
+    printf("\n");
+    if (!good) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 4. 10^6 points: thread count does not matter; time against all pairs
+   * from the same centres, extrapolated from 50 of them (report only) */
+  {
+    const std::vector<double> pts = henon(1000000);
+    DimensionSpectrumOptions o;
+    auto t0 = std::chrono::steady_clock::now();
+    const DimensionSpectrum A = correlation_dimensions(pts, 2, o);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    pool::configure({1, false});
+    const DimensionSpectrum B = correlation_dimensions(pts, 2, o);
+    pool::configure({4, false});
+    t0 = std::chrono::steady_clock::now();
+    long hits = 0;
+    const size_t n = pts.size() / 2;
+    for (int c = 0; c < 50; ++c) {
+      const size_t i = (size_t)c * (n / 50);
+      for (size_t j = 0; j < n; ++j) {
+        const double dx = pts[2 * i] - pts[2 * j], dy = pts[2 * i + 1] - pts[2 * j + 1];
+        hits += dx * dx + dy * dy < 0.5;
+      }
+    }
+    const double brute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() *
+                            (double)A.centres / 50.0;
+    const bool same = A.log_cq == B.log_cq && A.log_correlation == B.log_correlation;
+    printf("  10^6 Henon points, %ld centres: %.0f ms (all-pairs distances ~%.0f ms, %ld close pairs from 50), "
+           "D2 = %.3f, 1 thread %s\n",
+           A.centres, ms, brute_ms, hits, A.correlation_dimension, same ? "identical" : "DIFFERS");
+    if (!A.ok || !same || std::fabs(A.correlation_dimension - 1.21) > 0.06) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
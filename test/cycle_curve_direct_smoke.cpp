@@ -0,0 +1,108 @@
+/* Locks the direct continuation of cycle-bifurcation curves (minimally
+ * extended collocation systems, pseudo-arclength in (p, q)): the LPC curve of
+ * the Bautin normal form and the NS curve of a cycle whose transverse plane
+ * undergoes a Hopf bifurcation, both known in closed form. The cost of an
+ * LPC point against the one-parameter cycle branch that the former q scan
+ * ran per point is printed, not checked.
+ * make test-cyccurve */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::vector<std::vector<double>> circle(int mesh, double R, std::size_t n) {
+  std::vector<std::vector<double>> g;
+  for (int i = 0; i < mesh; ++i) {
+    const double th = 2 * M_PI * i / mesh;
+    std::vector<double> x(n, 0.0);
+    x[0] = R * std::cos(th); x[1] = R * std::sin(th);
+    g.push_back(x);
+  }
+  return g;
+}
+
+int main() {
+  int fails = 0;
+
+  /* 1. Bautin r' = r (mu + a r^2 - r^4): folds of cycles on mu = -a^2/4 */
+  {
+    Model2 m; m.n = 2;
+    m.vector_field = [](const double *X, double mu, double a, double *f, std::string *) {
+      const double R = X[0] * X[0] + X[1] * X[1], g = mu + a * R - R * R;
+      f[0] = -X[1] + X[0] * g; f[1] = X[0] + X[1] * g;
+      return true;
+    };
+    const double mu0 = 0.1, a0 = 1.0, rad = std::sqrt((a0 + std::sqrt(a0 * a0 + 4 * mu0)) / 2);
+    TwoParamSettings s; s.p_min = -1.0; s.p_max = 0.5; s.q_min = 0.5; s.q_max = 1.8; s.max_points = 40;
+    CycleSettings cs; cs.mesh = 20; cs.ncol = 4; cs.ds = 0.05; cs.max_steps = 200; cs.compute_floquet = false;
+    auto t0 = std::chrono::steady_clock::now();
+    const LPCCurve c = lpc_curve(m, circle(80, rad, 2), 2 * M_PI, mu0, a0, s, cs);
+    const double ms = ms_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    Model m1; m1.n = 2;
+    m1.vector_field = [&m, a0](const double *X, double mu, double *f, std::string *e) { return m.vector_field(X, mu, a0, f, e); };
+    CycleSettings cb = cs; cb.p_min = s.p_min; cb.p_max = s.p_max;
+    const CycleBranch br = continue_limit_cycle(m1, circle(80, rad, 2), 2 * M_PI, mu0, cb);
+    const double ms_branch = ms_since(t0);
+    double worst = 0, qlo = 1e9, qhi = -1e9;
+    for (const LPCPoint &pt : c.points) {
+      worst = std::max(worst, std::fabs(pt.p + pt.q * pt.q / 4));
+      qlo = std::min(qlo, pt.q); qhi = std::max(qhi, pt.q);
+    }
+    const double per_point = c.points.empty() ? 0.0 : ms / c.points.size();
+    printf("  LPC (Bautin), 20 x 4: %zu points over a in [%.2f, %.2f], worst |mu + a^2/4| %.1e | "
+           "%.1f ms, %.2f ms per point vs %.1f ms for one cycle branch (%zu samples, %.1fx)\n",
+           c.points.size(), qlo, qhi, worst, ms, per_point, ms_branch, br.samples.size(),
+           per_point > 0 ? ms_branch / per_point : 0.0);
+    if (!c.ok || c.points.size() < 20 || worst > 1e-5 || qlo > 0.55 || qhi < 1.75) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 2. a unit-circle cycle of period T = 2 pi / w, w = 1 + q/2, whose
+   * transverse (rho = r - 1, z) plane spirals at rate nu = p - q^2 and
+   * frequency 0.9: the multipliers are e^{(nu +- 0.9 i) T}, so the NS curve is
+   * p = q^2, with 0.9 T between pi and 2 pi (no strong resonance) */
+  {
+    Model2 m; m.n = 3;
+    m.vector_field = [](const double *X, double p, double q, double *f, std::string *) {
+      const double r = std::hypot(X[0], X[1]), rho = r - 1, z = X[2], nu = p - q * q, w = 1 + 0.5 * q;
+      const double s2 = rho * rho + z * z, drho = nu * rho - 0.9 * z - rho * s2;
+      f[0] = drho / r * X[0] - w * X[1];
+      f[1] = drho / r * X[1] + w * X[0];
+      f[2] = 0.9 * rho + nu * z - z * s2;
+      return true;
+    };
+    const double q0 = 0.5, p0 = 0.5;
+    TwoParamSettings s; s.p_min = -1.0; s.p_max = 1.5; s.q_min = 0.0; s.q_max = 1.0; s.max_points = 80;
+    CycleSettings cs; cs.mesh = 20; cs.ncol = 4; cs.ds = 0.05; cs.max_steps = 200;
+    const auto t0 = std::chrono::steady_clock::now();
+    const CycleBifCurve c = ns_curve(m, circle(80, 1.0, 3), 4 * M_PI / 2.5, p0, q0, s, cs);
+    const double ms = ms_since(t0);
+    double worst = 0, worstT = 0, qlo = 1e9, qhi = -1e9;
+    for (const CycleBifPoint &pt : c.points) {
+      worst = std::max(worst, std::fabs(pt.p - pt.q * pt.q));
+      worstT = std::max(worstT, std::fabs(pt.period - 2 * M_PI / (1 + 0.5 * pt.q)));
+      qlo = std::min(qlo, pt.q); qhi = std::max(qhi, pt.q);
+    }
+    printf("  NS, 20 x 4: %zu points over q in [%.2f, %.2f] in %.1f ms, worst |p - q^2| %.1e, "
+           "worst period error %.1e\n",
+           c.points.size(), qlo, qhi, ms, worst, worstT);
+    if (!c.ok || c.points.size() < 10 || worst > 1e-5 || worstT > 1e-5 || qlo > 0.05 || qhi < 0.95) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,109 @@
+/* Locks the bordered test functions of continue_equilibrium on a 50-D model:
+ * a fold and three Hopf pairs (one crossing in the shadow of another, so the
+ * tracked pair alone would miss it) are all located on both sides of the
+ * fold, every regular point's stability agrees with its full spectrum, and a
+ * point costs a handful of Jacobians.
+ * make test-eqtests */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static const int N = 50;
+static long jac_calls = 0;
+
+/* x0' = p - x0^2 (fold at p = 0); pairs (x1,x2), (x3,x4), (x5,x6) with
+ * eigenvalues (p - c) +- i w for c = 0.5, 0.75, 0.45; the rest a damped
+ * chain driven by x0 */
+static const double C[3] = {0.5, 0.75, 0.45}, W[3] = {2.0, 3.0, 5.0};
+
+static bool f(const double *X, double p, double *o, std::string *) {
+  o[0] = p - X[0] * X[0];
+  for (int k = 0; k < 3; ++k) {
+    const double u = X[1 + 2 * k], v = X[2 + 2 * k], r2 = u * u + v * v;
+    o[1 + 2 * k] = (p - C[k]) * u - W[k] * v - u * r2;
+    o[2 + 2 * k] = W[k] * u + (p - C[k]) * v - v * r2;
+  }
+  for (int k = 7; k < N; ++k) o[k] = -(1 + 0.1 * k) * X[k] + 0.3 * X[k - 1] * X[k - 1] + 0.05 * X[0];
+  return true;
+}
+static bool jac(const double *X, double p, double *J, std::string *) {
+  ++jac_calls;
+  for (int i = 0; i < N * N; ++i) J[i] = 0;
+  J[0] = -2 * X[0];
+  for (int k = 0; k < 3; ++k) {
+    const int a = 1 + 2 * k, b = a + 1;
+    const double u = X[a], v = X[b];
+    J[a * N + a] = (p - C[k]) - 3 * u * u - v * v; J[a * N + b] = -W[k] - 2 * u * v;
+    J[b * N + a] = W[k] - 2 * u * v;               J[b * N + b] = (p - C[k]) - u * u - 3 * v * v;
+  }
+  for (int k = 7; k < N; ++k) {
+    J[k * N + k] = -(1 + 0.1 * k);
+    J[k * N + k - 1] = 0.6 * X[k - 1];
+    J[k * N] += 0.05;
+  }
+  return true;
+}
+static bool dfdp(const double *X, double, double *o, std::string *) {
+  for (int i = 0; i < N; ++i) o[i] = 0;
+  o[0] = 1;
+  for (int k = 1; k < 7; ++k) o[k] = X[k];
+  return true;
+}
+
+int main() {
+  int fails = 0;
+  Model m; m.n = N; m.vector_field = f; m.jacobian_x = jac; m.dfdp = dfdp;
+  const double p0 = 1.2;
+  std::vector<double> x0(N, 0.0);
+  x0[0] = std::sqrt(p0);
+  for (int k = 7; k < N; ++k) x0[k] = (0.3 * x0[k - 1] * x0[k - 1] + 0.05 * x0[0]) / (1 + 0.1 * k);
+  ContinuationSettings s; s.h0 = 0.02; s.h_max = 0.05; s.p_min = -1; s.p_max = 1.25; s.direction = -1; s.max_points = 400;
+
+  auto t0 = std::chrono::steady_clock::now();
+  const Branch b = continue_equilibrium(m, x0, p0, s);
+  const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  const long jacs = jac_calls;
+
+  int folds = 0, hopfs[3] = {0, 0, 0}, stray = 0;
+  for (std::size_t i : b.special_indices) {
+    const BranchPoint &pt = b.points[i];
+    if (pt.special == SpecialPointKind::EndOfBranch) continue;
+    if (pt.special == SpecialPointKind::Fold || pt.special == SpecialPointKind::Cusp) {
+      folds += std::fabs(pt.p) < 1e-6;
+      continue;
+    }
+    bool hit = false;
+    for (int k = 0; k < 3; ++k)
+      if (std::fabs(pt.p - C[k]) < 1e-6) { ++hopfs[k]; hit = true; }
+    stray += !hit;
+  }
+  int mismatched = 0;
+  std::size_t regular = 0;
+  for (const BranchPoint &pt : b.points) {
+    if (pt.special != SpecialPointKind::None) continue;
+    ++regular;
+    std::vector<double> J(N * N);
+    std::string e;
+    jac(pt.x.data(), pt.p, J.data(), &e);
+    const Classification cl = classify_equilibrium(J, N, s.event_tol * 1e2);
+    if (cl.n_unstable != pt.n_unstable || (cl.n_unstable == 0 && cl.n_center == 0) != pt.stable) ++mismatched;
+  }
+  const double per = (double)jacs / std::max<std::size_t>(1, b.points.size());
+  printf("  n = %d: %zu points in %.1f ms (%.2f ms a point), %.1f Jacobians a point | "
+         "fold %d, Hopf at 0.5 / 0.75 / 0.45: %d / %d / %d, stray %d, stability mismatches %d\n",
+         N, b.points.size(), ms, ms / std::max<std::size_t>(1, b.points.size()), per, folds, hopfs[0], hopfs[1],
+         hopfs[2], stray, mismatched);
+  printf("  %s\n", b.message.c_str());
+  if (!b.ok || folds != 1 || hopfs[0] != 2 || hopfs[1] != 2 || hopfs[2] != 2 || stray != 0 || mismatched != 0 ||
+      per > 8) {
+    printf("  <-- FAIL\n");
+    fails++;
+  }
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,76 @@
+/* Locks the Floquet multipliers: on a Hopf cycle with one decoupled strongly
+ * unstable and one strongly stable mode the multipliers e^{6 pi} and
+ * e^{-10 pi} (20 orders of magnitude apart) come out to high relative
+ * accuracy together with the trivial one, both from the condensed Gauss
+ * collocation factorization and from the variational integration the
+ * trapezoidal scheme uses. The cost of compute_floquet on top of the
+ * continuation is printed, not checked.
+ * make test-floqcond */
+#include "analysis.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+int main() {
+  int fails = 0;
+
+  /* Hopf oscillator x, y with z' = 3 z and w' = -5 w: at mu = 1 the cycle is
+   * the unit circle, T = 2 pi, and the multipliers are 1, e^{-4 pi}, e^{6 pi},
+   * e^{-10 pi} */
+  Model m; m.n = 4;
+  m.vector_field = [](const double *X, double mu, double *f, std::string *) {
+    const double r2 = X[0] * X[0] + X[1] * X[1];
+    f[0] = -X[1] + X[0] * (mu - r2); f[1] = X[0] + X[1] * (mu - r2);
+    f[2] = 3 * X[2]; f[3] = -5 * X[3];
+    return true;
+  };
+  const double exact[4] = {std::exp(-10 * M_PI), std::exp(-4 * M_PI), 1.0, std::exp(6 * M_PI)};
+  std::vector<std::vector<double>> guess;
+  for (int i = 0; i < 100; ++i) {
+    const double th = 2 * M_PI * i / 100;
+    guess.push_back({std::cos(th), std::sin(th), 0.0, 0.0});
+  }
+
+  for (int ncol : {0, 4}) {
+    double ms[2] = {0, 0}, worst = 0, trivial = 0;
+    bool found = false, ok = true;
+    for (int fl = 0; fl < 2; ++fl) {
+      CycleSettings s; s.mesh = ncol ? 25 : 100; s.ncol = ncol; s.p_min = 0.2; s.p_max = 2.0; s.ds = 0.05;
+      s.max_steps = 40; s.compute_floquet = fl == 1; s.adaptive_mesh = false;
+      const auto t0 = std::chrono::steady_clock::now();
+      const CycleBranch b = continue_limit_cycle(m, guess, 2 * M_PI, 1.0, s);
+      ms[fl] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+      ok = ok && b.ok;
+      if (!fl) continue;
+      for (const CycleSample &c : b.samples) {
+        if (std::fabs(c.p - 1.0) > 1e-12 || c.floquet_re.size() != 4) continue;
+        std::vector<double> mod;
+        for (std::size_t i = 0; i < 4; ++i) mod.push_back(std::hypot(c.floquet_re[i], c.floquet_im[i]));
+        std::sort(mod.begin(), mod.end());
+        for (int i = 0; i < 4; ++i) worst = std::max(worst, std::fabs(mod[i] / exact[i] - 1));
+        trivial = mod[2];
+        found = !c.stable;
+      }
+    }
+    printf("  %s, %d unknowns: Floquet off %.1f ms, on %.1f ms | worst relative multiplier error %.2e, "
+           "trivial %.10f\n",
+           ncol ? "gauss 25 x 4" : "trapezoidal 100", (ncol ? 25 * 4 : 100) * 4 + 1, ms[0], ms[1], worst, trivial);
+    /* the trapezoidal orbit and period are second order (T off by ~2e-3 at
+     * 100 points, so e^{-10 pi} = e^{-5T} by ~1e-2); the integrated
+     * monodromy adds little to that. Gauss collocation holds every
+     * multiplier to ~1e-5. */
+    const double tol = ncol ? 1e-4 : 2e-2, trivial_tol = ncol ? 1e-6 : 1e-2;
+    if (!ok || !found || worst > tol || std::fabs(trivial - 1) > trivial_tol) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,82 @@
+/* Locks the fractal view's periodicity check (dynsys::period::Brent from
+ * fractal_period.h, the detector compute_fractal_image runs per pixel):
+ * attracting cycles of z->z^2+c are detected with the right period
+ * (cardioid 1, period-2 bulb 2, rabbit 3, real period-3 window 3, period-4
+ * bulb 4), escaping points are never flagged, the in/out classification of
+ * a whole Mandelbrot grid is unchanged, and the interior costs a fraction of
+ * the maxit budget. The detector is map-agnostic, so it is also run on the
+ * Henon map.
+ * make test-fractalperiod */
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <functional>
+#include "fractal_period.h"
+
+typedef std::function<void(const double*,double*)> Map2;
+struct Out{int it; int period; bool escaped;};
+
+// escape test on each iterate, then hand it to the shared detector
+static Out orbit(const Map2&f,double x0,double y0,int maxit,double R2,bool detect){
+  double cur[2]={x0,y0}, nx[2];
+  dynsys::period::Brent brent; brent.reset(cur,2);
+  int it=0;
+  for(;it<maxit;++it){
+    f(cur,nx);
+    double r2=nx[0]*nx[0]+nx[1]*nx[1];
+    if(!std::isfinite(r2)||r2>R2) return {it+1,0,true};
+    if(detect){ int p=brent.step(nx,2); if(p>0) return {it+1,p,false}; }
+    cur[0]=nx[0]; cur[1]=nx[1];
+  }
+  return {it,0,false};
+}
+static Map2 quad(double cre,double cim){
+  return [=](const double*z,double*o){ o[0]=z[0]*z[0]-z[1]*z[1]+cre; o[1]=2*z[0]*z[1]+cim; };
+}
+
+int main(){
+  int fails=0; const int M=5000; const double R2=16.0;
+  struct T{const char*name;double cre,cim;int period;};
+  T tests[]={
+    {"c=0 (cardioid centre)",0,0,1},
+    {"c=-0.5 (cardioid)",-0.5,0,1},
+    {"c=-1 (period-2 bulb)",-1,0,2},
+    {"c=-0.123+0.745i (Douady rabbit)",-0.123,0.745,3},
+    {"c=-1.7549 (real period-3 window)",-1.7549,0,3},
+    {"c=-1.3107 (period-4 bulb)",-1.3107,0,4},
+    {"c=0.5 (escapes)",0.5,0,0},
+    {"c=-2.1 (escapes)",-2.1,0,0},
+  };
+  for(auto&t:tests){
+    Out o=orbit(quad(t.cre,t.cim),0,0,M,R2,true);
+    bool ok=(o.period==t.period)&&(t.period>0?!o.escaped:o.escaped);
+    printf("  %-36s period=%d after %4d its (expect %d) %s\n",t.name,o.period,o.it,t.period,ok?"":"<-- FAIL");
+    if(!ok)fails++;
+  }
+
+  /* whole-grid: identical in/out, far fewer iterations on the interior */
+  const int W=160,H=120,maxit=2000; long it_plain=0,it_det=0; int mismatch=0,flagged=0;
+  for(int py=0;py<H;py++)for(int px=0;px<W;px++){
+    double cre=-2.5+3.5*px/(W-1), cim=-1.5+3.0*py/(H-1);
+    Out a=orbit(quad(cre,cim),0,0,maxit,R2,false), b=orbit(quad(cre,cim),0,0,maxit,R2,true);
+    it_plain+=a.it; it_det+=b.it; if(b.period>0)flagged++;
+    if(a.escaped!=b.escaped||(a.escaped&&a.it!=b.it))mismatch++;
+  }
+  printf("  grid %dx%d maxit=%d: %d pixels classified differently (expect 0), %d cycles caught\n",W,H,maxit,mismatch,flagged);
+  printf("  iterations: %ld plain vs %ld with periodicity check (%.1fx fewer)\n",it_plain,it_det,(double)it_plain/it_det);
+  if(mismatch)fails++;
+  if(it_det*3>it_plain){printf("  periodicity check saved too little <-- FAIL\n");fails++;}
+
+  /* a non-complex map: Henon (a=0.9, b=0.3) settles on an attracting 2-cycle;
+   * the classic chaotic a=1.4 must NOT be flagged as periodic */
+  auto henon=[](double a,double b){ return Map2([=](const double*z,double*o){ o[0]=1-a*z[0]*z[0]+z[1]; o[1]=b*z[0]; }); };
+  Out h1=orbit(henon(0.9,0.3),0.1,0.1,M,1e6,true);
+  Out h2=orbit(henon(1.4,0.3),0.1,0.1,M,1e6,true);
+  printf("  henon a=0.9: period=%d (expect 2) %s\n",h1.period,h1.period==2?"":"<-- FAIL");
+  printf("  henon a=1.4 (chaotic): period=%d (expect 0) %s\n",h2.period,h2.period==0?"":"<-- FAIL");
+  if(h1.period!=2)fails++;
+  if(h2.period!=0)fails++;
+
+  printf("=== %s ===\n", fails==0?"PASS":"FAIL");
+  return fails;
+}
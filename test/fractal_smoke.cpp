@@ -1,11 +1,21 @@
 /* Locks the escape-time logic used by the fractal view (PHASE C):
  * iterating z->z^2+c from 0 must classify known Mandelbrot points
  * (cardioid, period-2 bulb, Douady rabbit IN; c=1,0.5,-2.5,2i OUT).
+ * Also locks the boundary tracer the renderer uses (boundary_trace.h): on
+ * the Mandelbrot and rabbit-Julia views it must reproduce the brute-force
+ * escape-time image pixel for pixel, at every progressive step, while
+ * iterating only a fraction of the samples. On the sine-map and Newton
+ * views, where that exactness does not hold, it fills over some detail, as
+ * documented, but only in filled pixels.
  * make test-fractal */
 /* Verify the escape-time logic computes the actual Mandelbrot set:
  * iterate z->z^2+c from z0=0, check membership for known points. */
+#include "boundary_trace.h"
+
 #include <cmath>
+#include <complex>
 #include <cstdio>
+#include <vector>
 struct C{double re,im;};
 // returns iterations to escape (maxit if bounded), and final r2
 static int escape(C c,int maxit,double R2,double*r2out){
@@ -18,6 +28,78 @@ static int escape(C c,int maxit,double R2,double*r2out){
   }
   *r2out=r2; return it;
 }
+// value of one pixel of a view: the escape count for Mandelbrot (z0=0,
+// c=pixel), Julia (z0=pixel, c fixed) and the sine Julia set z->c sin z
+// (escape at |im z| > 50; its Julia set is a bouquet of thin hairs), and
+// root * 1000 + iterations for Newton's method on z^3 = 1 (state space)
+enum Kind{MANDEL,JULIA,SINE,NEWTON};
+struct View{const char*name;double x0,x1,y0,y1;Kind kind;C c;int maxit;};
+static int pixel(const View&v,int W,int H,int px,int py){
+  C p{v.x0+(v.x1-v.x0)*px/(W-1), v.y0+(v.y1-v.y0)*py/(H-1)};
+  int it=0;
+  if(v.kind==SINE){
+    std::complex<double> z(p.re,p.im), c(v.c.re,v.c.im);
+    for(;it<v.maxit;++it){ z=c*std::sin(z); if(std::fabs(z.imag())>50){++it;break;} }
+    return it;
+  }
+  if(v.kind==NEWTON){
+    std::complex<double> z(p.re,p.im);
+    for(;it<v.maxit;++it){ std::complex<double> n=z-(z*z*z-1.0)/(3.0*z*z); bool done=std::abs(n-z)<1e-10; z=n; if(done){++it;break;} }
+    if(!std::isfinite(z.real())||!std::isfinite(z.imag())) return -1;
+    const double a=std::arg(z);
+    return (a>1?1:a<-1?2:0)*1000+std::min(it,40);
+  }
+  double x=v.kind==JULIA?p.re:0, y=v.kind==JULIA?p.im:0; C c=v.kind==JULIA?v.c:p;
+  for(;it<v.maxit;++it){ double nx=x*x-y*y+c.re, ny=2*x*y+c.im; x=nx;y=ny; if(x*x+y*y>16.0){++it;break;} }
+  return it;
+}
+// the renderer's traced path (boundary_trace.h) on the progressive step grid;
+// filled[] marks pixels whose value was filled in rather than iterated
+static long trace(const View&v,int W,int H,int step,std::vector<int>&img,std::vector<char>&filled){
+  const int GW=(W+step-1)/step, GH=(H+step-1)/step; long iterated=0;
+  dynsys::trace::Grid<int> grid(GW,GH);
+  for(int item=0;item<grid.tiles();item++)
+    grid.trace_tile(item,[&](int gx,int gy){ ++iterated; return pixel(v,W,H,gx*step,gy*step); },
+      [&](int gx,int gy,int c,bool fill){
+        for(int by=gy*step;by<gy*step+step&&by<H;by++)for(int bx=gx*step;bx<gx*step+step&&bx<W;bx++){
+          img[(size_t)by*W+bx]=c; filled[(size_t)by*W+bx]=fill; } });
+  return iterated;
+}
+// Mandelbrot/Julia views (connected escape regions) must come out pixel for
+// pixel. The sine and Newton maps break that assumption, and the traced image
+// differs there, as documented. It must differ only in filled pixels, never
+// in iterated ones.
+static int trace_tests(){
+  const int W=300,H=240; int fails=0;
+  View views[]={
+    {"Mandelbrot",-2.5,1.0,-1.5,1.5,MANDEL,{0,0},500},
+    {"Mandelbrot antenna",-1.9,-1.6,-0.12,0.12,MANDEL,{0,0},800},
+    {"Mandelbrot south bulbs",-0.2,0.4,-1.1,-0.6,MANDEL,{0,0},600},
+    {"Julia rabbit",-1.6,1.6,-1.2,1.2,JULIA,{-0.123,0.745},500},
+    {"sine Julia hairs",-6,6,-4,4,SINE,{1.0,0.1},200},
+    {"Newton z^3=1 basins",-0.6,0.2,-0.3,0.3,NEWTON,{0,0},100},
+  };
+  long lost=0;
+  for(auto&v:views)for(int step=8;step>=1;step/=2){
+    std::vector<int> ref((size_t)W*H,-1), img((size_t)W*H,-1); std::vector<char> filled((size_t)W*H,0);
+    for(int py=0;py<H;py+=step)for(int px=0;px<W;px+=step){ int c=pixel(v,W,H,px,py);
+      for(int by=py;by<py+step&&by<H;by++)for(int bx=px;bx<px+step&&bx<W;bx++)ref[(size_t)by*W+bx]=c; }
+    long it=trace(v,W,H,step,img,filled); long total=(long)((W+step-1)/step)*((H+step-1)/step);
+    int diff=0, diff_iterated=0;
+    for(size_t i=0;i<ref.size();i++) if(ref[i]!=img[i]){ diff++; diff_iterated+=!filled[i]; }
+    const bool approximate=v.kind==SINE||v.kind==NEWTON;
+    const bool bad=approximate ? diff_iterated>0 : diff>0;
+    printf("  traced %-28s step=%d: %5.1f%% of samples iterated, %d differing pixels (%d iterated) %s\n",
+           v.name,step,100.0*it/total,diff,diff_iterated,bad?"<-- FAIL":"");
+    if(bad)fails++;
+    if(approximate) lost+=diff;
+    if(step==1&&v.kind==MANDEL&&it>=total){ printf("  tracing saved nothing on %s <-- FAIL\n",v.name); fails++; }
+  }
+  /* the approximation the renderer documents, and why tracing is opt-in */
+  printf("  sine / Newton: %ld pixels filled over by tracing %s\n",lost,lost>0?"":"<-- FAIL (expected some)");
+  if(lost==0)fails++;
+  return fails;
+}
 int main(){
   const int M=500; const double R2=16.0;
   struct T{const char*name;C c;bool in;};
@@ -40,6 +122,7 @@ int main(){
            t.in?"IN":"OUT", isin==t.in?"":"<-- FAIL");
     if(isin!=t.in)fails++;
   }
+  fails+=trace_tests();
   printf("=== %s ===\n", fails==0?"PASS":"FAIL");
   return fails;
 }
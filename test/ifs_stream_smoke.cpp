@@ -0,0 +1,103 @@
+/* Locks the streaming chaos game (chaos_game_stream): the Sierpinski
+ * triangle and the Barnsley fern come out with the box-counting dimension
+ * of the stored-point path, every point lands in the density grid, the
+ * density and box counts do not depend on the thread count, and a run of
+ * 10^8 points needs no more memory than a short one.
+ * make test-ifsstream */
+#include "analysis.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys;
+using namespace dynsys::analysis;
+
+static std::vector<AffineMap> sierpinski() {
+  std::vector<AffineMap> M(3);
+  M[0] = {0.5, 0, 0, 0.5, 0.0, 0.0, 1.0 / 3};
+  M[1] = {0.5, 0, 0, 0.5, 0.5, 0.0, 1.0 / 3};
+  M[2] = {0.5, 0, 0, 0.5, 0.25, 0.5, 1.0 / 3};
+  return M;
+}
+
+static std::vector<AffineMap> fern() {
+  std::vector<AffineMap> M(4);
+  M[0] = {0, 0, 0, 0.16, 0, 0, 0.01};
+  M[1] = {0.85, 0.04, -0.04, 0.85, 0, 1.6, 0.85};
+  M[2] = {0.20, -0.26, 0.23, 0.22, 0, 1.6, 0.07};
+  M[3] = {-0.15, 0.28, 0.26, 0.24, 0, 0.44, 0.07};
+  return M;
+}
+
+static std::uint64_t total(const IFSDensity &R) {
+  std::uint64_t s = 0;
+  for (std::uint64_t v : R.density) s += v;
+  return s;
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+
+  /* 1. same dimension as chaos_game + box_counting_dimension */
+  {
+    const char *names[2] = {"Sierpinski", "fern"};
+    const std::vector<AffineMap> sets[2] = {sierpinski(), fern()};
+    const double lo[2] = {1.50, 1.60}, hi[2] = {1.66, 2.00};
+    for (int k = 0; k < 2; ++k) {
+      IFSStreamOptions o;
+      o.iterations = 400000;
+      const IFSDensity S = chaos_game_stream(sets[k], o);
+      const IFSResult P = chaos_game(sets[k], 400000, 12345u);
+      std::vector<double> xs(P.xs.begin(), P.xs.end()), ys(P.ys.begin(), P.ys.end());
+      const BoxCountResult D = box_counting_dimension(xs, ys, 12);
+      printf("  %s: streamed D = %.3f (R2 %.3f), stored points D = %.3f | %llu binned + %ld off grid of %ld\n",
+             names[k], S.box.dimension, S.box.r_squared, D.dimension, (unsigned long long)total(S), S.outside,
+             S.points);
+      if (!S.ok || !S.box.ok || S.box.dimension < lo[k] || S.box.dimension > hi[k] ||
+          std::fabs(S.box.dimension - D.dimension) > 0.05 || total(S) + (std::uint64_t)S.outside != (std::uint64_t)S.points ||
+          S.outside != 0) {
+        printf("  <-- FAIL\n");
+        fails++;
+      }
+    }
+  }
+
+  /* 2. one thread gives the same density and box counts */
+  {
+    IFSStreamOptions o;
+    o.iterations = 1000000;
+    o.width = 300; o.height = 200;
+    const IFSDensity four = chaos_game_stream(fern(), o);
+    pool::configure({1, false});
+    const IFSDensity one = chaos_game_stream(fern(), o);
+    pool::configure({4, false});
+    const bool same = four.density == one.density && four.box.log_count == one.box.log_count;
+    printf("  1 thread vs 4: %s\n", same ? "identical" : "DIFFER");
+    if (!same) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 3. 10^8 points in the same footprint: density grid + bitmaps only */
+  {
+    IFSStreamOptions o;
+    o.iterations = 100000000;
+    const auto t0 = std::chrono::steady_clock::now();
+    const IFSDensity S = chaos_game_stream(sierpinski(), o);
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double stored_mb = 2.0 * sizeof(float) * (double)o.iterations / (1 << 20);
+    printf("  10^8 points: %.2f s (%.0f M points/s), D = %.3f, max density %llu, result %zu KiB "
+           "(stored points would be %.0f MiB)\n",
+           s, o.iterations / s / 1e6, S.box.dimension, (unsigned long long)S.max_density,
+           S.density.size() * sizeof(std::uint64_t) / 1024, stored_mb);
+    if (!S.ok || total(S) != (std::uint64_t)o.iterations || S.box.dimension < 1.50 || S.box.dimension > 1.66) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
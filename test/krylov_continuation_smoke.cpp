@@ -0,0 +1,200 @@
+/* Locks the matrix-free continuation of continue_equilibrium on 5000
+ * unknowns: the fold of 1-D Bratu (exact products, a tridiagonal
+ * preconditioner from the model) and the Hopf point of a network of
+ * mean-field coupled Brusselator cells (finite-difference products,
+ * block-Jacobi) land on their known values with the stability switching
+ * across them, and at n = 50 the fold agrees with the dense engine.
+ * make test-krylov */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static const double kPi = 3.14159265358979323846;
+
+/* Bratu: x'' + p e^x = 0 on (0,1), x(0) = x(1) = 0, n interior nodes */
+static Model bratu(int n) {
+  Model m;
+  m.n = n;
+  const double ih2 = (n + 1.0) * (n + 1.0);
+  m.vector_field = [n, ih2](const double *x, double p, double *f, std::string *) {
+    for (int i = 0; i < n; ++i) {
+      const double l = i > 0 ? x[i - 1] : 0.0, r = i + 1 < n ? x[i + 1] : 0.0;
+      f[i] = (l - 2 * x[i] + r) * ih2 + p * std::exp(x[i]);
+    }
+    return true;
+  };
+  m.dfdp = [n](const double *x, double, double *o, std::string *) {
+    for (int i = 0; i < n; ++i) o[i] = std::exp(x[i]);
+    return true;
+  };
+  m.jacobian_x = [n, ih2](const double *x, double p, double *J, std::string *) {
+    for (int i = 0; i < n; ++i) {
+      J[i * n + i] = -2 * ih2 + p * std::exp(x[i]);
+      if (i > 0) J[i * n + i - 1] = ih2;
+      if (i + 1 < n) J[i * n + i + 1] = ih2;
+    }
+    return true;
+  };
+  return m;
+}
+
+/* exact products and a Thomas solve of the tridiagonal f_x - shift I */
+static void bratu_matrix_free(Model *m) {
+  const int n = (int)m->n;
+  const double ih2 = (n + 1.0) * (n + 1.0);
+  m->jacobian_x = nullptr;
+  m->jacobian_vec = [n, ih2](const double *x, double p, const double *v, double *o, std::string *) {
+    for (int i = 0; i < n; ++i) {
+      const double l = i > 0 ? v[i - 1] : 0.0, r = i + 1 < n ? v[i + 1] : 0.0;
+      o[i] = (l - 2 * v[i] + r) * ih2 + p * std::exp(x[i]) * v[i];
+    }
+    return true;
+  };
+  m->precondition = [n, ih2](const double *x, double p, double s, const double *r, double *o, std::string *) {
+    std::vector<double> c(n);
+    double d = -2 * ih2 + p * std::exp(x[0]) - s;
+    c[0] = ih2 / d;
+    o[0] = r[0] / d;
+    for (int i = 1; i < n; ++i) {
+      d = -2 * ih2 + p * std::exp(x[i]) - s - ih2 * c[i - 1];
+      c[i] = ih2 / d;
+      o[i] = (r[i] - ih2 * o[i - 1]) / d;
+    }
+    for (int i = n - 1; i-- > 0;) o[i] -= c[i] * o[i + 1];
+    return true;
+  };
+}
+
+/* G Brusselator cells u' = A - (B+1) u + u^2 v + c (mean(u) - u),
+ * v' = B u - u^2 v, interleaved (u_i, v_i) and continued in B along the
+ * homogeneous state (A, B/A). The uniform mode loses stability at
+ * B = 1 + A^2, the (G-1)-fold non-uniform one only at 1 + A^2 + c. */
+static const int G = 2500;
+static const double A = 2.0, C = 1.0;
+
+static bool cells(const double *x, double B, double *f, std::string *) {
+  double mean = 0.0;
+  for (int i = 0; i < G; ++i) mean += x[2 * i];
+  mean /= G;
+  for (int i = 0; i < G; ++i) {
+    const double u = x[2 * i], v = x[2 * i + 1];
+    f[2 * i] = A - (B + 1) * u + u * u * v + C * (mean - u);
+    f[2 * i + 1] = B * u - u * u * v;
+  }
+  return true;
+}
+
+struct Found {
+  int folds = 0, hopfs = 0;
+  double p = std::nan("");
+  int unstable_before = -1, unstable_after = -1;
+};
+
+static Found scan(const Branch &b, SpecialPointKind kind) {
+  Found r;
+  for (std::size_t i : b.special_indices) {
+    const BranchPoint &pt = b.points[i];
+    r.folds += pt.special == SpecialPointKind::Fold;
+    r.hopfs += pt.special == SpecialPointKind::Hopf;
+    if (pt.special == kind && std::isnan(r.p)) {
+      r.p = pt.p;
+      for (std::size_t j = i; j-- > 0;)
+        if (b.points[j].special == SpecialPointKind::None) { r.unstable_before = b.points[j].n_unstable; break; }
+      for (std::size_t j = i + 1; j < b.points.size(); ++j)
+        if (b.points[j].special == SpecialPointKind::None) { r.unstable_after = b.points[j].n_unstable; break; }
+    }
+  }
+  return r;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main() {
+  int fails = 0;
+  ContinuationSettings s;
+  s.matrix_free = true;
+  s.corrector_tol = 1e-6;
+  s.detect_hopf = false;
+  s.h0 = 1; s.h_max = 20; s.p_min = 1; s.p_max = 4; s.max_points = 60;
+
+  /* Bratu, n = 50: against the dense engine */
+  double fold50 = std::nan("");
+  {
+    Model m = bratu(50);
+    ContinuationSettings sd = s;
+    sd.matrix_free = false;
+    const Branch dense = continue_equilibrium(m, std::vector<double>(50, 0.0), 1.5, sd);
+    bratu_matrix_free(&m);
+    const Branch mf = continue_equilibrium(m, std::vector<double>(50, 0.0), 1.5, s);
+    const Found fd = scan(dense, SpecialPointKind::Fold), fk = scan(mf, SpecialPointKind::Fold);
+    fold50 = fk.p;
+    printf("  Bratu n = 50: fold at p = %.9f (dense %.9f), %zu / %zu points\n", fk.p, fd.p, mf.points.size(),
+           dense.points.size());
+    if (!mf.ok || fk.folds != 1 || fd.folds != 1 || !(std::fabs(fk.p - fd.p) < 1e-6)) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* Bratu, n = 5000, exact products and the model's preconditioner */
+  {
+    const int n = 5000;
+    Model m = bratu(n);
+    bratu_matrix_free(&m);
+    auto t0 = std::chrono::steady_clock::now();
+    const Branch b = continue_equilibrium(m, std::vector<double>(n, 0.0), 1.5, s);
+    const double ms = ms_since(t0);
+    const Found f = scan(b, SpecialPointKind::Fold);
+    const double np = (double)b.points.size();
+    printf("  Bratu n = %d: fold at p = %.9f (n = 50: %.9f), unstable %d -> %d, %zu points in %.0f ms, "
+           "%.1f GMRES iterations and %.0f products a point\n",
+           n, f.p, fold50, f.unstable_before, f.unstable_after, b.points.size(), ms,
+           b.counts.krylov_iterations / np, b.counts.products / np);
+    printf("  %s\n", b.message.c_str());
+    if (!b.ok || f.folds != 1 || !(std::fabs(f.p - 3.513830719) < 1e-4) || f.unstable_before != 0 ||
+        f.unstable_after != 1) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* Brusselator cells, 2 x 2500 unknowns, finite-difference products,
+   * block-Jacobi */
+  {
+    const int n = 2 * G;
+    Model m;
+    m.n = n;
+    m.vector_field = cells;
+    const double B0 = 4.5, B_hopf = 1 + A * A;
+    std::vector<double> x0(n);
+    for (int i = 0; i < G; ++i) { x0[2 * i] = A; x0[2 * i + 1] = B0 / A; }
+    ContinuationSettings sb = s;
+    sb.detect_hopf = true;
+    sb.p_min = 4; sb.p_max = 5.5; sb.h0 = 0.5; sb.h_max = 5;
+    sb.krylov.block = 16;
+    auto t0 = std::chrono::steady_clock::now();
+    const Branch b = continue_equilibrium(m, x0, B0, sb);
+    const double ms = ms_since(t0);
+    const Found f = scan(b, SpecialPointKind::Hopf);
+    const double np = (double)b.points.size();
+    printf("  Brusselator cells n = %d: Hopf at B = %.9f (exact %.9f), unstable %d -> %d, %zu points in %.0f ms, "
+           "%.1f GMRES iterations and %.0f products a point\n",
+           n, f.p, B_hopf, f.unstable_before, f.unstable_after, b.points.size(), ms,
+           b.counts.krylov_iterations / np, b.counts.products / np);
+    printf("  %s\n", b.message.c_str());
+    if (!b.ok || f.hopfs != 1 || f.folds != 0 || !(std::fabs(f.p - B_hopf) < 1e-6) || f.unstable_before != 0 ||
+        f.unstable_after != 2) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
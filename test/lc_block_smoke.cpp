@@ -0,0 +1,121 @@
+/* Locks the block-structured collocation solver behind continue_limit_cycle:
+ * the Hopf cycle comes out at its exact radius and period in both
+ * continuation modes, the fold-of-cycles determinant taken from the
+ * structured factorization has opposite signs on the two cycle branches
+ * that meet at the fold of the Bautin normal form, and a 10-D system on a
+ * 200-point mesh (2001 unknowns, whose dense Jacobian would be 32 MB)
+ * continues accurately. Its run time is printed, not checked.
+ * make test-lcblock */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+static std::vector<std::vector<double>> circle(int mesh, double R, std::size_t n) {
+  std::vector<std::vector<double>> g;
+  for (int i = 0; i < mesh; ++i) {
+    const double th = 2 * M_PI * i / mesh;
+    std::vector<double> x(n, 0.0);
+    x[0] = R * std::cos(th); x[1] = R * std::sin(th);
+    g.push_back(x);
+  }
+  return g;
+}
+
+int main() {
+  int fails = 0;
+
+  /* 1. Hopf normal form: radius sqrt(mu), period 2 pi, both modes */
+  {
+    Model m; m.n = 2;
+    m.vector_field = [](const double *X, double mu, double *f, std::string *) {
+      const double r2 = X[0] * X[0] + X[1] * X[1];
+      f[0] = -X[1] + X[0] * (mu - r2); f[1] = X[0] + X[1] * (mu - r2);
+      return true;
+    };
+    for (int arc = 0; arc < 2; ++arc) {
+      CycleSettings s; s.mesh = 80; s.p_min = 0.1; s.p_max = 1.0; s.dp = 0.05; s.ds = 0.05;
+      s.max_steps = 40; s.arclength = arc == 1; s.adaptive_mesh = false;
+      const CycleBranch b = continue_limit_cycle(m, circle(s.mesh, std::sqrt(0.5), 2), 2 * M_PI, 0.5, s);
+      double errA = 0, errT = 0; int sign_flips = 0;
+      for (std::size_t i = 0; i < b.samples.size(); ++i) {
+        const CycleSample &c = b.samples[i];
+        errA = std::max(errA, std::fabs(c.amplitude - 2 * std::sqrt(c.p)));
+        errT = std::max(errT, std::fabs(c.period - 2 * M_PI));
+        if (arc && i > 0 && (c.fold_test > 0) != (b.samples[i - 1].fold_test > 0)) sign_flips++;
+      }
+      printf("  Hopf, %s: %zu samples, max |amp - 2 sqrt(mu)| %.2e, max |T - 2 pi| %.2e, fold-test sign flips %d\n",
+             arc ? "arclength" : "natural", b.samples.size(), errA, errT, sign_flips);
+      if (!b.ok || b.samples.size() < 10 || errA > 2e-3 || errT > 5e-3 || sign_flips != 0) {
+        printf("  <-- FAIL\n");
+        fails++;
+      }
+    }
+  }
+
+  /* 2. Bautin normal form r' = r (mu + r^2 - r^4): the stable and unstable
+   * cycles meet in a fold at mu = -1/4 */
+  {
+    Model m; m.n = 2;
+    m.vector_field = [](const double *X, double mu, double *f, std::string *) {
+      const double r2 = X[0] * X[0] + X[1] * X[1], g = mu + r2 - r2 * r2;
+      f[0] = -X[1] + X[0] * g; f[1] = X[0] + X[1] * g;
+      return true;
+    };
+    CycleSettings s; s.mesh = 60; s.p_min = -1.0; s.p_max = 0.2; s.ds = 0.1; s.max_steps = 200;
+    s.adaptive_mesh = false; s.compute_floquet = false;
+    const CycleBranch b = continue_limit_cycle(m, circle(s.mesh, 1.0, 2), 2 * M_PI, 0.0, s);
+    /* the fold test has one sign on the outer (stable, r^2 > 1/2) cycles and
+     * the other on the inner ones */
+    double fold_p = 1e9;
+    int outer[2] = {0, 0}, inner[2] = {0, 0};
+    for (const CycleSample &c : b.samples) {
+      if (c.is_fold && std::fabs(c.p + 0.25) < std::fabs(fold_p + 0.25)) fold_p = c.p;
+      if (c.p < -0.24 || !(c.fold_test != 0)) continue;
+      (c.amplitude > 2 * std::sqrt(0.5) ? outer : inner)[c.fold_test > 0]++;
+    }
+    printf("  Bautin: %zu samples, fold of cycles at mu = %.5f (exact -0.25); fold test +/-: "
+           "outer %d/%d, inner %d/%d\n",
+           b.samples.size(), fold_p, outer[1], outer[0], inner[1], inner[0]);
+    const bool split = (outer[0] == 0 && inner[1] == 0) || (outer[1] == 0 && inner[0] == 0);
+    if (!b.ok || std::fabs(fold_p + 0.25) > 2e-3 || !split || outer[0] + outer[1] < 5 ||
+        inner[0] + inner[1] < 5) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  /* 3. 10-D: the Hopf oscillator driving eight slaved stable modes, mesh 200 */
+  {
+    const std::size_t n = 10;
+    Model m; m.n = n;
+    m.vector_field = [](const double *X, double mu, double *f, std::string *) {
+      const double r2 = X[0] * X[0] + X[1] * X[1];
+      f[0] = -X[1] + X[0] * (mu - r2); f[1] = X[0] + X[1] * (mu - r2);
+      for (int k = 2; k < 10; ++k) f[k] = -k * (X[k] - X[0] * X[k - 1]) + (k == 2 ? X[1] * X[1] : 0.0);
+      return true;
+    };
+    CycleSettings s; s.mesh = 200; s.p_min = 0.1; s.p_max = 2.0; s.ds = 0.1; s.max_steps = 10;
+    s.adaptive_mesh = false; s.compute_floquet = false;
+    const auto t0 = std::chrono::steady_clock::now();
+    const CycleBranch b = continue_limit_cycle(m, circle(s.mesh, 1.0, n), 2 * M_PI, 1.0, s);
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double errA = 0;
+    for (const CycleSample &c : b.samples) errA = std::max(errA, std::fabs(c.amplitude - 2 * std::sqrt(c.p)));
+    const double N = (double)(s.mesh * n + 1);
+    printf("  10-D, mesh %d (%.0f unknowns): %zu samples in %.3f s, max amplitude error %.2e "
+           "(dense Jacobian would be %.0f MB)\n",
+           s.mesh, N, b.samples.size(), sec, errA, N * N * 8 / 1e6);
+    if (!b.ok || b.samples.size() < 8 || errA > 2e-3) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
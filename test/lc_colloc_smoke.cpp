@@ -1,9 +1,30 @@
 #include "analysis.h"
+#include <chrono>
 #include <cstdio>
 #include <cmath>
 #include <vector>
 using namespace dynsys::analysis;
 static int fails=0; static void chk(const char*l,bool c){printf("  %s : %s\n",l,c?"ok":"FAIL");if(!c)fails++;}
+// van der Pol relaxation oscillator x'' - mu (1 - x^2) x' + x = 0
+static bool vdp(const double*X,double mu,double*f,std::string*){ f[0]=X[1]; f[1]=mu*(1-X[0]*X[0])*X[1]-X[0]; return true; }
+// reference period by fine RK4 and interpolated upward crossings of x = 0
+static double vdp_period(double mu){
+  auto rk=[mu](double*x,double dt){ double k1[2],k2[2],k3[2],k4[2],t[2];
+    vdp(x,mu,k1,0); for(int i=0;i<2;i++) t[i]=x[i]+0.5*dt*k1[i];
+    vdp(t,mu,k2,0); for(int i=0;i<2;i++) t[i]=x[i]+0.5*dt*k2[i];
+    vdp(t,mu,k3,0); for(int i=0;i<2;i++) t[i]=x[i]+dt*k3[i];
+    vdp(t,mu,k4,0); for(int i=0;i<2;i++) x[i]+=dt/6*(k1[i]+2*k2[i]+2*k3[i]+k4[i]); };
+  double x[2]={2,0}, dt=2e-4, t=0, tc[3]; int nc=0;
+  for(int i=0;i<200000;i++) rk(x,dt);
+  while(nc<3){ const double x0=x[0]; rk(x,dt); t+=dt; if(x0<0&&x[0]>=0) tc[nc++]=t-dt*(1+x0/(x[0]-x0)); }
+  return tc[2]-tc[1];
+}
+static std::vector<std::vector<double>> vdp_circle(int pts){
+  std::vector<std::vector<double>> g;
+  for(int i=0;i<pts;i++){ double th=2*M_PI*i/pts; g.push_back({2*std::cos(th),-2*std::sin(th)}); }
+  return g;
+}
+static Model m2vdp(){ Model m; m.n=2; m.vector_field=vdp; return m; }
 int main(){
   // Supercritical Hopf: x'=-y + x(mu - (x^2+y^2)), y'= x + y(mu - (x^2+y^2)).
   // For mu>0: stable circular cycle radius sqrt(mu), period ~ 2*pi.
@@ -37,6 +58,75 @@ int main(){
     if(aLo>0&&aHi>0){ printf("   amp(mu=%.2f)=%.3f < amp(mu=%.2f)=%.3f ?\n",pLo,aLo,pHi,aHi);
       chk("amplitude grows with mu", aHi>aLo); }
   }
+
+  // Gauss-Legendre collocation (ntst intervals x ncol points) against the
+  // trapezoidal scheme on the mu = 5 relaxation cycle, uniform mesh
+  {
+    const double mu=5, Tref=vdp_period(mu);
+    printf("van der Pol mu=5, T_ref=%.9f (uniform mesh):\n", Tref);
+    double err[3]={0,0,0};
+    const int cfg[3][2]={{320,0},{40,4},{40,7}};
+    for(int k=0;k<3;k++){
+      CycleSettings s; s.mesh=cfg[k][0]; s.ncol=cfg[k][1]; s.p_min=mu-0.1; s.p_max=mu+0.1; s.ds=0.01; s.max_steps=2;
+      s.adaptive_mesh=false;
+      auto t0=std::chrono::steady_clock::now();
+      // the solver reseeds from a simulation when the crude circle fails
+      CycleBranch b=continue_limit_cycle(m2vdp(), vdp_circle(s.ncol ? 50 : s.mesh), 11.6, mu, s);
+      const double ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+      double T=0; const CycleSample *c0=nullptr;
+      for(auto&c:b.samples) if(std::fabs(c.p-mu)<1e-12){ T=c.period; c0=&c; }
+      err[k]=std::fabs(T-Tref);
+      printf("   %s ntst=%3d ncol=%d: %4d unknowns, T=%.9f, |T-T_ref|=%.2e, %.1f ms, %zu multipliers, stable=%d\n",
+             k?"gauss":"trap ", s.mesh, s.ncol, (s.ncol?s.ncol:1)*s.mesh*2+1, T, err[k], ms, c0?c0->floquet_re.size():0, c0?c0->stable:0);
+      if(!b.ok || !c0){ err[k]=1e9; continue; }
+      if(k) chk("Floquet: stable with a trivial multiplier", c0->stable && c0->floquet_re.size()==2);
+    }
+    chk("ncol=4 on half the unknowns beats trapezoidal 10x", err[1]*10 < err[0]);
+    chk("ncol=7, 40 intervals: |T-T_ref| < 1e-5", err[2] < 1e-5);
+  }
+
+  // branch mu = 1 -> 8 with adaptive remeshing (de Boor monitor for ncol > 0)
+  {
+    printf("van der Pol branch mu=1..8, ntst=20 ncol=4 (161 unknowns):\n");
+    double err[2]={1e9,1e9};
+    for(int adapt=0;adapt<2;adapt++){
+      CycleSettings s; s.mesh=20; s.ncol=4; s.p_min=1; s.p_max=8; s.ds=0.5; s.max_steps=400;
+      s.adaptive_mesh=adapt; s.compute_floquet=false;
+      auto t0=std::chrono::steady_clock::now();
+      CycleBranch b=continue_limit_cycle(m2vdp(), vdp_circle(50), 6.66, 1.0, s);
+      const double ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+      if(!b.ok) continue;
+      const CycleSample &e=b.samples.back();
+      const double Tr=vdp_period(e.p);
+      err[adapt]=std::fabs(e.period-Tr);
+      printf("   adaptive=%d: %zu samples in %.0f ms, at mu=%.4f T=%.8f (ref %.8f) err %.2e\n",
+             adapt, b.samples.size(), ms, e.p, e.period, Tr, err[adapt]);
+      if(adapt) chk("adaptive branch reaches mu=8", e.p>7.9);
+    }
+    chk("adaptive mesh: |T-T_ref| < 1e-3 at mu=8, 100x better than uniform", err[1]<1e-3 && err[1]*100<err[0]);
+  }
+
+  // fold of cycles of the Bautin form through the condensed determinant
+  {
+    Model mb; mb.n=2;
+    mb.vector_field=[](const double*X,double mu,double*f,std::string*)->bool{
+      const double r2=X[0]*X[0]+X[1]*X[1], g=mu+r2-r2*r2;
+      f[0]=-X[1]+X[0]*g; f[1]=X[0]+X[1]*g; return true; };
+    std::vector<std::vector<double>> g;
+    for(int i=0;i<40;i++){ double th=2*M_PI*i/40; g.push_back({std::cos(th),std::sin(th)}); }
+    CycleSettings s; s.mesh=15; s.ncol=4; s.p_min=-1; s.p_max=0.2; s.ds=0.1; s.max_steps=200; s.adaptive_mesh=false;
+    CycleBranch b=continue_limit_cycle(mb, g, 2*M_PI, 0.0, s);
+    double fold_p=1e9; int wrong=0;
+    for(auto&c:b.samples){
+      if(c.is_fold && std::fabs(c.p+0.25)<std::fabs(fold_p+0.25)) fold_p=c.p;
+      // (a multiplier ~ +1 at the fold and at the Hopf point: skip both ends)
+      if(c.p>-0.23 && c.amplitude>0.1 && (c.amplitude>2*std::sqrt(0.5)) != c.stable) wrong++;
+    }
+    printf("Bautin ntst=15 ncol=4: %zu samples, fold of cycles at mu=%.5f (exact -0.25), %d misclassified\n",
+           b.samples.size(), fold_p, wrong);
+    chk("fold of cycles at mu=-1/4", std::fabs(fold_p+0.25)<2e-3);
+    chk("outer cycles stable, inner unstable", wrong==0);
+  }
   printf("=== %s ===\n", fails==0?"PASS":"FAIL");
   return fails;
 }
@@ -0,0 +1,322 @@
+/* Standalone smoke test for the perturbation executor (deep zoom).
+ *
+ * Builds the map Programs by hand (no tpcas needed) and renders
+ * small escape-time images the way the fractal view's deep-zoom mode
+ * does: one double-double reference orbit at the view centre, every
+ * pixel as a double perturbation from it, the series approximation
+ * skipping the first iterations, and glitched pixels re-rendered
+ * against new references. Checks:
+ *   - the static check accepts polynomial maps and rejects the rest;
+ *   - at a shallow zoom the image matches plain double iteration
+ *     (Mandelbrot, Julia plane, and the abs()-based Burning Ship);
+ *   - at a 1e-20 wide view, where doubles collapse every pixel onto
+ *     the same c, it matches a brute-force double-double render;
+ *   - the series approximation skips iterations without changing
+ *     the image, and re-referencing clears every glitch.
+ *
+ *   make test-perturb
+ */
+
+#include "../src/expr_ir.h"
+#include "../src/expr_ir_perturb.h"
+
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+using namespace dynsys::ir;
+
+static int g_fail = 0;
+static void check(bool c, const char *what) {
+  std::printf("  %-58s %s\n", what, c ? "ok" : "<-- FAIL");
+  if (!c) ++g_fail;
+}
+
+static Instr I(Op op, uint16_t a = 0, uint16_t b = 0) { return Instr{op, a, b}; }
+
+/* z -> z^2 + c as (x, y), c = (param 0, param 1) */
+static std::vector<Program> mandelbrot() {
+  Program px, py;
+  px.code = {I(Op::PushState, 0), I(Op::PushState, 0), I(Op::Mul),
+             I(Op::PushState, 1), I(Op::PushState, 1), I(Op::Mul),
+             I(Op::Sub),          I(Op::PushParam, 0), I(Op::Add)};
+  py.constants = {2.0};
+  py.code = {I(Op::PushConst, 0), I(Op::PushState, 0), I(Op::Mul),
+             I(Op::PushState, 1), I(Op::Mul),          I(Op::PushParam, 1),
+             I(Op::Add)};
+  return {px, py};
+}
+
+/* Burning Ship: x' = abs(x)*abs(x) - abs(y)*abs(y) + cx, y' = 2*abs(x)*abs(y) + cy */
+static std::vector<Program> burning_ship() {
+  const Instr ax[] = {I(Op::PushState, 0), I(Op::CallBuiltin, (uint16_t)Builtin::Abs, 1)};
+  const Instr ay[] = {I(Op::PushState, 1), I(Op::CallBuiltin, (uint16_t)Builtin::Abs, 1)};
+  Program px, py;
+  px.code = {ax[0], ax[1], ax[0], ax[1], I(Op::Mul), ay[0], ay[1], ay[0], ay[1],
+             I(Op::Mul), I(Op::Sub), I(Op::PushParam, 0), I(Op::Add)};
+  py.constants = {2.0};
+  py.code = {I(Op::PushConst, 0), ax[0], ax[1], I(Op::Mul), ay[0], ay[1],
+             I(Op::Mul), I(Op::PushParam, 1), I(Op::Add)};
+  return {px, py};
+}
+
+/* plain double map step, the way the regular view iterates */
+static void step_double(const std::vector<Program> &maps, const double *z, const double *p,
+                        double *out) {
+  const bool ship = maps[0].code.size() > 9;
+  const double x = ship ? std::fabs(z[0]) : z[0], y = ship ? std::fabs(z[1]) : z[1];
+  out[0] = x * x - y * y + p[0];
+  out[1] = 2.0 * x * y + p[1];
+}
+
+struct View {
+  DD cx, cy;      /* centre, double-double */
+  double hw, hh;  /* half extents */
+  int W, H, maxit;
+  bool param_plane;
+  DD julia_re, julia_im; /* c for the Julia plane */
+};
+static const double kR2 = 16.0;
+
+struct Image {
+  std::vector<int> it;
+  std::vector<char> esc;
+  int skip = 0, refs = 0;
+  long glitched_first = 0, glitched_left = 0;
+};
+
+static double off_x(const View &v, int px) { return -v.hw + 2.0 * v.hw * px / (v.W - 1); }
+static double off_y(const View &v, int py) { return -v.hh + 2.0 * v.hh * py / (v.H - 1); }
+
+static void ref_inputs(const View &v, DD re, DD im, std::vector<DD> &s0, std::vector<DD> &p) {
+  s0.assign(2, DD{});
+  p.assign(2, DD{});
+  if (v.param_plane) {
+    p[0] = re;
+    p[1] = im;
+  } else {
+    s0[0] = re;
+    s0[1] = im;
+    p[0] = v.julia_re;
+    p[1] = v.julia_im;
+  }
+}
+
+/* mirrors compute_fractal_deep: reference at the centre, series, one pass,
+ * then re-reference at the worst glitch until none is left */
+static Image render_perturb(const std::vector<Program> &maps, const View &v, bool use_sa) {
+  Image img;
+  const size_t N = (size_t)v.W * v.H;
+  img.it.assign(N, 0);
+  img.esc.assign(N, 0);
+  PerturbPlane plane;
+  plane.params = v.param_plane;
+  std::vector<DD> s0, p;
+  ref_inputs(v, v.cx, v.cy, s0, p);
+  ReferenceOrbit ref;
+  char err[128];
+  if (!reference_orbit(maps, s0, p, v.maxit, kR2, &ref, err, sizeof(err))) {
+    std::printf("  reference failed: %s\n", err);
+    ++g_fail;
+    return img;
+  }
+  SeriesApprox sa;
+  const bool analytic = perturb_check(maps).analytic;
+  if (use_sa && analytic) series_approx(maps, ref, plane, v.hw, v.hh, &sa);
+  img.skip = sa.skip;
+  PerturbScratch ps;
+  std::vector<size_t> glitched;
+  std::vector<double> ratio(N, 0.0);
+  for (size_t k = 0; k < N; ++k) {
+    const int px = (int)(k % v.W), py = (int)(k / v.W);
+    PerturbPixel r = perturb_pixel(maps, ref, plane, sa.skip > 0 ? &sa : nullptr, v.hw, v.hh,
+                                   off_x(v, px), off_y(v, py), v.maxit, kR2, ps);
+    img.it[k] = r.iterations;
+    img.esc[k] = r.escaped;
+    if (r.glitched) { glitched.push_back(k); ratio[k] = r.glitch_ratio; }
+  }
+  img.glitched_first = (long)glitched.size();
+  img.refs = 1;
+  while (!glitched.empty() && img.refs < 16) {
+    size_t best = glitched[0];
+    for (size_t k : glitched) if (ratio[k] < ratio[best]) best = k;
+    const double rox = off_x(v, (int)(best % v.W)), roy = off_y(v, (int)(best / v.W));
+    ref_inputs(v, dd_add(v.cx, rox), dd_add(v.cy, roy), s0, p);
+    reference_orbit(maps, s0, p, v.maxit, kR2, &ref, err, sizeof(err));
+    ++img.refs;
+    std::vector<size_t> still;
+    for (size_t k : glitched) {
+      const int px = (int)(k % v.W), py = (int)(k / v.W);
+      PerturbPixel r = perturb_pixel(maps, ref, plane, nullptr, v.hw, v.hh, off_x(v, px) - rox,
+                                     off_y(v, py) - roy, v.maxit, kR2, ps);
+      img.it[k] = r.iterations;
+      img.esc[k] = r.escaped;
+      if (r.glitched) { still.push_back(k); ratio[k] = r.glitch_ratio; }
+    }
+    glitched.swap(still);
+  }
+  img.glitched_left = (long)glitched.size();
+  return img;
+}
+
+static Image render_double(const std::vector<Program> &maps, const View &v) {
+  Image img;
+  img.it.assign((size_t)v.W * v.H, 0);
+  img.esc.assign((size_t)v.W * v.H, 0);
+  for (int py = 0; py < v.H; ++py)
+    for (int px = 0; px < v.W; ++px) {
+      const double re = v.cx.hi + off_x(v, px), im = v.cy.hi + off_y(v, py);
+      double z[2] = {0, 0}, c[2] = {re, im}, nx[2];
+      if (!v.param_plane) { z[0] = re; z[1] = im; c[0] = v.julia_re.hi; c[1] = v.julia_im.hi; }
+      int it = 0;
+      bool esc = false;
+      for (; it < v.maxit; ++it) {
+        step_double(maps, z, c, nx);
+        const double r2 = nx[0] * nx[0] + nx[1] * nx[1];
+        if (!std::isfinite(r2) || r2 > kR2) { ++it; esc = true; break; }
+        z[0] = nx[0]; z[1] = nx[1];
+      }
+      img.it[(size_t)py * v.W + px] = it;
+      img.esc[(size_t)py * v.W + px] = esc;
+    }
+  return img;
+}
+
+/* brute force in double-double: the ground truth past 1e-13 */
+static Image render_dd(const View &v, bool ship = false) {
+  Image img;
+  img.it.assign((size_t)v.W * v.H, 0);
+  img.esc.assign((size_t)v.W * v.H, 0);
+  for (int py = 0; py < v.H; ++py)
+    for (int px = 0; px < v.W; ++px) {
+      const DD cr = dd_add(v.cx, off_x(v, px)), ci = dd_add(v.cy, off_y(v, py));
+      DD x{}, y{};
+      int it = 0;
+      bool esc = false;
+      for (; it < v.maxit; ++it) {
+        if (ship && x.hi < 0) x = dd_sub(DD{}, x);
+        if (ship && y.hi < 0) y = dd_sub(DD{}, y);
+        const DD xx = dd_mul(x, x), yy = dd_mul(y, y), xy = dd_mul(x, y);
+        x = dd_add(dd_sub(xx, yy), cr);
+        y = dd_add(dd_add(xy, xy), ci);
+        if (x.hi * x.hi + y.hi * y.hi > kR2) { ++it; esc = true; break; }
+      }
+      img.it[(size_t)py * v.W + px] = it;
+      img.esc[(size_t)py * v.W + px] = esc;
+    }
+  return img;
+}
+
+static long differ(const Image &a, const Image &b) {
+  long d = 0;
+  for (size_t k = 0; k < a.it.size(); ++k)
+    if (a.esc[k] != b.esc[k] || (a.esc[k] && a.it[k] != b.it[k])) ++d;
+  return d;
+}
+
+static DD dd_from(long double x) {
+  const double hi = (double)x;
+  return DD{hi, (double)(x - (long double)hi)};
+}
+
+int main() {
+  std::printf("=== dynsys perturbation smoke test ===\n");
+  char what[160];
+
+  /* double-double arithmetic */
+  {
+    const DD third = dd_div(DD{1.0, 0.0}, DD{3.0, 0.0});
+    const DD one = dd_mul(third, DD{3.0, 0.0});
+    check(std::fabs(one.hi - 1.0) + std::fabs(one.lo) < 1e-31, "double-double: (1/3)*3 == 1 to 1e-31");
+    const DD tiny = dd_add(DD{1.0, 0.0}, 1e-25);
+    check(dd_sub(tiny, DD{1.0, 0.0}).hi == 1e-25, "double-double: 1 + 1e-25 keeps the 1e-25");
+  }
+
+  /* static check */
+  {
+    check(perturb_check(mandelbrot()).ok && perturb_check(mandelbrot()).analytic,
+          "z^2+c accepted, analytic");
+    const PerturbSupport ship = perturb_check(burning_ship());
+    check(ship.ok && !ship.analytic, "burning ship accepted, not analytic (no series)");
+    std::vector<Program> m = mandelbrot();
+    m[0].constants = {3.0};
+    m[0].code = {I(Op::PushState, 0), I(Op::PushConst, 0),
+                 I(Op::CallBuiltin, (uint16_t)Builtin::Pow, 2), I(Op::PushParam, 0), I(Op::Add)};
+    check(perturb_check(m).ok, "pow(x, 3) accepted");
+    m[0].constants = {2.5};
+    check(!perturb_check(m).ok, "pow(x, 2.5) rejected");
+    m[0].code = {I(Op::PushState, 0), I(Op::CallBuiltin, (uint16_t)Builtin::Sin, 1)};
+    const PerturbSupport s = perturb_check(m);
+    check(!s.ok && s.why.find("sin") != std::string::npos, "sin(x) rejected with a reason");
+    m[0].code = {I(Op::PushParam, 0), I(Op::PushState, 0), I(Op::Div)};
+    check(!perturb_check(m).ok, "c / x rejected");
+  }
+
+  /* shallow zoom: perturbation == plain doubles */
+  {
+    View v{DD{-0.7435669, 0}, DD{0.1314023, 0}, 2e-4, 1.5e-4, 96, 72, 1500, true, {}, {}};
+    const Image a = render_double(mandelbrot(), v), b = render_perturb(mandelbrot(), v, true);
+    const long d = differ(a, b);
+    std::snprintf(what, sizeof(what), "seahorse 4e-4 wide: %ld/%d pixels differ from doubles", d, v.W * v.H);
+    check(d * 500 <= (long)v.W * v.H, what);
+
+    View j{DD{0.1, 0}, DD{0.05, 0}, 0.02, 0.015, 96, 72, 800, false, DD{-0.123, 0}, DD{0.745, 0}};
+    const Image ja = render_double(mandelbrot(), j), jb = render_perturb(mandelbrot(), j, true);
+    const long jd = differ(ja, jb);
+    std::snprintf(what, sizeof(what), "rabbit Julia plane: %ld pixels differ from doubles", jd);
+    check(jd * 500 <= (long)j.W * j.H, what);
+
+    /* the ship's bounded-looking chaotic bands escape after long, rounding-
+     * sensitive transients, so even plain doubles disagree with the
+     * double-double truth there; perturbation must do no worse */
+    View s{DD{-0.5, 0}, DD{-0.5, 0}, 1.7, 1.275, 96, 72, 200, true, {}, {}};
+    const Image st = render_dd(s, true);
+    const long sd = differ(st, render_double(burning_ship(), s));
+    const long sp = differ(st, render_perturb(burning_ship(), s, true));
+    std::snprintf(what, sizeof(what), "burning ship vs double-double: %ld differ (doubles: %ld)", sp, sd);
+    check(sp <= 2 * sd + 10, what);
+  }
+
+  /* deep zoom: 1e-20 wide, past what doubles can resolve */
+  {
+    View v{dd_from(-0.743643887037158704752191506114774L), dd_from(0.131825904205311970493132056385139L),
+           1e-20, 0.75e-20, 48, 36, 16000, true, {}, {}};
+    std::set<double> distinct;
+    for (int px = 0; px < v.W; ++px) distinct.insert(v.cx.hi + off_x(v, px));
+    std::snprintf(what, sizeof(what), "doubles see %zu distinct re(c) across %d columns", distinct.size(), v.W);
+    check(distinct.size() == 1, what);
+
+    const Image truth = render_dd(v);
+    const Image plain = render_perturb(mandelbrot(), v, false);
+    const Image fast = render_perturb(mandelbrot(), v, true);
+    std::set<int> levels(truth.it.begin(), truth.it.end());
+    std::snprintf(what, sizeof(what), "double-double truth has structure (%zu levels)", levels.size());
+    check(levels.size() > 20, what);
+    const long d0 = differ(truth, plain), d1 = differ(truth, fast);
+    /* a few pixels sit on orbits that linger ~10^4 iterations near the
+     * boundary; there double-double itself is off by tens of iterations
+     * against a 90-digit reference, so allow them (2%) */
+    std::snprintf(what, sizeof(what), "perturbation vs double-double: %ld/%d differ", d0, v.W * v.H);
+    check(d0 * 50 <= (long)v.W * v.H, what);
+    const long d2 = differ(plain, fast);
+    std::snprintf(what, sizeof(what), "series skips %d iterations, %ld/%d change", fast.skip, d2, v.W * v.H);
+    check(fast.skip > 1000 && d2 * 200 <= (long)v.W * v.H && d1 * 50 <= (long)v.W * v.H, what);
+    std::snprintf(what, sizeof(what), "glitches: %ld -> %ld after %d references", fast.glitched_first,
+                  fast.glitched_left, fast.refs);
+    check(fast.glitched_left == 0, what);
+  }
+
+  /* a reference that escapes early: everything must be re-referenced */
+  {
+    View v{DD{-0.75, 0}, DD{0.2, 0}, 0.1, 0.075, 64, 48, 400, true, {}, {}};
+    const Image a = render_double(mandelbrot(), v), b = render_perturb(mandelbrot(), v, true);
+    const long d = differ(a, b);
+    std::snprintf(what, sizeof(what), "escaping centre: %ld glitched -> %ld left (%d refs), %ld differ",
+                  b.glitched_first, b.glitched_left, b.refs, d);
+    check(b.glitched_first > 0 && b.glitched_left == 0 && d * 500 <= (long)v.W * v.H, what);
+  }
+
+  std::printf("=== %s ===\n", g_fail == 0 ? "PASS" : "FAIL");
+  return g_fail == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/* Locks the FFT signal tools (autocorrelation, power_spectrum) and the
+ * FFT-backed limit_cycle_period_amplitude: the autocorrelation equals the
+ * lag-by-lag sums, the period detector gives the periods of the old
+ * direct-ACF detector on sine, relaxation and noisy signals, the Welch
+ * spectrum finds the frequencies of a two-tone signal, and its integral is
+ * the variance (Parseval). The cost per sweep slice against the direct
+ * detector is printed, not checked.
+ * make test-spectrum */
+#include "analysis.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace dynsys::analysis;
+
+/* the detector as it was: ACF lag by lag, neighbours recomputed */
+static double direct_period(const std::vector<double> &y, double dt) {
+  const size_t n = y.size();
+  double mean = 0;
+  for (double v : y) mean += v;
+  mean /= n;
+  std::vector<double> c(y);
+  for (double &v : c) v -= mean;
+  double c0 = 0;
+  for (double v : c) c0 += v * v;
+  auto acf = [&](size_t lag) {
+    double s = 0;
+    for (size_t i = 0; i + lag < n; ++i) s += c[i] * c[i + lag];
+    return s / c0;
+  };
+  const size_t maxlag = n / 2;
+  bool dropped = false;
+  for (size_t lag = 1; lag < maxlag; ++lag) {
+    const double a = acf(lag);
+    if (!dropped && a < 0.0) dropped = true;
+    if (dropped) {
+      const double am = acf(lag - 1), ap = (lag + 1 < maxlag) ? acf(lag + 1) : a;
+      if (a > am && a >= ap && a > 0.2) {
+        const double denom = am - 2 * a + ap;
+        const double off = std::fabs(denom) > 1e-12 ? 0.5 * (am - ap) / denom : 0.0;
+        return (lag + off) * dt;
+      }
+    }
+  }
+  return NAN;
+}
+
+/* van der Pol, mu = 3: a relaxation oscillation, RK4 */
+static std::vector<double> vdp(size_t n, double dt) {
+  double x = 2, v = 0;
+  std::vector<double> out;
+  auto f = [](double x, double v, double *dx, double *dv) { *dx = v; *dv = 3.0 * (1 - x * x) * v - x; };
+  for (size_t i = 0; i < n + 20000; ++i) {
+    double k1x, k1v, k2x, k2v, k3x, k3v, k4x, k4v;
+    f(x, v, &k1x, &k1v);
+    f(x + 0.5 * dt * k1x, v + 0.5 * dt * k1v, &k2x, &k2v);
+    f(x + 0.5 * dt * k2x, v + 0.5 * dt * k2v, &k3x, &k3v);
+    f(x + dt * k3x, v + dt * k3v, &k4x, &k4v);
+    x += dt / 6 * (k1x + 2 * k2x + 2 * k3x + k4x);
+    v += dt / 6 * (k1v + 2 * k2v + 2 * k3v + k4v);
+    if (i >= 20000) out.push_back(x);
+  }
+  return out;
+}
+
+int main() {
+  int fails = 0;
+  std::mt19937_64 rng(11);
+  std::normal_distribution<double> N01(0.0, 1.0);
+
+  /* 1. autocorrelation against direct sums, odd length */
+  {
+    std::vector<double> y(3001);
+    for (size_t i = 0; i < y.size(); ++i) y[i] = std::sin(0.05 * i) + 0.3 * N01(rng) + 2.0;
+    const std::vector<double> r = autocorrelation(y, 500);
+    double mean = 0;
+    for (double v : y) mean += v;
+    mean /= y.size();
+    double c0 = 0, worst = 0;
+    for (double v : y) c0 += (v - mean) * (v - mean);
+    for (size_t lag = 0; lag <= 500; ++lag) {
+      double s = 0;
+      for (size_t i = 0; i + lag < y.size(); ++i) s += (y[i] - mean) * (y[i + lag] - mean);
+      worst = std::max(worst, std::fabs(s / c0 - r[lag]));
+    }
+    const bool flat_empty = autocorrelation(std::vector<double>(100, 1.0), 10).empty();
+    printf("  autocorrelation vs direct sums: max |diff| %.1e, constant signal %s\n", worst,
+           flat_empty ? "rejected" : "ACCEPTED");
+    if (r.size() != 501 || worst > 1e-12 || !flat_empty) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 2. same periods as the direct detector; cost of one 40000-sample
+   * sweep slice (report only) */
+  {
+    const double dt = 0.01;
+    std::vector<std::vector<double>> sigs;
+    std::vector<double> s1, s3, s4;
+    for (int i = 0; i < 40000; ++i) s1.push_back(1.5 * std::sin(0.7 * i * dt) + 0.3);
+    for (int i = 0; i < 40000; ++i) s4.push_back(std::cos(2 * M_PI * i * dt / 40.0));
+    for (int i = 0; i < 40000; ++i) s3.push_back(std::sin(2.0 * i * dt) + 0.5 * std::sin(4.0 * i * dt + 1) + 0.2 * N01(rng));
+    sigs.push_back(s1);
+    sigs.push_back(vdp(40000, dt));
+    sigs.push_back(s3);
+    sigs.push_back(s4);
+    const char *names[4] = {"sine T=8.98", "van der Pol mu=3", "two-tone + noise", "slow cosine T=40"};
+    double fft_ms = 0, direct_ms = 0;
+    bool good = true;
+    for (int k = 0; k < 4; ++k) {
+      auto t0 = std::chrono::steady_clock::now();
+      const LimitCycleResult R = limit_cycle_period_amplitude(sigs[k], dt);
+      auto t1 = std::chrono::steady_clock::now();
+      const double D = direct_period(sigs[k], dt);
+      auto t2 = std::chrono::steady_clock::now();
+      fft_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      direct_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+      printf("  %-18s T = %.6f (direct %.6f)\n", names[k], R.period, D);
+      good = good && R.ok && std::fabs(R.period - D) < 1e-9 * D;
+    }
+    printf("  4 slices of 40000 samples: FFT %.1f ms, lag by lag %.1f ms (%.0fx)\n", fft_ms, direct_ms,
+           direct_ms / fft_ms);
+    if (!good) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 3. Welch spectrum: two tones (1.5 and 4.2 cycles/unit) in noise;
+   * Parseval: the PSD integrates to the variance */
+  {
+    const double dt = 0.01;
+    std::vector<double> y(1 << 16);
+    double mean = 0, var = 0;
+    for (size_t i = 0; i < y.size(); ++i) {
+      const double t = i * dt;
+      y[i] = 2.0 * std::sin(2 * M_PI * 1.5 * t) + 0.7 * std::sin(2 * M_PI * 4.2 * t) + 0.5 * N01(rng);
+      mean += y[i];
+    }
+    mean /= y.size();
+    for (double v : y) var += (v - mean) * (v - mean);
+    var /= y.size();
+    const PowerSpectrum S = power_spectrum(y, dt);
+    double integral = 0, second = 0, second_f = 0;
+    const double df = S.frequency[1] - S.frequency[0];
+    for (size_t k = 0; k < S.power.size(); ++k) {
+      integral += S.power[k] * df;
+      if (std::fabs(S.frequency[k] - S.peak_frequency) > 1.0 && S.power[k] > second) {
+        second = S.power[k];
+        second_f = S.frequency[k];
+      }
+    }
+    printf("  Welch, %d segments of %zu: peak %.4f cycles/unit (1.5), next %.3f (4.2), "
+           "integral %.4f vs variance %.4f\n", S.segments, 2 * (S.power.size() - 1), S.peak_frequency, second_f,
+           integral, var);
+    if (!S.ok || std::fabs(S.peak_frequency - 1.5) > 0.01 || std::fabs(second_f - 4.2) > 0.05 ||
+        std::fabs(integral / var - 1.0) > 0.03) {
+      printf("  <-- FAIL\n");
+      fails++;
+    }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,123 @@
+/* Locks the shared compute pool (thread_pool.h): every item of a
+ * parallel_for runs exactly once, slots stay inside [0, threads()) and are
+ * never shared by two threads at the same time, badly skewed work is spread
+ * by stealing (more than one slot works on the heavy tail), nested calls
+ * finish, a Cancel token stops a long loop early and is reported, and
+ * --threads 1 degenerates to an in-order serial loop on the caller.
+ * make test-threadpool */
+#include "thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace dynsys;
+
+static double spin(long n) { /* deterministic busy work */
+  double s = 0.0;
+  for (long i = 0; i < n; ++i) s += std::sin((double)i * 1e-3);
+  return s;
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+  printf("  threads=%u\n", pool::threads());
+  if (pool::threads() != 4) { printf("  configure ignored <-- FAIL\n"); fails++; }
+
+  /* every item exactly once; a slot is never entered by two threads at once */
+  {
+    const size_t N = 100000;
+    std::vector<std::atomic<int>> hits(N);
+    std::vector<std::atomic<int>> inside(pool::threads());
+    std::atomic<int> bad_slot{0}, overlap{0};
+    bool ok = pool::parallel_for(N, [&](size_t i, unsigned slot) {
+      if (slot >= pool::threads()) { bad_slot++; return; }
+      if (inside[slot].fetch_add(1) != 0) overlap++;
+      hits[i].fetch_add(1, std::memory_order_relaxed);
+      inside[slot].fetch_sub(1);
+    });
+    int wrong = 0;
+    for (auto &h : hits) if (h.load() != 1) wrong++;
+    printf("  %zu items: %d not run exactly once, %d bad slots, %d slot overlaps (expect 0)\n",
+           N, wrong, bad_slot.load(), overlap.load());
+    if (!ok || wrong || bad_slot || overlap) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* skewed work: all the cost sits in the last quarter, which a static split
+   * would hand to one thread. Stealing must spread it. */
+  {
+    const size_t N = 64;
+    std::vector<int> owner(N, -1);
+    std::vector<double> sink(N);
+    pool::parallel_for(N, [&](size_t i, unsigned slot) {
+      sink[i] = spin(i >= 48 ? 400000 : 1000);
+      owner[i] = (int)slot;
+    });
+    std::vector<int> seen(pool::threads(), 0);
+    for (size_t i = 48; i < N; ++i) seen[owner[i]] = 1;
+    int slots = 0;
+    for (int s : seen) slots += s;
+    printf("  heavy tail ran on %d slots (expect >1)\n", slots);
+    if (slots < 2) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* nested parallel_for from inside a body */
+  {
+    std::atomic<long> total{0};
+    pool::parallel_for(16, [&](size_t, unsigned) {
+      pool::parallel_for(200, [&](size_t j, unsigned) { total.fetch_add((long)j); });
+    });
+    const long expect = 16L * (199L * 200L / 2);
+    printf("  nested: sum=%ld (expect %ld)\n", total.load(), expect);
+    if (total.load() != expect) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* cancellation: stop after a few items of a long loop */
+  {
+    pool::Cancel cancel;
+    std::atomic<long> ran{0};
+    const size_t N = 20000;
+    bool done = pool::parallel_for(N, [&](size_t, unsigned) {
+      if (ran.fetch_add(1) == 100) cancel.cancel();
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }, &cancel);
+    printf("  cancelled: returned %s after %ld of %zu items\n", done ? "true" : "false", ran.load(), N);
+    if (done || ran.load() > (long)N / 4) { printf("  <-- FAIL\n"); fails++; }
+    /* a token cancelled up front runs nothing */
+    std::atomic<long> ran2{0};
+    done = pool::parallel_for(N, [&](size_t, unsigned) { ran2++; }, &cancel);
+    if (done || ran2.load() != 0) { printf("  pre-cancelled loop ran %ld items <-- FAIL\n", ran2.load()); fails++; }
+  }
+
+  /* one thread: serial, in order, on the caller */
+  {
+    pool::configure({1, false});
+    std::vector<size_t> order;
+    const std::thread::id me = std::this_thread::get_id();
+    bool on_caller = true;
+    pool::parallel_for(1000, [&](size_t i, unsigned slot) {
+      order.push_back(i);
+      if (slot != 0 || std::this_thread::get_id() != me) on_caller = false;
+    });
+    bool in_order = order.size() == 1000;
+    for (size_t i = 0; in_order && i < order.size(); ++i) in_order = order[i] == i;
+    printf("  threads=1: in order %s, on caller %s\n", in_order ? "yes" : "no", on_caller ? "yes" : "no");
+    if (!in_order || !on_caller) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* reconfigure back up (with pinning, a no-op off Linux) and run again */
+  {
+    pool::configure({3, true});
+    std::atomic<long> total{0};
+    pool::parallel_for(5000, [&](size_t i, unsigned) { total.fetch_add((long)i); });
+    printf("  threads=3 pinned: sum=%ld (expect %ld)\n", total.load(), 4999L * 5000L / 2);
+    if (total.load() != 4999L * 5000L / 2) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
@@ -0,0 +1,237 @@
+/* Locks the view tile cache (tile_cache.h) and the way the fractal and basin
+ * views use it (compose_view_tiles in dynsys.cpp, mirrored here without GL):
+ * LRU order and the byte cap hold, every composed pixel takes the grid sample
+ * nearest to it at a level within sqrt2 of its own resolution, a pan or zoom
+ * only computes tiles that were never on screen and going back computes
+ * none (same image, far faster), and basin cells integrated tile by tile
+ * cluster exactly like one whole-grid integration. The cache is hammered
+ * from the pool to check its locking.
+ * make test-tilecache */
+#include "analysis.h"
+#include "thread_pool.h"
+#include "tile_cache.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace dynsys;
+using Clock = std::chrono::steady_clock;
+
+struct Tile { std::vector<uint32_t> v; };
+using TileCache = tiles::Cache<Tile>;
+constexpr size_t kTileBytes = sizeof(uint32_t) * tiles::kTile * tiles::kTile;
+
+/* escape count of the Julia set z^2 - 0.8 + 0.156i: the kind of sample the
+ * fractal view caches */
+static uint32_t julia(double x, double y) {
+  uint32_t it = 0;
+  for (; it < 300 && x * x + y * y <= 4.0; ++it) {
+    const double t = x * x - y * y - 0.8;
+    y = 2.0 * x * y + 0.156;
+    x = t;
+  }
+  return it;
+}
+
+/* compose_view_tiles, reduced to the cache protocol */
+static double render(TileCache &cache, const tiles::Window &view, int W, int H, std::vector<uint32_t> &out,
+                     long *computed, long *reused) {
+  const auto t0 = Clock::now();
+  const tiles::Range r = tiles::covering(view, W, H);
+  std::vector<std::shared_ptr<const Tile>> held;
+  std::vector<const uint32_t *> data;
+  *computed = *reused = 0;
+  for (int64_t ty = r.ty0; ty <= r.ty1; ++ty)
+    for (int64_t tx = r.tx0; tx <= r.tx1; ++tx) {
+      const tiles::Key key{42, r.level, tx, ty};
+      std::shared_ptr<const Tile> t = cache.find(key);
+      if (t) { ++*reused; }
+      else {
+        auto fresh = std::make_shared<Tile>();
+        const tiles::Window tw = tiles::tile_window(r.level, tx, ty);
+        fresh->v.resize((size_t)tiles::kTile * tiles::kTile);
+        pool::parallel_for(tiles::kTile, [&](size_t j, unsigned) {
+          for (int i = 0; i < tiles::kTile; ++i)
+            fresh->v[j * tiles::kTile + i] = julia(tw.x0 + (tw.x1 - tw.x0) * i / (tiles::kTile - 1),
+                                                   tw.y0 + (tw.y1 - tw.y0) * (double)j / (tiles::kTile - 1));
+        });
+        cache.insert(key, fresh, kTileBytes);
+        t = std::move(fresh);
+        ++*computed;
+      }
+      data.push_back(t->v.data());
+      held.push_back(std::move(t));
+    }
+  tiles::compose(view, W, H, r, data, out);
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static tiles::Window zoomed(const tiles::Window &v, double f) {
+  const double cx = 0.5 * (v.x0 + v.x1), cy = 0.5 * (v.y0 + v.y1);
+  return {cx + (v.x0 - cx) * f, cx + (v.x1 - cx) * f, cy + (v.y0 - cy) * f, cy + (v.y1 - cy) * f};
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+
+  /* 1. LRU order and the byte cap */
+  {
+    tiles::Cache<int> c(300);
+    auto v = std::make_shared<const int>(1);
+    const tiles::Key a{1, 0, 0, 0}, b{1, 0, 1, 0}, cc{1, 0, 2, 0}, d{1, 0, 3, 0};
+    c.insert(a, v, 100); c.insert(b, v, 100); c.insert(cc, v, 100);
+    c.find(a);           /* a is now the most recent: b is the oldest */
+    c.insert(d, v, 100);
+    const bool lru_ok = c.contains(a) && !c.contains(b) && c.contains(cc) && c.contains(d);
+    c.insert(d, v, 100); /* re-inserting a key must not count it twice */
+    const auto st = c.stats();
+    c.set_capacity(100);
+    const bool shrink_ok = c.stats().tiles == 1 && c.contains(d);
+    printf("  lru: oldest evicted %s, %zu bytes for %zu tiles (expect 300/3), shrink keeps newest %s\n",
+           lru_ok ? "yes" : "no", st.bytes, st.tiles, shrink_ok ? "yes" : "no");
+    if (!lru_ok || st.bytes != 300 || st.tiles != 3 || st.evictions != 1 || !shrink_ok) {
+      printf("  <-- FAIL\n"); fails++;
+    }
+  }
+
+  /* 2. every pixel takes its nearest grid sample, at a level near its own
+   * resolution; tiles carry their global sample indices here */
+  {
+    const tiles::Window views[] = {{-1.7, 1.3, -0.9, 1.1}, {0.123, 0.1275, -0.6551, -0.6519}, {-1e3, 2e3, 5e2, 2.5e3}};
+    int bad = 0;
+    for (const tiles::Window &view : views) {
+      const int W = 317, H = 211;
+      const tiles::Range r = tiles::covering(view, W, H);
+      const double s = tiles::spacing(r.level);
+      const double pixel = std::fmin((view.x1 - view.x0) / (W - 1), (view.y1 - view.y0) / (H - 1));
+      if (r.empty() || s < pixel / 1.4143 || s > pixel * 1.4143) { bad++; continue; }
+      struct Sample { int64_t gx, gy; };
+      std::vector<std::vector<Sample>> store;
+      for (int64_t ty = r.ty0; ty <= r.ty1; ++ty)
+        for (int64_t tx = r.tx0; tx <= r.tx1; ++tx) {
+          std::vector<Sample> t((size_t)tiles::kTile * tiles::kTile);
+          for (int j = 0; j < tiles::kTile; ++j)
+            for (int i = 0; i < tiles::kTile; ++i)
+              t[(size_t)j * tiles::kTile + i] = {tx * tiles::kTile + i, ty * tiles::kTile + j};
+          store.push_back(std::move(t));
+        }
+      std::vector<const Sample *> data;
+      for (auto &t : store) data.push_back(t.data());
+      std::vector<Sample> out;
+      tiles::compose(view, W, H, r, data, out);
+      for (int j = 0; j < H; ++j)
+        for (int i = 0; i < W; ++i) {
+          const Sample g = out[(size_t)j * W + i];
+          const double x = view.x0 + (view.x1 - view.x0) * i / (W - 1);
+          const double y = view.y0 + (view.y1 - view.y0) * (double)j / (H - 1);
+          if (std::fabs(g.gx * s - x) > 0.5001 * s || std::fabs(g.gy * s - y) > 0.5001 * s) bad++;
+        }
+    }
+    printf("  nearest-sample composition: %d bad pixels (expect 0)\n", bad);
+    if (bad) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 3. navigating around a Julia set: pan, zoom, then back */
+  {
+    TileCache cache;
+    const int W = 400, H = 300;
+    const tiles::Window home{-1.6, 1.6, -1.2, 1.2};
+    std::vector<uint32_t> first, img;
+    long computed, reused;
+    const double t_first = render(cache, home, W, H, first, &computed, &reused);
+    const long first_computed = computed;
+    const double wdt = home.x1 - home.x0;
+    const tiles::Window panned{home.x0 + 0.25 * wdt, home.x1 + 0.25 * wdt, home.y0, home.y1};
+    render(cache, panned, W, H, img, &computed, &reused);
+    printf("  home: %ld tiles in %.1f ms; pan by 1/4: %ld new, %ld cached\n", first_computed, t_first, computed, reused);
+    if (first_computed == 0 || computed == 0 || computed > first_computed / 2 || reused == 0) {
+      printf("  pan recomputed too much <-- FAIL\n"); fails++;
+    }
+    render(cache, zoomed(home, 0.9), W, H, img, &computed, &reused);
+    printf("  zoom 0.9: %ld new, %ld cached\n", computed, reused);
+    if (reused == 0) { printf("  zoom reused nothing <-- FAIL\n"); fails++; }
+    const double t_back = render(cache, home, W, H, img, &computed, &reused);
+    printf("  back home: %ld new, %ld cached in %.2f ms, image %s\n", computed, reused, t_back,
+           img == first ? "identical" : "DIFFERENT");
+    if (computed != 0 || img != first || t_back > 0.25 * t_first) { printf("  <-- FAIL\n"); fails++; }
+
+    /* under a small cap the cache never holds more than it may */
+    TileCache small(12 * kTileBytes);
+    size_t worst = 0;
+    tiles::Window v = home;
+    for (int k = 0; k < 6; ++k) {
+      render(small, v, 160, 120, img, &computed, &reused);
+      worst = std::max(worst, small.stats().bytes);
+      v = zoomed(v, 0.7);
+    }
+    printf("  cap 12 tiles: peak %zu tiles held, %ld evicted\n", worst / kTileBytes, small.stats().evictions);
+    if (worst > 12 * kTileBytes || small.stats().evictions == 0) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  /* 4. basins: cells integrated per tile cluster exactly like one integration
+   * of the same (tile-aligned) grid */
+  {
+    auto adv = [](double x, double y, double *nx, double *ny) {
+      const double tx = x >= 0 ? 1.0 : -1.0; /* two attractors, (+-1, 0) */
+      *nx = x + 0.15 * (tx - x);
+      *ny = y + 0.15 * (0.0 - y);
+      return true;
+    };
+    auto mk = [&](int) { return analysis::AdvanceFn(adv); };
+    const int level = 5; /* 2x2 tiles spanning [-2, 2) at spacing 1/32 */
+    const tiles::Window lo = tiles::tile_window(level, -1, -1), hi = tiles::tile_window(level, 0, 0);
+    analysis::BasinOptions o;
+    o.xmin = lo.x0; o.xmax = hi.x1; o.ymin = lo.y0; o.ymax = hi.y1;
+    o.width = o.height = 2 * tiles::kTile;
+    o.max_steps = 300; o.settle_tol = 1e-6; o.cluster_tol = 0.05; o.max_attractors = 8;
+    const analysis::BasinResult whole = analysis::compute_basins_mt(mk, o);
+    std::vector<analysis::BasinCell> stitched((size_t)o.width * o.height);
+    for (int ty = -1; ty <= 0; ++ty)
+      for (int tx = -1; tx <= 0; ++tx) {
+        const tiles::Window tw = tiles::tile_window(level, tx, ty);
+        analysis::BasinOptions to = o;
+        to.xmin = tw.x0; to.xmax = tw.x1; to.ymin = tw.y0; to.ymax = tw.y1;
+        to.width = to.height = tiles::kTile;
+        std::vector<analysis::BasinCell> cells;
+        analysis::integrate_basin_cells(mk, to, &cells);
+        for (int j = 0; j < tiles::kTile; ++j)
+          for (int i = 0; i < tiles::kTile; ++i)
+            stitched[(size_t)((ty + 1) * tiles::kTile + j) * o.width + (tx + 1) * tiles::kTile + i] =
+                cells[(size_t)j * tiles::kTile + i];
+      }
+    const analysis::BasinResult tiled = analysis::cluster_basin_cells(stitched, o.width, o.height, o);
+    int diff = 0;
+    for (size_t i = 0; i < whole.cell_attractor.size(); ++i)
+      if (!tiled.ok || whole.cell_attractor[i] != tiled.cell_attractor[i]) diff++;
+    printf("  basins: whole %zu attractors, tiled %zu, %d cells differ (expect 0)\n",
+           whole.attractors.size(), tiled.attractors.size(), diff);
+    if (!whole.ok || diff || whole.attractors.size() != 2 || tiled.attractors.size() != 2) {
+      printf("  <-- FAIL\n"); fails++;
+    }
+  }
+
+  /* 5. one cache hit from many threads at once (run under TSan too) */
+  {
+    TileCache shared(40 * kTileBytes);
+    std::vector<long> found(pool::threads(), 0);
+    pool::parallel_for(20000, [&](size_t i, unsigned slot) {
+      const tiles::Key key{7, 0, (int64_t)(i % 97), 0};
+      if (shared.find(key)) found[slot]++;
+      else shared.insert(key, std::make_shared<const Tile>(), kTileBytes);
+    });
+    long hits = 0;
+    for (long f : found) hits += f;
+    const auto st = shared.stats();
+    printf("  concurrent: %ld hits, %zu tiles held (cap 40)\n", hits, st.tiles);
+    if (st.bytes > 40 * kTileBytes || hits == 0 || st.hits != hits) { printf("  <-- FAIL\n"); fails++; }
+  }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}
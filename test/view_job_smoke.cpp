@@ -0,0 +1,188 @@
+/* Locks the background view-job protocol of the heavy views (ViewJob in
+ * dynsys.cpp, mirrored here without GL): a job computes its progressive
+ * levels on a private state built from a snapshot of the view's inputs and
+ * publishes each as a landing; the UI thread lands the newest one per frame
+ * without ever waiting, levels land coarse to fine, and a job retired
+ * because the view changed is cancelled through the pool's Cancel token and
+ * never lands. Timings are printed, not checked.
+ * make test-viewjob */
+#include "thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dynsys;
+using Clock = std::chrono::steady_clock;
+
+struct Ui {                 /* stands in for AppState */
+  int shown_level = 0;      /* the "texture": last landed level */
+  double shown_value = 0.0;
+  int shown_view = -1;      /* which view window produced it */
+  std::vector<std::pair<int, int>> landed; /* (view, level) in landing order */
+  int view = 0;             /* current view window (changes = stale) */
+  std::vector<double> history = std::vector<double>(4096, 1.0); /* not a view input */
+  const pool::Cancel *job_cancel = nullptr;
+};
+
+struct Snapshot {           /* stands in for ViewSnapshot */
+  int view = 0;
+};
+
+struct ViewJob {
+  Snapshot inputs;
+  pool::Cancel cancel;
+  std::thread thread;
+  std::atomic<bool> finished{false};
+  std::mutex mu;
+  std::function<void(Ui &)> landing;
+};
+
+static void publish(ViewJob &job, std::function<void(Ui &)> landing) {
+  std::lock_guard<std::mutex> lk(job.mu);
+  job.landing = std::move(landing);
+}
+static void retire(std::vector<std::shared_ptr<ViewJob>> &retired, std::shared_ptr<ViewJob> &job) {
+  if (!job) return;
+  job->cancel.cancel();
+  retired.push_back(std::move(job));
+  job.reset();
+}
+static void start(std::vector<std::shared_ptr<ViewJob>> &retired, const Ui &ui, std::shared_ptr<ViewJob> &slot,
+                  std::function<void(Ui &, ViewJob &)> work) {
+  retire(retired, slot);
+  auto job = std::make_shared<ViewJob>();
+  job->inputs.view = ui.view;
+  ViewJob *j = job.get();
+  job->thread = std::thread([j, work]() {
+    auto snap = std::make_unique<Ui>();
+    snap->history.clear(); /* dynsys builds a fresh AppState: no history */
+    snap->view = j->inputs.view;
+    snap->job_cancel = &j->cancel;
+    work(*snap, *j);
+    j->finished.store(true, std::memory_order_release);
+  });
+  slot = std::move(job);
+}
+static bool land(Ui &ui, std::shared_ptr<ViewJob> &slot) {
+  if (!slot) return false;
+  const bool done = slot->finished.load(std::memory_order_acquire);
+  std::function<void(Ui &)> landing;
+  { std::lock_guard<std::mutex> lk(slot->mu); landing.swap(slot->landing); }
+  if (landing) landing(ui);
+  if (!done) return true;
+  slot->thread.join();
+  slot.reset();
+  return false;
+}
+static void reap(std::vector<std::shared_ptr<ViewJob>> &retired) {
+  for (size_t i = 0; i < retired.size();)
+    if (retired[i]->finished.load()) { retired[i]->thread.join(); retired.erase(retired.begin() + (long)i); }
+    else ++i;
+}
+
+/* a "level": rows of busy work on the pool, cancellable like the views */
+static double compute_level(const Ui &s, int step) {
+  std::vector<double> rows(64, 0.0);
+  pool::parallel_for(rows.size(), [&](size_t r, unsigned) {
+    double acc = 0.0;
+    for (int k = 0; k < 600000 / step; ++k) acc += std::sin(k * 1e-4 + (double)r + s.view);
+    rows[r] = acc;
+  }, s.job_cancel);
+  double sum = 0.0;
+  for (double v : rows) sum += v;
+  return sum;
+}
+
+/* a job can be held before its first level until the test releases it */
+static std::atomic<bool> gate_open{true};
+static void wait_gate() {
+  const auto t0 = Clock::now();
+  while (!gate_open.load() && Clock::now() - t0 < std::chrono::seconds(30))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+int main() {
+  int fails = 0;
+  pool::configure({4, false});
+  Ui ui;
+  std::shared_ptr<ViewJob> job;
+  std::vector<std::shared_ptr<ViewJob>> retired;
+  std::atomic<int> published{0};
+  std::atomic<bool> saw_history{false};
+  auto work = [&published, &saw_history](Ui &snap, ViewJob &j) {
+    if (!snap.history.empty()) saw_history = true;
+    wait_gate();
+    for (int step = 8; step >= 1; step /= 2) {
+      const double v = compute_level(snap, step);
+      if (j.cancel.cancelled()) return;
+      ++published;
+      publish(j, [step, v, view = snap.view](Ui &u) {
+        u.shown_level = step; u.shown_value = v; u.shown_view = view;
+        u.landed.push_back({view, step});
+      });
+    }
+  };
+
+  /* 1. a full run: landing never waits for the job (it returns while the
+   * job is held), and the levels that land go strictly coarse -> fine */
+  gate_open = false;
+  start(retired, ui, job, work);
+  const bool pending = land(ui, job);
+  const bool nothing_yet = ui.landed.empty();
+  gate_open = true;
+  int frames = 1;
+  const auto t0 = Clock::now();
+  while (land(ui, job)) { ++frames; std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+  const double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  bool ordered = !ui.landed.empty();
+  for (size_t k = 1; k < ui.landed.size(); ++k) ordered = ordered && ui.landed[k].second < ui.landed[k - 1].second;
+  printf("  full run: %d frames over %.0f ms, %zu level(s) landed, job saw %s\n", frames, total_ms,
+         ui.landed.size(), saw_history ? "the UI history" : "only its snapshot");
+  if (!pending || !nothing_yet) { printf("  landing waited on the job <-- FAIL\n"); fails++; }
+  if (!ordered || ui.shown_level != 1 || ui.shown_view != 0) { printf("  levels did not land coarse -> fine <-- FAIL\n"); fails++; }
+  if (saw_history) { printf("  the job state carried more than its snapshot <-- FAIL\n"); fails++; }
+
+  /* 2. the view changes mid-job: the stale job is cancelled, never lands,
+   * and the new one shows the new view */
+  ui.landed.clear();
+  ui.view = 1;
+  start(retired, ui, job, work);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ui.view = 2;
+  start(retired, ui, job, work); /* retires (cancels) the view-1 job */
+  while (land(ui, job)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  const auto c0 = Clock::now();
+  while (!retired.empty() && Clock::now() - c0 < std::chrono::seconds(30)) { reap(retired); std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+  const bool stale_gone = retired.empty();
+  bool stale_landed = false;
+  for (const auto &l : ui.landed) stale_landed = stale_landed || l.first != 2;
+  printf("  view change: shows view %d (expect 2), stale job %s, %s\n", ui.shown_view,
+         stale_gone ? "joined" : "still running", stale_landed ? "a stale level landed" : "no stale level landed");
+  if (ui.shown_view != 2 || ui.shown_level != 1 || !stale_gone || stale_landed) { printf("  <-- FAIL\n"); fails++; }
+
+  /* 3. a job cancelled before its first level publishes nothing, and the
+   * view keeps what it showed */
+  ui.view = 3;
+  published = 0;
+  gate_open = false;
+  start(retired, ui, job, work);
+  retire(retired, job);
+  gate_open = true;
+  const auto k0 = Clock::now();
+  while (!retired.empty() && Clock::now() - k0 < std::chrono::seconds(30)) { reap(retired); std::this_thread::sleep_for(std::chrono::microseconds(200)); }
+  const double cancel_ms = std::chrono::duration<double, std::milli>(Clock::now() - k0).count();
+  printf("  cancel: stopped in %.1f ms (full run %.0f ms), %d level(s) published, view still %d\n", cancel_ms,
+         total_ms, published.load(), ui.shown_view);
+  if (!retired.empty() || published != 0 || ui.shown_view != 2) { printf("  <-- FAIL\n"); fails++; }
+
+  printf("=== %s ===\n", fails == 0 ? "PASS" : "FAIL");
+  return fails;
+}